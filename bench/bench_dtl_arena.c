@@ -0,0 +1,151 @@
+/*****************************************************************************
+* \file      bench_dtl_arena.c
+* \author    Conny Gustafsson
+* \date      2026-10-17
+* \brief     Benchmarks for dtl_arena
+*
+* Copyright (c) 2026 Conny Gustafsson
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench_util.h"
+#include "dtl_arena.h"
+#include "dtl_sv.h"
+#include "dtl_av.h"
+#include "dtl_hv.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define TREE_COUNT        1000u //number of request trees built and released
+#define TREE_ITEMS        250u  //hashes per tree, each hash holds 4 scalars
+#define NODES_PER_ITEM    5u
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static dtl_hv_t *build_heap_tree(uint32_t seed);
+static dtl_hv_t *build_arena_tree(dtl_arena_t *arena, uint32_t seed);
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Builds a request-sized tree from heap values and releases it through dtl_dec_ref.
+ */
+void bench_dtl_arena_tree_heap(uint32_t scale)
+{
+   uint32_t count = (uint32_t) (((uint64_t) TREE_COUNT * scale) / 100u);
+   uint32_t i;
+   double releaseTime = 0.0;
+   bench_state_t state;
+   bench_result_t result;
+
+   bench_begin(&state);
+   for (i = 0u; i < count; i++)
+   {
+      dtl_hv_t *tree = build_heap_tree(i);
+      double t0 = bench_time_now();
+      dtl_dec_ref(tree);
+      releaseTime += bench_time_now() - t0;
+   }
+   bench_end(&state, &result);
+   bench_report("tree_heap (build+release, per node)", (uint64_t) count * TREE_ITEMS * NODES_PER_ITEM, &result);
+   result.elapsedSec = releaseTime;
+   result.allocCount = 0u;
+   result.rssDelta = 0;
+   bench_report("tree_heap (release only, per node)", (uint64_t) count * TREE_ITEMS * NODES_PER_ITEM, &result);
+}
+
+/**
+ * Same tree as tree_heap, built from one arena that is reset after every tree.
+ */
+void bench_dtl_arena_tree_arena(uint32_t scale)
+{
+   uint32_t count = (uint32_t) (((uint64_t) TREE_COUNT * scale) / 100u);
+   uint32_t i;
+   double releaseTime = 0.0;
+   bench_state_t state;
+   bench_result_t result;
+   dtl_arena_t *arena = dtl_arena_new();
+   if (arena == NULL)
+   {
+      return;
+   }
+   bench_begin(&state);
+   for (i = 0u; i < count; i++)
+   {
+      double t0;
+      (void) build_arena_tree(arena, i);
+      t0 = bench_time_now();
+      dtl_arena_reset(arena);
+      releaseTime += bench_time_now() - t0;
+   }
+   bench_end(&state, &result);
+   bench_report("tree_arena (build+release, per node)", (uint64_t) count * TREE_ITEMS * NODES_PER_ITEM, &result);
+   result.elapsedSec = releaseTime;
+   result.allocCount = 0u;
+   result.rssDelta = 0;
+   bench_report("tree_arena (release only, per node)", (uint64_t) count * TREE_ITEMS * NODES_PER_ITEM, &result);
+   dtl_arena_delete(arena);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+static dtl_hv_t *build_heap_tree(uint32_t seed)
+{
+   dtl_hv_t *root = dtl_hv_new();
+   dtl_av_t *items = dtl_av_new();
+   uint32_t i;
+   for (i = 0u; i < TREE_ITEMS; i++)
+   {
+      dtl_hv_t *item = dtl_hv_new();
+      dtl_hv_set_cstr(item, "id", (dtl_dv_t*) dtl_sv_make_u32(seed + i), false);
+      dtl_hv_set_cstr(item, "price", (dtl_dv_t*) dtl_sv_make_dbl((double) i * 0.25), false);
+      dtl_hv_set_cstr(item, "active", (dtl_dv_t*) dtl_sv_make_bool((i & 1u) != 0u), false);
+      dtl_hv_set_cstr(item, "count", (dtl_dv_t*) dtl_sv_make_i32((int32_t) i), false);
+      dtl_av_push(items, (dtl_dv_t*) item, false);
+   }
+   dtl_hv_set_cstr(root, "items", (dtl_dv_t*) items, false);
+   return root;
+}
+
+static dtl_hv_t *build_arena_tree(dtl_arena_t *arena, uint32_t seed)
+{
+   dtl_hv_t *root = dtl_hv_arena_new(arena);
+   dtl_av_t *items = dtl_av_arena_new(arena);
+   uint32_t i;
+   for (i = 0u; i < TREE_ITEMS; i++)
+   {
+      dtl_hv_t *item = dtl_hv_arena_new(arena);
+      dtl_hv_set_cstr(item, "id", (dtl_dv_t*) dtl_sv_arena_make_u32(arena, seed + i), false);
+      dtl_hv_set_cstr(item, "price", (dtl_dv_t*) dtl_sv_arena_make_dbl(arena, (double) i * 0.25), false);
+      dtl_hv_set_cstr(item, "active", (dtl_dv_t*) dtl_sv_arena_make_bool(arena, (i & 1u) != 0u), false);
+      dtl_hv_set_cstr(item, "count", (dtl_dv_t*) dtl_sv_arena_make_i32(arena, (int32_t) i), false);
+      dtl_av_push(items, (dtl_dv_t*) item, false);
+   }
+   dtl_hv_set_cstr(root, "items", (dtl_dv_t*) items, false);
+   return root;
+}
@@ -0,0 +1,151 @@
+/*****************************************************************************
+* \file      bench_dtl_atom.c
+* \author    Conny Gustafsson
+* \date      2026-10-17
+* \brief     Benchmarks for dtl_atom
+*
+* Copyright (c) 2026 Conny Gustafsson
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench_util.h"
+#include "dtl_atom.h"
+#include "dtl_thread.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define ATOM_COUNT        10000000u
+#define ATOM_NUM_KEYS     300u  //a typical schema repeats a few hundred keys
+#define ATOM_NUM_THREADS  4u
+#define ATOM_KEY_LEN      32u
+
+typedef struct atom_worker_tag
+{
+   uint32_t count;
+   char (*keys)[ATOM_KEY_LEN];
+} atom_worker_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static void make_keys(char (*keys)[ATOM_KEY_LEN]);
+static dtl_thread_ret_t DTL_THREAD_CALL atom_worker(void *arg);
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Interns and releases repeated keys while one reference to every key is held, which is the steady state
+ * of a process that keeps many hashes with the same schema alive.
+ */
+void bench_dtl_atom_intern(uint32_t scale)
+{
+   uint32_t count = (uint32_t) (((uint64_t) ATOM_COUNT * scale) / 100u);
+   static char keys[ATOM_NUM_KEYS][ATOM_KEY_LEN];
+   dtl_atom_t *pinned[ATOM_NUM_KEYS];
+   atom_worker_t worker;
+   bench_state_t state;
+   bench_result_t result;
+   uint32_t i;
+
+   make_keys(keys);
+   for (i = 0u; i < ATOM_NUM_KEYS; i++)
+   {
+      pinned[i] = dtl_atom_intern(keys[i]);
+   }
+   worker.count = count;
+   worker.keys = keys;
+   bench_begin(&state);
+   (void) atom_worker(&worker);
+   bench_end(&state, &result);
+   bench_report("atom_intern (1 thread)", count, &result);
+   for (i = 0u; i < ATOM_NUM_KEYS; i++)
+   {
+      dtl_atom_release(pinned[i]);
+   }
+}
+
+void bench_dtl_atom_intern_mt(uint32_t scale)
+{
+   uint32_t count = (uint32_t) (((uint64_t) ATOM_COUNT * scale) / 100u);
+   static char keys[ATOM_NUM_KEYS][ATOM_KEY_LEN];
+   dtl_atom_t *pinned[ATOM_NUM_KEYS];
+   dtl_thread_t threads[ATOM_NUM_THREADS];
+   atom_worker_t worker;
+   bench_state_t state;
+   bench_result_t result;
+   uint32_t i;
+
+   make_keys(keys);
+   for (i = 0u; i < ATOM_NUM_KEYS; i++)
+   {
+      pinned[i] = dtl_atom_intern(keys[i]);
+   }
+   worker.count = count / ATOM_NUM_THREADS;
+   worker.keys = keys;
+   bench_begin(&state);
+   for (i = 0u; i < ATOM_NUM_THREADS; i++)
+   {
+      if (dtl_thread_create(&threads[i], atom_worker, &worker) != 0)
+      {
+         fprintf(stderr, "atom_intern_mt: failed to start thread\n");
+         exit(1);
+      }
+   }
+   for (i = 0u; i < ATOM_NUM_THREADS; i++)
+   {
+      dtl_thread_join(threads[i]);
+   }
+   bench_end(&state, &result);
+   bench_report("atom_intern (4 threads, total)", (uint64_t) worker.count * ATOM_NUM_THREADS, &result);
+   for (i = 0u; i < ATOM_NUM_KEYS; i++)
+   {
+      dtl_atom_release(pinned[i]);
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+static void make_keys(char (*keys)[ATOM_KEY_LEN])
+{
+   uint32_t i;
+   for (i = 0u; i < ATOM_NUM_KEYS; i++)
+   {
+      sprintf(keys[i], "field_name_%u", (unsigned) i);
+   }
+}
+
+static dtl_thread_ret_t DTL_THREAD_CALL atom_worker(void *arg)
+{
+   const atom_worker_t *worker = (const atom_worker_t*) arg;
+   uint32_t i;
+   for (i = 0u; i < worker->count; i++)
+   {
+      dtl_atom_t *atom = dtl_atom_intern(worker->keys[i % ATOM_NUM_KEYS]);
+      dtl_atom_release(atom);
+   }
+   return (dtl_thread_ret_t) 0;
+}
@@ -0,0 +1,212 @@
+/*****************************************************************************
+* \file      bench_dtl_bulk.c
+* \author    Conny Gustafsson
+* \date      2026-10-17
+* \brief     Benchmarks for building dtl_hv and dtl_av with a known element count
+*
+* Copyright (c) 2026 Conny Gustafsson
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench_util.h"
+#include "dtl_sv.h"
+#include "dtl_av.h"
+#include "dtl_hv.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define BULK_WORK     2000000u
+#define BULK_KEY_SIZE 16u
+
+typedef enum bulk_method_tag
+{
+   BULK_GROW,    //one insertion at a time into an empty container
+   BULK_RESERVE, //dtl_hv_reserve/dtl_av_reserve, then one insertion at a time
+   BULK_MAKE     //dtl_hv_make_from_pairs/dtl_av_make
+} bulk_method_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static void bulk_run(bool isHash, uint32_t scale);
+static void bulk_run_size(bool isHash, bulk_method_t method, uint32_t count, uint32_t work, const char *pKeys, dtl_dv_t *dv);
+static dtl_dv_t *bulk_build_hv(bulk_method_t method, uint32_t count, const char *pKeys, dtl_dv_t *dv, dtl_hv_pair_t *pPairs);
+static dtl_dv_t *bulk_build_av(bulk_method_t method, uint32_t count, dtl_dv_t *dv, dtl_dv_t **ppValues);
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+static const char *m_methodNames[3] = {"grow", "reserve", "make"};
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Builds hashes of 1K and 1M entries key by key, after dtl_hv_reserve and with dtl_hv_make_from_pairs.
+ */
+void bench_dtl_bulk_hv(uint32_t scale)
+{
+   bulk_run(true, scale);
+}
+
+/**
+ * Builds arrays of 1K and 1M values by pushing, after dtl_av_reserve and with dtl_av_make.
+ */
+void bench_dtl_bulk_av(uint32_t scale)
+{
+   bulk_run(false, scale);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+static void bulk_run(bool isHash, uint32_t scale)
+{
+   uint32_t sizes[2];
+   uint32_t work = (uint32_t) (((uint64_t) BULK_WORK * scale) / 100u);
+   uint32_t i;
+   char *pKeys = (char*) 0;
+   dtl_dv_t *dv = (dtl_dv_t*) dtl_sv_make_i32(1);
+   sizes[0] = 1000u;
+   sizes[1] = (uint32_t) (((uint64_t) 1000000u * scale) / 100u);
+   if (sizes[1] < sizes[0])
+   {
+      sizes[1] = sizes[0];
+   }
+   if (work < sizes[1])
+   {
+      work = sizes[1];
+   }
+   if (isHash)
+   {
+      pKeys = (char*) malloc((size_t) sizes[1] * BULK_KEY_SIZE);
+      if (pKeys == 0)
+      {
+         dtl_dec_ref(dv);
+         return;
+      }
+      for (i = 0u; i < sizes[1]; i++)
+      {
+         sprintf(&pKeys[i * BULK_KEY_SIZE], "field%u", i);
+      }
+   }
+   for (i = 0u; i < 2u; i++)
+   {
+      bulk_run_size(isHash, BULK_GROW, sizes[i], work, pKeys, dv);
+      bulk_run_size(isHash, BULK_RESERVE, sizes[i], work, pKeys, dv);
+      bulk_run_size(isHash, BULK_MAKE, sizes[i], work, pKeys, dv);
+   }
+   free(pKeys);
+   dtl_dec_ref(dv);
+}
+
+/**
+ * Builds work/count containers of count elements. Every element refers to dv, the references that dtl_hv_make_from_pairs
+ * and dtl_av_make take over are added before the clock starts. The containers are released after it stops.
+ */
+static void bulk_run_size(bool isHash, bulk_method_t method, uint32_t count, uint32_t work, const char *pKeys, dtl_dv_t *dv)
+{
+   uint32_t rounds = work / count;
+   uint32_t round;
+   uint32_t i;
+   char name[64];
+   dtl_dv_t **ppContainers = (dtl_dv_t**) malloc(rounds * sizeof(dtl_dv_t*));
+   dtl_hv_pair_t *pPairs = (dtl_hv_pair_t*) malloc(count * sizeof(dtl_hv_pair_t));
+   dtl_dv_t **ppValues = (dtl_dv_t**) malloc(count * sizeof(dtl_dv_t*));
+   bench_state_t state;
+   bench_result_t result;
+   if ( (ppContainers != 0) && (pPairs != 0) && (ppValues != 0) )
+   {
+      for (i = 0u; i < count; i++)
+      {
+         pPairs[i].pKey = &pKeys[i * BULK_KEY_SIZE];
+         pPairs[i].dv = dv;
+         ppValues[i] = dv;
+      }
+      if (method == BULK_MAKE)
+      {
+         for (i = 0u; i < rounds * count; i++)
+         {
+            dtl_dv_inc_ref(dv);
+         }
+      }
+      bench_begin(&state);
+      for (round = 0u; round < rounds; round++)
+      {
+         ppContainers[round] = isHash? bulk_build_hv(method, count, pKeys, dv, pPairs) : bulk_build_av(method, count, dv, ppValues);
+      }
+      bench_mark(&state);
+      bench_end(&state, &result);
+      sprintf(name, "bulk_%s %s n=%u", isHash? "hv" : "av", m_methodNames[method], count);
+      bench_report(name, (uint64_t) rounds * count, &result);
+      for (round = 0u; round < rounds; round++)
+      {
+         dtl_dec_ref(ppContainers[round]);
+      }
+   }
+   free(ppContainers);
+   free(pPairs);
+   free(ppValues);
+}
+
+static dtl_dv_t *bulk_build_hv(bulk_method_t method, uint32_t count, const char *pKeys, dtl_dv_t *dv, dtl_hv_pair_t *pPairs)
+{
+   dtl_hv_t *hv;
+   uint32_t i;
+   if (method == BULK_MAKE)
+   {
+      return (dtl_dv_t*) dtl_hv_make_from_pairs(pPairs, count);
+   }
+   hv = dtl_hv_new();
+   if (method == BULK_RESERVE)
+   {
+      (void) dtl_hv_reserve(hv, count);
+   }
+   for (i = 0u; i < count; i++)
+   {
+      dtl_hv_set_cstr(hv, &pKeys[i * BULK_KEY_SIZE], dv, true);
+   }
+   return (dtl_dv_t*) hv;
+}
+
+static dtl_dv_t *bulk_build_av(bulk_method_t method, uint32_t count, dtl_dv_t *dv, dtl_dv_t **ppValues)
+{
+   dtl_av_t *av;
+   uint32_t i;
+   if (method == BULK_MAKE)
+   {
+      return (dtl_dv_t*) dtl_av_make(ppValues, (int32_t) count);
+   }
+   av = dtl_av_new();
+   if (method == BULK_RESERVE)
+   {
+      (void) dtl_av_reserve(av, (int32_t) count);
+   }
+   for (i = 0u; i < count; i++)
+   {
+      dtl_av_push(av, dv, true);
+   }
+   return (dtl_dv_t*) av;
+}
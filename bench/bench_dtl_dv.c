@@ -0,0 +1,263 @@
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench_util.h"
+#include "dtl_sv.h"
+#include "dtl_av.h"
+#include "dtl_hv.h"
+#include "dtl_thread.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define DV_REFCNT_COUNT       100000000u //inc_ref/dec_ref pairs
+#define DV_REFCNT_VALUES      1024u      //values are visited round-robin, all stay in cache
+#define DV_REFCNT_NUM_THREADS 4u
+#define DV_TREE_RECORDS       100000u    //each record is a hash with 4 scalars and an array of 4 scalars (10 values)
+#define DV_RECLAIM_BUDGET     10000u     //values freed per dtl_reclaim call in deferred mode
+#define DV_RESPONSES          20000u     //responses built and released in the dv_release benchmarks
+#define DV_RESPONSE_RECORDS   100u       //records per response (about 1000 values)
+
+typedef struct refcnt_worker_tag
+{
+   uint32_t count;
+   dtl_sv_t **values;
+} refcnt_worker_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static void dv_refcnt(uint32_t scale, bool atomic, uint32_t numThreads, const char *name);
+static dtl_thread_ret_t DTL_THREAD_CALL refcnt_worker(void *arg);
+static dtl_av_t *dv_make_tree(uint32_t numRecords);
+static void dv_release(uint32_t scale, bool useReclaimer, const char *name);
+static int dv_compare_double(const void *a, const void *b);
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * dtl_dv_inc_ref/dtl_dv_dec_ref pairs on plain values. In a DTL_TYPE_ATOMIC_REFCNT build all values are atomic.
+ */
+void bench_dtl_dv_refcnt_plain(uint32_t scale)
+{
+   dv_refcnt(scale, false, 1u, "dv_refcnt (plain, 1 thread)");
+}
+
+/**
+ * Same as bench_dtl_dv_refcnt_plain on values marked with dtl_dv_set_atomic.
+ * In a DTL_TYPE_BIASED_REFCNT build dtl_dv_set_atomic does nothing, this measures the owner thread path
+ * and bench_dtl_dv_refcnt_atomic_mt the shared count used by other threads.
+ */
+void bench_dtl_dv_refcnt_atomic(uint32_t scale)
+{
+   dv_refcnt(scale, true, 1u, "dv_refcnt (atomic, 1 thread)");
+}
+
+/**
+ * Atomic values shared by DV_REFCNT_NUM_THREADS threads that all take and drop references to the same values.
+ */
+void bench_dtl_dv_refcnt_atomic_mt(uint32_t scale)
+{
+   dv_refcnt(scale, true, DV_REFCNT_NUM_THREADS, "dv_refcnt (atomic, 4 threads, total)");
+}
+
+/**
+ * Time spent in the single dtl_dec_ref call that releases a tree of about one million values.
+ */
+void bench_dtl_dv_destroy_tree(uint32_t scale)
+{
+   uint32_t numRecords = (uint32_t) (((uint64_t) DV_TREE_RECORDS * scale) / 100u);
+   bench_state_t state;
+   bench_result_t result;
+   dtl_av_t *tree = dv_make_tree(numRecords);
+   bench_begin(&state);
+   dtl_dec_ref(tree);
+   bench_end(&state, &result);
+   bench_report("dv_destroy_tree (one call)", (uint64_t) numRecords * 10u + 1u, &result);
+}
+
+/**
+ * Same tree released in deferred mode and freed with dtl_reclaim(DV_RECLAIM_BUDGET) calls,
+ * the longest call is what an event loop would see as its pause time.
+ */
+void bench_dtl_dv_destroy_tree_deferred(uint32_t scale)
+{
+   uint32_t numRecords = (uint32_t) (((uint64_t) DV_TREE_RECORDS * scale) / 100u);
+   uint32_t numCalls = 0u;
+   double maxPause = 0.0;
+   bench_state_t state;
+   bench_result_t result;
+   dtl_av_t *tree = dv_make_tree(numRecords);
+   dtl_reclaim_set_deferred(true);
+   bench_begin(&state);
+   dtl_dec_ref(tree);
+   while (dtl_reclaim_pending() > 0u)
+   {
+      double start = bench_time_now();
+      double elapsed;
+      (void) dtl_reclaim(DV_RECLAIM_BUDGET);
+      elapsed = bench_time_now() - start;
+      if (elapsed > maxPause)
+      {
+         maxPause = elapsed;
+      }
+      numCalls++;
+   }
+   bench_end(&state, &result);
+   dtl_reclaim_set_deferred(false);
+   bench_report("dv_destroy_tree (deferred, total)", (uint64_t) numRecords * 10u + 1u, &result);
+   printf("   %u dtl_reclaim calls, longest %.3f ms\n", (unsigned) numCalls, maxPause * 1000.0);
+}
+
+/**
+ * A request handler that builds a response tree of DV_RESPONSE_RECORDS records (about 1000 values) and releases it.
+ * Reports the release time seen by the handler, freeing done by the reclaimer thread is not included.
+ */
+void bench_dtl_dv_release_inline(uint32_t scale)
+{
+   dv_release(scale, false, "dv_release (inline, per response)");
+}
+
+void bench_dtl_dv_release_reclaimer(uint32_t scale)
+{
+   dv_release(scale, true, "dv_release (reclaimer, per response)");
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+static void dv_refcnt(uint32_t scale, bool atomic, uint32_t numThreads, const char *name)
+{
+   uint32_t count = (uint32_t) (((uint64_t) DV_REFCNT_COUNT * scale) / 100u);
+   dtl_sv_t *values[DV_REFCNT_VALUES];
+   dtl_thread_t threads[DV_REFCNT_NUM_THREADS];
+   refcnt_worker_t worker;
+   bench_state_t state;
+   bench_result_t result;
+   uint32_t i;
+
+   for (i = 0u; i < DV_REFCNT_VALUES; i++)
+   {
+      values[i] = dtl_sv_make_i32((int32_t) i + 1000);
+      if (atomic)
+      {
+         dtl_dv_set_atomic((dtl_dv_t*) values[i]);
+      }
+   }
+   worker.count = count / numThreads;
+   worker.values = values;
+   bench_begin(&state);
+   if (numThreads == 1u)
+   {
+      (void) refcnt_worker(&worker);
+   }
+   else
+   {
+      for (i = 0u; i < numThreads; i++)
+      {
+         if (dtl_thread_create(&threads[i], refcnt_worker, &worker) != 0)
+         {
+            fprintf(stderr, "dv_refcnt: failed to start thread\n");
+            exit(1);
+         }
+      }
+      for (i = 0u; i < numThreads; i++)
+      {
+         dtl_thread_join(threads[i]);
+      }
+   }
+   bench_end(&state, &result);
+   bench_report(name, (uint64_t) worker.count * numThreads, &result);
+   for (i = 0u; i < DV_REFCNT_VALUES; i++)
+   {
+      dtl_dec_ref(values[i]);
+   }
+}
+
+static dtl_thread_ret_t DTL_THREAD_CALL refcnt_worker(void *arg)
+{
+   const refcnt_worker_t *worker = (const refcnt_worker_t*) arg;
+   uint32_t i;
+   for (i = 0u; i < worker->count; i++)
+   {
+      dtl_dv_t *dv = (dtl_dv_t*) worker->values[i & (DV_REFCNT_VALUES - 1u)];
+      dtl_dv_inc_ref(dv);
+      dtl_dv_dec_ref(dv);
+   }
+   return (dtl_thread_ret_t) 0;
+}
+
+static void dv_release(uint32_t scale, bool useReclaimer, const char *name)
+{
+   uint32_t numResponses = (uint32_t) (((uint64_t) DV_RESPONSES * scale) / 100u);
+   double *pauses;
+   double total = 0.0;
+   uint32_t i;
+   if (numResponses == 0u)
+   {
+      numResponses = 1u;
+   }
+   pauses = (double*) malloc(sizeof(double) * numResponses);
+   if ( (pauses == NULL) || (useReclaimer && (!dtl_reclaimer_start())) )
+   {
+      fprintf(stderr, "%s: not available\n", name);
+      free(pauses);
+      return;
+   }
+   for (i = 0u; i < numResponses; i++)
+   {
+      dtl_av_t *response = dv_make_tree(DV_RESPONSE_RECORDS);
+      double start = bench_time_now();
+      dtl_dec_ref(response);
+      pauses[i] = bench_time_now() - start;
+      total += pauses[i];
+   }
+   if (useReclaimer)
+   {
+      dtl_reclaimer_stats_t stats;
+      (void) dtl_reclaimer_stats(&stats);
+      dtl_reclaimer_flush();
+      dtl_reclaimer_stop();
+      printf("   reclaimer: max queue depth %u, %.1f MB freed\n", (unsigned) stats.u32MaxQueueDepth,
+         (double) stats.u64NumBytes / (1024.0 * 1024.0));
+   }
+   qsort(pauses, numResponses, sizeof(double), dv_compare_double);
+   printf("%-40s %8u ops   mean %8.2f us   min %8.2f us   p50 %8.2f us   p99 %8.2f us   max %8.2f us\n", name,
+      (unsigned) numResponses, total * 1e6 / numResponses, pauses[0] * 1e6, pauses[numResponses / 2u] * 1e6, pauses[(numResponses * 99u) / 100u] * 1e6,
+      pauses[numResponses - 1u] * 1e6);
+   free(pauses);
+}
+
+static int dv_compare_double(const void *a, const void *b)
+{
+   double lhs = *(const double*) a;
+   double rhs = *(const double*) b;
+   return (lhs < rhs)? -1 : ((lhs > rhs)? 1 : 0);
+}
+
+static dtl_av_t *dv_make_tree(uint32_t numRecords)
+{
+   dtl_av_t *tree = dtl_av_new();
+   uint32_t i;
+   for (i = 0u; i < numRecords; i++)
+   {
+      dtl_hv_t *record = dtl_hv_new();
+      dtl_av_t *samples = dtl_av_new();
+      int32_t j;
+      dtl_hv_set_cstr(record, "id", (dtl_dv_t*) dtl_sv_make_u32(i), false);
+      dtl_hv_set_cstr(record, "name", (dtl_dv_t*) dtl_sv_make_cstr("sensor"), false);
+      dtl_hv_set_cstr(record, "value", (dtl_dv_t*) dtl_sv_make_dbl(i * 0.5), false);
+      dtl_hv_set_cstr(record, "ok", (dtl_dv_t*) dtl_sv_make_i32(1000), false);
+      for (j = 0; j < 4; j++)
+      {
+         dtl_av_push(samples, (dtl_dv_t*) dtl_sv_make_i32(j + 1000), false);
+      }
+      dtl_hv_set_cstr(record, "samples", (dtl_dv_t*) samples, false);
+      dtl_av_push(tree, (dtl_dv_t*) record, false);
+   }
+   return tree;
+}
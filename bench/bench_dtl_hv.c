@@ -0,0 +1,370 @@
+/*****************************************************************************
+* \file      bench_dtl_hv.c
+* \author    Conny Gustafsson
+* \date      2026-10-17
+* \brief     Benchmarks for dtl_hv
+*
+* Copyright (c) 2026 Conny Gustafsson
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench_util.h"
+#include "adt_hash.h"
+#include "dtl_sv.h"
+#include "dtl_av.h"
+#include "dtl_hv.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define HV_RECORDS_COUNT  1000000u
+#define HV_RECORDS_FIELDS 4u
+#define HV_TABLE_WORK     2000000u
+#define HV_TABLE_KEY_SIZE 24u
+#define HV_KEY_LOOKUPS    4000000u
+
+//the operations of one hash table backend; the table benchmarks run the same work against each
+typedef struct hv_table_ops_tag
+{
+   const char *name;
+   void *(*create)(void);
+   void (*destroy)(void *table);
+   void (*insert)(void *table, const char *pKey, dtl_dv_t *dv);
+   dtl_dv_t *(*lookup)(void *table, const char *pKey);
+   uint32_t (*iterate)(void *table);
+} hv_table_ops_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static void hv_table_run(const hv_table_ops_t *ops, uint32_t scale);
+static void hv_table_run_size(const hv_table_ops_t *ops, uint32_t numKeys, uint32_t work, const char *pKeys, dtl_dv_t *dv);
+static void *dtl_table_create(void);
+static void dtl_table_destroy(void *table);
+static void dtl_table_insert(void *table, const char *pKey, dtl_dv_t *dv);
+static dtl_dv_t *dtl_table_lookup(void *table, const char *pKey);
+static uint32_t dtl_table_iterate(void *table);
+static void *adt_table_create(void);
+static void adt_table_destroy(void *table);
+static void adt_table_insert(void *table, const char *pKey, dtl_dv_t *dv);
+static dtl_dv_t *adt_table_lookup(void *table, const char *pKey);
+static uint32_t adt_table_iterate(void *table);
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+static const hv_table_ops_t m_dtlTableOps = {"hv_table", dtl_table_create, dtl_table_destroy, dtl_table_insert, dtl_table_lookup, dtl_table_iterate};
+static const hv_table_ops_t m_adtTableOps = {"hv_table_adt", adt_table_create, adt_table_destroy, adt_table_insert, adt_table_lookup, adt_table_iterate};
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Record decode: an array of small hashes (the most common shape of decoded messages) is built, walked and released.
+ */
+void bench_dtl_hv_records(uint32_t scale)
+{
+   static const char *keys[HV_RECORDS_FIELDS] = {"id", "x", "y", "z"};
+   uint32_t count = (uint32_t) (((uint64_t) HV_RECORDS_COUNT * scale) / 100u);
+   uint32_t i;
+   int64_t sum = 0;
+   bench_state_t state;
+   bench_result_t result;
+   dtl_av_t *records = dtl_av_new();
+
+   bench_begin(&state);
+   for (i = 0u; i < count; i++)
+   {
+      dtl_hv_t *hv = dtl_hv_new();
+      uint32_t j;
+      for (j = 0u; j < HV_RECORDS_FIELDS; j++)
+      {
+         dtl_hv_set_cstr(hv, keys[j], (dtl_dv_t*) dtl_sv_make_i32((int32_t) (i + j)), false);
+      }
+      dtl_av_push(records, (dtl_dv_t*) hv, false);
+   }
+   bench_mark(&state);
+   for (i = 0u; i < count; i++)
+   {
+      dtl_hv_t *hv = (dtl_hv_t*) dtl_av_value(records, (int32_t) i);
+      sum += dtl_sv_to_i32((dtl_sv_t*) dtl_hv_get_cstr(hv, keys[1]), NULL);
+   }
+   dtl_dec_ref(records);
+   bench_end(&state, &result);
+   if (sum == 0)
+   {
+      printf("unexpected checksum\n");
+   }
+   bench_report("hv_records (4 fields)", count, &result);
+}
+
+/**
+ * Insert, lookup and iterate on dtl_hv_t at 8, 1K and 1M entries.
+ */
+void bench_dtl_hv_table(uint32_t scale)
+{
+   hv_table_run(&m_dtlTableOps, scale);
+}
+
+/**
+ * The same work as hv_table against a bare adt_hash_t, the backend dtl_hv_t used before dtl_htab_t.
+ */
+void bench_dtl_hv_table_adt(uint32_t scale)
+{
+   hv_table_run(&m_adtTableOps, scale);
+}
+
+/**
+ * Looks up record fields by NUL-terminated key, by key slice and by key slice with a hash computed once up front.
+ */
+void bench_dtl_hv_key_lookup(uint32_t scale)
+{
+   static const char *keys[HV_RECORDS_FIELDS] = {"timestamp", "sensor/identifier", "value", "unit"};
+   const uint8_t *pBegin[HV_RECORDS_FIELDS];
+   const uint8_t *pEnd[HV_RECORDS_FIELDS];
+   uint32_t hashes[HV_RECORDS_FIELDS];
+   uint32_t count = (uint32_t) (((uint64_t) HV_KEY_LOOKUPS * scale) / 100u);
+   uint32_t i;
+   int64_t sum = 0;
+   bench_state_t state;
+   bench_result_t result;
+   dtl_hv_t *hv = dtl_hv_new();
+   for (i = 0u; i < HV_RECORDS_FIELDS; i++)
+   {
+      pBegin[i] = (const uint8_t*) keys[i];
+      pEnd[i] = pBegin[i] + strlen(keys[i]);
+      hashes[i] = dtl_key_hash(pBegin[i], pEnd[i]);
+      dtl_hv_set_cstr(hv, keys[i], (dtl_dv_t*) dtl_sv_make_i32((int32_t) i + 1), false);
+   }
+
+   bench_begin(&state);
+   for (i = 0u; i < count; i++)
+   {
+      sum += dtl_sv_to_i32((dtl_sv_t*) dtl_hv_get_cstr(hv, keys[i % HV_RECORDS_FIELDS]), NULL);
+   }
+   bench_end(&state, &result);
+   bench_report("hv_key_lookup cstr", count, &result);
+
+   bench_begin(&state);
+   for (i = 0u; i < count; i++)
+   {
+      uint32_t j = i % HV_RECORDS_FIELDS;
+      sum += dtl_sv_to_i32((dtl_sv_t*) dtl_hv_get_bstr(hv, pBegin[j], pEnd[j]), NULL);
+   }
+   bench_end(&state, &result);
+   bench_report("hv_key_lookup bstr", count, &result);
+
+   bench_begin(&state);
+   for (i = 0u; i < count; i++)
+   {
+      uint32_t j = i % HV_RECORDS_FIELDS;
+      sum += dtl_sv_to_i32((dtl_sv_t*) dtl_hv_get_hashed(hv, pBegin[j], pEnd[j], hashes[j]), NULL);
+   }
+   bench_end(&state, &result);
+   bench_report("hv_key_lookup hashed", count, &result);
+
+   dtl_dec_ref(hv);
+   if (sum == 0)
+   {
+      printf("unexpected checksum\n");
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+static void hv_table_run(const hv_table_ops_t *ops, uint32_t scale)
+{
+   uint32_t sizes[3];
+   uint32_t work = (uint32_t) (((uint64_t) HV_TABLE_WORK * scale) / 100u);
+   uint32_t i;
+   char *pKeys;
+   dtl_dv_t *dv = (dtl_dv_t*) dtl_sv_make_i32(1);
+   sizes[0] = 8u;
+   sizes[1] = 1024u;
+   sizes[2] = (uint32_t) (((uint64_t) 1000000u * scale) / 100u);
+   if (sizes[2] < 1u)
+   {
+      sizes[2] = 1u;
+   }
+   if (work < sizes[2])
+   {
+      work = sizes[2];
+   }
+   //keys are generated up front so that only the table work is timed
+   pKeys = (char*) malloc((size_t) sizes[2] * HV_TABLE_KEY_SIZE);
+   if (pKeys == NULL)
+   {
+      dtl_dec_ref(dv);
+      return;
+   }
+   bench_rand_seed(18u);
+   for (i = 0u; i < sizes[2]; i++)
+   {
+      //mixes short record field names with longer path-like keys
+      if ( (i % 4u) == 3u)
+      {
+         sprintf(&pKeys[i * HV_TABLE_KEY_SIZE], "cfg/item/%08x", bench_rand_u32());
+      }
+      else
+      {
+         sprintf(&pKeys[i * HV_TABLE_KEY_SIZE], "f%u", i);
+      }
+   }
+   for (i = 0u; i < 3u; i++)
+   {
+      hv_table_run_size(ops, (sizes[i] < sizes[2])? sizes[i] : sizes[2], work, pKeys, dv);
+   }
+   free(pKeys);
+   dtl_dec_ref(dv);
+}
+
+static void hv_table_run_size(const hv_table_ops_t *ops, uint32_t numKeys, uint32_t work, const char *pKeys, dtl_dv_t *dv)
+{
+   uint32_t rounds = work / numKeys;
+   uint32_t round;
+   uint32_t i;
+   uint64_t hits = 0u;
+   char name[64];
+   void **tables;
+   bench_state_t state;
+   bench_result_t result;
+   tables = (void**) malloc(rounds * sizeof(void*));
+   if (tables == NULL)
+   {
+      return;
+   }
+   bench_begin(&state);
+   for (round = 0u; round < rounds; round++)
+   {
+      tables[round] = ops->create();
+      for (i = 0u; i < numKeys; i++)
+      {
+         ops->insert(tables[round], &pKeys[i * HV_TABLE_KEY_SIZE], dv);
+      }
+   }
+   bench_mark(&state);
+   bench_end(&state, &result);
+   sprintf(name, "%s insert n=%u", ops->name, numKeys);
+   bench_report(name, (uint64_t) rounds * numKeys, &result);
+
+   bench_begin(&state);
+   for (round = 0u; round < rounds; round++)
+   {
+      for (i = 0u; i < numKeys; i++)
+      {
+         //walks the keys in a scattered order so that large tables miss in cache as they would in real use
+         uint32_t k = (uint32_t) (((uint64_t) i * 2654435761u) % numKeys);
+         hits += (ops->lookup(tables[round], &pKeys[k * HV_TABLE_KEY_SIZE]) == dv)? 1u : 0u;
+      }
+   }
+   bench_end(&state, &result);
+   sprintf(name, "%s lookup n=%u", ops->name, numKeys);
+   bench_report(name, (uint64_t) rounds * numKeys, &result);
+
+   bench_begin(&state);
+   for (round = 0u; round < rounds; round++)
+   {
+      hits += ops->iterate(tables[round]);
+   }
+   bench_end(&state, &result);
+   sprintf(name, "%s iterate n=%u", ops->name, numKeys);
+   bench_report(name, (uint64_t) rounds * numKeys, &result);
+
+   for (round = 0u; round < rounds; round++)
+   {
+      ops->destroy(tables[round]);
+   }
+   free(tables);
+   if (hits != (uint64_t) rounds * numKeys * 2u)
+   {
+      printf("unexpected checksum\n");
+   }
+}
+
+static void *dtl_table_create(void)
+{
+   return dtl_hv_new();
+}
+
+static void dtl_table_destroy(void *table)
+{
+   dtl_dec_ref(table);
+}
+
+static void dtl_table_insert(void *table, const char *pKey, dtl_dv_t *dv)
+{
+   dtl_hv_set_cstr((dtl_hv_t*) table, pKey, dv, true);
+}
+
+static dtl_dv_t *dtl_table_lookup(void *table, const char *pKey)
+{
+   return dtl_hv_get_cstr((const dtl_hv_t*) table, pKey);
+}
+
+static uint32_t dtl_table_iterate(void *table)
+{
+   dtl_hv_iter_t iter;
+   uint32_t count = 0u;
+   dtl_hv_iter_begin((const dtl_hv_t*) table, &iter);
+   while (dtl_hv_iter_next(&iter))
+   {
+      count += (iter.pKey[0] != 0)? 1u : 0u;
+   }
+   return count;
+}
+
+static void *adt_table_create(void)
+{
+   return adt_hash_new(NULL);
+}
+
+static void adt_table_destroy(void *table)
+{
+   adt_hash_delete((adt_hash_t*) table);
+}
+
+static void adt_table_insert(void *table, const char *pKey, dtl_dv_t *dv)
+{
+   adt_hash_set((adt_hash_t*) table, pKey, dv);
+}
+
+static dtl_dv_t *adt_table_lookup(void *table, const char *pKey)
+{
+   void **ppVal = adt_hash_get((const adt_hash_t*) table, pKey);
+   return (ppVal != NULL)? (dtl_dv_t*) *ppVal : NULL;
+}
+
+static uint32_t adt_table_iterate(void *table)
+{
+   const char *pKey = NULL;
+   uint32_t count = 0u;
+   adt_hash_iter_init((adt_hash_t*) table);
+   while (adt_hash_iter_next((adt_hash_t*) table, &pKey) != NULL)
+   {
+      count += (pKey[0] != 0)? 1u : 0u;
+   }
+   return count;
+}
@@ -0,0 +1,302 @@
+/*****************************************************************************
+* \file      bench_dtl_persistent.c
+* \author    Conny Gustafsson
+* \date      2026-10-17
+* \brief     Benchmarks for persistent values versus copying mutable containers
+*
+* Copyright (c) 2026 Conny Gustafsson
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench_util.h"
+#include "dtl_sv.h"
+#include "dtl_av.h"
+#include "dtl_hv.h"
+#include "dtl_phv.h"
+#include "dtl_pav.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define PERSISTENT_NUM_SIZES 3u
+#define PERSISTENT_UPDATES   2000u  //new versions made at each size, each update keeps the previous version readable
+#define PERSISTENT_LOOKUPS   1000000u
+#define PERSISTENT_COPY_WORK 200000u //entries copied by the copy benchmarks at each size, every copy touches all entries
+
+static const uint32_t m_sizes[PERSISTENT_NUM_SIZES] = {100u, 10000u, 100000u};
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static dtl_hv_t *hv_copy(const dtl_hv_t *hv);
+static dtl_av_t *av_copy(const dtl_av_t *av);
+static uint32_t scaled(uint32_t count, uint32_t scale);
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Snapshot updates on a persistent hash: every update returns a new version that shares all untouched trie nodes.
+ */
+void bench_dtl_persistent_phv(uint32_t scale)
+{
+   uint32_t s;
+   for (s = 0u; s < PERSISTENT_NUM_SIZES; s++)
+   {
+      uint32_t size = m_sizes[s];
+      uint32_t updates = scaled(PERSISTENT_UPDATES, scale);
+      uint32_t lookups = scaled(PERSISTENT_LOOKUPS, scale);
+      uint32_t i;
+      int64_t sum = 0;
+      char key[16];
+      char name[64];
+      bench_state_t state;
+      bench_result_t result;
+      dtl_phv_t *phv = dtl_phv_new();
+      for (i = 0u; i < size; i++)
+      {
+         dtl_phv_t *version;
+         sprintf(key, "k%u", i);
+         version = dtl_phv_set_cstr(phv, key, (dtl_dv_t*) dtl_sv_make_i32((int32_t) i), false);
+         dtl_dec_ref(phv);
+         phv = version;
+      }
+
+      bench_begin(&state);
+      for (i = 0u; i < updates; i++)
+      {
+         dtl_phv_t *version;
+         sprintf(key, "k%u", bench_rand_u32() % size);
+         version = dtl_phv_set_cstr(phv, key, (dtl_dv_t*) dtl_sv_make_i32((int32_t) i), false);
+         dtl_dec_ref(phv);
+         phv = version;
+      }
+      bench_end(&state, &result);
+      sprintf(name, "persistent_phv update (n=%u)", size);
+      bench_report(name, updates, &result);
+
+      bench_begin(&state);
+      for (i = 0u; i < lookups; i++)
+      {
+         sprintf(key, "k%u", i % size);
+         sum += dtl_sv_to_i32((dtl_sv_t*) dtl_phv_get_cstr(phv, key), NULL);
+      }
+      bench_end(&state, &result);
+      sprintf(name, "persistent_phv get (n=%u)", size);
+      bench_report(name, lookups, &result);
+      if (sum == 0)
+      {
+         printf("unexpected checksum\n");
+      }
+      dtl_dec_ref(phv);
+   }
+}
+
+/**
+ * The same snapshot updates on a mutable hash, which has to be copied before every change.
+ */
+void bench_dtl_persistent_hv_copy(uint32_t scale)
+{
+   uint32_t s;
+   for (s = 0u; s < PERSISTENT_NUM_SIZES; s++)
+   {
+      uint32_t size = m_sizes[s];
+      uint32_t updates = scaled(PERSISTENT_COPY_WORK / size, scale);
+      uint32_t lookups = scaled(PERSISTENT_LOOKUPS, scale);
+      uint32_t i;
+      int64_t sum = 0;
+      char key[16];
+      char name[64];
+      bench_state_t state;
+      bench_result_t result;
+      dtl_hv_t *hv = dtl_hv_new();
+      for (i = 0u; i < size; i++)
+      {
+         sprintf(key, "k%u", i);
+         dtl_hv_set_cstr(hv, key, (dtl_dv_t*) dtl_sv_make_i32((int32_t) i), false);
+      }
+
+      bench_begin(&state);
+      for (i = 0u; i < updates; i++)
+      {
+         dtl_hv_t *version = hv_copy(hv);
+         sprintf(key, "k%u", bench_rand_u32() % size);
+         dtl_hv_set_cstr(version, key, (dtl_dv_t*) dtl_sv_make_i32((int32_t) i), false);
+         dtl_dec_ref(hv);
+         hv = version;
+      }
+      bench_end(&state, &result);
+      sprintf(name, "persistent_hv_copy update (n=%u)", size);
+      bench_report(name, updates, &result);
+
+      bench_begin(&state);
+      for (i = 0u; i < lookups; i++)
+      {
+         sprintf(key, "k%u", i % size);
+         sum += dtl_sv_to_i32((dtl_sv_t*) dtl_hv_get_cstr(hv, key), NULL);
+      }
+      bench_end(&state, &result);
+      sprintf(name, "persistent_hv_copy get (n=%u)", size);
+      bench_report(name, lookups, &result);
+      if (sum == 0)
+      {
+         printf("unexpected checksum\n");
+      }
+      dtl_dec_ref(hv);
+   }
+}
+
+/**
+ * Snapshot updates on a persistent array: random element updates and reads.
+ */
+void bench_dtl_persistent_pav(uint32_t scale)
+{
+   uint32_t s;
+   for (s = 0u; s < PERSISTENT_NUM_SIZES; s++)
+   {
+      uint32_t size = m_sizes[s];
+      uint32_t updates = scaled(PERSISTENT_UPDATES, scale);
+      uint32_t lookups = scaled(PERSISTENT_LOOKUPS, scale);
+      uint32_t i;
+      int64_t sum = 0;
+      char name[64];
+      bench_state_t state;
+      bench_result_t result;
+      dtl_pav_t *pav = dtl_pav_new();
+      for (i = 0u; i < size; i++)
+      {
+         dtl_pav_t *version = dtl_pav_push(pav, (dtl_dv_t*) dtl_sv_make_i32((int32_t) i), false);
+         dtl_dec_ref(pav);
+         pav = version;
+      }
+
+      bench_begin(&state);
+      for (i = 0u; i < updates; i++)
+      {
+         dtl_pav_t *version = dtl_pav_set(pav, (int32_t) (bench_rand_u32() % size), (dtl_dv_t*) dtl_sv_make_i32((int32_t) i), false);
+         dtl_dec_ref(pav);
+         pav = version;
+      }
+      bench_end(&state, &result);
+      sprintf(name, "persistent_pav update (n=%u)", size);
+      bench_report(name, updates, &result);
+
+      bench_begin(&state);
+      for (i = 0u; i < lookups; i++)
+      {
+         sum += dtl_sv_to_i32((dtl_sv_t*) dtl_pav_value(pav, (int32_t) (i % size)), NULL);
+      }
+      bench_end(&state, &result);
+      sprintf(name, "persistent_pav get (n=%u)", size);
+      bench_report(name, lookups, &result);
+      if (sum == 0)
+      {
+         printf("unexpected checksum\n");
+      }
+      dtl_dec_ref(pav);
+   }
+}
+
+/**
+ * The same snapshot updates on a mutable array, which has to be copied before every change.
+ */
+void bench_dtl_persistent_av_copy(uint32_t scale)
+{
+   uint32_t s;
+   for (s = 0u; s < PERSISTENT_NUM_SIZES; s++)
+   {
+      uint32_t size = m_sizes[s];
+      uint32_t updates = scaled(PERSISTENT_COPY_WORK / size, scale);
+      uint32_t lookups = scaled(PERSISTENT_LOOKUPS, scale);
+      uint32_t i;
+      int64_t sum = 0;
+      char name[64];
+      bench_state_t state;
+      bench_result_t result;
+      dtl_av_t *av = dtl_av_new();
+      for (i = 0u; i < size; i++)
+      {
+         dtl_av_push(av, (dtl_dv_t*) dtl_sv_make_i32((int32_t) i), false);
+      }
+
+      bench_begin(&state);
+      for (i = 0u; i < updates; i++)
+      {
+         dtl_av_t *version = av_copy(av);
+         dtl_av_set(version, (int32_t) (bench_rand_u32() % size), (dtl_dv_t*) dtl_sv_make_i32((int32_t) i));
+         dtl_dec_ref(av);
+         av = version;
+      }
+      bench_end(&state, &result);
+      sprintf(name, "persistent_av_copy update (n=%u)", size);
+      bench_report(name, updates, &result);
+
+      bench_begin(&state);
+      for (i = 0u; i < lookups; i++)
+      {
+         sum += dtl_sv_to_i32((dtl_sv_t*) dtl_av_value(av, (int32_t) (i % size)), NULL);
+      }
+      bench_end(&state, &result);
+      sprintf(name, "persistent_av_copy get (n=%u)", size);
+      bench_report(name, lookups, &result);
+      if (sum == 0)
+      {
+         printf("unexpected checksum\n");
+      }
+      dtl_dec_ref(av);
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+static dtl_hv_t *hv_copy(const dtl_hv_t *hv)
+{
+   dtl_hv_t *copy = dtl_hv_new();
+   dtl_hv_iter_t iter;
+   dtl_hv_iter_begin(hv, &iter);
+   while (dtl_hv_iter_next(&iter))
+   {
+      dtl_hv_set_cstr(copy, iter.pKey, iter.dv, true);
+   }
+   return copy;
+}
+
+static dtl_av_t *av_copy(const dtl_av_t *av)
+{
+   dtl_av_t *copy = dtl_av_new();
+   int32_t s32Len = dtl_av_length(av);
+   int32_t i;
+   for (i = 0; i < s32Len; i++)
+   {
+      dtl_av_push(copy, dtl_av_value(av, i), true);
+   }
+   return copy;
+}
+
+static uint32_t scaled(uint32_t count, uint32_t scale)
+{
+   uint32_t result = (uint32_t) (((uint64_t) count * scale) / 100u);
+   return (result > 0u)? result : 1u;
+}
@@ -0,0 +1,238 @@
+/*****************************************************************************
+* \file      bench_dtl_sort.c
+* \author    Conny Gustafsson
+* \date      2026-10-17
+* \brief     Benchmarks for dtl_av_sort
+*
+* Copyright (c) 2026 Conny Gustafsson
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench_util.h"
+#include "dtl_sv.h"
+#include "dtl_av.h"
+#include "dtl_hv.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define SORT_COUNT 100000u
+#define SORT_PARALLEL_COUNT 2000000u
+
+typedef enum sort_order_tag
+{
+   SORT_RANDOM,
+   SORT_SORTED,
+   SORT_REVERSED
+} sort_order_t;
+
+typedef enum sort_value_tag
+{
+   SORT_I32,
+   SORT_DBL,
+   SORT_STR,
+   SORT_MIXED, //i32 and dbl scalars, compared with dtl_sv_cmp
+   SORT_RECORD //hash with an "id" field, sorted with a key function
+} sort_value_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static void sort_run(sort_value_t valueType, uint32_t scale);
+static void sort_run_order(sort_value_t valueType, sort_order_t order, uint32_t count, uint32_t numThreads);
+static dtl_dv_t *sort_make_value(sort_value_t valueType, uint32_t u32Key);
+static dtl_dv_t *sort_record_id(const dtl_dv_t *dv);
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+static const char *m_orderNames[3] = {"random", "sorted", "reversed"};
+static const char *m_valueNames[5] = {"sort_i32", "sort_dbl", "sort_str", "sort_mixed", "sort_records"};
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Sorts arrays of i32 scalars in random, ascending and descending order.
+ */
+void bench_dtl_sort_i32(uint32_t scale)
+{
+   sort_run(SORT_I32, scale);
+}
+
+/**
+ * Sorts arrays of negative and positive double scalars.
+ */
+void bench_dtl_sort_dbl(uint32_t scale)
+{
+   sort_run(SORT_DBL, scale);
+}
+
+/**
+ * Sorts arrays of string scalars (a mix of inline and heap strings).
+ */
+void bench_dtl_sort_str(uint32_t scale)
+{
+   sort_run(SORT_STR, scale);
+}
+
+/**
+ * Sorts arrays that mix i32 and double scalars.
+ */
+void bench_dtl_sort_mixed(uint32_t scale)
+{
+   sort_run(SORT_MIXED, scale);
+}
+
+/**
+ * Sorts arrays of hashes by one of their fields through a key function.
+ */
+void bench_dtl_sort_records(uint32_t scale)
+{
+   sort_run(SORT_RECORD, scale);
+}
+
+/**
+ * Scaling of dtl_av_sort_parallel on random input with 1 to 8 threads, compared with dtl_av_sort.
+ */
+void bench_dtl_sort_parallel(uint32_t scale)
+{
+   static const uint32_t threadCounts[4] = {1u, 2u, 4u, 8u};
+   uint32_t count = (uint32_t) (((uint64_t) SORT_PARALLEL_COUNT * scale) / 100u);
+   uint32_t valueType;
+   uint32_t i;
+   if (count < 2u)
+   {
+      count = 2u;
+   }
+   for (valueType = SORT_I32; valueType <= SORT_STR; valueType++)
+   {
+      sort_run_order((sort_value_t) valueType, SORT_RANDOM, count, 0u);
+      for (i = 0u; i < 4u; i++)
+      {
+         sort_run_order((sort_value_t) valueType, SORT_RANDOM, count, threadCounts[i]);
+      }
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+static void sort_run(sort_value_t valueType, uint32_t scale)
+{
+   uint32_t count = (uint32_t) (((uint64_t) SORT_COUNT * scale) / 100u);
+   if (count < 2u)
+   {
+      count = 2u;
+   }
+   sort_run_order(valueType, SORT_RANDOM, count, 0u);
+   sort_run_order(valueType, SORT_SORTED, count, 0u);
+   sort_run_order(valueType, SORT_REVERSED, count, 0u);
+}
+
+/**
+ * Only the sort call is timed, dtl_av_sort_parallel when numThreads is set. The result is checked afterwards.
+ */
+static void sort_run_order(sort_value_t valueType, sort_order_t order, uint32_t count, uint32_t numThreads)
+{
+   uint32_t i;
+   char name[64];
+   dtl_error_t errorCode;
+   bench_state_t state;
+   bench_result_t result;
+   dtl_key_func_t *key = (valueType == SORT_RECORD)? sort_record_id : NULL;
+   dtl_av_t *av = dtl_av_new();
+   bench_rand_seed(21u);
+   for (i = 0u; i < count; i++)
+   {
+      uint32_t u32Key = (order == SORT_RANDOM)? bench_rand_u32() % (count * 4u) : (order == SORT_SORTED)? i : count - i;
+      dtl_av_push(av, sort_make_value(valueType, u32Key), false);
+   }
+   bench_begin(&state);
+   errorCode = (numThreads > 0u)? dtl_av_sort_parallel(av, key, false, numThreads) : dtl_av_sort(av, key, false);
+   bench_end(&state, &result);
+   if (numThreads > 0u)
+   {
+      sprintf(name, "%s %s n=%u threads=%u", m_valueNames[valueType], m_orderNames[order], count, numThreads);
+   }
+   else
+   {
+      sprintf(name, "%s %s n=%u", m_valueNames[valueType], m_orderNames[order], count);
+   }
+   if (errorCode != DTL_NO_ERROR)
+   {
+      printf("%-40s failed with error %d\n", name, (int) errorCode);
+   }
+   else
+   {
+      bench_report(name, count, &result);
+      for (i = 1u; i < count; i++)
+      {
+         int32_t result = 0;
+         const dtl_dv_t *left = dtl_av_value(av, (int32_t) i);
+         const dtl_dv_t *right = dtl_av_value(av, (int32_t) i - 1);
+         if (key != NULL)
+         {
+            left = key(left);
+            right = key(right);
+         }
+         (void) dtl_sv_cmp((const dtl_sv_t*) left, (const dtl_sv_t*) right, &result);
+         if (result < 0)
+         {
+            printf("unexpected order at %u\n", i);
+            break;
+         }
+      }
+   }
+   dtl_dec_ref(av);
+}
+
+static dtl_dv_t *sort_make_value(sort_value_t valueType, uint32_t u32Key)
+{
+   char text[32];
+   dtl_hv_t *hv;
+   switch (valueType)
+   {
+   case SORT_I32:
+      return (dtl_dv_t*) dtl_sv_make_i32((int32_t) u32Key);
+   case SORT_DBL:
+      return (dtl_dv_t*) dtl_sv_make_dbl((double) u32Key * 0.25 - 100000.0);
+   case SORT_MIXED:
+      return ( (u32Key & 1u) == 0u)? (dtl_dv_t*) dtl_sv_make_i32((int32_t) u32Key) : (dtl_dv_t*) dtl_sv_make_dbl((double) u32Key);
+   case SORT_STR:
+      //zero padded so that text order equals number order, every fourth string is too long to be stored inline
+      sprintf(text, (u32Key % 4u) == 0u? "k%010u/with/a/suffix" : "k%010u", u32Key);
+      return (dtl_dv_t*) dtl_sv_make_cstr(text);
+   default:
+      hv = dtl_hv_new();
+      dtl_hv_set_cstr(hv, "name", (dtl_dv_t*) dtl_sv_make_cstr("sensor"), false);
+      dtl_hv_set_cstr(hv, "id", (dtl_dv_t*) dtl_sv_make_i32((int32_t) u32Key), false);
+      return (dtl_dv_t*) hv;
+   }
+}
+
+static dtl_dv_t *sort_record_id(const dtl_dv_t *dv)
+{
+   return dtl_hv_get_cstr((const dtl_hv_t*) dv, "id");
+}
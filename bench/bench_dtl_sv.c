@@ -0,0 +1,483 @@
+/*****************************************************************************
+* \file      bench_dtl_sv.c
+* \author    Conny Gustafsson
+* \date      2026-10-17
+* \brief     Benchmarks for dtl_sv
+*
+* Copyright (c) 2026 Conny Gustafsson
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench_util.h"
+#include "dtl_sv.h"
+#include "dtl_hv.h"
+#include "dtl_av.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define SV_MAKE_I32_COUNT 10000000u
+#define SV_CHURN_COUNT    10000000u
+#define SV_CHURN_BATCH    64u
+#define SV_KV_OBJECTS     200000u
+#define SV_KV_FIELDS      8u
+#define SV_FLAG_RECORDS   500000u
+#define SV_FLAG_FIELDS    8u
+#define SV_FMT_COUNT      100000000u
+#define SV_FMT_PRINTF_COUNT 10000000u //snprintf is an order of magnitude slower, keep its run time reasonable
+#define SV_FMT_POOL       (1u << 20)  //distinct input values, reused round-robin
+#define SV_DUAL_VALUES    100000u
+#define SV_DUAL_PASSES    100u
+#define SV_CMP_VALUES     100000u
+#define SV_CMP_PASSES     100u
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static void sv_flags(uint32_t scale, bool useConst);
+static double *sv_fmt_make_doubles(void);
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Creates SV_MAKE_I32_COUNT scalars, keeps all of them alive (to measure RSS) and then releases them.
+ */
+void bench_dtl_sv_make_i32(uint32_t scale)
+{
+   uint32_t count = (uint32_t) (((uint64_t) SV_MAKE_I32_COUNT * scale) / 100u);
+   uint32_t i;
+   bench_state_t state;
+   bench_result_t result;
+   dtl_sv_t **values = (dtl_sv_t**) malloc(sizeof(dtl_sv_t*) * count);
+   if (values == NULL)
+   {
+      return;
+   }
+   bench_begin(&state);
+   for (i = 0u; i < count; i++)
+   {
+      values[i] = dtl_sv_make_i32((int32_t) i);
+   }
+   bench_mark(&state);
+   for (i = 0u; i < count; i++)
+   {
+      dtl_dec_ref(values[i]);
+   }
+   bench_end(&state, &result);
+   bench_report("sv_make_i32 (create+release)", count, &result);
+   free(values);
+}
+
+/**
+ * Parse-and-discard pattern: short-lived scalars are created in small batches and released right away.
+ */
+void bench_dtl_sv_churn(uint32_t scale)
+{
+   uint32_t count = (uint32_t) (((uint64_t) SV_CHURN_COUNT * scale) / 100u);
+   uint32_t i;
+   bench_state_t state;
+   bench_result_t result;
+   dtl_sv_t *batch[SV_CHURN_BATCH];
+
+   count -= count % SV_CHURN_BATCH;
+   bench_begin(&state);
+   for (i = 0u; i < count; i += SV_CHURN_BATCH)
+   {
+      uint32_t j;
+      for (j = 0u; j < SV_CHURN_BATCH; j++)
+      {
+         batch[j] = dtl_sv_make_i32((int32_t) (i + j));
+      }
+      for (j = 0u; j < SV_CHURN_BATCH; j++)
+      {
+         dtl_dec_ref(batch[j]);
+      }
+   }
+   bench_end(&state, &result);
+   bench_report("sv_churn (batches of 64)", count, &result);
+}
+
+/**
+ * Key/value heavy workload: records with short string fields (identifiers and enum names) are built and released.
+ */
+void bench_dtl_sv_kv_strings(uint32_t scale)
+{
+   static const char *keys[SV_KV_FIELDS] = {"id", "type", "state", "iface", "unit", "mode", "owner", "description"};
+   static const char *states[4] = {"ACTIVE", "INACTIVE", "PENDING", "DISABLED"};
+   uint32_t count = (uint32_t) (((uint64_t) SV_KV_OBJECTS * scale) / 100u);
+   uint32_t i;
+   char buf[64];
+   bench_state_t state;
+   bench_result_t result;
+   dtl_hv_t **records = (dtl_hv_t**) malloc(sizeof(dtl_hv_t*) * count);
+   if (records == NULL)
+   {
+      return;
+   }
+   bench_begin(&state);
+   for (i = 0u; i < count; i++)
+   {
+      dtl_hv_t *hv = dtl_hv_new();
+      sprintf(buf, "node_%u", (unsigned) i);
+      dtl_hv_set_cstr(hv, keys[0], (dtl_dv_t*) dtl_sv_make_cstr(buf), false);
+      dtl_hv_set_cstr(hv, keys[1], (dtl_dv_t*) dtl_sv_make_cstr("SENSOR"), false);
+      dtl_hv_set_cstr(hv, keys[2], (dtl_dv_t*) dtl_sv_make_cstr(states[i & 3u]), false);
+      dtl_hv_set_cstr(hv, keys[3], (dtl_dv_t*) dtl_sv_make_cstr("eth0"), false);
+      dtl_hv_set_cstr(hv, keys[4], (dtl_dv_t*) dtl_sv_make_cstr("degC"), false);
+      dtl_hv_set_cstr(hv, keys[5], (dtl_dv_t*) dtl_sv_make_cstr("AUTO"), false);
+      dtl_hv_set_cstr(hv, keys[6], (dtl_dv_t*) dtl_sv_make_cstr("root"), false);
+      dtl_hv_set_cstr(hv, keys[7], (dtl_dv_t*) dtl_sv_make_cstr("temperature sensor on the main board"), false);
+      records[i] = hv;
+   }
+   bench_mark(&state);
+   for (i = 0u; i < count; i++)
+   {
+      dtl_dec_ref(records[i]);
+   }
+   bench_end(&state, &result);
+   bench_report("sv_kv_strings (8 string fields)", (uint64_t) count * SV_KV_FIELDS, &result);
+   free(records);
+}
+
+/**
+ * Telemetry style records full of flags, small counters and nulls, built with the allocating constructors.
+ */
+void bench_dtl_sv_flags_make(uint32_t scale)
+{
+   sv_flags(scale, false);
+}
+
+/**
+ * Same records as bench_dtl_sv_flags_make built with the shared immortal values.
+ */
+void bench_dtl_sv_flags_const(uint32_t scale)
+{
+   sv_flags(scale, true);
+}
+
+/**
+ * Formats SV_FMT_COUNT doubles (random measurement-like values with 1 to 17 significant digits) with dtl_sv_format_dbl.
+ */
+void bench_dtl_sv_format_dbl(uint32_t scale)
+{
+   uint32_t count = (uint32_t) (((uint64_t) SV_FMT_COUNT * scale) / 100u);
+   uint32_t i;
+   uint64_t totalLen = 0u;
+   char buf[DTL_SV_NUM_BUF_SIZE];
+   bench_state_t state;
+   bench_result_t result;
+   double *values = sv_fmt_make_doubles();
+   if (values == NULL)
+   {
+      return;
+   }
+   bench_begin(&state);
+   for (i = 0u; i < count; i++)
+   {
+      totalLen += (uint64_t) dtl_sv_format_dbl(values[i & (SV_FMT_POOL - 1u)], buf, sizeof(buf));
+   }
+   bench_end(&state, &result);
+   bench_report("sv_format_dbl (shortest)", count, &result);
+   printf("   average length: %.2f\n", (double) totalLen / (double) count);
+   free(values);
+}
+
+/**
+ * Same inputs as bench_dtl_sv_format_dbl formatted with snprintf("%.17g"), the usual way to get round-trip text from stdio.
+ */
+void bench_dtl_sv_format_dbl_printf(uint32_t scale)
+{
+   uint32_t count = (uint32_t) (((uint64_t) SV_FMT_PRINTF_COUNT * scale) / 100u);
+   uint32_t i;
+   uint64_t totalLen = 0u;
+   char buf[DTL_SV_NUM_BUF_SIZE];
+   bench_state_t state;
+   bench_result_t result;
+   double *values = sv_fmt_make_doubles();
+   if (values == NULL)
+   {
+      return;
+   }
+   bench_begin(&state);
+   for (i = 0u; i < count; i++)
+   {
+      totalLen += (uint64_t) snprintf(buf, sizeof(buf), "%.17g", values[i & (SV_FMT_POOL - 1u)]);
+   }
+   bench_end(&state, &result);
+   bench_report("sv_format_dbl (snprintf %.17g)", count, &result);
+   printf("   average length: %.2f\n", (double) totalLen / (double) count);
+   free(values);
+}
+
+/**
+ * Formats SV_FMT_COUNT 64-bit integers of mixed magnitude.
+ */
+void bench_dtl_sv_format_i64(uint32_t scale)
+{
+   uint32_t count = (uint32_t) (((uint64_t) SV_FMT_COUNT * scale) / 100u);
+   uint32_t i;
+   uint64_t totalLen = 0u;
+   uint64_t x = 88172645463325252ull;
+   char buf[DTL_SV_NUM_BUF_SIZE];
+   bench_state_t state;
+   bench_result_t result;
+
+   bench_begin(&state);
+   for (i = 0u; i < count; i++)
+   {
+      x ^= x << 13;
+      x ^= x >> 7;
+      x ^= x << 17;
+      totalLen += (uint64_t) dtl_sv_format_i64((int64_t) (x >> (x & 63u)), buf, sizeof(buf));
+   }
+   bench_end(&state, &result);
+   bench_report("sv_format_i64", count, &result);
+   printf("   average length: %.2f\n", (double) totalLen / (double) count);
+}
+
+/**
+ * SV_DUAL_VALUES string scalars holding numbers (as read from a text file) are summed SV_DUAL_PASSES times with dtl_sv_to_dbl.
+ * The first pass parses, later passes are served from the dual-value cache.
+ */
+void bench_dtl_sv_dual_str_to_dbl(uint32_t scale)
+{
+   uint32_t count = (uint32_t) (((uint64_t) SV_DUAL_VALUES * scale) / 100u);
+   uint32_t i;
+   uint32_t pass;
+   double sum = 0.0;
+   char buf[DTL_SV_NUM_BUF_SIZE];
+   bench_state_t state;
+   bench_result_t result;
+   dtl_sv_t **values = (dtl_sv_t**) malloc(sizeof(dtl_sv_t*) * (count + 1u));
+   double *numbers = sv_fmt_make_doubles();
+   if ( (values == NULL) || (numbers == NULL) )
+   {
+      free(values);
+      free(numbers);
+      return;
+   }
+   for (i = 0u; i < count; i++)
+   {
+      if ( (i & 1u) == 0u)
+      {
+         dtl_sv_format_dbl(numbers[i & (SV_FMT_POOL - 1u)], buf, sizeof(buf));
+      }
+      else
+      {
+         dtl_sv_format_i64((int64_t) bench_rand_u32(), buf, sizeof(buf));
+      }
+      values[i] = dtl_sv_make_cstr(buf);
+   }
+   bench_begin(&state);
+   for (i = 0u; i < count; i++)
+   {
+      sum += dtl_sv_to_dbl(values[i], NULL);
+   }
+   bench_end(&state, &result);
+   bench_report("sv_dual_str_to_dbl (first read)", count, &result);
+   bench_begin(&state);
+   for (pass = 1u; pass < SV_DUAL_PASSES; pass++)
+   {
+      for (i = 0u; i < count; i++)
+      {
+         sum += dtl_sv_to_dbl(values[i], NULL);
+      }
+   }
+   bench_end(&state, &result);
+   bench_report("sv_dual_str_to_dbl (cached reads)", (uint64_t) count * (SV_DUAL_PASSES - 1u), &result);
+   printf("   checksum: %g\n", sum);
+   for (i = 0u; i < count; i++)
+   {
+      dtl_dec_ref(values[i]);
+   }
+   free(values);
+   free(numbers);
+}
+
+/**
+ * Three-way comparison of neighbouring scalars: two dtl_sv_lt calls against one dtl_sv_cmp, then dtl_sv_cmp between
+ * i64 and double scalars (which dtl_sv_lt rejects) and dtl_sv_hash.
+ */
+void bench_dtl_sv_compare(uint32_t scale)
+{
+   uint32_t count = (uint32_t) (((uint64_t) SV_CMP_VALUES * scale) / 100u);
+   uint32_t i;
+   uint32_t pass;
+   int64_t sum = 0;
+   bench_state_t state;
+   bench_result_t result;
+   dtl_sv_t **ints = (dtl_sv_t**) malloc(sizeof(dtl_sv_t*) * (count + 1u));
+   dtl_sv_t **mixed = (dtl_sv_t**) malloc(sizeof(dtl_sv_t*) * (count + 1u));
+   if ( (ints == NULL) || (mixed == NULL) )
+   {
+      free(ints);
+      free(mixed);
+      return;
+   }
+   for (i = 0u; i <= count; i++)
+   {
+      uint32_t u32Value = bench_rand_u32() % 1000u;
+      ints[i] = dtl_sv_make_i64((int64_t) u32Value);
+      mixed[i] = ( (i & 1u) == 0u)? dtl_sv_make_i64((int64_t) u32Value) : dtl_sv_make_dbl((double) u32Value + 0.5);
+   }
+   bench_begin(&state);
+   for (pass = 0u; pass < SV_CMP_PASSES; pass++)
+   {
+      for (i = 0u; i < count; i++)
+      {
+         bool isLess = false;
+         bool isGreater = false;
+         (void) dtl_sv_lt(ints[i], ints[i + 1u], &isLess);
+         (void) dtl_sv_lt(ints[i + 1u], ints[i], &isGreater);
+         sum += (int64_t) isGreater - (int64_t) isLess;
+      }
+   }
+   bench_end(&state, &result);
+   bench_report("sv_compare (2x dtl_sv_lt, i64)", (uint64_t) count * SV_CMP_PASSES, &result);
+   bench_begin(&state);
+   for (pass = 0u; pass < SV_CMP_PASSES; pass++)
+   {
+      for (i = 0u; i < count; i++)
+      {
+         int32_t cmp = 0;
+         (void) dtl_sv_cmp(ints[i], ints[i + 1u], &cmp);
+         sum += cmp;
+      }
+   }
+   bench_end(&state, &result);
+   bench_report("sv_compare (dtl_sv_cmp, i64)", (uint64_t) count * SV_CMP_PASSES, &result);
+   bench_begin(&state);
+   for (pass = 0u; pass < SV_CMP_PASSES; pass++)
+   {
+      for (i = 0u; i < count; i++)
+      {
+         int32_t cmp = 0;
+         (void) dtl_sv_cmp(mixed[i], mixed[i + 1u], &cmp);
+         sum += cmp;
+      }
+   }
+   bench_end(&state, &result);
+   bench_report("sv_compare (dtl_sv_cmp, i64 vs dbl)", (uint64_t) count * SV_CMP_PASSES, &result);
+   bench_begin(&state);
+   for (pass = 0u; pass < SV_CMP_PASSES; pass++)
+   {
+      for (i = 0u; i < count; i++)
+      {
+         sum += dtl_sv_hash(mixed[i]);
+      }
+   }
+   bench_end(&state, &result);
+   bench_report("sv_compare (dtl_sv_hash, i64 and dbl)", (uint64_t) count * SV_CMP_PASSES, &result);
+   printf("   checksum: %lld\n", (long long) sum);
+   for (i = 0u; i <= count; i++)
+   {
+      dtl_dec_ref(ints[i]);
+      dtl_dec_ref(mixed[i]);
+   }
+   free(ints);
+   free(mixed);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+static void sv_flags(uint32_t scale, bool useConst)
+{
+   uint32_t count = (uint32_t) (((uint64_t) SV_FLAG_RECORDS * scale) / 100u);
+   uint32_t i;
+   bench_state_t state;
+   bench_result_t result;
+   dtl_av_t **records = (dtl_av_t**) malloc(sizeof(dtl_av_t*) * count);
+   if (records == NULL)
+   {
+      return;
+   }
+   bench_begin(&state);
+   for (i = 0u; i < count; i++)
+   {
+      dtl_av_t *av = dtl_av_new();
+      uint32_t j;
+      for (j = 0u; j < SV_FLAG_FIELDS; j++)
+      {
+         dtl_dv_t *dv;
+         switch (j & 3u)
+         {
+         case 0u:
+            dv = (dtl_dv_t*) (useConst? dtl_sv_const_bool(((i + j) & 1u) != 0u) : dtl_sv_make_bool(((i + j) & 1u) != 0u));
+            break;
+         case 1u:
+            dv = (dtl_dv_t*) (useConst? dtl_sv_const_i32((int32_t) ((i + j) % 200u)) : dtl_sv_make_i32((int32_t) ((i + j) % 200u)));
+            break;
+         case 2u:
+            dv = (dtl_dv_t*) (useConst? dtl_sv_const_u32(j) : dtl_sv_make_u32(j));
+            break;
+         default:
+            dv = useConst? dtl_dv_const_null() : dtl_dv_null();
+            break;
+         }
+         dtl_av_push(av, dv, false);
+      }
+      records[i] = av;
+   }
+   bench_mark(&state);
+   for (i = 0u; i < count; i++)
+   {
+      dtl_dec_ref(records[i]);
+   }
+   bench_end(&state, &result);
+   bench_report(useConst? "sv_flags_const (8 fields)" : "sv_flags_make (8 fields)", (uint64_t) count * SV_FLAG_FIELDS, &result);
+   free(records);
+}
+
+static double *sv_fmt_make_doubles(void)
+{
+   static const double scales[8] = {1.0, 10.0, 100.0, 1000.0, 1e6, 1e9, 1e-3, 1e12};
+   uint64_t x = 88172645463325252ull;
+   uint32_t i;
+   double *values = (double*) malloc(sizeof(double) * SV_FMT_POOL);
+   if (values == NULL)
+   {
+      return NULL;
+   }
+   for (i = 0u; i < SV_FMT_POOL; i++)
+   {
+      x ^= x << 13;
+      x ^= x >> 7;
+      x ^= x << 17;
+      if ( (i & 1u) == 0u)
+      {
+         //measurement-like values: a few significant digits
+         values[i] = (double) (int64_t) (x % 2000001u - 1000000) / scales[(x >> 40) & 7u];
+      }
+      else
+      {
+         //arbitrary doubles needing up to 17 digits
+         uint64_t bits = (x & 0x800FFFFFFFFFFFFFull) | ((uint64_t) (900u + ((x >> 52) % 250u)) << 52);
+         memcpy(&values[i], &bits, sizeof(double));
+      }
+   }
+   return values;
+}
@@ -0,0 +1,139 @@
+/*****************************************************************************
+* \file      bench_dtl_tav.c
+* \author    Conny Gustafsson
+* \date      2026-10-17
+* \brief     Benchmarks for dtl_tav
+*
+* Copyright (c) 2026 Conny Gustafsson
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench_util.h"
+#include "dtl_sv.h"
+#include "dtl_av.h"
+#include "dtl_tav.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define TAV_SERIES_LEN    1000000u
+#define TAV_SERIES_PASSES 20u
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static void tav_report_sum(const char *name, uint32_t count, const bench_state_t *pState, double sum);
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A series of 1M doubles held as an F64 dtl_tav_t and as a dtl_av_t of scalars: building it by pushing (the
+ * reported RSS growth is the memory the series takes), then summing it repeatedly by index and, for the typed
+ * array, through dtl_tav_data. The typed array runs first so that its RSS growth is not hidden by the freed scalars.
+ */
+void bench_dtl_tav_series(uint32_t scale)
+{
+   uint32_t count = (uint32_t) (((uint64_t) TAV_SERIES_LEN * scale) / 100u);
+   uint32_t pass;
+   uint32_t i;
+   double sum = 0.0;
+   dtl_av_t *av;
+   dtl_tav_t *tav;
+   const double *pElems;
+   bench_state_t state;
+   bench_result_t result;
+   if (count == 0u)
+   {
+      count = 1u;
+   }
+
+   bench_begin(&state);
+   tav = dtl_tav_new(DTL_TAV_F64);
+   for (i = 0u; i < count; i++)
+   {
+      (void) dtl_tav_push_dbl(tav, (double) i * 0.5);
+   }
+   bench_mark(&state);
+   bench_end(&state, &result);
+   bench_report("tav_series push (dtl_tav_t f64)", count, &result);
+   bench_begin(&state);
+   for (pass = 0u; pass < TAV_SERIES_PASSES; pass++)
+   {
+      for (i = 0u; i < count; i++)
+      {
+         sum += dtl_tav_get_dbl(tav, (int32_t) i, NULL);
+      }
+   }
+   tav_report_sum("tav_series sum (dtl_tav_get_dbl)", count, &state, sum);
+   sum = 0.0;
+   bench_begin(&state);
+   pElems = (const double*) dtl_tav_data(tav);
+   for (pass = 0u; pass < TAV_SERIES_PASSES; pass++)
+   {
+      for (i = 0u; i < count; i++)
+      {
+         sum += pElems[i];
+      }
+   }
+   tav_report_sum("tav_series sum (dtl_tav_data)", count, &state, sum);
+   dtl_dec_ref(tav);
+
+   sum = 0.0;
+   bench_begin(&state);
+   av = dtl_av_new();
+   for (i = 0u; i < count; i++)
+   {
+      dtl_av_push(av, (dtl_dv_t*) dtl_sv_make_dbl((double) i * 0.5), false);
+   }
+   bench_mark(&state);
+   bench_end(&state, &result);
+   bench_report("tav_series push (dtl_av_t of dbl)", count, &result);
+   bench_begin(&state);
+   for (pass = 0u; pass < TAV_SERIES_PASSES; pass++)
+   {
+      for (i = 0u; i < count; i++)
+      {
+         sum += dtl_sv_to_dbl((const dtl_sv_t*) dtl_av_value(av, (int32_t) i), NULL);
+      }
+   }
+   tav_report_sum("tav_series sum (dtl_av_t of dbl)", count, &state, sum);
+   dtl_dec_ref(av);
+
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+static void tav_report_sum(const char *name, uint32_t count, const bench_state_t *pState, double sum)
+{
+   bench_state_t state = *pState;
+   bench_result_t result;
+   bench_end(&state, &result);
+   bench_report(name, (uint64_t) count * TAV_SERIES_PASSES, &result);
+   if (sum < 0.0)
+   {
+      printf("unexpected sum %f\n", sum); //keeps the loop from being optimized away
+   }
+}
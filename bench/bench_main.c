@@ -0,0 +1,199 @@
+/*****************************************************************************
+* \file      bench_main.c
+* \author    Conny Gustafsson
+* \date      2026-10-17
+* \brief     Benchmark driver for dtl_type
+*
+* Copyright (c) 2026 Conny Gustafsson
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench_util.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define DEFAULT_SCALE 100u
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+bench_func_t bench_dtl_arena_tree_heap;
+bench_func_t bench_dtl_arena_tree_arena;
+bench_func_t bench_dtl_atom_intern;
+bench_func_t bench_dtl_atom_intern_mt;
+bench_func_t bench_dtl_bulk_hv;
+bench_func_t bench_dtl_bulk_av;
+bench_func_t bench_dtl_dv_refcnt_plain;
+bench_func_t bench_dtl_dv_refcnt_atomic;
+bench_func_t bench_dtl_dv_refcnt_atomic_mt;
+bench_func_t bench_dtl_dv_destroy_tree;
+bench_func_t bench_dtl_dv_destroy_tree_deferred;
+bench_func_t bench_dtl_dv_release_inline;
+bench_func_t bench_dtl_dv_release_reclaimer;
+bench_func_t bench_dtl_hv_records;
+bench_func_t bench_dtl_hv_table;
+bench_func_t bench_dtl_hv_table_adt;
+bench_func_t bench_dtl_hv_key_lookup;
+bench_func_t bench_dtl_persistent_phv;
+bench_func_t bench_dtl_persistent_hv_copy;
+bench_func_t bench_dtl_persistent_pav;
+bench_func_t bench_dtl_persistent_av_copy;
+bench_func_t bench_dtl_sort_i32;
+bench_func_t bench_dtl_sort_dbl;
+bench_func_t bench_dtl_sort_str;
+bench_func_t bench_dtl_sort_mixed;
+bench_func_t bench_dtl_sort_records;
+bench_func_t bench_dtl_sort_parallel;
+bench_func_t bench_dtl_sv_make_i32;
+bench_func_t bench_dtl_sv_churn;
+bench_func_t bench_dtl_sv_kv_strings;
+bench_func_t bench_dtl_sv_flags_make;
+bench_func_t bench_dtl_sv_flags_const;
+bench_func_t bench_dtl_sv_format_dbl;
+bench_func_t bench_dtl_sv_format_dbl_printf;
+bench_func_t bench_dtl_sv_format_i64;
+bench_func_t bench_dtl_sv_dual_str_to_dbl;
+bench_func_t bench_dtl_sv_compare;
+bench_func_t bench_dtl_tav_series;
+
+static void print_usage(const char *name);
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+static const bench_case_t m_cases[] = {
+   {"sv_make_i32", bench_dtl_sv_make_i32},
+   {"sv_churn", bench_dtl_sv_churn},
+   {"sv_kv_strings", bench_dtl_sv_kv_strings},
+   {"sv_flags_make", bench_dtl_sv_flags_make},
+   {"sv_flags_const", bench_dtl_sv_flags_const},
+   {"sv_format_dbl", bench_dtl_sv_format_dbl},
+   {"sv_format_dbl_printf", bench_dtl_sv_format_dbl_printf},
+   {"sv_format_i64", bench_dtl_sv_format_i64},
+   {"sv_dual_str_to_dbl", bench_dtl_sv_dual_str_to_dbl},
+   {"sv_compare", bench_dtl_sv_compare},
+   {"tree_heap", bench_dtl_arena_tree_heap},
+   {"tree_arena", bench_dtl_arena_tree_arena},
+   {"atom_intern", bench_dtl_atom_intern},
+   {"atom_intern_mt", bench_dtl_atom_intern_mt},
+   {"bulk_hv", bench_dtl_bulk_hv},
+   {"bulk_av", bench_dtl_bulk_av},
+   {"dv_refcnt_plain", bench_dtl_dv_refcnt_plain},
+   {"dv_refcnt_atomic", bench_dtl_dv_refcnt_atomic},
+   {"dv_refcnt_atomic_mt", bench_dtl_dv_refcnt_atomic_mt},
+   {"dv_destroy_tree", bench_dtl_dv_destroy_tree},
+   {"dv_destroy_tree_deferred", bench_dtl_dv_destroy_tree_deferred},
+   {"dv_release_inline", bench_dtl_dv_release_inline},
+   {"dv_release_reclaimer", bench_dtl_dv_release_reclaimer},
+   {"hv_records", bench_dtl_hv_records},
+   {"hv_table", bench_dtl_hv_table},
+   {"hv_table_adt", bench_dtl_hv_table_adt},
+   {"hv_key_lookup", bench_dtl_hv_key_lookup},
+   {"persistent_phv", bench_dtl_persistent_phv},
+   {"persistent_hv_copy", bench_dtl_persistent_hv_copy},
+   {"persistent_pav", bench_dtl_persistent_pav},
+   {"persistent_av_copy", bench_dtl_persistent_av_copy},
+   {"sort_i32", bench_dtl_sort_i32},
+   {"sort_dbl", bench_dtl_sort_dbl},
+   {"sort_str", bench_dtl_sort_str},
+   {"sort_mixed", bench_dtl_sort_mixed},
+   {"sort_records", bench_dtl_sort_records},
+   {"sort_parallel", bench_dtl_sort_parallel},
+   {"tav_series", bench_dtl_tav_series},
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Usage: dtl_type_bench [-s percent] [name-prefix ...]
+ * The scale argument shrinks or grows the default problem size of every benchmark (100 means default size).
+ */
+int main(int argc, char **argv)
+{
+   uint32_t scale = DEFAULT_SCALE;
+   int numFilters = 0;
+   const char **filters = (const char**) calloc((size_t) argc, sizeof(char*));
+   size_t i;
+   int j;
+
+   if (filters == NULL)
+   {
+      return 1;
+   }
+   for (j = 1; j < argc; j++)
+   {
+      if ( (strcmp(argv[j], "-s") == 0) && (j + 1 < argc) )
+      {
+         scale = (uint32_t) strtoul(argv[++j], NULL, 10);
+      }
+      else if ( (strcmp(argv[j], "-h") == 0) || (strcmp(argv[j], "--help") == 0) )
+      {
+         print_usage(argv[0]);
+         free((void*) filters);
+         return 0;
+      }
+      else
+      {
+         filters[numFilters++] = argv[j];
+      }
+   }
+   if (scale == 0u)
+   {
+      scale = DEFAULT_SCALE;
+   }
+   for (i = 0u; i < sizeof(m_cases) / sizeof(m_cases[0]); i++)
+   {
+      bool selected = (numFilters == 0);
+      for (j = 0; j < numFilters; j++)
+      {
+         if (strncmp(m_cases[i].name, filters[j], strlen(filters[j])) == 0)
+         {
+            selected = true;
+            break;
+         }
+      }
+      if (selected)
+      {
+         m_cases[i].func(scale);
+      }
+   }
+   free((void*) filters);
+   return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+static void print_usage(const char *name)
+{
+   size_t i;
+   printf("Usage: %s [-s percent] [name-prefix ...]\n\nBenchmarks:\n", name);
+   for (i = 0u; i < sizeof(m_cases) / sizeof(m_cases[0]); i++)
+   {
+      printf("   %s\n", m_cases[i].name);
+   }
+}
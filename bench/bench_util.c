@@ -0,0 +1,222 @@
+/*****************************************************************************
+* \file      bench_util.c
+* \author    Conny Gustafsson
+* \date      2026-10-17
+* \brief     Helpers for dtl_type benchmarks
+*
+* Copyright (c) 2026 Conny Gustafsson
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <string.h>
+#include "bench_util.h"
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <time.h>
+#include <unistd.h>
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+static uint32_t m_randState = 2463534242u;
+
+#if defined(__GLIBC__) && !defined(MEM_LEAK_CHECK)
+/*
+ * On glibc the benchmark executable interposes the allocator entry points so that allocation counts
+ * can be reported without instrumenting the library itself.
+ */
+#define BENCH_COUNT_ALLOCS
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t num, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void *__libc_memalign(size_t alignment, size_t size);
+extern void __libc_free(void *ptr);
+
+static volatile uint64_t m_allocCount = 0u;
+
+void *malloc(size_t size)
+{
+   m_allocCount++;
+   return __libc_malloc(size);
+}
+
+void *calloc(size_t num, size_t size)
+{
+   m_allocCount++;
+   return __libc_calloc(num, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+   if (ptr == NULL)
+   {
+      m_allocCount++;
+   }
+   return __libc_realloc(ptr, size);
+}
+
+void *aligned_alloc(size_t alignment, size_t size)
+{
+   m_allocCount++;
+   return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void **memptr, size_t alignment, size_t size)
+{
+   void *ptr;
+   m_allocCount++;
+   ptr = __libc_memalign(alignment, size);
+   if (ptr == NULL)
+   {
+      return 12; //ENOMEM
+   }
+   *memptr = ptr;
+   return 0;
+}
+
+void free(void *ptr)
+{
+   __libc_free(ptr);
+}
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+void bench_begin(bench_state_t *state)
+{
+   state->startRss = bench_rss_bytes();
+   state->rssDelta = 0;
+   state->startAllocCount = bench_alloc_count();
+   state->startTime = bench_time_now();
+}
+
+/**
+ * Records the RSS growth at the point where the benchmark has all of its data alive.
+ */
+void bench_mark(bench_state_t *state)
+{
+   state->rssDelta = (int64_t) bench_rss_bytes() - (int64_t) state->startRss;
+}
+
+void bench_end(bench_state_t *state, bench_result_t *result)
+{
+   result->elapsedSec = bench_time_now() - state->startTime;
+   result->allocCount = bench_alloc_count() - state->startAllocCount;
+   result->rssDelta = state->rssDelta;
+}
+
+void bench_report(const char *name, uint64_t numOps, const bench_result_t *result)
+{
+   double nsPerOp = (numOps > 0u)? (result->elapsedSec * 1e9) / (double) numOps : 0.0;
+   printf("%-40s %12llu ops %10.3f ms %9.2f ns/op", name, (unsigned long long) numOps,
+      result->elapsedSec * 1e3, nsPerOp);
+   if (bench_alloc_count_available())
+   {
+      printf(" %12llu allocs", (unsigned long long) result->allocCount);
+   }
+   if (result->rssDelta != 0)
+   {
+      printf(" %9.1f MiB rss", (double) result->rssDelta / (1024.0 * 1024.0));
+   }
+   printf("\n");
+   fflush(stdout);
+}
+
+double bench_time_now(void)
+{
+#ifdef _WIN32
+   LARGE_INTEGER freq, now;
+   QueryPerformanceFrequency(&freq);
+   QueryPerformanceCounter(&now);
+   return (double) now.QuadPart / (double) freq.QuadPart;
+#else
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+#endif
+}
+
+size_t bench_rss_bytes(void)
+{
+#if defined(_WIN32)
+   PROCESS_MEMORY_COUNTERS pmc;
+   if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+   {
+      return (size_t) pmc.WorkingSetSize;
+   }
+   return 0u;
+#elif defined(__linux__)
+   unsigned long size = 0u, resident = 0u;
+   FILE *fh = fopen("/proc/self/statm", "r");
+   if (fh != NULL)
+   {
+      if (fscanf(fh, "%lu %lu", &size, &resident) != 2)
+      {
+         resident = 0u;
+      }
+      fclose(fh);
+   }
+   return (size_t) resident * (size_t) sysconf(_SC_PAGESIZE);
+#else
+   return 0u;
+#endif
+}
+
+uint64_t bench_alloc_count(void)
+{
+#ifdef BENCH_COUNT_ALLOCS
+   return m_allocCount;
+#else
+   return 0u;
+#endif
+}
+
+bool bench_alloc_count_available(void)
+{
+#ifdef BENCH_COUNT_ALLOCS
+   return true;
+#else
+   return false;
+#endif
+}
+
+/**
+ * xorshift32, good enough for generating benchmark input and reproducible between runs.
+ */
+uint32_t bench_rand_u32(void)
+{
+   uint32_t x = m_randState;
+   x ^= x << 13;
+   x ^= x >> 17;
+   x ^= x << 5;
+   m_randState = x;
+   return x;
+}
+
+void bench_rand_seed(uint32_t seed)
+{
+   m_randState = (seed != 0u)? seed : 2463534242u;
+}
@@ -0,0 +1,76 @@
+/*****************************************************************************
+* \file      bench_util.h
+* \author    Conny Gustafsson
+* \date      2026-10-17
+* \brief     Helpers for dtl_type benchmarks
+*
+* Copyright (c) 2026 Conny Gustafsson
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+#ifndef BENCH_UTIL_H
+#define BENCH_UTIL_H
+
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+typedef struct bench_result_tag
+{
+   double elapsedSec;
+   uint64_t allocCount; //number of calls to malloc/calloc/realloc(NULL)/aligned allocators
+   int64_t rssDelta;    //resident set size growth in bytes, measured at bench_mark()
+} bench_result_t;
+
+typedef struct bench_state_tag
+{
+   double startTime;
+   uint64_t startAllocCount;
+   size_t startRss;
+   int64_t rssDelta;
+} bench_state_t;
+
+typedef void (bench_func_t)(uint32_t scale);
+
+typedef struct bench_case_tag
+{
+   const char *name;
+   bench_func_t *func;
+} bench_case_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+void bench_begin(bench_state_t *state);
+void bench_mark(bench_state_t *state);
+void bench_end(bench_state_t *state, bench_result_t *result);
+void bench_report(const char *name, uint64_t numOps, const bench_result_t *result);
+double bench_time_now(void);
+size_t bench_rss_bytes(void);
+uint64_t bench_alloc_count(void);
+bool bench_alloc_count_available(void);
+uint32_t bench_rand_u32(void);
+void bench_rand_seed(uint32_t seed);
+
+#endif //BENCH_UTIL_H
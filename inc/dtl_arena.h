@@ -0,0 +1,72 @@
+/*****************************************************************************
+* \file      dtl_arena.h
+* \author    Conny Gustafsson
+* \date      2026-10-17
+* \brief     Arena allocator for short-lived DTL value trees
+*
+* Copyright (c) 2026 Conny Gustafsson
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+#ifndef DTL_ARENA_H
+#define DTL_ARENA_H
+
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stdbool.h>
+#include "dtl_dv.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define DTL_ARENA_CHUNK_SIZE 65536u //chunks are aligned to their size so that a value can find its arena
+#define DTL_ARENA_MAX_ALLOC  1024u  //largest block that can be requested from dtl_arena_alloc
+
+typedef struct dtl_arena_tag dtl_arena_t;
+
+typedef struct dtl_arena_stats_tag{
+   uint32_t u32NumChunks;     //chunks held by the arena (including retained chunks)
+   uint32_t u32NumFinalizers; //values that will be destroyed by the next dtl_arena_reset
+   uint64_t u64BytesUsed;     //bytes handed out since the last reset
+} dtl_arena_stats_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+/*
+ * An arena hands out value memory from bump-pointer chunks. Values created by the arena constructors
+ * (dtl_sv_arena_new, dtl_sv_arena_make_*, dtl_av_arena_new, dtl_hv_arena_new) ignore dtl_dv_inc_ref/dtl_dv_dec_ref
+ * and are all released together by dtl_arena_reset or dtl_arena_delete.
+ * Containers and scalars that own heap data (strings, bytes, pointers with destructors, references to heap values)
+ * are destroyed during reset, everything else is released without being visited.
+ * Use dtl_dv_promote to deep-copy a value that must outlive its arena.
+ * An arena is not thread-safe.
+ */
+dtl_arena_t *dtl_arena_new(void);
+void dtl_arena_delete(dtl_arena_t *self);
+void dtl_arena_reset(dtl_arena_t *self);
+void *dtl_arena_alloc(dtl_arena_t *self, uint32_t u32Size);
+bool dtl_arena_stats(const dtl_arena_t *self, dtl_arena_stats_t *stats);
+
+//Used by the value constructors
+dtl_arena_t *dtl_dv_arena(const dtl_dv_t *dv);
+void dtl_arena_add_finalizer(dtl_arena_t *self, dtl_dv_t *dv);
+
+#endif //DTL_ARENA_H
@@ -0,0 +1,62 @@
+/*****************************************************************************
+* \file      dtl_atom.h
+* \author    Conny Gustafsson
+* \date      2026-10-17
+* \brief     Global table of interned strings
+*
+* Copyright (c) 2026 Conny Gustafsson
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+#ifndef DTL_ATOM_H
+#define DTL_ATOM_H
+
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stdbool.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+typedef struct dtl_atom_tag dtl_atom_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+/*
+ * An atom is an immutable, reference counted string that is stored only once per process.
+ * Interning the same byte sequence twice returns the same atom, so atoms can be compared by pointer.
+ * The hash of the string is computed once when the atom is created.
+ * All functions are thread-safe.
+ */
+dtl_atom_t *dtl_atom_intern(const char *cstr);
+dtl_atom_t *dtl_atom_intern_bstr(const uint8_t *pBegin, const uint8_t *pEnd);
+dtl_atom_t *dtl_atom_find(const char *cstr);
+void dtl_atom_retain(dtl_atom_t *self);
+void dtl_atom_release(dtl_atom_t *self);
+const char *dtl_atom_cstr(const dtl_atom_t *self);
+uint32_t dtl_atom_length(const dtl_atom_t *self);
+uint32_t dtl_atom_hash(const dtl_atom_t *self);
+uint32_t dtl_atom_hash_bstr(const uint8_t *pBegin, const uint8_t *pEnd); //same value as dtl_atom_hash of the interned bytes
+uint32_t dtl_atom_hash_cstr(const char *cstr, uint32_t *pu32Len);
+uint32_t dtl_atom_ref_cnt(const dtl_atom_t *self);
+uint32_t dtl_atom_count(void);
+
+#endif //DTL_ATOM_H
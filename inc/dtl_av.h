@@ -31,6 +31,7 @@
 //////////////////////////////////////////////////////////////////////////////
 #include <stdbool.h>
 #include "dtl_dv.h"
+#include "dtl_arena.h"
 #include "adt_ary.h"
 #include "dtl_error.h"
 
@@ -38,8 +39,13 @@
 // PUBLIC CONSTANTS AND DATA TYPES
 //////////////////////////////////////////////////////////////////////////////
 
+/*
+ * The adt_ary_t is embedded so that the array value and its container share a single allocation.
+ * pAny always points to the embedded ary member. A dtl_av_t must not be copied by value.
+ */
 typedef struct dtl_av_tag{
   DTL_DV_HEAD(adt_ary_t)
+  adt_ary_t ary;
 } dtl_av_t;
 
 typedef dtl_dv_t* (dtl_key_func_t)(const dtl_dv_t *dv);
@@ -53,12 +59,14 @@ typedef dtl_dv_t* (dtl_key_func_t)(const dtl_dv_t *dv);
 //////////////////////////////////////////////////////////////////////////////
 //Constructor/Destructor
 dtl_av_t* dtl_av_new();
+dtl_av_t* dtl_av_arena_new(dtl_arena_t *arena);
 dtl_av_t* dtl_av_make(dtl_dv_t** ppValue, int32_t s32Len);
 void dtl_av_delete(dtl_av_t *self);
 void dtl_av_create(dtl_av_t *self);
 void dtl_av_destroy(dtl_av_t *self);
 
-//Accessors
+//Accessors (functions that modify the array do nothing on a frozen array and return NULL, see dtl_dv_freeze.
+//dtl_av_set, dtl_av_unshift and dtl_av_push without autoIncrementRef still take over the caller's reference and release it)
 dtl_dv_t** dtl_av_set(dtl_av_t *self, int32_t s32Index, dtl_dv_t *pValue);
 dtl_dv_t** dtl_av_get(const dtl_av_t *self, int32_t s32Index);
 void dtl_av_push(dtl_av_t *self, dtl_dv_t *dv, bool autoIncrementRef);
@@ -71,10 +79,12 @@ dtl_dv_t* dtl_av_value(const dtl_av_t *self, int32_t s32Index);
 //Utility functions
 void dtl_av_extend(dtl_av_t *self, int32_t s32Len);
 void dtl_av_fill(dtl_av_t *self, int32_t s32Len);
+dtl_error_t dtl_av_reserve(dtl_av_t *self, int32_t s32Len);
 void dtl_av_clear(dtl_av_t *self);
 int32_t dtl_av_length(const dtl_av_t *self);
 bool dtl_av_is_empty(const dtl_av_t* self);
 bool dtl_av_exists(const dtl_av_t *self, int32_t s32Index);
 dtl_error_t dtl_av_sort(dtl_av_t *self, dtl_key_func_t *key, bool reverse);
+dtl_error_t dtl_av_sort_parallel(dtl_av_t *self, dtl_key_func_t *key, bool reverse, uint32_t u32NumThreads);
 
 #endif //DTL_AV_H__
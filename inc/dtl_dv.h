@@ -10,14 +10,46 @@
 #ifndef DTL_DV_H__
 #define DTL_DV_H__
 #include <stdint.h>
+#include <stdbool.h>
 
 #define DTL_DV_TYPE_MASK 		0xF
 #define DTL_DV_TYPE_SHIFT 		0
 
+//Bits 0-7 of u32Flags hold the dv and sv type, the bits below are value attributes
+#define DTL_DV_FLAG_ARENA		0x100	//value memory is owned by a dtl_arena_t, reference counting is disabled
+#define DTL_DV_FLAG_FINALIZE	0x200	//arena value owns heap data and is registered for cleanup in dtl_arena_reset
+#define DTL_DV_FLAG_SSO			0x400	//DTL_SV_STR scalar stores its string inline instead of in an adt_str_t
+#define DTL_DV_FLAG_ATOM		0x800	//DTL_SV_STR scalar references an interned string (dtl_atom_t)
+#define DTL_DV_FLAG_IMMORTAL	0x1000	//statically allocated shared value, reference counting is disabled and it is never freed
+#define DTL_DV_CACHE_MASK		0xE000	//scalar only: what the dual-value cache (svx.cache) currently holds
+#define DTL_DV_CACHE_SHIFT		13
+#define DTL_DV_FLAG_ATOMIC		0x10000	//reference count is updated with atomic operations, see dtl_dv_set_atomic
+#define DTL_DV_FLAG_FROZEN		0x20000	//value is immutable, setters leave it unchanged (see dtl_dv_freeze)
+#define DTL_DV_OWNER_MASK		0xFFF00000u	//biased reference counting (DTL_BIASED_REFCNT): id of the thread that created the value
+#define DTL_DV_OWNER_SHIFT		20
+
+#define DTL_DV_IS_FROZEN(dv) ( ((dv)->u32Flags & DTL_DV_FLAG_FROZEN) != 0u )
+#define DTL_DV_IS_WRITABLE(dv) ( ((dv) != 0) && !DTL_DV_IS_FROZEN(dv) )
+
+/*
+ * With biased reference counting u32RefCnt is only touched by the owner thread (non-atomic),
+ * other threads update u32SharedRefCnt atomically. The two are merged when the owner's count reaches zero.
+ * DTL_DV_HEAD_INIT gives the head of a statically allocated value.
+ */
+#ifdef DTL_BIASED_REFCNT
+#define DTL_DV_HEAD(ValueType)\
+	ValueType *pAny;\
+	uint32_t u32RefCnt;\
+	uint32_t u32Flags;\
+	uint32_t u32SharedRefCnt;
+#define DTL_DV_HEAD_INIT(pAny, u32Flags) (pAny), 1u, (u32Flags), 0u
+#else
 #define DTL_DV_HEAD(ValueType)\
 	ValueType *pAny;\
 	uint32_t u32RefCnt;\
 	uint32_t u32Flags;
+#define DTL_DV_HEAD_INIT(pAny, u32Flags) (pAny), 1u, (u32Flags)
+#endif
 
 
 typedef struct dtl_dv_tag{
@@ -30,16 +62,40 @@ typedef enum dtl_dv_type_id{
 	DTL_DV_SCALAR,
 	DTL_DV_ARRAY,
 	DTL_DV_HASH,
+	DTL_DV_PHASH,	//persistent hash (dtl_phv_t)
+	DTL_DV_PARRAY,	//persistent array (dtl_pav_t)
+	DTL_DV_TYPED_ARRAY,	//packed array of numbers (dtl_tav_t)
 } dtl_dv_type_id;
 
+typedef struct dtl_reclaimer_stats_tag{
+	uint32_t u32QueueDepth;		//trees handed to the reclaimer thread that are not freed yet
+	uint32_t u32MaxQueueDepth;	//highest queue depth seen since dtl_reclaimer_start
+	uint64_t u64NumTrees;		//trees freed by the reclaimer thread
+	uint64_t u64NumValues;		//values freed by the reclaimer thread (containers and their children)
+	uint64_t u64NumBytes;		//approximate memory released by the reclaimer thread
+} dtl_reclaimer_stats_t;
+
 
 /***************** Public Function Declarations *******************/
 dtl_dv_t *dtl_dv_null();
+dtl_dv_t *dtl_dv_const_null(void); //shared immortal null value
 void dtl_dv_delete(dtl_dv_t* dv );
 void dtl_dv_vdelete(void *arg);
 void dtl_dv_inc_ref(dtl_dv_t* dv);
 void dtl_dv_dec_ref(dtl_dv_t* dv);
 dtl_dv_type_id dtl_dv_type(const dtl_dv_t* dv);
+dtl_dv_t *dtl_dv_promote(dtl_dv_t *dv);
+void dtl_dv_set_atomic(dtl_dv_t *dv);
+void dtl_dv_freeze(dtl_dv_t *dv);
+bool dtl_dv_is_frozen(const dtl_dv_t *dv);
+void dtl_dv_refcnt_merge(void);
+uint32_t dtl_reclaim(uint32_t u32Budget);
+uint32_t dtl_reclaim_pending(void);
+void dtl_reclaim_set_deferred(bool isDeferred);
+bool dtl_reclaimer_start(void);
+void dtl_reclaimer_stop(void);
+void dtl_reclaimer_flush(void);
+bool dtl_reclaimer_stats(dtl_reclaimer_stats_t *stats);
 
 void dtl_dv_dec_ref_void(void* ptr);
 
@@ -41,6 +41,7 @@ typedef int32_t dtl_error_t;
 #define DTL_NOT_IMPLEMENTED_ERROR    3
 #define DTL_TYPE_ERROR               4
 #define DTL_CONVERSION_ERROR         5
+#define DTL_FROZEN_ERROR             6 //the value was frozen with dtl_dv_freeze and cannot be modified
 
 //////////////////////////////////////////////////////////////////////////////
 // PUBLIC FUNCTION PROTOTYPES
@@ -0,0 +1,98 @@
+/*****************************************************************************
+* \file      dtl_htab.h
+* \author    Conny Gustafsson
+* \date      2026-10-17
+* \brief     Open addressing string-keyed hash table used by dtl_hv_t
+*
+* Copyright (c) 2026 Conny Gustafsson
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+#ifndef DTL_HTAB_H
+#define DTL_HTAB_H
+
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stdbool.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define DTL_HTAB_INLINE_KEY_SIZE 16u //keys shorter than this are stored inside the entry
+
+/*
+ * Entries are kept in a dense array in insertion order, removed entries stay there (with u32KeyLen set to
+ * DTL_HTAB_REMOVED) until the table is rebuilt. The hash of the key is cached next to it.
+ */
+#define DTL_HTAB_REMOVED UINT32_MAX
+
+typedef struct dtl_htab_entry_tag{
+   void *pVal;
+   uint32_t u32Hash;
+   uint32_t u32KeyLen;
+   union{
+      char acInline[DTL_HTAB_INLINE_KEY_SIZE];
+      char *pHeap;
+   } key;
+} dtl_htab_entry_t;
+
+/*
+ * Swiss table style index: one control byte per slot (empty, removed or 7 bits of the key hash) is probed a group
+ * at a time with SSE2, or 8 bytes at a time with plain integer operations on other targets (and with
+ * DTL_HTAB_NO_SIMD). A full slot holds the position of its entry in the entry array.
+ * Control bytes, slot positions and entries share one allocation, an empty table allocates nothing.
+ * Keys are compared by hash and length before their bytes are read.
+ */
+typedef struct dtl_htab_tag{
+   dtl_htab_entry_t *pEntries;
+   uint32_t *pSlots;
+   uint8_t *pCtrl;
+   uint32_t u32Capacity;   //number of slots, 0 or a power of two
+   uint32_t u32NumEntries; //entries in use, including removed ones
+   uint32_t u32Length;     //entries not removed
+   uint32_t u32IterPos;    //position of dtl_htab_iter_next
+   void (*pDestructor)(void*);
+} dtl_htab_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+void dtl_htab_create(dtl_htab_t *self, void (*pDestructor)(void*));
+void dtl_htab_destroy(dtl_htab_t *self);
+
+//u32Hash must be dtl_atom_hash_bstr (or dtl_atom_hash_cstr) of the key bytes
+void **dtl_htab_find(const dtl_htab_t *self, const char *pKey, uint32_t u32KeyLen, uint32_t u32Hash);
+void **dtl_htab_insert(dtl_htab_t *self, const char *pKey, uint32_t u32KeyLen, uint32_t u32Hash, bool *pIsNew);
+bool dtl_htab_remove(dtl_htab_t *self, const char *pKey, uint32_t u32KeyLen, uint32_t u32Hash, void **ppVal);
+bool dtl_htab_reserve(dtl_htab_t *self, uint32_t u32Count);
+uint32_t dtl_htab_length(const dtl_htab_t *self);
+uint64_t dtl_htab_footprint(const dtl_htab_t *self);
+
+//iteration in insertion order, *pu32Pos starts at 0
+const dtl_htab_entry_t *dtl_htab_next(const dtl_htab_t *self, uint32_t *pu32Pos);
+void dtl_htab_iter_init(dtl_htab_t *self);
+const dtl_htab_entry_t *dtl_htab_iter_next(dtl_htab_t *self);
+
+static inline const char *dtl_htab_entry_key(const dtl_htab_entry_t *entry)
+{
+   return (entry->u32KeyLen < DTL_HTAB_INLINE_KEY_SIZE)? entry->key.acInline : entry->key.pHeap;
+}
+
+#endif //DTL_HTAB_H
@@ -30,17 +30,44 @@
 // INCLUDES
 //////////////////////////////////////////////////////////////////////////////
 #include "dtl_sv.h"
-#include "adt_hash.h"
+#include "dtl_htab.h"
 #include "dtl_av.h"
 
 //////////////////////////////////////////////////////////////////////////////
 // PUBLIC CONSTANTS AND DATA TYPES
 //////////////////////////////////////////////////////////////////////////////
+/*
+ * The dtl_htab_t is embedded so that the hash value and its container share a single allocation.
+ * pAny always points to the embedded hash member. A dtl_hv_t must not be copied by value.
+ */
 typedef struct dtl_hv_tag
 {
-  DTL_DV_HEAD(adt_hash_t)
+  DTL_DV_HEAD(dtl_htab_t)
+  dtl_htab_t hash;
 } dtl_hv_t;
 
+/*
+ * Iterator that lives on the caller's stack and keeps its position outside the hash, so several iterators (also in
+ * different threads) can walk the same hash at once and iterations can be nested. The hash must not be modified while
+ * it is being walked. After dtl_hv_iter_next has returned true the fields below describe the current entry.
+ */
+typedef struct dtl_hv_iter_tag
+{
+  const dtl_htab_t *pTable;
+  uint32_t u32Pos;
+  const char *pKey;
+  dtl_dv_t *dv;
+  uint32_t u32KeyLen;
+  uint32_t u32KeyHash; //hash cached in the table, equal to dtl_atom_hash_bstr of the key
+} dtl_hv_iter_t;
+
+//key and value for dtl_hv_make_from_pairs
+typedef struct dtl_hv_pair_tag
+{
+  const char *pKey;
+  dtl_dv_t *dv;
+} dtl_hv_pair_t;
+
 //////////////////////////////////////////////////////////////////////////////
 // PUBLIC VARIABLES
 //////////////////////////////////////////////////////////////////////////////
@@ -50,20 +77,37 @@ typedef struct dtl_hv_tag
 //////////////////////////////////////////////////////////////////////////////
 //Constructor/Destructor
 dtl_hv_t* dtl_hv_new(void);
+dtl_hv_t* dtl_hv_arena_new(dtl_arena_t *arena);
+dtl_hv_t* dtl_hv_make_from_pairs(const dtl_hv_pair_t *pPairs, uint32_t u32Count);
 void dtl_hv_delete(dtl_hv_t *self);
 void dtl_hv_create(dtl_hv_t *self);
 void dtl_hv_destroy(dtl_hv_t *self);
 
-//Accessors
+//Accessors (a frozen hash is left unchanged, see dtl_dv_freeze.
+//Setters called without autoIncrementRef still take over the caller's reference to the value and release it)
 void dtl_hv_set_cstr(dtl_hv_t *self, const char *pKey, dtl_dv_t *dv, bool autoIncrementRef);
 dtl_dv_t* dtl_hv_get_cstr(const dtl_hv_t *self, const char *pKey);
 dtl_dv_t* dtl_hv_remove_cstr(dtl_hv_t *self, const char *pKey);
-void dtl_hv_iter_init(dtl_hv_t *self);
+void dtl_hv_set_bstr(dtl_hv_t *self, const uint8_t *pBegin, const uint8_t *pEnd, dtl_dv_t *dv, bool autoIncrementRef);
+dtl_dv_t* dtl_hv_get_bstr(const dtl_hv_t *self, const uint8_t *pBegin, const uint8_t *pEnd);
+dtl_dv_t* dtl_hv_remove_bstr(dtl_hv_t *self, const uint8_t *pBegin, const uint8_t *pEnd);
+void dtl_hv_set_hashed(dtl_hv_t *self, const uint8_t *pBegin, const uint8_t *pEnd, uint32_t u32Hash, dtl_dv_t *dv, bool autoIncrementRef);
+dtl_dv_t* dtl_hv_get_hashed(const dtl_hv_t *self, const uint8_t *pBegin, const uint8_t *pEnd, uint32_t u32Hash);
+dtl_dv_t* dtl_hv_remove_hashed(dtl_hv_t *self, const uint8_t *pBegin, const uint8_t *pEnd, uint32_t u32Hash);
+void dtl_hv_set_atom(dtl_hv_t *self, const dtl_atom_t *key, dtl_dv_t *dv, bool autoIncrementRef);
+dtl_dv_t* dtl_hv_get_atom(const dtl_hv_t *self, const dtl_atom_t *key);
+void dtl_hv_iter_begin(const dtl_hv_t *self, dtl_hv_iter_t *iter);
+bool dtl_hv_iter_next(dtl_hv_iter_t *iter);
+void dtl_hv_iter_init(dtl_hv_t *self); //keeps the position inside the hash, prefer dtl_hv_iter_begin
 dtl_dv_t* dtl_hv_iter_next_cstr(dtl_hv_t *self,const char **ppKey);
 
 //Utility functions
 uint32_t dtl_hv_length(const dtl_hv_t *self);
+dtl_error_t dtl_hv_reserve(dtl_hv_t *self, uint32_t u32Count);
 bool dtl_hv_exists_cstr(const dtl_hv_t *self, const char *pKey);
+bool dtl_hv_exists_bstr(const dtl_hv_t *self, const uint8_t *pBegin, const uint8_t *pEnd);
+bool dtl_hv_exists_hashed(const dtl_hv_t *self, const uint8_t *pBegin, const uint8_t *pEnd, uint32_t u32Hash);
+uint32_t dtl_key_hash(const uint8_t *pBegin, const uint8_t *pEnd); //hash for the _hashed accessors
 dtl_av_t* dtl_hv_keys(const dtl_hv_t *self);
 
 #endif //DTL_HV_H_
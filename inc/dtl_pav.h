@@ -0,0 +1,80 @@
+/*****************************************************************************
+* \file      dtl_pav.h
+* \author    Conny Gustafsson
+* \date      2026-10-17
+* \brief     Persistent array value (radix balanced trie with structural sharing)
+*
+* Copyright (c) 2026 Conny Gustafsson
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+#ifndef DTL_PAV_H
+#define DTL_PAV_H
+
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stdbool.h>
+#include "dtl_dv.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define DTL_PAV_BRANCH_BITS 5
+#define DTL_PAV_BRANCH_SIZE (1 << DTL_PAV_BRANCH_BITS)
+
+typedef struct dtl_pav_node_tag dtl_pav_node_t;
+
+typedef struct dtl_pav_data_tag{
+   dtl_pav_node_t *root; //trie holding all elements before the tail, NULL when they fit in the tail
+   dtl_pav_node_t *tail; //last 1-32 elements, NULL when empty
+   uint32_t u32Length;
+   uint32_t u32Shift;    //DTL_PAV_BRANCH_BITS times the number of trie levels above the leaves
+} dtl_pav_data_t;
+
+/*
+ * A persistent array never changes after it has been created. dtl_pav_push, dtl_pav_set and dtl_pav_pop return a new
+ * version that shares every trie node the change did not touch with the version it was made from. Reads and updates
+ * cost O(log32 n), pushing and popping at the end mostly touches the tail only. Old and new versions stay valid and
+ * can be read at the same time, also from different threads. Trie nodes are reference counted with atomic operations,
+ * versions and stored values use the normal dtl_dv_t reference counts.
+ * pAny always points to the embedded data member. A dtl_pav_t must not be copied by value.
+ */
+typedef struct dtl_pav_tag{
+   DTL_DV_HEAD(dtl_pav_data_t)
+   dtl_pav_data_t data;
+} dtl_pav_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+//Constructor/Destructor
+dtl_pav_t *dtl_pav_new(void);
+void dtl_pav_delete(dtl_pav_t *self);
+
+//Versions (the caller owns one reference to the returned version, NULL means out of memory or index out of range)
+dtl_pav_t *dtl_pav_push(const dtl_pav_t *self, dtl_dv_t *dv, bool autoIncrementRef);
+dtl_pav_t *dtl_pav_set(const dtl_pav_t *self, int32_t s32Index, dtl_dv_t *dv, bool autoIncrementRef);
+dtl_pav_t *dtl_pav_pop(const dtl_pav_t *self);
+
+//Accessors
+dtl_dv_t *dtl_pav_value(const dtl_pav_t *self, int32_t s32Index);
+int32_t dtl_pav_length(const dtl_pav_t *self);
+
+#endif //DTL_PAV_H
@@ -0,0 +1,88 @@
+/*****************************************************************************
+* \file      dtl_phv.h
+* \author    Conny Gustafsson
+* \date      2026-10-17
+* \brief     Persistent hash value (hash array mapped trie with structural sharing)
+*
+* Copyright (c) 2026 Conny Gustafsson
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+#ifndef DTL_PHV_H
+#define DTL_PHV_H
+
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stdbool.h>
+#include "dtl_dv.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define DTL_PHV_MAX_DEPTH 8 //7 levels of 5 hash bits (the last has 2) plus a level for keys whose hashes collide
+
+typedef struct dtl_phv_node_tag dtl_phv_node_t;
+
+typedef struct dtl_phv_data_tag{
+   dtl_phv_node_t *root; //NULL when empty
+   uint32_t u32Length;
+} dtl_phv_data_t;
+
+/*
+ * A persistent hash never changes after it has been created. dtl_phv_set_cstr and dtl_phv_remove_cstr return a new
+ * version that shares every trie node the change did not touch with the version it was made from, so an update
+ * costs O(log32 n) instead of a copy of the whole hash. Old and new versions stay valid and can be read at the same
+ * time, also from different threads. The trie nodes are reference counted with atomic operations, versions and
+ * stored values use the normal dtl_dv_t reference counts (see dtl_dv_set_atomic/dtl_dv_freeze for sharing them).
+ * pAny always points to the embedded data member. A dtl_phv_t must not be copied by value.
+ */
+typedef struct dtl_phv_tag{
+   DTL_DV_HEAD(dtl_phv_data_t)
+   dtl_phv_data_t data;
+} dtl_phv_t;
+
+/*
+ * Iterator that lives on the caller's stack. It does not modify the hash, several threads may iterate the same version.
+ */
+typedef struct dtl_phv_iter_tag{
+   const dtl_phv_node_t *nodes[DTL_PHV_MAX_DEPTH];
+   uint32_t u32Pos[DTL_PHV_MAX_DEPTH];
+   int32_t s32Depth;
+} dtl_phv_iter_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+//Constructor/Destructor
+dtl_phv_t *dtl_phv_new(void);
+void dtl_phv_delete(dtl_phv_t *self);
+
+//Versions (the caller owns one reference to the returned version, NULL means out of memory)
+dtl_phv_t *dtl_phv_set_cstr(const dtl_phv_t *self, const char *pKey, dtl_dv_t *dv, bool autoIncrementRef);
+dtl_phv_t *dtl_phv_remove_cstr(const dtl_phv_t *self, const char *pKey);
+
+//Accessors
+dtl_dv_t *dtl_phv_get_cstr(const dtl_phv_t *self, const char *pKey);
+bool dtl_phv_exists_cstr(const dtl_phv_t *self, const char *pKey);
+uint32_t dtl_phv_length(const dtl_phv_t *self);
+void dtl_phv_iter_init(const dtl_phv_t *self, dtl_phv_iter_t *iter);
+dtl_dv_t *dtl_phv_iter_next_cstr(dtl_phv_iter_t *iter, const char **ppKey);
+
+#endif //DTL_PHV_H
@@ -0,0 +1,71 @@
+/*****************************************************************************
+* \file      dtl_pool.h
+* \author    Conny Gustafsson
+* \date      2026-10-17
+* \brief     Fixed-size block pools for DTL values
+*
+* Copyright (c) 2026 Conny Gustafsson
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+#ifndef DTL_POOL_H
+#define DTL_POOL_H
+
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stdbool.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+typedef enum dtl_pool_id_tag{
+   DTL_POOL_DV = 0, //dtl_dv_t (null values)
+   DTL_POOL_SV,     //dtl_sv_t
+   DTL_POOL_AV,     //dtl_av_t (including its embedded adt_ary_t)
+   DTL_POOL_HV,     //dtl_hv_t (including its embedded dtl_htab_t)
+   DTL_POOL_PHV,    //dtl_phv_t (version header, trie nodes are allocated with malloc)
+   DTL_POOL_PAV,    //dtl_pav_t (version header, trie nodes are allocated with malloc)
+   DTL_POOL_TAV,    //dtl_tav_t (header only, the element buffer is allocated with malloc)
+   DTL_POOL_NUM_POOLS
+} dtl_pool_id_t;
+
+typedef struct dtl_pool_stats_tag{
+   uint32_t u32BlockSize;     //size of each block in bytes
+   uint32_t u32BlocksPerSlab;
+   uint32_t u32NumSlabs;      //slabs currently held by the pool
+   uint32_t u32NumOutstanding; //blocks handed out to threads (in use or held in a thread cache)
+   uint32_t u32NumCached;     //blocks held in the calling thread's cache
+} dtl_pool_stats_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+/*
+ * When dtl_type is built with DTL_TYPE_POOL_ALLOC=ON the value constructors take their memory from
+ * per-type slab pools with thread-local free lists. Otherwise these functions fall back to malloc/free
+ * and dtl_pool_trim/dtl_pool_stats do nothing.
+ */
+void *dtl_pool_alloc(dtl_pool_id_t id);
+void dtl_pool_free(dtl_pool_id_t id, void *ptr);
+void dtl_pool_trim(void);
+bool dtl_pool_stats(dtl_pool_id_t id, dtl_pool_stats_t *stats);
+bool dtl_pool_enabled(void);
+
+#endif //DTL_POOL_H
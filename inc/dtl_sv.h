@@ -30,7 +30,10 @@
 // INCLUDES
 //////////////////////////////////////////////////////////////////////////////
 #include <stdbool.h>
+#include <stddef.h>
 #include "dtl_dv.h"
+#include "dtl_arena.h"
+#include "dtl_atom.h"
 #include "adt_str.h"
 #include "adt_bytes.h"
 #include "adt_bytearray.h"
@@ -41,6 +44,9 @@
 //////////////////////////////////////////////////////////////////////////////
 #define DTL_SV_TYPE_MASK      0xF0
 #define DTL_SV_TYPE_SHIFT     4
+#define DTL_SV_SSO_CAPACITY   15 //strings up to this length (in bytes) are stored inside the scalar
+#define DTL_SV_NUM_BUF_SIZE   32  //buffer size (including null-terminator) that fits any number written by dtl_sv_format
+#define DTL_SV_CACHE_TEXT_SIZE 16 //numbers whose text is shorter than this keep it cached in the scalar
 
 typedef struct dtl_pv_tag{
    void *p;
@@ -62,17 +68,36 @@ typedef union dtl_sv_value_tag{
     bool       bl;
     adt_bytes_t *bytes;
     adt_bytearray_t *bytearray;
+    dtl_atom_t *atom;
+    char       sso[DTL_SV_SSO_CAPACITY+1]; //inline string, last byte holds DTL_SV_SSO_CAPACITY minus the string length
 } dtl_sv_value_t;
 
+/*
+ * Dual-value cache. A string scalar caches the number it was parsed to on first numeric access,
+ * a numeric scalar caches its text on the first call to dtl_sv_to_cstr. Any setter invalidates the cache.
+ */
+typedef union dtl_sv_cache_tag{
+   int64_t    i64;
+   uint64_t   u64;
+   double     dbl;
+   char       text[DTL_SV_CACHE_TEXT_SIZE];
+} dtl_sv_cache_t;
+
 typedef struct dtl_svx_tag
 {
-   adt_str_t *tmpStr; //used as temporary storage area when user calls dtl_sv_to_cstr
    dtl_sv_value_t val;
+   dtl_sv_cache_t cache;
 } dtl_svx_t;
 
 
+/*
+ * The payload is embedded in the scalar so that header and value share a single allocation.
+ * pAny always points to the embedded svx member, this keeps the DTL_DV_HEAD casting model working for existing code.
+ * Since pAny is self-referencing a dtl_sv_t must never be copied by value, use dtl_sv_create on the new location instead.
+ */
 typedef struct dtl_sv_tag{
    DTL_DV_HEAD(dtl_svx_t)
+   dtl_svx_t svx;
 }dtl_sv_t;
 
 //TODO: Right now we can only have 16 different types of scalar values. Change typeId to use 8 bits out of u32Flags instead of 4 bits.
@@ -125,15 +150,44 @@ dtl_sv_t *dtl_sv_make_bytes(adt_bytes_t *bytes);
 dtl_sv_t *dtl_sv_make_bytes_raw(const uint8_t *dataBuf, uint32_t dataLen);
 dtl_sv_t *dtl_sv_make_bytearray(adt_bytearray_t *array);
 dtl_sv_t *dtl_sv_make_bytearray_raw(const uint8_t *dataBuf, uint32_t dataLen);
+dtl_sv_t *dtl_sv_make_atom(dtl_atom_t *atom);
+
+//Immortal constructors, the returned values are shared and must not be modified
+dtl_sv_t *dtl_sv_const_bool(bool bl);
+dtl_sv_t *dtl_sv_const_i32(int32_t i32); //shared for 0..255
+dtl_sv_t *dtl_sv_const_u32(uint32_t u32); //shared for 0..255
+dtl_sv_t *dtl_sv_const_empty_str(void);
+
+//Arena constructors
+dtl_sv_t* dtl_sv_arena_new(dtl_arena_t *arena);
+dtl_sv_t *dtl_sv_arena_make_i32(dtl_arena_t *arena, int32_t i32);
+dtl_sv_t *dtl_sv_arena_make_u32(dtl_arena_t *arena, uint32_t u32);
+dtl_sv_t *dtl_sv_arena_make_i64(dtl_arena_t *arena, int64_t i64);
+dtl_sv_t *dtl_sv_arena_make_u64(dtl_arena_t *arena, uint64_t u64);
+dtl_sv_t *dtl_sv_arena_make_flt(dtl_arena_t *arena, float flt);
+dtl_sv_t *dtl_sv_arena_make_dbl(dtl_arena_t *arena, double dbl);
+dtl_sv_t *dtl_sv_arena_make_bool(dtl_arena_t *arena, bool bl);
+dtl_sv_t *dtl_sv_arena_make_char(dtl_arena_t *arena, char cr);
+dtl_sv_t *dtl_sv_arena_make_ptr(dtl_arena_t *arena, void *ptr, void (*pDestructor)(void*));
+dtl_sv_t *dtl_sv_arena_make_str(dtl_arena_t *arena, const adt_str_t *str);
+dtl_sv_t *dtl_sv_arena_make_cstr(dtl_arena_t *arena, const char *cstr);
+dtl_sv_t *dtl_sv_arena_make_dv(dtl_arena_t *arena, dtl_dv_t *dv, bool autoIncRef);
+dtl_sv_t *dtl_sv_arena_make_bytes(dtl_arena_t *arena, adt_bytes_t *bytes);
+dtl_sv_t *dtl_sv_arena_make_bytes_raw(dtl_arena_t *arena, const uint8_t *dataBuf, uint32_t dataLen);
+dtl_sv_t *dtl_sv_arena_make_bytearray(dtl_arena_t *arena, adt_bytearray_t *array);
+dtl_sv_t *dtl_sv_arena_make_bytearray_raw(dtl_arena_t *arena, const uint8_t *dataBuf, uint32_t dataLen);
+dtl_sv_t *dtl_sv_arena_make_atom(dtl_arena_t *arena, dtl_atom_t *atom);
 
 //getters
 dtl_sv_type_id dtl_sv_type(const dtl_sv_t* self);
 dtl_dv_type_id dtl_sv_dv_type(const dtl_sv_t* self);
 const adt_bytes_t* dtl_sv_get_bytes(const dtl_sv_t* self); //Gets a read-only copy, use dtl_sv_to_bytes in order to get a cloned object
 const adt_bytearray_t* dtl_sv_get_bytearray(const dtl_sv_t* self); //Gets a read-only copy, use dtl_sv_to_bytearray in order to get a cloned object
+dtl_atom_t* dtl_sv_get_atom(const dtl_sv_t* self); //Returns the interned string of an atom scalar (no reference is added)
+const char* dtl_sv_get_str_data(const dtl_sv_t* self, uint32_t *pu32Len); //Bytes and length of a string scalar (not copied), NULL for other types
 
 
-//Setters
+//Setters (a frozen scalar is left unchanged, see dtl_dv_freeze. dtl_sv_set_dv without autoIncRef still releases the value)
 void dtl_sv_set_i32(dtl_sv_t *self, int32_t i32);
 void dtl_sv_set_u32(dtl_sv_t *self, uint32_t u32);
 void dtl_sv_set_i64(dtl_sv_t *self, int64_t i64);
@@ -152,6 +206,7 @@ void dtl_sv_set_bytes_raw(dtl_sv_t *self, const uint8_t *dataBuf, uint32_t dataL
 void dtl_sv_set_bytearray(dtl_sv_t *self, adt_bytearray_t *array);
 void dtl_sv_set_bytearray_raw(dtl_sv_t *self, const uint8_t *dataBuf, uint32_t dataLen);
 void dtl_sv_take_bytes(dtl_sv_t *self, adt_bytes_t *bytes);
+void dtl_sv_set_atom(dtl_sv_t *self, dtl_atom_t *atom);
 
 //Conversion functions
 int32_t dtl_sv_to_i32(const dtl_sv_t *self, bool *ok);
@@ -164,14 +219,23 @@ bool dtl_sv_to_bool(const dtl_sv_t *self, bool* ok);
 char dtl_sv_to_char(const dtl_sv_t* self, bool* ok);
 void* dtl_sv_to_ptr(const dtl_sv_t *self);
 adt_str_t *dtl_sv_to_str(const dtl_sv_t *self, bool* ok);
-const char *dtl_sv_to_cstr(dtl_sv_t *self, bool* ok);
+const char *dtl_sv_to_cstr(dtl_sv_t *self, bool* ok); //see dtl_sv.c for lifetime of the returned string
 dtl_dv_t *dtl_sv_to_dv(const dtl_sv_t *self);
 dtl_sv_t *dtl_sv_to_sv(const dtl_sv_t *self);
 struct dtl_av_tag *dtl_sv_to_av(const dtl_sv_t *self);
 struct dtl_hv_tag *dtl_sv_to_hv(const dtl_sv_t *self);
 
+//Formatting functions (never allocate, safe to call on shared scalars from any thread)
+int32_t dtl_sv_format(const dtl_sv_t *self, char *buf, size_t cap);
+int32_t dtl_sv_format_i64(int64_t value, char *buf, size_t cap);
+int32_t dtl_sv_format_u64(uint64_t value, char *buf, size_t cap);
+int32_t dtl_sv_format_dbl(double value, char *buf, size_t cap); //shortest text that round-trips
+int32_t dtl_sv_format_flt(float value, char *buf, size_t cap);
+
 //Comparison functions
 dtl_error_t dtl_sv_lt(const dtl_sv_t *self, const dtl_sv_t *other, bool *result);
+dtl_error_t dtl_sv_cmp(const dtl_sv_t *self, const dtl_sv_t *other, int32_t *result); //exact order across numeric types
+uint32_t dtl_sv_hash(const dtl_sv_t *self); //equal under dtl_sv_cmp implies equal hash
 
 //Macros
 #define dtl_sv_none() &g_dtl_sv_none
@@ -0,0 +1,108 @@
+/*****************************************************************************
+* \file      dtl_tav.h
+* \author    Conny Gustafsson
+* \date      2026-10-17
+* \brief     Typed array value (packed vector of numbers of one element type)
+*
+* Copyright (c) 2026 Conny Gustafsson
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+#ifndef DTL_TAV_H
+#define DTL_TAV_H
+
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stdbool.h>
+#include "dtl_dv.h"
+#include "dtl_av.h"
+#include "dtl_error.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+typedef enum dtl_tav_elem_tag{
+   DTL_TAV_I8,
+   DTL_TAV_I16,
+   DTL_TAV_I32,
+   DTL_TAV_I64,
+   DTL_TAV_U8,
+   DTL_TAV_U16,
+   DTL_TAV_U32,
+   DTL_TAV_U64,
+   DTL_TAV_F32,
+   DTL_TAV_F64,
+   DTL_TAV_NUM_ELEM_TYPES
+} dtl_tav_elem_t;
+
+typedef struct dtl_tav_data_tag{
+   void *pElems;          //u32Capacity elements in native byte order, NULL before the first one is added
+   uint32_t u32Length;
+   uint32_t u32Capacity;
+   uint8_t u8ElemType;    //dtl_tav_elem_t
+   uint8_t u8ElemSize;    //bytes per element
+} dtl_tav_data_t;
+
+/*
+ * A typed array stores numbers of a single element type in one contiguous buffer, without a dtl_sv_t per element.
+ * One million doubles take 8 MB instead of the scalars, payloads and pointer array of a dtl_av_t.
+ * Elements are read and written as int64_t, uint64_t or double. Writes check that the value fits the element type:
+ * integer elements take only integers in their range, float elements take any number (F32 rounds to float).
+ * The array itself is reference counted like every dtl_dv_t and holds no references, so freeing it is a single free.
+ * pAny always points to the embedded data member. A dtl_tav_t must not be copied by value.
+ */
+typedef struct dtl_tav_tag{
+   DTL_DV_HEAD(dtl_tav_data_t)
+   dtl_tav_data_t data;
+} dtl_tav_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+//Constructor/Destructor
+dtl_tav_t *dtl_tav_new(dtl_tav_elem_t elemType);
+void dtl_tav_delete(dtl_tav_t *self);
+dtl_tav_t *dtl_tav_make(dtl_tav_elem_t elemType, const void *pElems, uint32_t u32Count); //copies native elements
+
+//Conversion (NULL when an element is not a number that fits elemType, or out of memory)
+dtl_tav_t *dtl_tav_make_from_av(const dtl_av_t *av, dtl_tav_elem_t elemType);
+dtl_av_t *dtl_tav_to_av(const dtl_tav_t *self); //one scalar per element: I32, U32, I64, U64, FLT or DBL
+
+//Modifiers (DTL_CONVERSION_ERROR when the value does not fit the element type)
+dtl_error_t dtl_tav_push_i64(dtl_tav_t *self, int64_t value);
+dtl_error_t dtl_tav_push_u64(dtl_tav_t *self, uint64_t value);
+dtl_error_t dtl_tav_push_dbl(dtl_tav_t *self, double value);
+dtl_error_t dtl_tav_append(dtl_tav_t *self, const void *pElems, uint32_t u32Count); //native elements of the array's type
+dtl_error_t dtl_tav_set_i64(dtl_tav_t *self, int32_t s32Index, int64_t value);
+dtl_error_t dtl_tav_set_u64(dtl_tav_t *self, int32_t s32Index, uint64_t value);
+dtl_error_t dtl_tav_set_dbl(dtl_tav_t *self, int32_t s32Index, double value);
+dtl_error_t dtl_tav_reserve(dtl_tav_t *self, int32_t s32Len);
+void dtl_tav_clear(dtl_tav_t *self);
+
+//Accessors (a negative index counts from the end, float elements are truncated when read as integers,
+//ok is false for an index out of range or a value outside the range of the result type)
+int64_t dtl_tav_get_i64(const dtl_tav_t *self, int32_t s32Index, bool *ok);
+uint64_t dtl_tav_get_u64(const dtl_tav_t *self, int32_t s32Index, bool *ok);
+double dtl_tav_get_dbl(const dtl_tav_t *self, int32_t s32Index, bool *ok);
+int32_t dtl_tav_length(const dtl_tav_t *self);
+dtl_tav_elem_t dtl_tav_elem_type(const dtl_tav_t *self);
+const void *dtl_tav_data(const dtl_tav_t *self); //dtl_tav_length elements, valid until the array is modified
+
+#endif //DTL_TAV_H
@@ -43,8 +43,12 @@
 //////////////////////////////////////////////////////////////////////////////
 // INCLUDES
 //////////////////////////////////////////////////////////////////////////////
+#include "dtl_arena.h"
 #include "dtl_sv.h"
 #include "dtl_av.h"
 #include "dtl_hv.h"
+#include "dtl_phv.h"
+#include "dtl_pav.h"
+#include "dtl_tav.h"
 
 #endif //DTL_TYPE_H_
@@ -0,0 +1,248 @@
+/*****************************************************************************
+* \file      dtl_arena.c
+* \author    Conny Gustafsson
+* \date      2026-10-17
+* \brief     Arena allocator for short-lived DTL value trees
+*
+* Copyright (c) 2026 Conny Gustafsson
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <malloc.h>
+#include <assert.h>
+#include <string.h>
+#include "dtl_arena.h"
+#include "dtl_sv.h"
+#include "dtl_av.h"
+#include "dtl_hv.h"
+#include "dtl_thread.h"
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define BLOCK_ALIGN        8u
+#define ROUND_UP(x, a)     ( ((x) + ((a) - 1u)) & ~((a) - 1u) )
+
+typedef struct dtl_arena_chunk_tag{
+   struct dtl_arena_chunk_tag *next;
+   dtl_arena_t *arena;
+} dtl_arena_chunk_t;
+
+#define CHUNK_HEADER_SIZE  ROUND_UP((uint32_t) sizeof(dtl_arena_chunk_t), 16u)
+
+typedef struct dtl_arena_finalizer_tag{
+   struct dtl_arena_finalizer_tag *next;
+   dtl_dv_t *dv;
+} dtl_arena_finalizer_t;
+
+struct dtl_arena_tag{
+   dtl_arena_chunk_t *first;
+   dtl_arena_chunk_t *last;
+   dtl_arena_chunk_t *current;   //chunk that pBump points into, chunks after it are retained from before the last reset
+   uint8_t *pBump;
+   uint8_t *pEnd;
+   dtl_arena_finalizer_t *finalizers;
+   uint32_t u32NumChunks;
+   uint32_t u32NumFinalizers;
+   uint64_t u64BytesUsed;
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static bool dtl_arena_next_chunk(dtl_arena_t *self);
+static void dtl_arena_run_finalizers(dtl_arena_t *self);
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+dtl_arena_t *dtl_arena_new(void)
+{
+   dtl_arena_t *self = (dtl_arena_t*) malloc(sizeof(dtl_arena_t));
+   if (self != 0)
+   {
+      memset(self, 0, sizeof(dtl_arena_t));
+   }
+   return self;
+}
+
+void dtl_arena_delete(dtl_arena_t *self)
+{
+   if (self != 0)
+   {
+      dtl_arena_chunk_t *chunk = self->first;
+      dtl_arena_run_finalizers(self);
+      while (chunk != 0)
+      {
+         dtl_arena_chunk_t *next = chunk->next;
+         dtl_aligned_free(chunk);
+         chunk = next;
+      }
+      free(self);
+   }
+}
+
+/**
+ * Destroys every value created from the arena. The chunks are kept and reused by subsequent allocations.
+ */
+void dtl_arena_reset(dtl_arena_t *self)
+{
+   if (self != 0)
+   {
+      dtl_arena_run_finalizers(self);
+      self->current = self->first;
+      if (self->current != 0)
+      {
+         self->pBump = ((uint8_t*) self->current) + CHUNK_HEADER_SIZE;
+         self->pEnd = ((uint8_t*) self->current) + DTL_ARENA_CHUNK_SIZE;
+      }
+      self->u64BytesUsed = 0u;
+   }
+}
+
+/**
+ * Returns u32Size bytes (8-byte aligned) of arena memory or NULL when u32Size is 0 or larger than DTL_ARENA_MAX_ALLOC.
+ */
+void *dtl_arena_alloc(dtl_arena_t *self, uint32_t u32Size)
+{
+   if ( (self != 0) && (u32Size > 0u) && (u32Size <= DTL_ARENA_MAX_ALLOC) )
+   {
+      void *ptr;
+      u32Size = ROUND_UP(u32Size, BLOCK_ALIGN);
+      if ( (self->pBump == 0) || ((uint32_t) (self->pEnd - self->pBump) < u32Size) )
+      {
+         if (!dtl_arena_next_chunk(self))
+         {
+            return (void*) 0;
+         }
+      }
+      ptr = self->pBump;
+      self->pBump += u32Size;
+      self->u64BytesUsed += u32Size;
+      return ptr;
+   }
+   return (void*) 0;
+}
+
+bool dtl_arena_stats(const dtl_arena_t *self, dtl_arena_stats_t *stats)
+{
+   if ( (self != 0) && (stats != 0) )
+   {
+      stats->u32NumChunks = self->u32NumChunks;
+      stats->u32NumFinalizers = self->u32NumFinalizers;
+      stats->u64BytesUsed = self->u64BytesUsed;
+      return true;
+   }
+   return false;
+}
+
+/**
+ * Returns the arena that owns dv or NULL when dv is a heap value.
+ */
+dtl_arena_t *dtl_dv_arena(const dtl_dv_t *dv)
+{
+   if ( (dv != 0) && ((dv->u32Flags & DTL_DV_FLAG_ARENA) != 0u) )
+   {
+      const dtl_arena_chunk_t *chunk = (const dtl_arena_chunk_t*) ( ((uintptr_t) dv) & ~((uintptr_t) DTL_ARENA_CHUNK_SIZE - 1u) );
+      return chunk->arena;
+   }
+   return (dtl_arena_t*) 0;
+}
+
+/**
+ * Registers dv to be destroyed (but not freed) when the arena is reset.
+ */
+void dtl_arena_add_finalizer(dtl_arena_t *self, dtl_dv_t *dv)
+{
+   if ( (self != 0) && (dv != 0) && ((dv->u32Flags & DTL_DV_FLAG_FINALIZE) == 0u) )
+   {
+      dtl_arena_finalizer_t *finalizer = (dtl_arena_finalizer_t*) dtl_arena_alloc(self, (uint32_t) sizeof(dtl_arena_finalizer_t));
+      if (finalizer != 0)
+      {
+         finalizer->dv = dv;
+         finalizer->next = self->finalizers;
+         self->finalizers = finalizer;
+         self->u32NumFinalizers++;
+         dv->u32Flags |= DTL_DV_FLAG_FINALIZE;
+      }
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+static bool dtl_arena_next_chunk(dtl_arena_t *self)
+{
+   dtl_arena_chunk_t *chunk = (self->current != 0)? self->current->next : self->first;
+   if (chunk == 0)
+   {
+      chunk = (dtl_arena_chunk_t*) dtl_aligned_alloc(DTL_ARENA_CHUNK_SIZE, DTL_ARENA_CHUNK_SIZE);
+      if (chunk == 0)
+      {
+         return false;
+      }
+      chunk->next = (dtl_arena_chunk_t*) 0;
+      chunk->arena = self;
+      if (self->last == 0)
+      {
+         self->first = chunk;
+      }
+      else
+      {
+         self->last->next = chunk;
+      }
+      self->last = chunk;
+      self->u32NumChunks++;
+   }
+   self->current = chunk;
+   self->pBump = ((uint8_t*) chunk) + CHUNK_HEADER_SIZE;
+   self->pEnd = ((uint8_t*) chunk) + DTL_ARENA_CHUNK_SIZE;
+   return true;
+}
+
+static void dtl_arena_run_finalizers(dtl_arena_t *self)
+{
+   dtl_arena_finalizer_t *finalizer = self->finalizers;
+   while (finalizer != 0)
+   {
+      dtl_dv_t *dv = finalizer->dv;
+      switch(dtl_dv_type(dv))
+      {
+      case DTL_DV_SCALAR:
+         dtl_sv_destroy((dtl_sv_t*) dv);
+         break;
+      case DTL_DV_ARRAY:
+         dtl_av_destroy((dtl_av_t*) dv);
+         break;
+      case DTL_DV_HASH:
+         dtl_hv_destroy((dtl_hv_t*) dv);
+         break;
+      default:
+         break;
+      }
+      finalizer = finalizer->next;
+   }
+   self->finalizers = (dtl_arena_finalizer_t*) 0;
+   self->u32NumFinalizers = 0u;
+}
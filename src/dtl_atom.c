@@ -0,0 +1,372 @@
+/*****************************************************************************
+* \file      dtl_atom.c
+* \author    Conny Gustafsson
+* \date      2026-10-17
+* \brief     Global table of interned strings
+*
+* Copyright (c) 2026 Conny Gustafsson
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <malloc.h>
+#include <assert.h>
+#include <string.h>
+#include <stddef.h>
+#include "dtl_atom.h"
+#include "dtl_thread.h"
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define NUM_SHARDS         16u   //the table is split by the top bits of the hash to reduce lock contention
+#define SHARD_SHIFT        28u
+#define INITIAL_BUCKETS    64u   //must be a power of two
+
+struct dtl_atom_tag{
+   struct dtl_atom_tag *next;
+   volatile uint32_t u32RefCnt;
+   uint32_t u32Hash;
+   uint32_t u32Len;
+   char str[1]; //allocated with room for u32Len bytes plus null terminator
+};
+
+typedef struct dtl_atom_shard_tag{
+   dtl_mutex_t lock;
+   dtl_atom_t **buckets;
+   uint32_t u32NumBuckets;
+   uint32_t u32NumAtoms;
+} dtl_atom_shard_t;
+
+#define SHARD_INIT {DTL_MUTEX_INITIALIZER, NULL, 0u, 0u}
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static uint32_t dtl_atom_compute_hash(const uint8_t *pData, uint32_t u32Len);
+static uint32_t dtl_atom_finalize_hash(uint32_t u32Hash);
+static dtl_atom_t *dtl_atom_lookup(dtl_atom_shard_t *shard, const uint8_t *pData, uint32_t u32Len, uint32_t u32Hash);
+static bool dtl_atom_shard_grow(dtl_atom_shard_t *shard);
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+static dtl_atom_shard_t m_shards[NUM_SHARDS] = {
+   SHARD_INIT, SHARD_INIT, SHARD_INIT, SHARD_INIT, SHARD_INIT, SHARD_INIT, SHARD_INIT, SHARD_INIT,
+   SHARD_INIT, SHARD_INIT, SHARD_INIT, SHARD_INIT, SHARD_INIT, SHARD_INIT, SHARD_INIT, SHARD_INIT
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+/**
+ * Returns the atom for cstr, creating it when needed. The caller owns one reference to the returned atom.
+ */
+dtl_atom_t *dtl_atom_intern(const char *cstr)
+{
+   if (cstr != 0)
+   {
+      const uint8_t *pBegin = (const uint8_t*) cstr;
+      return dtl_atom_intern_bstr(pBegin, pBegin + strlen(cstr));
+   }
+   return (dtl_atom_t*) 0;
+}
+
+dtl_atom_t *dtl_atom_intern_bstr(const uint8_t *pBegin, const uint8_t *pEnd)
+{
+   if ( (pBegin != 0) && (pEnd != 0) && (pBegin <= pEnd) )
+   {
+      uint32_t u32Len = (uint32_t) (pEnd - pBegin);
+      uint32_t u32Hash = dtl_atom_compute_hash(pBegin, u32Len);
+      dtl_atom_shard_t *shard = &m_shards[u32Hash >> SHARD_SHIFT];
+      dtl_atom_t *atom;
+      dtl_mutex_lock(&shard->lock);
+      atom = dtl_atom_lookup(shard, pBegin, u32Len, u32Hash);
+      if (atom != 0)
+      {
+         dtl_atom_retain(atom);
+      }
+      else if ( (shard->u32NumAtoms < shard->u32NumBuckets) || dtl_atom_shard_grow(shard) )
+      {
+         atom = (dtl_atom_t*) malloc(offsetof(dtl_atom_t, str) + u32Len + 1u);
+         if (atom != 0)
+         {
+            uint32_t u32Index = u32Hash & (shard->u32NumBuckets - 1u);
+            memcpy(atom->str, pBegin, u32Len);
+            atom->str[u32Len] = '\0';
+            atom->u32Len = u32Len;
+            atom->u32Hash = u32Hash;
+            atom->u32RefCnt = 1u;
+            atom->next = shard->buckets[u32Index];
+            shard->buckets[u32Index] = atom;
+            shard->u32NumAtoms++;
+         }
+      }
+      dtl_mutex_unlock(&shard->lock);
+      return atom;
+   }
+   return (dtl_atom_t*) 0;
+}
+
+/**
+ * Returns the atom for cstr if it has already been interned, otherwise NULL.
+ * The caller owns one reference to the returned atom.
+ */
+dtl_atom_t *dtl_atom_find(const char *cstr)
+{
+   if (cstr != 0)
+   {
+      uint32_t u32Len = (uint32_t) strlen(cstr);
+      uint32_t u32Hash = dtl_atom_compute_hash((const uint8_t*) cstr, u32Len);
+      dtl_atom_shard_t *shard = &m_shards[u32Hash >> SHARD_SHIFT];
+      dtl_atom_t *atom;
+      dtl_mutex_lock(&shard->lock);
+      atom = dtl_atom_lookup(shard, (const uint8_t*) cstr, u32Len, u32Hash);
+      if (atom != 0)
+      {
+         dtl_atom_retain(atom);
+      }
+      dtl_mutex_unlock(&shard->lock);
+      return atom;
+   }
+   return (dtl_atom_t*) 0;
+}
+
+void dtl_atom_retain(dtl_atom_t *self)
+{
+   if (self != 0)
+   {
+      dtl_atomic_inc_u32(&self->u32RefCnt);
+   }
+}
+
+/**
+ * Drops one reference. The atom is removed from the table when the last reference is released.
+ * Only the transition from one to zero references takes the shard lock, so that a concurrent
+ * dtl_atom_intern can never hand out an atom that is being freed.
+ */
+void dtl_atom_release(dtl_atom_t *self)
+{
+   if (self != 0)
+   {
+      for(;;)
+      {
+         uint32_t u32RefCnt = dtl_atomic_load_u32(&self->u32RefCnt);
+         assert(u32RefCnt > 0u);
+         if (u32RefCnt > 1u)
+         {
+            if (dtl_atomic_cas_u32(&self->u32RefCnt, u32RefCnt, u32RefCnt - 1u))
+            {
+               return;
+            }
+         }
+         else
+         {
+            dtl_atom_shard_t *shard = &m_shards[self->u32Hash >> SHARD_SHIFT];
+            dtl_mutex_lock(&shard->lock);
+            if (dtl_atomic_dec_u32(&self->u32RefCnt) == 0u)
+            {
+               dtl_atom_t **ppIter = &shard->buckets[self->u32Hash & (shard->u32NumBuckets - 1u)];
+               while (*ppIter != self)
+               {
+                  assert(*ppIter != 0);
+                  ppIter = &(*ppIter)->next;
+               }
+               *ppIter = self->next;
+               shard->u32NumAtoms--;
+               free(self);
+               if (shard->u32NumAtoms == 0u)
+               {
+                  free(shard->buckets);
+                  shard->buckets = (dtl_atom_t**) 0;
+                  shard->u32NumBuckets = 0u;
+               }
+            }
+            dtl_mutex_unlock(&shard->lock);
+            return;
+         }
+      }
+   }
+}
+
+const char *dtl_atom_cstr(const dtl_atom_t *self)
+{
+   if (self != 0)
+   {
+      return self->str;
+   }
+   return (const char*) 0;
+}
+
+uint32_t dtl_atom_length(const dtl_atom_t *self)
+{
+   if (self != 0)
+   {
+      return self->u32Len;
+   }
+   return 0u;
+}
+
+/**
+ * Hashes a null-terminated string in a single pass and stores its length in *pu32Len.
+ * Gives the same value as dtl_atom_hash_bstr on the same bytes.
+ */
+uint32_t dtl_atom_hash_cstr(const char *cstr, uint32_t *pu32Len)
+{
+   uint32_t u32Hash = 2166136261u;
+   const uint8_t *pNext = (const uint8_t*) cstr;
+   if (pNext != 0)
+   {
+      while (*pNext != 0u)
+      {
+         u32Hash ^= *pNext++;
+         u32Hash *= 16777619u;
+      }
+   }
+   if (pu32Len != 0)
+   {
+      *pu32Len = (uint32_t) (pNext - (const uint8_t*) cstr);
+   }
+   return dtl_atom_finalize_hash(u32Hash);
+}
+
+uint32_t dtl_atom_hash_bstr(const uint8_t *pBegin, const uint8_t *pEnd)
+{
+   if ( (pBegin != 0) && (pEnd != 0) && (pBegin <= pEnd) )
+   {
+      return dtl_atom_compute_hash(pBegin, (uint32_t) (pEnd - pBegin));
+   }
+   return dtl_atom_compute_hash(pBegin, 0u);
+}
+
+uint32_t dtl_atom_hash(const dtl_atom_t *self)
+{
+   if (self != 0)
+   {
+      return self->u32Hash;
+   }
+   return 0u;
+}
+
+uint32_t dtl_atom_ref_cnt(const dtl_atom_t *self)
+{
+   if (self != 0)
+   {
+      return dtl_atomic_load_u32(&self->u32RefCnt);
+   }
+   return 0u;
+}
+
+/**
+ * Returns the number of atoms currently in the table.
+ */
+uint32_t dtl_atom_count(void)
+{
+   uint32_t u32Count = 0u;
+   uint32_t i;
+   for (i = 0u; i < NUM_SHARDS; i++)
+   {
+      dtl_mutex_lock(&m_shards[i].lock);
+      u32Count += m_shards[i].u32NumAtoms;
+      dtl_mutex_unlock(&m_shards[i].lock);
+   }
+   return u32Count;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+/**
+ * FNV-1a followed by the murmur3 finalizer, which spreads the entropy to both the top bits (shard) and the low bits (bucket).
+ */
+static uint32_t dtl_atom_compute_hash(const uint8_t *pData, uint32_t u32Len)
+{
+   uint32_t u32Hash = 2166136261u;
+   uint32_t i;
+   for (i = 0u; i < u32Len; i++)
+   {
+      u32Hash ^= pData[i];
+      u32Hash *= 16777619u;
+   }
+   return dtl_atom_finalize_hash(u32Hash);
+}
+
+//Mixes the FNV-1a state so that both the low and the high bits of the result can index hash tables
+static uint32_t dtl_atom_finalize_hash(uint32_t u32Hash)
+{
+   u32Hash ^= u32Hash >> 16;
+   u32Hash *= 0x85ebca6bu;
+   u32Hash ^= u32Hash >> 13;
+   u32Hash *= 0xc2b2ae35u;
+   u32Hash ^= u32Hash >> 16;
+   return u32Hash;
+}
+
+//Must be called with the shard lock held
+static dtl_atom_t *dtl_atom_lookup(dtl_atom_shard_t *shard, const uint8_t *pData, uint32_t u32Len, uint32_t u32Hash)
+{
+   if (shard->buckets != 0)
+   {
+      dtl_atom_t *atom = shard->buckets[u32Hash & (shard->u32NumBuckets - 1u)];
+      while (atom != 0)
+      {
+         if ( (atom->u32Hash == u32Hash) && (atom->u32Len == u32Len) && ( (u32Len == 0u) || (memcmp(atom->str, pData, u32Len) == 0) ) )
+         {
+            return atom;
+         }
+         atom = atom->next;
+      }
+   }
+   return (dtl_atom_t*) 0;
+}
+
+//Must be called with the shard lock held
+static bool dtl_atom_shard_grow(dtl_atom_shard_t *shard)
+{
+   uint32_t u32NumBuckets = (shard->u32NumBuckets == 0u)? INITIAL_BUCKETS : shard->u32NumBuckets * 2u;
+   dtl_atom_t **buckets = (dtl_atom_t**) calloc(u32NumBuckets, sizeof(dtl_atom_t*));
+   uint32_t i;
+   if (buckets == 0)
+   {
+      return false;
+   }
+   for (i = 0u; i < shard->u32NumBuckets; i++)
+   {
+      dtl_atom_t *atom = shard->buckets[i];
+      while (atom != 0)
+      {
+         dtl_atom_t *next = atom->next;
+         uint32_t u32Index = atom->u32Hash & (u32NumBuckets - 1u);
+         atom->next = buckets[u32Index];
+         buckets[u32Index] = atom;
+         atom = next;
+      }
+   }
+   if (shard->buckets != 0)
+   {
+      free(shard->buckets);
+   }
+   shard->buckets = buckets;
+   shard->u32NumBuckets = u32NumBuckets;
+   return true;
+}
@@ -28,8 +28,12 @@
 //////////////////////////////////////////////////////////////////////////////
 #include "dtl_av.h"
 #include "dtl_sv.h"
+#include "dtl_pool.h"
+#include "dtl_refcnt.h"
+#include "dtl_sort.h"
 #include <malloc.h>
 #include <assert.h>
+#include <string.h>
 #ifdef MEM_LEAK_CHECK
 #include "CMemLeak.h"
 #endif
@@ -41,7 +45,6 @@
 //////////////////////////////////////////////////////////////////////////////
 // PRIVATE FUNCTION PROTOTYPES
 //////////////////////////////////////////////////////////////////////////////
-static dtl_error_t dtl_av_insertion_sort(dtl_av_t *self, bool reverse);
 
 
 //////////////////////////////////////////////////////////////////////////////
@@ -54,46 +57,71 @@ static dtl_error_t dtl_av_insertion_sort(dtl_av_t *self, bool reverse);
 //Constructor/Destructor
 dtl_av_t* dtl_av_new(){
    dtl_av_t *self;
-   if((self = (dtl_av_t*)malloc(sizeof(dtl_av_t)))==(dtl_av_t*)0){
+   if((self = (dtl_av_t*)dtl_pool_alloc(DTL_POOL_AV))==(dtl_av_t*)0){
       return (dtl_av_t*)0;
    }
-   if((self->pAny = (adt_ary_t*)malloc(sizeof(adt_ary_t)))==(adt_ary_t*)0){
-      free(self);
+   dtl_av_create(self);
+   return self;
+}
+
+/**
+ * Creates an array in arena memory. The array is destroyed by dtl_arena_reset, reference counting is disabled.
+ * Heap values stored in the array are released (dtl_dv_dec_ref) when the arena is reset.
+ */
+dtl_av_t* dtl_av_arena_new(dtl_arena_t *arena){
+   dtl_av_t *self;
+   if((self = (dtl_av_t*)dtl_arena_alloc(arena, (uint32_t) sizeof(dtl_av_t)))==(dtl_av_t*)0){
       return (dtl_av_t*)0;
    }
    dtl_av_create(self);
+   self->u32Flags |= DTL_DV_FLAG_ARENA;
+   dtl_arena_add_finalizer(arena, (dtl_dv_t*) self);
    return self;
 }
 
+/**
+ * Creates an array holding the s32Len values in ppValue. The array takes over the caller's reference to each value
+ * (no dtl_dv_inc_ref). Its storage is allocated once and the values are copied in as a block.
+ * Returns NULL when out of memory, the values have then been released.
+ */
 dtl_av_t* dtl_av_make(dtl_dv_t** ppValue, int32_t s32Len){
-   if(s32Len<0){
+   dtl_av_t *self;
+   if( (s32Len<0) || ((ppValue==0) && (s32Len>0)) ){
       return (dtl_av_t*)0;
    }
-   dtl_av_t *self = dtl_av_new();
-   if(self){
+   self = dtl_av_new();
+   if( (self != 0) && (dtl_av_reserve(self,s32Len) != DTL_NO_ERROR) ){
+      dtl_av_delete(self);
+      self = (dtl_av_t*)0;
+   }
+   if(self == 0){
       int32_t s32i;
-      dtl_av_extend(self,s32Len);
       for(s32i=0;s32i<s32Len;s32i++){
-         dtl_av_set(self,s32i,ppValue[s32i]);
+         dtl_dv_dec_ref(ppValue[s32i]);
       }
+      return (dtl_av_t*)0;
+   }
+   if(s32Len > 0){
+      memcpy(self->pAny->pFirst, ppValue, (size_t) s32Len * sizeof(dtl_dv_t*));
+      self->pAny->s32CurLen = s32Len;
    }
    return self;
 }
 
 void dtl_av_delete(dtl_av_t *self){
-   if(self){
+   if( (self != 0) && ((self->u32Flags & DTL_DV_FLAG_ARENA) == 0u) ){
       dtl_av_destroy(self);
-      free(self->pAny);
-      free(self);
+      dtl_pool_free(DTL_POOL_AV, self);
    }
 }
 
 void dtl_av_create(dtl_av_t *self){
    if(self){
+      self->pAny = &self->ary;
       adt_ary_create(self->pAny, dtl_dv_dec_ref_void);
       adt_ary_set_fill_elem(self->pAny,(void*) &g_dtl_sv_none);
       self->u32Flags = ((uint32_t)DTL_DV_ARRAY);
-      self->u32RefCnt = 1;
+      dtl_refcnt_init((dtl_dv_t*) self);
    }
 }
 void dtl_av_destroy(dtl_av_t *self){
@@ -105,13 +133,16 @@ void dtl_av_destroy(dtl_av_t *self){
 
 //Accessors
 dtl_dv_t**  dtl_av_set(dtl_av_t *self, int32_t s32Index, dtl_dv_t *pValue){
-   if(self){
+   if(DTL_DV_IS_WRITABLE(self)){
       dtl_dv_t **tmp = (dtl_dv_t**)adt_ary_get(self->pAny,s32Index);
       if(tmp && *tmp != pValue){
          dtl_dv_dec_ref(*tmp);
       }
       return (dtl_dv_t**) adt_ary_set(self->pAny,s32Index,pValue);
    }
+   if(self){
+      dtl_dv_dec_ref(pValue); //frozen, the reference handed over by the caller is released
+   }
    return (dtl_dv_t**) 0;
 }
 
@@ -130,48 +161,76 @@ dtl_dv_t*  dtl_av_value(const dtl_av_t *self, int32_t s32Index){
 }
 
 void dtl_av_push(dtl_av_t *self, dtl_dv_t *dv, bool autoIncrementRef){
-   if(self){
+   if(DTL_DV_IS_WRITABLE(self)){
       adt_ary_push(self->pAny, dv);
       if (autoIncrementRef)
       {
          dtl_dv_inc_ref(dv);
       }
    }
+   else if( (self != 0) && (!autoIncrementRef) ){
+      dtl_dv_dec_ref(dv); //frozen, the reference handed over by the caller is released
+   }
 }
 dtl_dv_t* dtl_av_pop(dtl_av_t *self){
-   if(self){
+   if(DTL_DV_IS_WRITABLE(self)){
       return (dtl_dv_t*) adt_ary_pop(self->pAny);
    }
    return (dtl_dv_t*)0;
 }
 
 dtl_dv_t*   dtl_av_shift(dtl_av_t *self){
-   if(self){
+   if(DTL_DV_IS_WRITABLE(self)){
       return (dtl_dv_t*) adt_ary_shift(self->pAny);
    }
    return (dtl_dv_t*)0;
 }
 void dtl_av_unshift(dtl_av_t *self, dtl_dv_t *pValue){
-   if(self){
+   if(DTL_DV_IS_WRITABLE(self)){
       adt_ary_unshift(self->pAny,pValue);
    }
+   else if(self){
+      dtl_dv_dec_ref(pValue); //frozen, the reference handed over by the caller is released
+   }
 }
 
 
 //Utility functions
 void  dtl_av_extend(dtl_av_t *self, int32_t s32Len){
-   if(self){
+   if(DTL_DV_IS_WRITABLE(self)){
       adt_ary_extend(self->pAny,s32Len);
    }
 }
 void  dtl_av_fill(dtl_av_t *self, int32_t s32Len){
-   if(self){
+   if(DTL_DV_IS_WRITABLE(self)){
       adt_ary_fill(self->pAny,s32Len);
    }
 }
 
+/**
+ * Makes room for s32Len values in total, so that pushing values up to that length does not reallocate.
+ * The length of the array is unchanged.
+ */
+dtl_error_t dtl_av_reserve(dtl_av_t *self, int32_t s32Len){
+   if( (self == 0) || (s32Len < 0) ){
+      return DTL_INVALID_ARGUMENT_ERROR;
+   }
+   if(DTL_DV_IS_FROZEN(self)){
+      return DTL_FROZEN_ERROR;
+   }
+   if(s32Len > (self->pAny->s32AllocLen - (int32_t) (self->pAny->pFirst - self->pAny->ppAlloc))){
+      //adt_ary_t has no reserve, extending allocates the room and the length is then set back
+      int32_t s32CurLen = self->pAny->s32CurLen;
+      if(adt_ary_extend(self->pAny,s32Len) != ADT_NO_ERROR){
+         return DTL_MEM_ERROR;
+      }
+      self->pAny->s32CurLen = s32CurLen;
+   }
+   return DTL_NO_ERROR;
+}
+
 void  dtl_av_clear(dtl_av_t *self){
-   if(self){
+   if(DTL_DV_IS_WRITABLE(self)){
       adt_ary_clear(self->pAny);
    }
 }
@@ -198,96 +257,42 @@ bool dtl_av_exists(const dtl_av_t *self, int32_t s32Index){
    return false;
 }
 
+/**
+ * Stable sort (equal values keep their order), ascending unless reverse is set. Values are ordered as by dtl_sv_cmp,
+ * so numbers of different types can be sorted together.
+ * Without a key function every value must be a scalar. With one, key is called once per value and returns the scalar
+ * to sort it by, such as a field of a hash. The key is borrowed from the value (no reference is transferred).
+ * On error the array is left unchanged.
+ */
 dtl_error_t dtl_av_sort(dtl_av_t *self, dtl_key_func_t *key, bool reverse)
 {
    if (self != 0)
    {
-      if (key != 0)
+      if (DTL_DV_IS_FROZEN(self))
       {
-         return DTL_NOT_IMPLEMENTED_ERROR;
+         return DTL_FROZEN_ERROR;
       }
-      return dtl_av_insertion_sort(self, reverse);
+      return dtl_sort_values((dtl_dv_t**) self->pAny->pFirst, (uint32_t) self->pAny->s32CurLen, key, reverse);
    }
    return DTL_INVALID_ARGUMENT_ERROR;
 }
-//////////////////////////////////////////////////////////////////////////////
-// PRIVATE FUNCTIONS
-//////////////////////////////////////////////////////////////////////////////
-static dtl_error_t dtl_av_insertion_sort(dtl_av_t *self, bool reverse)
+
+/**
+ * Same as dtl_av_sort, using up to u32NumThreads threads for arrays large enough to benefit. The result does not depend
+ * on the number of threads. The key function is only called from the calling thread.
+ */
+dtl_error_t dtl_av_sort_parallel(dtl_av_t *self, dtl_key_func_t *key, bool reverse, uint32_t u32NumThreads)
 {
-   int32_t arrayLen = self->pAny->s32CurLen;
-   if (arrayLen > 1)
+   if (self != 0)
    {
-      int32_t unsortedStart = 1;
-
-      while(unsortedStart < arrayLen)
+      if (DTL_DV_IS_FROZEN(self))
       {
-         bool result = false;
-         dtl_error_t errorCode = DTL_NO_ERROR;
-         dtl_dv_type_id leftType, rightType;
-         dtl_dv_t *left = self->pAny->pFirst[unsortedStart-1];
-         dtl_dv_t *right = self->pAny->pFirst[unsortedStart];
-         assert( (left != 0) && (right != 0) );
-         leftType = dtl_dv_type(left);
-         rightType = dtl_dv_type(right);
-         if ( (leftType == DTL_DV_SCALAR) && (rightType == DTL_DV_SCALAR) )
-         {
-            errorCode = dtl_sv_lt( (dtl_sv_t*) left, (dtl_sv_t*) right, &result);
-         }
-         else
-         {
-            return DTL_TYPE_ERROR;
-         }
-
-         if (errorCode != DTL_NO_ERROR)
-         {
-            return errorCode;
-         }
-         else
-         {
-            if (reverse)
-            {
-               result = !result;
-            }
-            if (result == false)
-            {
-               int32_t i;
-               self->pAny->pFirst[unsortedStart] = left;
-               for(i=unsortedStart-1; i>0; i--)
-               {
-                  left = self->pAny->pFirst[i-1];
-                  leftType = dtl_dv_type(left);
-                  if ( (leftType == DTL_DV_SCALAR) )
-                  {
-                     errorCode = dtl_sv_lt( (dtl_sv_t*) left, (dtl_sv_t*) right, &result);
-                     if (errorCode != DTL_NO_ERROR)
-                     {
-                        return errorCode;
-                     }
-                  }
-                  else
-                  {
-                     return DTL_TYPE_ERROR;
-                  }
-                  if (reverse)
-                  {
-                     result = !result;
-                  }
-                  if (result == false)
-                  {
-                     self->pAny->pFirst[i] = left;
-                  }
-                  else
-                  {
-                     break;
-                  }
-               }
-               self->pAny->pFirst[i] = right;
-            }
-            unsortedStart++;
-         }
+         return DTL_FROZEN_ERROR;
       }
+      return dtl_sort_values_parallel((dtl_dv_t**) self->pAny->pFirst, (uint32_t) self->pAny->s32CurLen, key, reverse, u32NumThreads);
    }
-   return DTL_NO_ERROR;
+   return DTL_INVALID_ARGUMENT_ERROR;
 }
-
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
@@ -11,46 +11,96 @@
 #include "dtl_sv.h"
 #include "dtl_av.h"
 #include "dtl_hv.h"
+#include "dtl_phv.h"
+#include "dtl_pav.h"
+#include "dtl_tav.h"
+#include "dtl_pool.h"
+#include "dtl_refcnt.h"
+#include "dtl_reclaimer.h"
+#include <stdlib.h>
 #include <malloc.h>
+#include <assert.h>
 #ifdef MEM_LEAK_CHECK
 #include "CMemLeak.h"
 #endif
 
 
+/**************** Private Constants ******************************/
+#define DTL_DV_DELETE_MAX_DEPTH 32 //nested frees done directly before values are put on the worklist
+#define DTL_DV_MARK_MAX_DEPTH 32 //nesting levels marked directly before values are put on the worklist of dtl_dv_mark_tree
+
+/**************** Private Data Types ******************************/
+//values below DTL_DV_MARK_MAX_DEPTH that dtl_dv_mark_tree has not visited yet
+typedef struct dtl_dv_mark_list_tag{
+	dtl_dv_t **ppValues;
+	uint32_t u32Len;
+	uint32_t u32Capacity;
+} dtl_dv_mark_list_t;
+
 /**************** Private Function Declarations *******************/
 void dtl_dv_create(dtl_dv_t *self);
+static dtl_sv_t *dtl_dv_promote_sv(dtl_sv_t *sv);
+static dtl_av_t *dtl_dv_promote_av(dtl_av_t *av);
+static dtl_hv_t *dtl_dv_promote_hv(dtl_hv_t *hv);
+static void dtl_dv_free(dtl_dv_t *dv);
+static uint64_t dtl_dv_footprint(dtl_dv_t *dv);
+static void dtl_dv_mark_tree(dtl_dv_t *dv, uint32_t u32Flags);
+static void dtl_dv_mark_value(dtl_dv_t *dv, uint32_t u32Flags, uint32_t u32Depth, dtl_dv_mark_list_t *list);
+static void dtl_dv_mark_child(dtl_dv_t *dv, uint32_t u32Flags, uint32_t u32Depth, dtl_dv_mark_list_t *list);
 
 /**************** Private Variable Declarations *******************/
+static dtl_dv_t m_dtl_dv_null = {DTL_DV_HEAD_INIT((void*) 0, ((uint32_t)DTL_DV_NULL) | DTL_DV_FLAG_IMMORTAL | DTL_DV_FLAG_FROZEN)};
+//values waiting to be freed by the calling thread, linked through pAny (see dtl_dv_delete)
+static DTL_THREAD_LOCAL dtl_dv_t *m_dtl_dv_dead = (dtl_dv_t*) 0;
+static DTL_THREAD_LOCAL uint32_t m_dtl_dv_numDead = 0u;
+static DTL_THREAD_LOCAL uint32_t m_dtl_dv_deleteDepth = 0u;
+static DTL_THREAD_LOCAL bool m_dtl_dv_isReclaiming = false;
+static DTL_THREAD_LOCAL bool m_dtl_dv_isDeferred = false;
+//set while dtl_dv_free_tree runs, dtl_dv_free then counts what it releases
+static DTL_THREAD_LOCAL bool m_dtl_dv_isCounting = false;
+static DTL_THREAD_LOCAL uint32_t m_dtl_dv_numFreed = 0u;
+static DTL_THREAD_LOCAL uint64_t m_dtl_dv_bytesFreed = 0u;
 
 
 /****************** Public Function Definitions *******************/
 dtl_dv_t *dtl_dv_null(void){
 	dtl_dv_t *self;
-	if((self = (dtl_dv_t*)malloc(sizeof(dtl_dv_t)))==(dtl_dv_t*)0){
+	if((self = (dtl_dv_t*)dtl_pool_alloc(DTL_POOL_DV))==(dtl_dv_t*)0){
 		return (dtl_dv_t*)0;
 	}
 	dtl_dv_create(self);
 	return self;
 }
 
+dtl_dv_t *dtl_dv_const_null(void){
+	return &m_dtl_dv_null;
+}
+
+/**
+ * Children are freed directly while they are close to the top of the tree. Values nested deeper than
+ * DTL_DV_DELETE_MAX_DEPTH go on a thread-local worklist instead, which the outermost call empties,
+ * so the stack depth does not depend on how deeply the tree is nested.
+ * In deferred mode (dtl_reclaim_set_deferred) every value goes on the list and stays there until dtl_reclaim is called.
+ * While the reclaimer thread runs (dtl_reclaimer_start) a released container is handed to it instead of being freed here.
+ */
 void dtl_dv_delete(dtl_dv_t* dv ){
-	if(dv){
-		switch(dtl_dv_type(dv))
-		{
-		case DTL_DV_INVALID:
-			break;
-		case DTL_DV_NULL:
-			free(dv);
-			break;
-		case DTL_DV_SCALAR:
-			dtl_sv_delete((dtl_sv_t*) dv);
-			break;
-		case DTL_DV_ARRAY:
-			dtl_av_delete((dtl_av_t*) dv);
-			break;
-		case DTL_DV_HASH:
-			dtl_hv_delete((dtl_hv_t*) dv);
-			break;
+	if( (dv) && ((dv->u32Flags & (DTL_DV_FLAG_ARENA | DTL_DV_FLAG_IMMORTAL)) == 0u) ){
+		if( m_dtl_dv_isDeferred || (m_dtl_dv_deleteDepth >= DTL_DV_DELETE_MAX_DEPTH) ){
+			//pAny of a heap value always points into the value itself, it is restored in dtl_dv_free
+			dv->pAny = m_dtl_dv_dead;
+			m_dtl_dv_dead = dv;
+			m_dtl_dv_numDead++;
+			return;
+		}
+		if( (m_dtl_dv_deleteDepth == 0u) && ((dtl_dv_type(dv) == DTL_DV_ARRAY) || (dtl_dv_type(dv) == DTL_DV_HASH)) &&
+			dtl_reclaimer_handoff(dv) ){
+			return;
+		}
+		m_dtl_dv_deleteDepth++;
+		dtl_dv_free(dv);
+		m_dtl_dv_deleteDepth--;
+		if( (m_dtl_dv_deleteDepth == 0u) && (m_dtl_dv_dead != 0) && (!m_dtl_dv_isReclaiming) ){
+			(void) dtl_reclaim(UINT32_MAX);
 		}
 	}
 }
@@ -60,12 +110,45 @@ void dtl_dv_vdelete(void *arg){
 }
 
 void dtl_dv_inc_ref(dtl_dv_t* dv){
-	if(dv) dv->u32RefCnt++;
+	if( (dv) && ((dv->u32Flags & (DTL_DV_FLAG_ARENA | DTL_DV_FLAG_IMMORTAL)) == 0u) ){
+		if(DTL_DV_IS_ATOMIC(dv)){
+			dtl_atomic_inc_u32(&dv->u32RefCnt);
+		}
+#ifdef DTL_BIASED_REFCNT
+		else if(!DTL_REFCNT_IS_OWNER(dv)){
+			dtl_refcnt_shared_inc(dv);
+		}
+#endif
+		else{
+			dv->u32RefCnt++;
+		}
+	}
 }
+/**
+ * For atomic values the decrement has acquire/release ordering: all writes made by other owners
+ * happen before dtl_dv_delete runs in the thread that dropped the last reference.
+ * With biased reference counting the owner thread uses its local count, the value is deleted
+ * by whichever thread finds both counts at zero.
+ */
 void dtl_dv_dec_ref(dtl_dv_t* dv){
-	if( (dv) && (dv != (dtl_dv_t*)&g_dtl_sv_none) && (dv->u32RefCnt>0) )
+	if( (dv) && ((dv->u32Flags & (DTL_DV_FLAG_ARENA | DTL_DV_FLAG_IMMORTAL)) == 0u) )
 	{
-		if(--dv->u32RefCnt == 0) dtl_dv_delete(dv);
+		if(DTL_DV_IS_ATOMIC(dv)){
+			assert(dtl_atomic_load_u32(&dv->u32RefCnt) > 0u);
+			if(dtl_atomic_dec_u32(&dv->u32RefCnt) == 0u) dtl_dv_delete(dv);
+		}
+#ifdef DTL_BIASED_REFCNT
+		else if(!DTL_REFCNT_IS_OWNER(dv)){
+			if(dtl_refcnt_shared_dec(dv)) dtl_dv_delete(dv);
+		}
+		else if(--dv->u32RefCnt == 0){
+			if(dtl_refcnt_merge(dv)) dtl_dv_delete(dv);
+		}
+#else
+		else if(dv->u32RefCnt>0){
+			if(--dv->u32RefCnt == 0) dtl_dv_delete(dv);
+		}
+#endif
 	}
 }
 dtl_dv_type_id dtl_dv_type(const dtl_dv_t* dv){
@@ -79,14 +162,416 @@ void dtl_dv_dec_ref_void(void* ptr){
 	dtl_dv_dec_ref( (dtl_dv_t*) ptr);
 }
 
+/**
+ * Returns a heap copy of an arena value that stays valid after the arena has been reset.
+ * Arena values are copied recursively, heap values reachable from the tree are shared (their reference count is incremented).
+ * Ownership of pointer scalars moves to the copy, the arena scalar no longer calls the destructor.
+ * For a heap value the value itself is returned with an incremented reference count.
+ * The caller owns one reference to the returned value.
+ */
+dtl_dv_t *dtl_dv_promote(dtl_dv_t *dv){
+	if(!dv) return (dtl_dv_t*)0;
+	if( (dv->u32Flags & DTL_DV_FLAG_ARENA) == 0u ){
+		dtl_dv_inc_ref(dv);
+		return dv;
+	}
+	switch(dtl_dv_type(dv))
+	{
+	case DTL_DV_NULL:
+		return dtl_dv_const_null();
+	case DTL_DV_SCALAR:
+		return (dtl_dv_t*) dtl_dv_promote_sv((dtl_sv_t*) dv);
+	case DTL_DV_ARRAY:
+		return (dtl_dv_t*) dtl_dv_promote_av((dtl_av_t*) dv);
+	case DTL_DV_HASH:
+		return (dtl_dv_t*) dtl_dv_promote_hv((dtl_hv_t*) dv);
+	default:
+		break;
+	}
+	return (dtl_dv_t*)0;
+}
+
+/**
+ * Switches dv and every value reachable from it to atomic reference counting (DTL_DV_FLAG_ATOMIC).
+ * Afterwards the tree can be handed to other threads, which may read it and take or drop references concurrently.
+ * Call it once the tree is complete: values added later are not marked, and the containers themselves are not
+ * safe to modify while shared. Scalars marked atomic no longer fill their dual-value cache.
+ * Arena and immortal values have no reference count and are left as they are, but heap values below them are marked.
+ * With DTL_BIASED_REFCNT every value can already be shared and this function does nothing.
+ */
+void dtl_dv_set_atomic(dtl_dv_t *dv){
+#ifdef DTL_BIASED_REFCNT
+	(void) dv;
+	return;
+#else
+	dtl_dv_mark_tree(dv, DTL_DV_FLAG_ATOMIC);
+#endif
+}
+
+/**
+ * Makes dv and everything reachable from it immutable. Setters on a frozen value leave it unchanged
+ * (functions that report errors return DTL_FROZEN_ERROR) and its read functions never write to it,
+ * including dtl_sv_to_cstr and the numeric conversions that otherwise fill the scalar's cache.
+ * Reference counts become atomic as with dtl_dv_set_atomic, so a frozen tree can be read, shared and released
+ * by any number of threads without locks. dtl_hv_iter_init/dtl_hv_iter_next_cstr store their position in the hash
+ * and are the exception, use dtl_hv_iter_begin/dtl_hv_iter_next to walk a hash that other threads read at the same time.
+ * Freezing cannot be undone.
+ */
+void dtl_dv_freeze(dtl_dv_t *dv){
+#ifdef DTL_BIASED_REFCNT
+	dtl_dv_mark_tree(dv, DTL_DV_FLAG_FROZEN);
+#else
+	dtl_dv_mark_tree(dv, DTL_DV_FLAG_FROZEN | DTL_DV_FLAG_ATOMIC);
+#endif
+}
+
+bool dtl_dv_is_frozen(const dtl_dv_t *dv){
+	return (dv != 0) && DTL_DV_IS_FROZEN(dv);
+}
+
+/**
+ * Biased reference counting: merges the values owned by the calling thread whose last references were dropped
+ * by other threads, and frees those that are no longer referenced. This happens automatically when the thread
+ * creates values or exits, a thread that hands out values but rarely creates new ones can call it periodically.
+ */
+void dtl_dv_refcnt_merge(void){
+#ifdef DTL_BIASED_REFCNT
+	dtl_refcnt_merge_queued();
+#endif
+}
+
+/**
+ * Frees up to u32Budget values from the calling thread's list of dead values and returns how many were freed.
+ * Children released by a freed container are only added to the list, they count against the budget
+ * when they are freed themselves. Calls made while the list is already being processed return 0.
+ */
+uint32_t dtl_reclaim(uint32_t u32Budget){
+	uint32_t u32NumFreed = 0u;
+	if(m_dtl_dv_isReclaiming) return 0u;
+	m_dtl_dv_isReclaiming = true;
+	while( (u32NumFreed < u32Budget) && (m_dtl_dv_dead != 0) ){
+		dtl_dv_t *dv = m_dtl_dv_dead;
+		m_dtl_dv_dead = (dtl_dv_t*) dv->pAny;
+		m_dtl_dv_numDead--;
+		m_dtl_dv_deleteDepth++;
+		dtl_dv_free(dv);
+		m_dtl_dv_deleteDepth--;
+		u32NumFreed++;
+	}
+	m_dtl_dv_isReclaiming = false;
+	return u32NumFreed;
+}
+
+/**
+ * Number of dead values the calling thread has not freed yet.
+ */
+uint32_t dtl_reclaim_pending(void){
+	return m_dtl_dv_numDead;
+}
+
+/**
+ * In deferred mode values released by the calling thread are not freed until it calls dtl_reclaim,
+ * which lets an event loop spread the cost of freeing a large tree over several iterations.
+ * Values still pending when deferred mode is turned off are freed by the next release or dtl_reclaim call.
+ * A thread must not exit with values pending, they would never be freed.
+ */
+void dtl_reclaim_set_deferred(bool isDeferred){
+	m_dtl_dv_isDeferred = isDeferred;
+}
+
+/**
+ * Frees dv and everything it releases on the calling thread, bypassing the reclaimer.
+ * Returns the number of values freed and adds their approximate size to *pu64NumBytes.
+ */
+uint32_t dtl_dv_free_tree(dtl_dv_t *dv, uint64_t *pu64NumBytes){
+	uint32_t u32NumFreed;
+	m_dtl_dv_isCounting = true;
+	m_dtl_dv_numFreed = 0u;
+	m_dtl_dv_bytesFreed = 0u;
+	m_dtl_dv_deleteDepth++;
+	dtl_dv_free(dv);
+	m_dtl_dv_deleteDepth--;
+	(void) dtl_reclaim(UINT32_MAX);
+	m_dtl_dv_isCounting = false;
+	u32NumFreed = m_dtl_dv_numFreed;
+	*pu64NumBytes += m_dtl_dv_bytesFreed;
+	return u32NumFreed;
+}
+
 /***************** Private Function Definitions *******************/
 void dtl_dv_create(dtl_dv_t *self){
 	if(self){
 		self->pAny = (void*) 0;
-		self->u32RefCnt = 1;
 		self->u32Flags =  ((uint32_t)DTL_DV_NULL);
+		dtl_refcnt_init(self);
 	}
 }
 
+static void dtl_dv_free(dtl_dv_t *dv){
+	if(m_dtl_dv_isCounting){
+		m_dtl_dv_numFreed++;
+		m_dtl_dv_bytesFreed += dtl_dv_footprint(dv);
+	}
+	switch(dtl_dv_type(dv))
+	{
+	case DTL_DV_INVALID:
+		break;
+	case DTL_DV_NULL:
+		dtl_pool_free(DTL_POOL_DV, dv);
+		break;
+	case DTL_DV_SCALAR:
+		dv->pAny = &((dtl_sv_t*) dv)->svx;
+		dtl_sv_delete((dtl_sv_t*) dv);
+		break;
+	case DTL_DV_ARRAY:
+		dv->pAny = &((dtl_av_t*) dv)->ary;
+		dtl_av_delete((dtl_av_t*) dv);
+		break;
+	case DTL_DV_HASH:
+		dv->pAny = &((dtl_hv_t*) dv)->hash;
+		dtl_hv_delete((dtl_hv_t*) dv);
+		break;
+	case DTL_DV_PHASH:
+		dv->pAny = &((dtl_phv_t*) dv)->data;
+		dtl_phv_delete((dtl_phv_t*) dv);
+		break;
+	case DTL_DV_PARRAY:
+		dv->pAny = &((dtl_pav_t*) dv)->data;
+		dtl_pav_delete((dtl_pav_t*) dv);
+		break;
+	case DTL_DV_TYPED_ARRAY:
+		dv->pAny = &((dtl_tav_t*) dv)->data;
+		dtl_tav_delete((dtl_tav_t*) dv);
+		break;
+	}
+}
+
+/**
+ * Sets u32Flags on dv and everything reachable from it. Immortal values are skipped, arena values are not
+ * reference counted and never become atomic. A frozen subtree already has all flags freezing sets and cannot
+ * have gained children since, it is not visited again.
+ * Values nested deeper than DTL_DV_MARK_MAX_DEPTH go on a worklist that is emptied before returning, so the stack depth
+ * does not depend on how deeply the tree is nested (see dtl_dv_delete).
+ */
+static void dtl_dv_mark_tree(dtl_dv_t *dv, uint32_t u32Flags){
+	dtl_dv_mark_list_t list = {(dtl_dv_t**) 0, 0u, 0u};
+	dtl_dv_mark_value(dv, u32Flags, 0u, &list);
+	while(list.u32Len > 0u){
+		dv = list.ppValues[--list.u32Len];
+		dtl_dv_mark_value(dv, u32Flags, 0u, &list);
+	}
+	free(list.ppValues);
+}
+
+/**
+ * Marks dv, u32Depth levels below the value dtl_dv_mark_tree started from or took from its worklist.
+ */
+static void dtl_dv_mark_value(dtl_dv_t *dv, uint32_t u32Flags, uint32_t u32Depth, dtl_dv_mark_list_t *list){
+	if( (!dv) || ((dv->u32Flags & DTL_DV_FLAG_IMMORTAL) != 0u) ) return;
+	if( DTL_DV_IS_FROZEN(dv) && ((u32Flags & DTL_DV_FLAG_FROZEN) != 0u) ) return;
+	if( (dv->u32Flags & DTL_DV_FLAG_ARENA) != 0u ){
+		dv->u32Flags |= (u32Flags & ~((uint32_t) DTL_DV_FLAG_ATOMIC));
+	}
+	else{
+		dv->u32Flags |= u32Flags;
+	}
+	switch(dtl_dv_type(dv))
+	{
+	case DTL_DV_SCALAR:
+		if(dtl_sv_type((dtl_sv_t*) dv) == DTL_SV_DV){
+			dtl_dv_mark_child(((dtl_sv_t*) dv)->svx.val.dv, u32Flags, u32Depth, list);
+		}
+		break;
+	case DTL_DV_ARRAY:
+		{
+			int32_t s32i;
+			int32_t s32Len = dtl_av_length((dtl_av_t*) dv);
+			for(s32i=0;s32i<s32Len;s32i++){
+				dtl_dv_mark_child(dtl_av_value((dtl_av_t*) dv, s32i), u32Flags, u32Depth, list);
+			}
+		}
+		break;
+	case DTL_DV_HASH:
+		{
+			dtl_hv_iter_t iter;
+			dtl_hv_iter_begin((dtl_hv_t*) dv, &iter);
+			while(dtl_hv_iter_next(&iter)){
+				dtl_dv_mark_child(iter.dv, u32Flags, u32Depth, list);
+			}
+		}
+		break;
+	case DTL_DV_PHASH:
+		{
+			dtl_dv_t *child;
+			dtl_phv_iter_t iter;
+			dtl_phv_iter_init((dtl_phv_t*) dv, &iter);
+			while( (child = dtl_phv_iter_next_cstr(&iter, (const char**) 0)) != 0 ){
+				dtl_dv_mark_child(child, u32Flags, u32Depth, list);
+			}
+		}
+		break;
+	case DTL_DV_PARRAY:
+		{
+			int32_t s32i;
+			int32_t s32Len = dtl_pav_length((dtl_pav_t*) dv);
+			for(s32i=0;s32i<s32Len;s32i++){
+				dtl_dv_mark_child(dtl_pav_value((dtl_pav_t*) dv, s32i), u32Flags, u32Depth, list);
+			}
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+/**
+ * Marks a child of a value at u32Depth directly, or puts it on the worklist when the nesting gets too deep.
+ * Should the worklist fail to grow the child is marked directly, only running out of memory makes the stack depth unbounded.
+ */
+static void dtl_dv_mark_child(dtl_dv_t *dv, uint32_t u32Flags, uint32_t u32Depth, dtl_dv_mark_list_t *list){
+	if(!dv) return;
+	if(u32Depth + 1u >= DTL_DV_MARK_MAX_DEPTH){
+		if(list->u32Len == list->u32Capacity){
+			uint32_t u32Capacity = (list->u32Capacity == 0u)? 64u : list->u32Capacity * 2u;
+			dtl_dv_t **ppValues = (dtl_dv_t**) realloc(list->ppValues, (size_t) u32Capacity * sizeof(dtl_dv_t*));
+			if(ppValues){
+				list->ppValues = ppValues;
+				list->u32Capacity = u32Capacity;
+			}
+		}
+		if(list->u32Len < list->u32Capacity){
+			list->ppValues[list->u32Len++] = dv;
+			return;
+		}
+	}
+	dtl_dv_mark_value(dv, u32Flags, u32Depth + 1u, list);
+}
+
+/**
+ * Approximate heap memory owned by dv itself: the value block plus array storage (element buffer of a typed array), hash entries,
+ * or the buffer of a non-inline string. Children are counted when they are freed.
+ * Trie nodes of persistent values may be shared with other versions and are not counted.
+ */
+static uint64_t dtl_dv_footprint(dtl_dv_t *dv){
+	uint64_t u64Size = 0u;
+	switch(dtl_dv_type(dv))
+	{
+	case DTL_DV_INVALID:
+		break;
+	case DTL_DV_NULL:
+		u64Size = sizeof(dtl_dv_t);
+		break;
+	case DTL_DV_SCALAR:
+		u64Size = sizeof(dtl_sv_t);
+		if( (dtl_sv_type((dtl_sv_t*) dv) == DTL_SV_STR) && ((dv->u32Flags & (DTL_DV_FLAG_SSO | DTL_DV_FLAG_ATOM)) == 0u) ){
+			adt_str_t *str = ((dtl_sv_t*) dv)->svx.val.str;
+			if(str) u64Size += sizeof(adt_str_t) + (uint64_t) str->s32Size;
+		}
+		break;
+	case DTL_DV_ARRAY:
+		u64Size = sizeof(dtl_av_t) + (uint64_t) ((dtl_av_t*) dv)->ary.s32AllocLen * sizeof(void*);
+		break;
+	case DTL_DV_HASH:
+		u64Size = sizeof(dtl_hv_t) + dtl_htab_footprint(&((dtl_hv_t*) dv)->hash);
+		break;
+	case DTL_DV_PHASH:
+		u64Size = sizeof(dtl_phv_t);
+		break;
+	case DTL_DV_PARRAY:
+		u64Size = sizeof(dtl_pav_t);
+		break;
+	case DTL_DV_TYPED_ARRAY:
+		u64Size = sizeof(dtl_tav_t) + (uint64_t) ((dtl_tav_t*) dv)->data.u32Capacity * ((dtl_tav_t*) dv)->data.u8ElemSize;
+		break;
+	}
+	return u64Size;
+}
+
+static dtl_sv_t *dtl_dv_promote_sv(dtl_sv_t *sv){
+	dtl_sv_t *self = dtl_sv_new();
+	if(!self) return (dtl_sv_t*)0;
+	switch(dtl_sv_type(sv))
+	{
+	case DTL_SV_NONE:
+		break;
+	case DTL_SV_I32:
+		dtl_sv_set_i32(self, sv->svx.val.i32);
+		break;
+	case DTL_SV_U32:
+		dtl_sv_set_u32(self, sv->svx.val.u32);
+		break;
+	case DTL_SV_I64:
+		dtl_sv_set_i64(self, sv->svx.val.i64);
+		break;
+	case DTL_SV_U64:
+		dtl_sv_set_u64(self, sv->svx.val.u64);
+		break;
+	case DTL_SV_FLT:
+		dtl_sv_set_flt(self, sv->svx.val.flt);
+		break;
+	case DTL_SV_DBL:
+		dtl_sv_set_dbl(self, sv->svx.val.dbl);
+		break;
+	case DTL_SV_CHAR:
+		dtl_sv_set_char(self, sv->svx.val.cr);
+		break;
+	case DTL_SV_BOOL:
+		dtl_sv_set_bool(self, sv->svx.val.bl);
+		break;
+	case DTL_SV_STR:
+		if( (sv->u32Flags & DTL_DV_FLAG_ATOM) != 0u ){
+			dtl_sv_set_atom(self, sv->svx.val.atom);
+		}
+		else if( (sv->u32Flags & DTL_DV_FLAG_SSO) != 0u ){
+			const uint8_t *pBegin = (const uint8_t*) sv->svx.val.sso;
+			dtl_sv_set_bstr(self, pBegin, pBegin + (DTL_SV_SSO_CAPACITY - (uint8_t) sv->svx.val.sso[DTL_SV_SSO_CAPACITY]));
+		}
+		else{
+			dtl_sv_set_str(self, sv->svx.val.str);
+		}
+		break;
+	case DTL_SV_PTR:
+		dtl_sv_set_ptr(self, sv->svx.val.ptr.p, sv->svx.val.ptr.pDestructor);
+		sv->svx.val.ptr.pDestructor = 0;
+		break;
+	case DTL_SV_DV:
+		dtl_sv_set_dv(self, dtl_dv_promote(sv->svx.val.dv), false);
+		break;
+	case DTL_SV_BYTES:
+		dtl_sv_set_bytes(self, sv->svx.val.bytes);
+		break;
+	case DTL_SV_BYTEARRAY:
+		dtl_sv_set_bytearray(self, sv->svx.val.bytearray);
+		break;
+	}
+	return self;
+}
+
+static dtl_av_t *dtl_dv_promote_av(dtl_av_t *av){
+	dtl_av_t *self = dtl_av_new();
+	if(self){
+		int32_t s32i;
+		int32_t s32Len = dtl_av_length(av);
+		for(s32i=0;s32i<s32Len;s32i++){
+			dtl_av_push(self, dtl_dv_promote(dtl_av_value(av, s32i)), false);
+		}
+	}
+	return self;
+}
+
+static dtl_hv_t *dtl_dv_promote_hv(dtl_hv_t *hv){
+	dtl_hv_t *self = dtl_hv_new();
+	if(self){
+		dtl_hv_iter_t iter;
+		(void) dtl_hv_reserve(self, dtl_hv_length(hv));
+		dtl_hv_iter_begin(hv, &iter);
+		while(dtl_hv_iter_next(&iter)){
+			//keys are copied by length (they may contain NUL bytes) and keep their cached hash
+			dtl_hv_set_hashed(self, (const uint8_t*) iter.pKey, (const uint8_t*) iter.pKey + iter.u32KeyLen, iter.u32KeyHash, dtl_dv_promote(iter.dv), false);
+		}
+	}
+	return self;
+}
+
 /************************ Task Definition *************************/
 
@@ -0,0 +1,508 @@
+/*****************************************************************************
+* \file      dtl_htab.c
+* \author    Conny Gustafsson
+* \date      2026-10-17
+* \brief     Open addressing string-keyed hash table used by dtl_hv_t
+*
+* Copyright (c) 2026 Conny Gustafsson
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "dtl_htab.h"
+#if !defined(DTL_HTAB_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2)))
+#define DTL_HTAB_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define CTRL_EMPTY      0x80u
+#define CTRL_REMOVED    0xFEu //also set in the high bit, full slots hold the low 7 bits of the hash (H2)
+#define NOT_FOUND       UINT32_MAX
+
+#ifdef DTL_HTAB_SSE2
+#define GROUP_WIDTH 16u
+typedef uint32_t dtl_htab_mask_t; //bit i set for slot i of the group
+#else
+#define GROUP_WIDTH 8u
+typedef uint64_t dtl_htab_mask_t; //bit 8*i+7 set for slot i of the group
+#define LSB_BYTES 0x0101010101010101ull
+#define MSB_BYTES 0x8080808080808080ull
+#endif
+
+#define H1(u32Hash) ((u32Hash) >> 7)
+#define H2(u32Hash) ((uint8_t) ((u32Hash) & 0x7Fu))
+
+#if defined(__GNUC__) || defined(__clang__)
+#define PREFETCH(pAddr) __builtin_prefetch(pAddr)
+#else
+#define PREFETCH(pAddr)
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static uint32_t dtl_htab_find_slot(const dtl_htab_t *self, const char *pKey, uint32_t u32KeyLen, uint32_t u32Hash);
+static uint32_t dtl_htab_find_free(const uint8_t *pCtrl, uint32_t u32Capacity, uint32_t u32Hash);
+static bool dtl_htab_grow(dtl_htab_t *self);
+static bool dtl_htab_rebuild(dtl_htab_t *self, uint32_t u32Capacity);
+
+static inline uint32_t dtl_htab_max_load(uint32_t u32Capacity)
+{
+   return u32Capacity - (u32Capacity / 8u);
+}
+
+#ifdef DTL_HTAB_SSE2
+static inline dtl_htab_mask_t dtl_htab_match(const uint8_t *pGroup, uint8_t u8Byte)
+{
+   __m128i group = _mm_loadu_si128((const __m128i*) pGroup);
+   return (dtl_htab_mask_t) _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char) u8Byte)));
+}
+
+static inline dtl_htab_mask_t dtl_htab_match_empty(const uint8_t *pGroup)
+{
+   return dtl_htab_match(pGroup, (uint8_t) CTRL_EMPTY);
+}
+
+static inline dtl_htab_mask_t dtl_htab_match_free(const uint8_t *pGroup)
+{
+   return (dtl_htab_mask_t) _mm_movemask_epi8(_mm_loadu_si128((const __m128i*) pGroup));
+}
+
+static inline uint32_t dtl_htab_mask_first(dtl_htab_mask_t mask)
+{
+#ifdef _MSC_VER
+   unsigned long index;
+   _BitScanForward(&index, mask);
+   return (uint32_t) index;
+#else
+   return (uint32_t) __builtin_ctz(mask);
+#endif
+}
+#else
+static inline uint64_t dtl_htab_load_group(const uint8_t *pGroup)
+{
+   uint64_t u64Group;
+   memcpy(&u64Group, pGroup, sizeof(u64Group));
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+   u64Group = __builtin_bswap64(u64Group);
+#endif
+   return u64Group;
+}
+
+//may report a false match above a real one, candidates are always compared by hash and key
+static inline dtl_htab_mask_t dtl_htab_match(const uint8_t *pGroup, uint8_t u8Byte)
+{
+   uint64_t u64Diff = dtl_htab_load_group(pGroup) ^ (LSB_BYTES * u8Byte);
+   return (u64Diff - LSB_BYTES) & ~u64Diff & MSB_BYTES;
+}
+
+static inline dtl_htab_mask_t dtl_htab_match_empty(const uint8_t *pGroup)
+{
+   uint64_t u64Group = dtl_htab_load_group(pGroup);
+   return u64Group & ~(u64Group << 6) & MSB_BYTES; //high bit set and bit 1 clear
+}
+
+static inline dtl_htab_mask_t dtl_htab_match_free(const uint8_t *pGroup)
+{
+   return dtl_htab_load_group(pGroup) & MSB_BYTES;
+}
+
+static inline uint32_t dtl_htab_mask_first(dtl_htab_mask_t mask)
+{
+#ifdef _MSC_VER
+   unsigned long index;
+   _BitScanForward64(&index, mask);
+   return (uint32_t) index >> 3;
+#else
+   return (uint32_t) __builtin_ctzll(mask) >> 3;
+#endif
+}
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+void dtl_htab_create(dtl_htab_t *self, void (*pDestructor)(void*))
+{
+   if (self != 0)
+   {
+      self->pEntries = (dtl_htab_entry_t*) 0;
+      self->pSlots = (uint32_t*) 0;
+      self->pCtrl = (uint8_t*) 0;
+      self->u32Capacity = 0u;
+      self->u32NumEntries = 0u;
+      self->u32Length = 0u;
+      self->u32IterPos = 0u;
+      self->pDestructor = pDestructor;
+   }
+}
+
+void dtl_htab_destroy(dtl_htab_t *self)
+{
+   if (self != 0)
+   {
+      uint32_t i;
+      for (i = 0u; i < self->u32NumEntries; i++)
+      {
+         dtl_htab_entry_t *entry = &self->pEntries[i];
+         if (entry->u32KeyLen != DTL_HTAB_REMOVED)
+         {
+            if (entry->u32KeyLen >= DTL_HTAB_INLINE_KEY_SIZE)
+            {
+               free(entry->key.pHeap);
+            }
+            if (self->pDestructor != 0)
+            {
+               self->pDestructor(entry->pVal);
+            }
+         }
+      }
+      free(self->pEntries);
+      dtl_htab_create(self, self->pDestructor);
+   }
+}
+
+/**
+ * Returns a pointer to the value stored under the key, or NULL when the key is not in the table.
+ */
+void **dtl_htab_find(const dtl_htab_t *self, const char *pKey, uint32_t u32KeyLen, uint32_t u32Hash)
+{
+   uint32_t u32Slot = dtl_htab_find_slot(self, pKey, u32KeyLen, u32Hash);
+   if (u32Slot != NOT_FOUND)
+   {
+      return &self->pEntries[self->pSlots[u32Slot]].pVal;
+   }
+   return (void**) 0;
+}
+
+/**
+ * Returns a pointer to the value stored under the key. A missing key is added with a NULL value and
+ * *pIsNew is set to true. Returns NULL when out of memory. The pointer is valid until the next insertion.
+ */
+void **dtl_htab_insert(dtl_htab_t *self, const char *pKey, uint32_t u32KeyLen, uint32_t u32Hash, bool *pIsNew)
+{
+   dtl_htab_entry_t *entry;
+   uint32_t u32Slot;
+   char *pHeapKey = (char*) 0;
+   if ( (self == 0) || (pKey == 0) || (u32KeyLen == DTL_HTAB_REMOVED) )
+   {
+      return (void**) 0;
+   }
+   u32Slot = dtl_htab_find_slot(self, pKey, u32KeyLen, u32Hash);
+   if (u32Slot != NOT_FOUND)
+   {
+      if (pIsNew != 0)
+      {
+         *pIsNew = false;
+      }
+      return &self->pEntries[self->pSlots[u32Slot]].pVal;
+   }
+   if (u32KeyLen >= DTL_HTAB_INLINE_KEY_SIZE)
+   {
+      pHeapKey = (char*) malloc(u32KeyLen + 1u);
+      if (pHeapKey == 0)
+      {
+         return (void**) 0;
+      }
+      memcpy(pHeapKey, pKey, u32KeyLen);
+      pHeapKey[u32KeyLen] = '\0';
+   }
+   if ( (self->u32NumEntries == dtl_htab_max_load(self->u32Capacity)) && (!dtl_htab_grow(self)) )
+   {
+      free(pHeapKey);
+      return (void**) 0;
+   }
+   u32Slot = dtl_htab_find_free(self->pCtrl, self->u32Capacity, u32Hash);
+   self->pCtrl[u32Slot] = H2(u32Hash);
+   self->pSlots[u32Slot] = self->u32NumEntries;
+   entry = &self->pEntries[self->u32NumEntries++];
+   self->u32Length++;
+   entry->pVal = (void*) 0;
+   entry->u32Hash = u32Hash;
+   entry->u32KeyLen = u32KeyLen;
+   if (pHeapKey != 0)
+   {
+      entry->key.pHeap = pHeapKey;
+   }
+   else
+   {
+      memcpy(entry->key.acInline, pKey, u32KeyLen);
+      entry->key.acInline[u32KeyLen] = '\0';
+   }
+   if (pIsNew != 0)
+   {
+      *pIsNew = true;
+   }
+   return &entry->pVal;
+}
+
+/**
+ * Removes the key and stores its value in *ppVal (the destructor is not called). Returns false when the key is not in the table.
+ */
+bool dtl_htab_remove(dtl_htab_t *self, const char *pKey, uint32_t u32KeyLen, uint32_t u32Hash, void **ppVal)
+{
+   dtl_htab_entry_t *entry;
+   uint32_t u32Slot = dtl_htab_find_slot(self, pKey, u32KeyLen, u32Hash);
+   if (u32Slot == NOT_FOUND)
+   {
+      return false;
+   }
+   entry = &self->pEntries[self->pSlots[u32Slot]];
+   if (ppVal != 0)
+   {
+      *ppVal = entry->pVal;
+   }
+   if (entry->u32KeyLen >= DTL_HTAB_INLINE_KEY_SIZE)
+   {
+      free(entry->key.pHeap);
+   }
+   entry->u32KeyLen = DTL_HTAB_REMOVED;
+   entry->pVal = (void*) 0;
+   //a group that still has an empty slot never made a probe move on, so the slot can become empty again
+   self->pCtrl[u32Slot] = (dtl_htab_match_empty(&self->pCtrl[u32Slot & ~(GROUP_WIDTH - 1u)]) != 0u)? (uint8_t) CTRL_EMPTY : (uint8_t) CTRL_REMOVED;
+   self->u32Length--;
+   if (self->u32Length == 0u)
+   {
+      memset(self->pCtrl, CTRL_EMPTY, self->u32Capacity);
+      self->u32NumEntries = 0u;
+      self->u32IterPos = 0u;
+   }
+   return true;
+}
+
+/**
+ * Makes room for u32Count entries in total, so that adding keys up to that count allocates nothing and never
+ * rebuilds the table. Removed entries are dropped if the table has to be rebuilt. Returns false when out of memory.
+ */
+bool dtl_htab_reserve(dtl_htab_t *self, uint32_t u32Count)
+{
+   uint32_t u32Capacity = GROUP_WIDTH;
+   if (self == 0)
+   {
+      return false;
+   }
+   if ( (u32Count <= self->u32Length) ||
+        ((u32Count - self->u32Length) <= (dtl_htab_max_load(self->u32Capacity) - self->u32NumEntries)) )
+   {
+      return true;
+   }
+   while (dtl_htab_max_load(u32Capacity) < u32Count)
+   {
+      if (u32Capacity > (UINT32_MAX / 2u))
+      {
+         return false;
+      }
+      u32Capacity *= 2u;
+   }
+   return dtl_htab_rebuild(self, u32Capacity);
+}
+
+uint32_t dtl_htab_length(const dtl_htab_t *self)
+{
+   return (self != 0)? self->u32Length : 0u;
+}
+
+/**
+ * Memory held by the table, not counting keys too long to be stored in their entry.
+ */
+uint64_t dtl_htab_footprint(const dtl_htab_t *self)
+{
+   if (self != 0)
+   {
+      return (uint64_t) dtl_htab_max_load(self->u32Capacity) * sizeof(dtl_htab_entry_t) +
+         (uint64_t) self->u32Capacity * (sizeof(uint32_t) + 1u);
+   }
+   return 0u;
+}
+
+/**
+ * Returns the entry at or after *pu32Pos and moves *pu32Pos past it, or NULL after the last entry.
+ * Removing entries does not move the others, so the walk may remove the entry it has just been given.
+ */
+const dtl_htab_entry_t *dtl_htab_next(const dtl_htab_t *self, uint32_t *pu32Pos)
+{
+   if ( (self != 0) && (pu32Pos != 0) )
+   {
+      while (*pu32Pos < self->u32NumEntries)
+      {
+         const dtl_htab_entry_t *entry = &self->pEntries[(*pu32Pos)++];
+         if (entry->u32KeyLen != DTL_HTAB_REMOVED)
+         {
+            return entry;
+         }
+      }
+   }
+   return (const dtl_htab_entry_t*) 0;
+}
+
+void dtl_htab_iter_init(dtl_htab_t *self)
+{
+   if (self != 0)
+   {
+      self->u32IterPos = 0u;
+   }
+}
+
+const dtl_htab_entry_t *dtl_htab_iter_next(dtl_htab_t *self)
+{
+   return (self != 0)? dtl_htab_next(self, &self->u32IterPos) : (const dtl_htab_entry_t*) 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+/**
+ * Groups are probed in triangular order (1, 2, 3, ... groups apart), which visits every group of a power of two table.
+ */
+static uint32_t dtl_htab_find_slot(const dtl_htab_t *self, const char *pKey, uint32_t u32KeyLen, uint32_t u32Hash)
+{
+   uint32_t u32GroupMask;
+   uint32_t u32Group;
+   uint32_t u32Step = 0u;
+   uint8_t u8H2 = H2(u32Hash);
+   if ( (self == 0) || (self->u32Capacity == 0u) || (pKey == 0) )
+   {
+      return NOT_FOUND;
+   }
+   u32GroupMask = (self->u32Capacity / GROUP_WIDTH) - 1u;
+   u32Group = H1(u32Hash) & u32GroupMask;
+   //the slot indices of a group share a cache line, fetching it now overlaps its miss with the one on the control bytes
+   PREFETCH(&self->pSlots[u32Group * GROUP_WIDTH]);
+   for (;;)
+   {
+      const uint8_t *pGroup = &self->pCtrl[u32Group * GROUP_WIDTH];
+      dtl_htab_mask_t mask = dtl_htab_match(pGroup, u8H2);
+      while (mask != 0u)
+      {
+         uint32_t u32Slot = (u32Group * GROUP_WIDTH) + dtl_htab_mask_first(mask);
+         const dtl_htab_entry_t *entry = &self->pEntries[self->pSlots[u32Slot]];
+         if ( (entry->u32Hash == u32Hash) && (entry->u32KeyLen == u32KeyLen) &&
+              (memcmp(dtl_htab_entry_key(entry), pKey, u32KeyLen) == 0) )
+         {
+            return u32Slot;
+         }
+         mask &= mask - 1u;
+      }
+      if (dtl_htab_match_empty(pGroup) != 0u)
+      {
+         return NOT_FOUND;
+      }
+      u32Step++;
+      u32Group = (u32Group + u32Step) & u32GroupMask;
+   }
+}
+
+static uint32_t dtl_htab_find_free(const uint8_t *pCtrl, uint32_t u32Capacity, uint32_t u32Hash)
+{
+   uint32_t u32GroupMask = (u32Capacity / GROUP_WIDTH) - 1u;
+   uint32_t u32Group = H1(u32Hash) & u32GroupMask;
+   uint32_t u32Step = 0u;
+   for (;;)
+   {
+      dtl_htab_mask_t mask = dtl_htab_match_free(&pCtrl[u32Group * GROUP_WIDTH]);
+      if (mask != 0u)
+      {
+         return (u32Group * GROUP_WIDTH) + dtl_htab_mask_first(mask);
+      }
+      u32Step++;
+      u32Group = (u32Group + u32Step) & u32GroupMask;
+   }
+}
+
+/**
+ * Makes room for one more entry. When at most half of the entries are still in use the table keeps its size and
+ * only drops the removed entries, otherwise the capacity is doubled.
+ */
+static bool dtl_htab_grow(dtl_htab_t *self)
+{
+   uint32_t u32Capacity = self->u32Capacity;
+   if (u32Capacity == 0u)
+   {
+      u32Capacity = GROUP_WIDTH;
+   }
+   else if ( (self->u32Length + 1u) > (dtl_htab_max_load(u32Capacity) / 2u) )
+   {
+      if (u32Capacity > (UINT32_MAX / 2u))
+      {
+         return false;
+      }
+      u32Capacity *= 2u;
+   }
+   return dtl_htab_rebuild(self, u32Capacity);
+}
+
+/**
+ * Moves the live entries (in order) into a new allocation with u32Capacity slots and indexes them again.
+ */
+static bool dtl_htab_rebuild(dtl_htab_t *self, uint32_t u32Capacity)
+{
+   size_t entriesSize = (size_t) dtl_htab_max_load(u32Capacity) * sizeof(dtl_htab_entry_t);
+   uint8_t *pBlock = (uint8_t*) malloc(entriesSize + (size_t) u32Capacity * (sizeof(uint32_t) + 1u));
+   dtl_htab_entry_t *pEntries;
+   uint32_t *pSlots;
+   uint8_t *pCtrl;
+   uint32_t u32NumEntries = 0u;
+   uint32_t u32IterPos = 0u;
+   uint32_t i;
+   if (pBlock == 0)
+   {
+      return false;
+   }
+   pEntries = (dtl_htab_entry_t*) pBlock;
+   pSlots = (uint32_t*) (pBlock + entriesSize);
+   pCtrl = (uint8_t*) (pSlots + u32Capacity);
+   memset(pCtrl, CTRL_EMPTY, u32Capacity);
+   for (i = 0u; i < self->u32NumEntries; i++)
+   {
+      const dtl_htab_entry_t *entry = &self->pEntries[i];
+      if (entry->u32KeyLen != DTL_HTAB_REMOVED)
+      {
+         uint32_t u32Slot = dtl_htab_find_free(pCtrl, u32Capacity, entry->u32Hash);
+         pCtrl[u32Slot] = H2(entry->u32Hash);
+         pSlots[u32Slot] = u32NumEntries;
+         pEntries[u32NumEntries++] = *entry;
+         if (i < self->u32IterPos)
+         {
+            u32IterPos++;
+         }
+      }
+   }
+   assert(u32NumEntries == self->u32Length);
+   free(self->pEntries);
+   self->pEntries = pEntries;
+   self->pSlots = pSlots;
+   self->pCtrl = pCtrl;
+   self->u32Capacity = u32Capacity;
+   self->u32NumEntries = u32NumEntries;
+   self->u32IterPos = u32IterPos;
+   return true;
+}
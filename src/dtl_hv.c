@@ -9,17 +9,22 @@
 ******************************************************************************/
 #include <malloc.h>
 #include <assert.h>
+#include <string.h>
 #include "dtl_hv.h"
 #include "dtl_sv.h"
+#include "dtl_pool.h"
+#include "dtl_refcnt.h"
+#include "dtl_atom.h"
 #ifdef MEM_LEAK_CHECK
 #include "CMemLeak.h"
-#else
-#define vfree free
 #endif
 
 
 
 /**************** Private Function Declarations *******************/
+static void dtl_hv_store(dtl_hv_t *self, const char *pKey, uint32_t u32KeyLen, uint32_t u32Hash, dtl_dv_t *dv, bool autoIncrementRef);
+static dtl_dv_t* dtl_hv_find(const dtl_hv_t *self, const char *pKey, uint32_t u32KeyLen, uint32_t u32Hash);
+static dtl_dv_t* dtl_hv_take(dtl_hv_t *self, const char *pKey, uint32_t u32KeyLen, uint32_t u32Hash);
 
 
 /**************** Private Variable Declarations *******************/
@@ -30,26 +35,71 @@
 dtl_hv_t* dtl_hv_new(void)
 {
 	dtl_hv_t *self;
-	if( (self = (dtl_hv_t*) malloc(sizeof(dtl_hv_t))) == (dtl_hv_t*) 0 )
+	if( (self = (dtl_hv_t*) dtl_pool_alloc(DTL_POOL_HV)) == (dtl_hv_t*) 0 )
 	{
 		return (dtl_hv_t*) 0;
 	}
-	if( (self->pAny = (adt_hash_t*) malloc(sizeof(adt_hash_t))) == (adt_hash_t*) 0 )
+	dtl_hv_create(self);
+	return self;
+}
+
+/**
+ * Creates a hash in arena memory. The hash is destroyed by dtl_arena_reset, reference counting is disabled.
+ * Heap values stored in the hash are released (dtl_dv_dec_ref) when the arena is reset.
+ */
+dtl_hv_t* dtl_hv_arena_new(dtl_arena_t *arena)
+{
+	dtl_hv_t *self;
+	if( (self = (dtl_hv_t*) dtl_arena_alloc(arena, (uint32_t) sizeof(dtl_hv_t))) == (dtl_hv_t*) 0 )
 	{
-		free(self);
-		return (dtl_hv_t*)0;
+		return (dtl_hv_t*) 0;
 	}
 	dtl_hv_create(self);
+	self->u32Flags |= DTL_DV_FLAG_ARENA;
+	dtl_arena_add_finalizer(arena, (dtl_dv_t*) self);
+	return self;
+}
+
+/**
+ * Creates a hash holding the given keys and values. The table is sized for u32Count entries up front, so it is
+ * allocated once and never rebuilt. The hash takes over the caller's reference to each value (no dtl_dv_inc_ref).
+ * When a key occurs more than once the last value is kept and the earlier ones are released.
+ * Returns NULL when out of memory, the values have then been released (as are values paired with a NULL key).
+ */
+dtl_hv_t* dtl_hv_make_from_pairs(const dtl_hv_pair_t *pPairs, uint32_t u32Count)
+{
+	dtl_hv_t *self;
+	uint32_t i;
+	if( (pPairs == 0) && (u32Count > 0u) )
+	{
+		return (dtl_hv_t*) 0;
+	}
+	self = dtl_hv_new();
+	if( (self != 0) && (dtl_hv_reserve(self, u32Count) != DTL_NO_ERROR) )
+	{
+		dtl_hv_delete(self);
+		self = (dtl_hv_t*) 0;
+	}
+	for(i = 0u; i < u32Count; i++)
+	{
+		if( (self != 0) && (pPairs[i].pKey != 0) )
+		{
+			dtl_hv_set_cstr(self, pPairs[i].pKey, pPairs[i].dv, false);
+		}
+		else
+		{
+			dtl_dv_dec_ref(pPairs[i].dv);
+		}
+	}
 	return self;
 }
 
 void dtl_hv_delete(dtl_hv_t *self)
 {
-	if(self)
+	if( (self != 0) && ((self->u32Flags & DTL_DV_FLAG_ARENA) == 0u) )
 	{
 		dtl_hv_destroy(self);
-		free(self->pAny);
-		free(self);
+		dtl_pool_free(DTL_POOL_HV, self);
 	}
 }
 
@@ -57,9 +107,10 @@ void dtl_hv_create(dtl_hv_t *self)
 {
 	if(self)
 	{
-		adt_hash_create(self->pAny,dtl_dv_dec_ref_void);
+		self->pAny = &self->hash;
+		dtl_htab_create(self->pAny,dtl_dv_dec_ref_void);
 		self->u32Flags = ((uint32_t)DTL_DV_HASH);
-		self->u32RefCnt = 1;
+		dtl_refcnt_init((dtl_dv_t*) self);
 	}
 }
 
@@ -67,7 +118,7 @@ void dtl_hv_destroy(dtl_hv_t *self)
 {
 	if(self)
 	{
-		adt_hash_destroy(self->pAny);
+		dtl_htab_destroy(self->pAny);
 	}
 }
 
@@ -75,48 +126,168 @@ void dtl_hv_destroy(dtl_hv_t *self)
 //Accessors
 void dtl_hv_set_cstr(dtl_hv_t *self, const char *pKey, dtl_dv_t *dv, bool autoIncrementRef)
 {
-	if(self)
+	if( DTL_DV_IS_WRITABLE(self) && (pKey != 0) )
 	{
-		dtl_dv_t *current = (dtl_dv_t*) adt_hash_get(self->pAny, pKey);
-		if( (current != 0) && (current != dv) )
-		{
-			dtl_dv_dec_ref(current);
-		}
-		adt_hash_set(self->pAny,pKey,dv);
-      if (autoIncrementRef)
-      {
-         dtl_dv_inc_ref(dv);
-      }
+		uint32_t u32KeyLen;
+		uint32_t u32Hash = dtl_atom_hash_cstr(pKey, &u32KeyLen);
+		dtl_hv_store(self, pKey, u32KeyLen, u32Hash, dv, autoIncrementRef);
+	}	else if( (self != 0) && DTL_DV_IS_FROZEN(self) && (!autoIncrementRef) )
+	{
+		dtl_dv_dec_ref(dv); //frozen, the reference handed over by the caller is released
 	}
 }
 
 dtl_dv_t* dtl_hv_get_cstr(const dtl_hv_t *self, const char *pKey)
 {
-	if(self)
+	if( (self != 0) && (pKey != 0) )
 	{
-	   void **result = adt_hash_get(self->pAny,pKey);
-	   if (result != 0)
-	   {
-	      return (dtl_dv_t*) *result;
-	   }
+		uint32_t u32KeyLen;
+		uint32_t u32Hash = dtl_atom_hash_cstr(pKey, &u32KeyLen);
+		return dtl_hv_find(self, pKey, u32KeyLen, u32Hash);
 	}
 	return (dtl_dv_t*) 0;
 }
 
+/**
+ * Removes the key and returns its value, the caller takes over the hash's reference to it.
+ */
 dtl_dv_t* dtl_hv_remove_cstr(dtl_hv_t *self, const char *pKey)
 {
-	if(self)
+	if( DTL_DV_IS_WRITABLE(self) && (pKey != 0) )
+	{
+		uint32_t u32KeyLen;
+		uint32_t u32Hash = dtl_atom_hash_cstr(pKey, &u32KeyLen);
+		return dtl_hv_take(self, pKey, u32KeyLen, u32Hash);
+	}
+	return (dtl_dv_t*) 0;
+}
+
+/**
+ * The key is the bytes from pBegin up to (not including) pEnd. It does not need to be NUL-terminated, so a key can be
+ * used directly from the buffer it was parsed from. The hash stores its own copy of the key.
+ */
+void dtl_hv_set_bstr(dtl_hv_t *self, const uint8_t *pBegin, const uint8_t *pEnd, dtl_dv_t *dv, bool autoIncrementRef)
+{
+	if( (pBegin != 0) && (pEnd >= pBegin) )
+	{
+		dtl_hv_set_hashed(self, pBegin, pEnd, dtl_key_hash(pBegin, pEnd), dv, autoIncrementRef);
+	}
+}
+
+dtl_dv_t* dtl_hv_get_bstr(const dtl_hv_t *self, const uint8_t *pBegin, const uint8_t *pEnd)
+{
+	if( (pBegin != 0) && (pEnd >= pBegin) )
+	{
+		return dtl_hv_get_hashed(self, pBegin, pEnd, dtl_key_hash(pBegin, pEnd));
+	}
+	return (dtl_dv_t*) 0;
+}
+
+dtl_dv_t* dtl_hv_remove_bstr(dtl_hv_t *self, const uint8_t *pBegin, const uint8_t *pEnd)
+{
+	if( (pBegin != 0) && (pEnd >= pBegin) )
 	{
-		return (dtl_dv_t*) adt_hash_remove(self->pAny,pKey);
+		return dtl_hv_remove_hashed(self, pBegin, pEnd, dtl_key_hash(pBegin, pEnd));
 	}
 	return (dtl_dv_t*) 0;
 }
 
+/**
+ * Same as the _bstr accessors but with the hash of the key supplied by the caller. u32Hash must be the value
+ * dtl_key_hash returns for the key, otherwise the key is not found (or is stored where it cannot be found again).
+ * Hashing a key once and reusing the hash saves reading the key bytes on every call.
+ */
+void dtl_hv_set_hashed(dtl_hv_t *self, const uint8_t *pBegin, const uint8_t *pEnd, uint32_t u32Hash, dtl_dv_t *dv, bool autoIncrementRef)
+{
+	if( DTL_DV_IS_WRITABLE(self) && (pBegin != 0) && (pEnd >= pBegin) )
+	{
+		dtl_hv_store(self, (const char*) pBegin, (uint32_t) (pEnd - pBegin), u32Hash, dv, autoIncrementRef);
+	}	else if( (self != 0) && DTL_DV_IS_FROZEN(self) && (!autoIncrementRef) )
+	{
+		dtl_dv_dec_ref(dv); //frozen, the reference handed over by the caller is released
+	}
+}
+
+dtl_dv_t* dtl_hv_get_hashed(const dtl_hv_t *self, const uint8_t *pBegin, const uint8_t *pEnd, uint32_t u32Hash)
+{
+	if( (self != 0) && (pBegin != 0) && (pEnd >= pBegin) )
+	{
+		return dtl_hv_find(self, (const char*) pBegin, (uint32_t) (pEnd - pBegin), u32Hash);
+	}
+	return (dtl_dv_t*) 0;
+}
+
+dtl_dv_t* dtl_hv_remove_hashed(dtl_hv_t *self, const uint8_t *pBegin, const uint8_t *pEnd, uint32_t u32Hash)
+{
+	if( DTL_DV_IS_WRITABLE(self) && (pBegin != 0) && (pEnd >= pBegin) )
+	{
+		return dtl_hv_take(self, (const char*) pBegin, (uint32_t) (pEnd - pBegin), u32Hash);
+	}
+	return (dtl_dv_t*) 0;
+}
+
+/**
+ * Atom keys carry their length and hash, so setting and getting them does not read the key bytes until a candidate is found.
+ */
+void dtl_hv_set_atom(dtl_hv_t *self, const dtl_atom_t *key, dtl_dv_t *dv, bool autoIncrementRef)
+{
+	if( DTL_DV_IS_WRITABLE(self) && (key != 0) )
+	{
+		dtl_hv_store(self, dtl_atom_cstr(key), dtl_atom_length(key), dtl_atom_hash(key), dv, autoIncrementRef);
+	}	else if( (self != 0) && DTL_DV_IS_FROZEN(self) && (!autoIncrementRef) )
+	{
+		dtl_dv_dec_ref(dv); //frozen, the reference handed over by the caller is released
+	}
+}
+
+dtl_dv_t* dtl_hv_get_atom(const dtl_hv_t *self, const dtl_atom_t *key)
+{
+	if( (self != 0) && (key != 0) )
+	{
+		return dtl_hv_find(self, dtl_atom_cstr(key), dtl_atom_length(key), dtl_atom_hash(key));
+	}
+	return (dtl_dv_t*) 0;
+}
+
+void dtl_hv_iter_begin(const dtl_hv_t *self, dtl_hv_iter_t *iter)
+{
+	if(iter)
+	{
+		iter->pTable = (self != 0)? &self->hash : (const dtl_htab_t*) 0;
+		iter->u32Pos = 0u;
+		iter->pKey = (const char*) 0;
+		iter->dv = (dtl_dv_t*) 0;
+		iter->u32KeyLen = 0u;
+		iter->u32KeyHash = 0u;
+	}
+}
+
+/**
+ * Moves to the next entry in insertion order. Returns false when all entries have been visited.
+ * Only reads the hash, the iterator holds the position.
+ */
+bool dtl_hv_iter_next(dtl_hv_iter_t *iter)
+{
+	if(iter != 0)
+	{
+		const dtl_htab_entry_t *entry = dtl_htab_next(iter->pTable, &iter->u32Pos);
+		if(entry != 0)
+		{
+			iter->pKey = dtl_htab_entry_key(entry);
+			iter->dv = (dtl_dv_t*) entry->pVal;
+			iter->u32KeyLen = entry->u32KeyLen;
+			iter->u32KeyHash = entry->u32Hash;
+			return true;
+		}
+	}
+	return false;
+}
+
 void dtl_hv_iter_init(dtl_hv_t *self)
 {
 	if(self)
 	{
-		adt_hash_iter_init(self->pAny);
+		dtl_htab_iter_init(self->pAny);
 	}
 }
 
@@ -129,10 +300,14 @@ dtl_dv_t* dtl_hv_iter_next_cstr(dtl_hv_t *self, const char **ppKey)
 {
 	if(self)
 	{
-	   void **ppValue = adt_hash_iter_next(self->pAny, ppKey);
-	   if (ppValue != 0)
+	   const dtl_htab_entry_t *entry = dtl_htab_iter_next(self->pAny);
+	   if (entry != 0)
 	   {
-	      return (dtl_dv_t*) *ppValue;
+	      if (ppKey != 0)
+	      {
+	         *ppKey = dtl_htab_entry_key(entry);
+	      }
+	      return (dtl_dv_t*) entry->pVal;
 	   }
 	}
 	return (dtl_dv_t*) 0;
@@ -145,55 +320,97 @@ uint32_t dtl_hv_length(const dtl_hv_t *self)
 {
 	if(self)
 	{
-		return adt_hash_length(self->pAny);
+		return dtl_htab_length(self->pAny);
 	}
 	return (uint32_t) 0;
 }
 
+/**
+ * Makes room for u32Count keys in total, so that adding keys up to that count never rebuilds the table.
+ */
+dtl_error_t dtl_hv_reserve(dtl_hv_t *self, uint32_t u32Count)
+{
+	if(self != 0)
+	{
+		if(DTL_DV_IS_FROZEN(self))
+		{
+			return DTL_FROZEN_ERROR;
+		}
+		return dtl_htab_reserve(self->pAny, u32Count)? DTL_NO_ERROR : DTL_MEM_ERROR;
+	}
+	return DTL_INVALID_ARGUMENT_ERROR;
+}
+
 bool dtl_hv_exists_cstr(const dtl_hv_t *self, const char *pKey)
 {
-	if(self)
+	if( (self != 0) && (pKey != 0) )
+	{
+		uint32_t u32KeyLen;
+		uint32_t u32Hash = dtl_atom_hash_cstr(pKey, &u32KeyLen);
+		return dtl_htab_find(self->pAny, pKey, u32KeyLen, u32Hash) != 0;
+	}
+	return false;
+}
+
+bool dtl_hv_exists_bstr(const dtl_hv_t *self, const uint8_t *pBegin, const uint8_t *pEnd)
+{
+	if( (pBegin != 0) && (pEnd >= pBegin) )
 	{
-		return adt_hash_exists(self->pAny,pKey);
+		return dtl_hv_exists_hashed(self, pBegin, pEnd, dtl_key_hash(pBegin, pEnd));
+	}
+	return false;
+}
+
+bool dtl_hv_exists_hashed(const dtl_hv_t *self, const uint8_t *pBegin, const uint8_t *pEnd, uint32_t u32Hash)
+{
+	if( (self != 0) && (pBegin != 0) && (pEnd >= pBegin) )
+	{
+		return dtl_htab_find(self->pAny, (const char*) pBegin, (uint32_t) (pEnd - pBegin), u32Hash) != 0;
 	}
 	return false;
 }
 
+/**
+ * Hash of the key bytes from pBegin up to (not including) pEnd, as used by the _hashed accessors. Equal to
+ * dtl_atom_hash of the interned key and to the u32KeyHash an iterator reports, so those can be passed on as well.
+ */
+uint32_t dtl_key_hash(const uint8_t *pBegin, const uint8_t *pEnd)
+{
+	return dtl_atom_hash_bstr(pBegin, pEnd);
+}
+
 /**
  * Returns new DTL Array containing the keys found in the hash.
  * Each item in the returned array is of type dtl_sv_t (where scalar type is string).
+ * Keys too long to be stored inline in the scalar are interned so that repeated keys share one buffer.
  * The caller is responsible of disposing the array after use (preferably by calling dtl_dec_ref).
  */
 dtl_av_t* dtl_hv_keys(const dtl_hv_t *self)
 {
 	if( (self != 0) )
 	{
-	   dtl_av_t *array = 0;
-	   adt_ary_t *tmp = 0; //adt_ary returns a list of cstr (C strings).
-	   array = dtl_av_new();
+	   dtl_av_t *array = dtl_av_new();
 	   if (array != 0)
 	   {
-	      tmp = adt_ary_new(vfree);
-	   }
-	   if ( (array != 0) && (tmp != 0) )
-	   {
-	      int32_t numItems = adt_hash_keys(self->pAny, tmp);
-	      if (numItems > 0)
+	      const dtl_htab_entry_t *entry;
+	      uint32_t u32Pos = 0u;
+	      while ( (entry = dtl_htab_next(self->pAny, &u32Pos)) != 0 )
 	      {
-	         int32_t i;
-	         dtl_av_clear(array);
-	         for (i=0; i<numItems; i++)
+	         const char *key = dtl_htab_entry_key(entry);
+	         if (entry->u32KeyLen > DTL_SV_SSO_CAPACITY)
+	         {
+	            dtl_atom_t *atom = dtl_atom_intern_bstr((const uint8_t*) key, (const uint8_t*) key + entry->u32KeyLen);
+	            dtl_av_push(array, (dtl_dv_t*) dtl_sv_make_atom(atom), false);
+	            dtl_atom_release(atom);
+	         }
+	         else
 	         {
-	            const char *key = (const char *) adt_ary_value(tmp, i);
-	            assert(key != 0);
-	            dtl_av_push(array, (dtl_dv_t*) dtl_sv_make_cstr(key), false);
+	            dtl_sv_t *sv = dtl_sv_new();
+	            dtl_sv_set_bstr(sv, (const uint8_t*) key, (const uint8_t*) key + entry->u32KeyLen); //keys may contain NUL bytes
+	            dtl_av_push(array, (dtl_dv_t*) sv, false);
 	         }
 	      }
-	      assert(dtl_av_length(array) == numItems);
-	   }
-	   if (tmp != 0)
-	   {
-	      adt_ary_delete(tmp);
+	      assert(dtl_av_length(array) == (int32_t) dtl_htab_length(self->pAny));
 	   }
 	   return array;
 	}
@@ -201,4 +418,34 @@ dtl_av_t* dtl_hv_keys(const dtl_hv_t *self)
 }
 
 /***************** Private Function Definitions *******************/
+static void dtl_hv_store(dtl_hv_t *self, const char *pKey, uint32_t u32KeyLen, uint32_t u32Hash, dtl_dv_t *dv, bool autoIncrementRef)
+{
+	void **ppVal = dtl_htab_insert(self->pAny, pKey, u32KeyLen, u32Hash, (bool*) 0);
+	if( (ppVal != 0) && (*ppVal != (void*) dv) )
+	{
+		dtl_dv_t *current = (dtl_dv_t*) *ppVal;
+		*ppVal = dv;
+		if(autoIncrementRef)
+		{
+			dtl_dv_inc_ref(dv);
+		}
+		dtl_dv_dec_ref(current);
+	}
+}
 
+static dtl_dv_t* dtl_hv_find(const dtl_hv_t *self, const char *pKey, uint32_t u32KeyLen, uint32_t u32Hash)
+{
+	void **result = dtl_htab_find(self->pAny, pKey, u32KeyLen, u32Hash);
+	if (result != 0)
+	{
+		return (dtl_dv_t*) *result;
+	}
+	return (dtl_dv_t*) 0;
+}
+
+static dtl_dv_t* dtl_hv_take(dtl_hv_t *self, const char *pKey, uint32_t u32KeyLen, uint32_t u32Hash)
+{
+	void *pVal = 0;
+	(void) dtl_htab_remove(self->pAny, pKey, u32KeyLen, u32Hash, &pVal);
+	return (dtl_dv_t*) pVal;
+}
@@ -0,0 +1,70 @@
+/*****************************************************************************
+* \file      dtl_numfmt.h
+* \author    Conny Gustafsson
+* \date      2026-10-17
+* \brief     Private number formatting (shortest round-trip floating point, integers)
+*
+* Copyright (c) 2026 Conny Gustafsson
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+#ifndef DTL_NUMFMT_H
+#define DTL_NUMFMT_H
+
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define DTL_NUMFMT_BUF_SIZE 32 //fits any number written by the functions below, including the null-terminator
+
+typedef enum dtl_numfmt_kind_tag{
+   DTL_NUMFMT_INVALID = 0, //text is not a number
+   DTL_NUMFMT_I64,
+   DTL_NUMFMT_U64,         //only used for integers above INT64_MAX
+   DTL_NUMFMT_DBL
+} dtl_numfmt_kind_t;
+
+typedef union dtl_numfmt_value_tag{
+   int64_t i64;
+   uint64_t u64;
+   double dbl;
+} dtl_numfmt_value_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+/*
+ * All functions write a null-terminated string to buf (which must hold DTL_NUMFMT_BUF_SIZE bytes)
+ * and return its length. They use neither the heap nor the C locale.
+ */
+int32_t dtl_numfmt_u64(uint64_t value, char *buf);
+int32_t dtl_numfmt_i64(int64_t value, char *buf);
+int32_t dtl_numfmt_dbl(double value, char *buf);
+int32_t dtl_numfmt_flt(float value, char *buf);
+
+/*
+ * Parses the complete text (no surrounding whitespace) as a decimal integer, a decimal floating point number
+ * ("1.5", "-2e10", ".5") or inf/infinity/nan. The decimal separator is always '.', regardless of locale.
+ */
+dtl_numfmt_kind_t dtl_numfmt_parse(const char *str, uint32_t len, dtl_numfmt_value_t *value);
+
+#endif //DTL_NUMFMT_H
@@ -0,0 +1,544 @@
+/*****************************************************************************
+* \file      dtl_pav.c
+* \author    Conny Gustafsson
+* \date      2026-10-17
+* \brief     Persistent array value (radix balanced trie with structural sharing)
+*
+* Copyright (c) 2026 Conny Gustafsson
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdlib.h>
+#include <string.h>
+#include "dtl_pav.h"
+#include "dtl_pool.h"
+#include "dtl_refcnt.h"
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define LEVEL_MASK ((uint32_t) DTL_PAV_BRANCH_SIZE - 1u)
+
+/*
+ * Leaf nodes hold values (dtl_dv_t*), inner nodes hold child nodes. Unused slots are NULL.
+ * A node is never modified once it is reachable from a version.
+ */
+struct dtl_pav_node_tag{
+   volatile uint32_t u32RefCnt;
+   void *slots[DTL_PAV_BRANCH_SIZE];
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static dtl_pav_t *dtl_pav_version(const dtl_pav_t *self, dtl_pav_node_t *root, dtl_pav_node_t *tail, uint32_t u32Length, uint32_t u32Shift);
+static uint32_t dtl_pav_tail_offset(uint32_t u32Length);
+static dtl_pav_node_t *dtl_pav_leaf_for(const dtl_pav_data_t *data, uint32_t u32Index);
+static dtl_pav_node_t *dtl_pav_push_tail(const dtl_pav_data_t *data, uint32_t u32Level, const dtl_pav_node_t *parent, dtl_pav_node_t *tail);
+static dtl_pav_node_t *dtl_pav_new_path(uint32_t u32Level, dtl_pav_node_t *node);
+static dtl_pav_node_t *dtl_pav_assoc(uint32_t u32Level, const dtl_pav_node_t *node, uint32_t u32Index, dtl_dv_t *dv);
+static dtl_pav_node_t *dtl_pav_pop_tail(const dtl_pav_data_t *data, uint32_t u32Level, const dtl_pav_node_t *node, bool *pFailed);
+static dtl_pav_node_t *dtl_pav_node_new(void);
+static dtl_pav_node_t *dtl_pav_node_copy(const dtl_pav_node_t *node, uint32_t u32Level, uint32_t u32Count);
+static void dtl_pav_node_retain(dtl_pav_node_t *node);
+static void dtl_pav_node_release(dtl_pav_node_t *node, uint32_t u32Level);
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+dtl_pav_t *dtl_pav_new(void)
+{
+   dtl_pav_t *self = (dtl_pav_t*) dtl_pool_alloc(DTL_POOL_PAV);
+   if (self != 0)
+   {
+      self->pAny = &self->data;
+      self->data.root = (dtl_pav_node_t*) 0;
+      self->data.tail = (dtl_pav_node_t*) 0;
+      self->data.u32Length = 0u;
+      self->data.u32Shift = DTL_PAV_BRANCH_BITS;
+      self->u32Flags = (uint32_t) DTL_DV_PARRAY;
+      dtl_refcnt_init((dtl_dv_t*) self);
+   }
+   return self;
+}
+
+void dtl_pav_delete(dtl_pav_t *self)
+{
+   if (self != 0)
+   {
+      dtl_pav_node_release(self->data.root, self->data.u32Shift);
+      dtl_pav_node_release(self->data.tail, 0u);
+      dtl_pool_free(DTL_POOL_PAV, self);
+   }
+}
+
+/**
+ * Returns a new version with dv appended. With autoIncrementRef false the new version takes over
+ * the caller's reference to dv, unless NULL is returned.
+ */
+dtl_pav_t *dtl_pav_push(const dtl_pav_t *self, dtl_dv_t *dv, bool autoIncrementRef)
+{
+   const dtl_pav_data_t *data;
+   dtl_pav_node_t *root;
+   dtl_pav_node_t *tail;
+   dtl_pav_t *version;
+   uint32_t u32Shift;
+   uint32_t u32TailLength;
+   if (self == 0)
+   {
+      return (dtl_pav_t*) 0;
+   }
+   data = &self->data;
+   u32Shift = data->u32Shift;
+   u32TailLength = data->u32Length - dtl_pav_tail_offset(data->u32Length);
+   if ( (data->tail != 0) && (u32TailLength < (uint32_t) DTL_PAV_BRANCH_SIZE) )
+   {
+      //room left in the tail, the trie is shared as is
+      tail = dtl_pav_node_copy(data->tail, 0u, u32TailLength);
+      if (tail == 0)
+      {
+         return (dtl_pav_t*) 0;
+      }
+      root = data->root;
+      dtl_pav_node_retain(root);
+   }
+   else
+   {
+      tail = dtl_pav_node_new();
+      if (tail == 0)
+      {
+         return (dtl_pav_t*) 0;
+      }
+      u32TailLength = 0u;
+      root = data->root;
+      if (data->tail == 0)
+      {
+         dtl_pav_node_retain(root);
+      }
+      else if ( (data->u32Length >> DTL_PAV_BRANCH_BITS) > (1u << u32Shift) )
+      {
+         //the trie is full, add a level above the current root
+         dtl_pav_node_t *path;
+         root = dtl_pav_node_new();
+         dtl_pav_node_retain(data->tail);
+         path = dtl_pav_new_path(u32Shift, data->tail);
+         if ( (root == 0) || (path == 0) )
+         {
+            dtl_pav_node_release(root, u32Shift + DTL_PAV_BRANCH_BITS);
+            dtl_pav_node_release(path, u32Shift);
+            dtl_pav_node_release(tail, 0u);
+            return (dtl_pav_t*) 0;
+         }
+         dtl_pav_node_retain(data->root);
+         root->slots[0] = data->root;
+         root->slots[1] = path;
+         u32Shift += DTL_PAV_BRANCH_BITS;
+      }
+      else
+      {
+         root = dtl_pav_push_tail(data, u32Shift, data->root, data->tail);
+         if (root == 0)
+         {
+            dtl_pav_node_release(tail, 0u);
+            return (dtl_pav_t*) 0;
+         }
+      }
+   }
+   tail->slots[u32TailLength] = dv;
+   dtl_dv_inc_ref(dv);
+   version = dtl_pav_version(self, root, tail, data->u32Length + 1u, u32Shift);
+   if ( (version != 0) && (!autoIncrementRef) )
+   {
+      dtl_dv_dec_ref(dv); //the trie holds its own reference
+   }
+   return version;
+}
+
+/**
+ * Returns a new version where the element at s32Index is dv. A negative index counts from the end.
+ * With autoIncrementRef false the new version takes over the caller's reference to dv, unless NULL is returned.
+ */
+dtl_pav_t *dtl_pav_set(const dtl_pav_t *self, int32_t s32Index, dtl_dv_t *dv, bool autoIncrementRef)
+{
+   const dtl_pav_data_t *data;
+   dtl_pav_node_t *root;
+   dtl_pav_node_t *tail;
+   dtl_pav_t *version;
+   uint32_t u32Index;
+   uint32_t u32TailOffset;
+   if (self == 0)
+   {
+      return (dtl_pav_t*) 0;
+   }
+   data = &self->data;
+   if (s32Index < 0)
+   {
+      s32Index += (int32_t) data->u32Length;
+   }
+   if ( (s32Index < 0) || ((uint32_t) s32Index >= data->u32Length) )
+   {
+      return (dtl_pav_t*) 0;
+   }
+   u32Index = (uint32_t) s32Index;
+   u32TailOffset = dtl_pav_tail_offset(data->u32Length);
+   if (u32Index >= u32TailOffset)
+   {
+      tail = dtl_pav_assoc(0u, data->tail, u32Index, dv);
+      if (tail == 0)
+      {
+         return (dtl_pav_t*) 0;
+      }
+      root = data->root;
+      dtl_pav_node_retain(root);
+   }
+   else
+   {
+      root = dtl_pav_assoc(data->u32Shift, data->root, u32Index, dv);
+      if (root == 0)
+      {
+         return (dtl_pav_t*) 0;
+      }
+      tail = data->tail;
+      dtl_pav_node_retain(tail);
+   }
+   version = dtl_pav_version(self, root, tail, data->u32Length, data->u32Shift);
+   if ( (version != 0) && (!autoIncrementRef) )
+   {
+      dtl_dv_dec_ref(dv);
+   }
+   return version;
+}
+
+/**
+ * Returns a new version without the last element. NULL is returned when self is empty.
+ */
+dtl_pav_t *dtl_pav_pop(const dtl_pav_t *self)
+{
+   const dtl_pav_data_t *data;
+   dtl_pav_node_t *root;
+   dtl_pav_node_t *tail;
+   uint32_t u32Shift;
+   uint32_t u32TailLength;
+   bool isFailed = false;
+   if ( (self == 0) || (self->data.u32Length == 0u) )
+   {
+      return (dtl_pav_t*) 0;
+   }
+   data = &self->data;
+   u32Shift = data->u32Shift;
+   u32TailLength = data->u32Length - dtl_pav_tail_offset(data->u32Length);
+   if (u32TailLength > 1u)
+   {
+      tail = dtl_pav_node_copy(data->tail, 0u, u32TailLength - 1u);
+      if (tail == 0)
+      {
+         return (dtl_pav_t*) 0;
+      }
+      root = data->root;
+      dtl_pav_node_retain(root);
+   }
+   else if (data->root == 0)
+   {
+      root = (dtl_pav_node_t*) 0;
+      tail = (dtl_pav_node_t*) 0;
+   }
+   else
+   {
+      //the tail becomes empty, the last leaf of the trie takes its place
+      tail = dtl_pav_leaf_for(data, data->u32Length - 2u);
+      root = dtl_pav_pop_tail(data, u32Shift, data->root, &isFailed);
+      if (isFailed)
+      {
+         return (dtl_pav_t*) 0;
+      }
+      dtl_pav_node_retain(tail);
+      if ( (root != 0) && (u32Shift > DTL_PAV_BRANCH_BITS) && (root->slots[1] == 0) )
+      {
+         //the root has a single child left, drop a level
+         dtl_pav_node_t *child = (dtl_pav_node_t*) root->slots[0];
+         dtl_pav_node_retain(child);
+         dtl_pav_node_release(root, u32Shift);
+         root = child;
+         u32Shift -= DTL_PAV_BRANCH_BITS;
+      }
+   }
+   return dtl_pav_version(self, root, tail, data->u32Length - 1u, u32Shift);
+}
+
+dtl_dv_t *dtl_pav_value(const dtl_pav_t *self, int32_t s32Index)
+{
+   if (self != 0)
+   {
+      const dtl_pav_data_t *data = &self->data;
+      if (s32Index < 0)
+      {
+         s32Index += (int32_t) data->u32Length;
+      }
+      if ( (s32Index >= 0) && ((uint32_t) s32Index < data->u32Length) )
+      {
+         return (dtl_dv_t*) dtl_pav_leaf_for(data, (uint32_t) s32Index)->slots[(uint32_t) s32Index & LEVEL_MASK];
+      }
+   }
+   return (dtl_dv_t*) 0;
+}
+
+int32_t dtl_pav_length(const dtl_pav_t *self)
+{
+   return (self != 0)? (int32_t) self->data.u32Length : 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+/**
+ * Creates the header of a new version that owns root and tail. They are released if the header cannot be allocated.
+ * A version made from an atomic version is atomic too, so that it can be shared the same way.
+ */
+static dtl_pav_t *dtl_pav_version(const dtl_pav_t *self, dtl_pav_node_t *root, dtl_pav_node_t *tail, uint32_t u32Length, uint32_t u32Shift)
+{
+   dtl_pav_t *version = (dtl_pav_t*) dtl_pool_alloc(DTL_POOL_PAV);
+   if (version == 0)
+   {
+      dtl_pav_node_release(root, u32Shift);
+      dtl_pav_node_release(tail, 0u);
+      return (dtl_pav_t*) 0;
+   }
+   version->pAny = &version->data;
+   version->data.root = root;
+   version->data.tail = tail;
+   version->data.u32Length = u32Length;
+   version->data.u32Shift = u32Shift;
+   version->u32Flags = ((uint32_t) DTL_DV_PARRAY) | (self->u32Flags & DTL_DV_FLAG_ATOMIC);
+   dtl_refcnt_init((dtl_dv_t*) version);
+   return version;
+}
+
+static uint32_t dtl_pav_tail_offset(uint32_t u32Length)
+{
+   return (u32Length == 0u)? 0u : ((u32Length - 1u) & ~LEVEL_MASK);
+}
+
+static dtl_pav_node_t *dtl_pav_leaf_for(const dtl_pav_data_t *data, uint32_t u32Index)
+{
+   const dtl_pav_node_t *node;
+   uint32_t u32Level;
+   if (u32Index >= dtl_pav_tail_offset(data->u32Length))
+   {
+      return data->tail;
+   }
+   node = data->root;
+   for (u32Level = data->u32Shift; u32Level > 0u; u32Level -= DTL_PAV_BRANCH_BITS)
+   {
+      node = (const dtl_pav_node_t*) node->slots[(u32Index >> u32Level) & LEVEL_MASK];
+   }
+   return (dtl_pav_node_t*) node;
+}
+
+/**
+ * Returns a copy of parent (NULL is an empty node) with the full tail of data added as its last leaf.
+ */
+static dtl_pav_node_t *dtl_pav_push_tail(const dtl_pav_data_t *data, uint32_t u32Level, const dtl_pav_node_t *parent, dtl_pav_node_t *tail)
+{
+   uint32_t u32SubIndex = ((data->u32Length - 1u) >> u32Level) & LEVEL_MASK;
+   dtl_pav_node_t *child;
+   dtl_pav_node_t *copy = (parent != 0)? dtl_pav_node_copy(parent, u32Level, u32SubIndex) : dtl_pav_node_new();
+   if (copy == 0)
+   {
+      return (dtl_pav_node_t*) 0;
+   }
+   if (u32Level == DTL_PAV_BRANCH_BITS)
+   {
+      child = tail;
+      dtl_pav_node_retain(tail);
+   }
+   else if ( (parent != 0) && (parent->slots[u32SubIndex] != 0) )
+   {
+      child = dtl_pav_push_tail(data, u32Level - DTL_PAV_BRANCH_BITS, (const dtl_pav_node_t*) parent->slots[u32SubIndex], tail);
+   }
+   else
+   {
+      dtl_pav_node_retain(tail);
+      child = dtl_pav_new_path(u32Level - DTL_PAV_BRANCH_BITS, tail);
+   }
+   if (child == 0)
+   {
+      dtl_pav_node_release(copy, u32Level);
+      return (dtl_pav_node_t*) 0;
+   }
+   copy->slots[u32SubIndex] = child;
+   return copy;
+}
+
+/**
+ * Returns node wrapped in single-child inner nodes up to u32Level. node is consumed, also on failure.
+ */
+static dtl_pav_node_t *dtl_pav_new_path(uint32_t u32Level, dtl_pav_node_t *node)
+{
+   uint32_t u32Current;
+   for (u32Current = 0u; u32Current < u32Level; u32Current += DTL_PAV_BRANCH_BITS)
+   {
+      dtl_pav_node_t *parent = dtl_pav_node_new();
+      if (parent == 0)
+      {
+         dtl_pav_node_release(node, u32Current);
+         return (dtl_pav_node_t*) 0;
+      }
+      parent->slots[0] = node;
+      node = parent;
+   }
+   return node;
+}
+
+/**
+ * Returns a copy of the path from node down to the element at u32Index, with the element replaced by dv.
+ */
+static dtl_pav_node_t *dtl_pav_assoc(uint32_t u32Level, const dtl_pav_node_t *node, uint32_t u32Index, dtl_dv_t *dv)
+{
+   uint32_t u32SubIndex = (u32Index >> u32Level) & LEVEL_MASK;
+   dtl_pav_node_t *copy;
+   if (u32Level == 0u)
+   {
+      copy = dtl_pav_node_copy(node, 0u, DTL_PAV_BRANCH_SIZE);
+      if (copy != 0)
+      {
+         dtl_dv_dec_ref((dtl_dv_t*) copy->slots[u32SubIndex]);
+         copy->slots[u32SubIndex] = dv;
+         dtl_dv_inc_ref(dv);
+      }
+   }
+   else
+   {
+      dtl_pav_node_t *child = dtl_pav_assoc(u32Level - DTL_PAV_BRANCH_BITS, (const dtl_pav_node_t*) node->slots[u32SubIndex], u32Index, dv);
+      if (child == 0)
+      {
+         return (dtl_pav_node_t*) 0;
+      }
+      copy = dtl_pav_node_copy(node, u32Level, DTL_PAV_BRANCH_SIZE);
+      if (copy == 0)
+      {
+         dtl_pav_node_release(child, u32Level - DTL_PAV_BRANCH_BITS);
+         return (dtl_pav_node_t*) 0;
+      }
+      dtl_pav_node_release((dtl_pav_node_t*) copy->slots[u32SubIndex], u32Level - DTL_PAV_BRANCH_BITS);
+      copy->slots[u32SubIndex] = child;
+   }
+   return copy;
+}
+
+/**
+ * Returns a copy of node without its last leaf, or NULL when that leaf was the only one below node.
+ */
+static dtl_pav_node_t *dtl_pav_pop_tail(const dtl_pav_data_t *data, uint32_t u32Level, const dtl_pav_node_t *node, bool *pFailed)
+{
+   uint32_t u32SubIndex = ((data->u32Length - 2u) >> u32Level) & LEVEL_MASK;
+   dtl_pav_node_t *child = (dtl_pav_node_t*) 0;
+   dtl_pav_node_t *copy;
+   if (u32Level > DTL_PAV_BRANCH_BITS)
+   {
+      child = dtl_pav_pop_tail(data, u32Level - DTL_PAV_BRANCH_BITS, (const dtl_pav_node_t*) node->slots[u32SubIndex], pFailed);
+      if (*pFailed)
+      {
+         return (dtl_pav_node_t*) 0;
+      }
+   }
+   if ( (child == 0) && (u32SubIndex == 0u) )
+   {
+      return (dtl_pav_node_t*) 0;
+   }
+   copy = dtl_pav_node_copy(node, u32Level, u32SubIndex);
+   if (copy == 0)
+   {
+      dtl_pav_node_release(child, u32Level - DTL_PAV_BRANCH_BITS);
+      *pFailed = true;
+      return (dtl_pav_node_t*) 0;
+   }
+   copy->slots[u32SubIndex] = child;
+   return copy;
+}
+
+static dtl_pav_node_t *dtl_pav_node_new(void)
+{
+   dtl_pav_node_t *node = (dtl_pav_node_t*) calloc(1u, sizeof(dtl_pav_node_t));
+   if (node != 0)
+   {
+      node->u32RefCnt = 1u;
+   }
+   return node;
+}
+
+/**
+ * Returns a new node holding the first u32Count slots of node, the remaining slots are NULL.
+ */
+static dtl_pav_node_t *dtl_pav_node_copy(const dtl_pav_node_t *node, uint32_t u32Level, uint32_t u32Count)
+{
+   dtl_pav_node_t *copy = dtl_pav_node_new();
+   if (copy != 0)
+   {
+      uint32_t i;
+      memcpy(copy->slots, node->slots, u32Count * sizeof(void*));
+      for (i = 0u; i < u32Count; i++)
+      {
+         if (u32Level == 0u)
+         {
+            dtl_dv_inc_ref((dtl_dv_t*) copy->slots[i]);
+         }
+         else
+         {
+            dtl_pav_node_retain((dtl_pav_node_t*) copy->slots[i]);
+         }
+      }
+   }
+   return copy;
+}
+
+static void dtl_pav_node_retain(dtl_pav_node_t *node)
+{
+   if (node != 0)
+   {
+      dtl_atomic_inc_u32(&node->u32RefCnt);
+   }
+}
+
+/**
+ * Releases a node at u32Level (0 for leaves and the tail), nodes below are released when the last reference is dropped.
+ */
+static void dtl_pav_node_release(dtl_pav_node_t *node, uint32_t u32Level)
+{
+   if ( (node != 0) && (dtl_atomic_dec_u32(&node->u32RefCnt) == 0u) )
+   {
+      uint32_t i;
+      for (i = 0u; i < (uint32_t) DTL_PAV_BRANCH_SIZE; i++)
+      {
+         if (u32Level == 0u)
+         {
+            dtl_dv_dec_ref((dtl_dv_t*) node->slots[i]);
+         }
+         else
+         {
+            dtl_pav_node_release((dtl_pav_node_t*) node->slots[i], u32Level - DTL_PAV_BRANCH_BITS);
+         }
+      }
+      free(node);
+   }
+}
@@ -0,0 +1,726 @@
+/*****************************************************************************
+* \file      dtl_phv.c
+* \author    Conny Gustafsson
+* \date      2026-10-17
+* \brief     Persistent hash value (hash array mapped trie with structural sharing)
+*
+* Copyright (c) 2026 Conny Gustafsson
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#include "dtl_phv.h"
+#include "dtl_atom.h"
+#include "dtl_pool.h"
+#include "dtl_refcnt.h"
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define BITS_PER_LEVEL  5u
+#define LEVEL_MASK      0x1Fu
+#define MAX_SHIFT       30u //nodes below this level hold keys whose 32-bit hashes are equal
+
+typedef struct dtl_phv_entry_tag{
+   dtl_atom_t *key;
+   dtl_dv_t *dv;
+   uint32_t u32Hash;
+} dtl_phv_entry_t;
+
+/*
+ * Each trie node keeps its entries and child nodes in two compact arrays, u32DataMap and u32NodeMap say
+ * which of the 32 positions of the level are used by each (compressed HAMT, the layout used by CHAMP).
+ * A node is never modified once it is reachable from a version.
+ */
+struct dtl_phv_node_tag{
+   volatile uint32_t u32RefCnt;
+   uint32_t u32DataMap;
+   uint32_t u32NodeMap;
+   uint32_t u32NumCollisions; //collision node: number of entries (both maps are zero)
+   //followed by the entries and then the child node pointers
+};
+
+typedef struct dtl_phv_key_tag{
+   const char *pKey;
+   uint32_t u32Len;
+   uint32_t u32Hash;
+} dtl_phv_key_t;
+
+#define NODE_ENTRIES(node) ((dtl_phv_entry_t*) ((node) + 1))
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static void dtl_phv_create(dtl_phv_t *self, dtl_phv_node_t *root, uint32_t u32Length, uint32_t u32Flags);
+static void dtl_phv_make_key(dtl_phv_key_t *key, const char *pKey);
+static bool dtl_phv_key_equals(const dtl_phv_entry_t *entry, const dtl_phv_key_t *key);
+static const dtl_phv_entry_t *dtl_phv_find(const dtl_phv_node_t *node, const dtl_phv_key_t *key);
+static dtl_phv_node_t *dtl_phv_insert(const dtl_phv_node_t *node, const dtl_phv_key_t *key, uint32_t u32Shift, dtl_dv_t *dv, bool *pAdded);
+static dtl_phv_node_t *dtl_phv_erase(const dtl_phv_node_t *node, const dtl_phv_key_t *key, uint32_t u32Shift, bool *pRemoved, bool *pFailed);
+static dtl_phv_node_t *dtl_phv_merge(const dtl_phv_entry_t *first, const dtl_phv_entry_t *second, uint32_t u32Shift);
+static dtl_phv_node_t *dtl_phv_node_new(uint32_t u32DataMap, uint32_t u32NodeMap, uint32_t u32NumCollisions);
+static void dtl_phv_node_release(dtl_phv_node_t *node);
+static dtl_phv_node_t *dtl_phv_copy_set_entry(const dtl_phv_node_t *node, uint32_t u32Index, const dtl_phv_entry_t *entry);
+static dtl_phv_node_t *dtl_phv_copy_insert_entry(const dtl_phv_node_t *node, uint32_t u32Index, const dtl_phv_entry_t *entry, uint32_t u32DataMap, uint32_t u32NumCollisions);
+static dtl_phv_node_t *dtl_phv_copy_remove_entry(const dtl_phv_node_t *node, uint32_t u32Index, uint32_t u32DataMap, uint32_t u32NumCollisions);
+static dtl_phv_node_t *dtl_phv_copy_set_child(const dtl_phv_node_t *node, uint32_t u32Index, dtl_phv_node_t *child);
+static dtl_phv_node_t *dtl_phv_copy_entry_to_child(const dtl_phv_node_t *node, uint32_t u32Bit, dtl_phv_node_t *child);
+static dtl_phv_node_t *dtl_phv_copy_child_to_entry(const dtl_phv_node_t *node, uint32_t u32Bit, const dtl_phv_entry_t *entry);
+static void dtl_phv_copy_entries(dtl_phv_entry_t *dest, const dtl_phv_entry_t *src, uint32_t u32Count);
+static void dtl_phv_copy_children(dtl_phv_node_t **dest, dtl_phv_node_t * const *src, uint32_t u32Count);
+
+static inline uint32_t dtl_phv_popcount(uint32_t u32Value)
+{
+#ifdef _MSC_VER
+   return (uint32_t) __popcnt(u32Value);
+#else
+   return (uint32_t) __builtin_popcount(u32Value);
+#endif
+}
+
+static inline uint32_t dtl_phv_num_entries(const dtl_phv_node_t *node)
+{
+   return (node->u32NumCollisions != 0u)? node->u32NumCollisions : dtl_phv_popcount(node->u32DataMap);
+}
+
+static inline dtl_phv_node_t **dtl_phv_children(const dtl_phv_node_t *node)
+{
+   return (dtl_phv_node_t**) (NODE_ENTRIES(node) + dtl_phv_num_entries(node));
+}
+
+static inline uint32_t dtl_phv_bit(uint32_t u32Hash, uint32_t u32Shift)
+{
+   return 1u << ((u32Hash >> u32Shift) & LEVEL_MASK);
+}
+
+//position of bit among the bits set in u32Map
+static inline uint32_t dtl_phv_index(uint32_t u32Map, uint32_t u32Bit)
+{
+   return dtl_phv_popcount(u32Map & (u32Bit - 1u));
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+dtl_phv_t *dtl_phv_new(void)
+{
+   dtl_phv_t *self = (dtl_phv_t*) dtl_pool_alloc(DTL_POOL_PHV);
+   if (self != 0)
+   {
+      dtl_phv_create(self, (dtl_phv_node_t*) 0, 0u, 0u);
+   }
+   return self;
+}
+
+void dtl_phv_delete(dtl_phv_t *self)
+{
+   if (self != 0)
+   {
+      dtl_phv_node_release(self->data.root);
+      dtl_pool_free(DTL_POOL_PHV, self);
+   }
+}
+
+/**
+ * Returns a new version where pKey maps to dv. With autoIncrementRef false the new version takes over
+ * the caller's reference to dv, unless NULL is returned.
+ */
+dtl_phv_t *dtl_phv_set_cstr(const dtl_phv_t *self, const char *pKey, dtl_dv_t *dv, bool autoIncrementRef)
+{
+   dtl_phv_t *version;
+   dtl_phv_node_t *root;
+   dtl_phv_key_t key;
+   bool isAdded = false;
+   if ( (self == 0) || (pKey == 0) )
+   {
+      return (dtl_phv_t*) 0;
+   }
+   version = (dtl_phv_t*) dtl_pool_alloc(DTL_POOL_PHV);
+   if (version == 0)
+   {
+      return (dtl_phv_t*) 0;
+   }
+   dtl_phv_make_key(&key, pKey);
+   if (self->data.root == 0)
+   {
+      dtl_phv_entry_t entry;
+      entry.key = dtl_atom_intern_bstr((const uint8_t*) key.pKey, (const uint8_t*) key.pKey + key.u32Len);
+      entry.dv = dv;
+      entry.u32Hash = key.u32Hash;
+      root = (entry.key != 0)? dtl_phv_copy_insert_entry((const dtl_phv_node_t*) 0, 0u, &entry, dtl_phv_bit(key.u32Hash, 0u), 0u) : 0;
+      dtl_atom_release(entry.key);
+      isAdded = true;
+   }
+   else
+   {
+      root = dtl_phv_insert(self->data.root, &key, 0u, dv, &isAdded);
+   }
+   if (root == 0)
+   {
+      dtl_pool_free(DTL_POOL_PHV, version);
+      return (dtl_phv_t*) 0;
+   }
+   dtl_phv_create(version, root, self->data.u32Length + (isAdded? 1u : 0u), self->u32Flags);
+   if (!autoIncrementRef)
+   {
+      dtl_dv_dec_ref(dv); //the trie holds its own reference
+   }
+   return version;
+}
+
+/**
+ * Returns a new version without pKey. When pKey is not in the hash the result is self with an added reference.
+ */
+dtl_phv_t *dtl_phv_remove_cstr(const dtl_phv_t *self, const char *pKey)
+{
+   dtl_phv_t *version;
+   dtl_phv_node_t *root = (dtl_phv_node_t*) 0;
+   dtl_phv_key_t key;
+   bool isRemoved = false;
+   bool isFailed = false;
+   if ( (self == 0) || (pKey == 0) )
+   {
+      return (dtl_phv_t*) 0;
+   }
+   dtl_phv_make_key(&key, pKey);
+   if (self->data.root != 0)
+   {
+      root = dtl_phv_erase(self->data.root, &key, 0u, &isRemoved, &isFailed);
+   }
+   if (isFailed)
+   {
+      return (dtl_phv_t*) 0;
+   }
+   if (!isRemoved)
+   {
+      dtl_dv_inc_ref((dtl_dv_t*) self);
+      return (dtl_phv_t*) self;
+   }
+   version = (dtl_phv_t*) dtl_pool_alloc(DTL_POOL_PHV);
+   if (version == 0)
+   {
+      dtl_phv_node_release(root);
+      return (dtl_phv_t*) 0;
+   }
+   dtl_phv_create(version, root, self->data.u32Length - 1u, self->u32Flags);
+   return version;
+}
+
+dtl_dv_t *dtl_phv_get_cstr(const dtl_phv_t *self, const char *pKey)
+{
+   if ( (self != 0) && (pKey != 0) && (self->data.root != 0) )
+   {
+      dtl_phv_key_t key;
+      const dtl_phv_entry_t *entry;
+      dtl_phv_make_key(&key, pKey);
+      entry = dtl_phv_find(self->data.root, &key);
+      if (entry != 0)
+      {
+         return entry->dv;
+      }
+   }
+   return (dtl_dv_t*) 0;
+}
+
+bool dtl_phv_exists_cstr(const dtl_phv_t *self, const char *pKey)
+{
+   if ( (self != 0) && (pKey != 0) && (self->data.root != 0) )
+   {
+      dtl_phv_key_t key;
+      dtl_phv_make_key(&key, pKey);
+      return dtl_phv_find(self->data.root, &key) != 0;
+   }
+   return false;
+}
+
+uint32_t dtl_phv_length(const dtl_phv_t *self)
+{
+   return (self != 0)? self->data.u32Length : 0u;
+}
+
+void dtl_phv_iter_init(const dtl_phv_t *self, dtl_phv_iter_t *iter)
+{
+   if (iter != 0)
+   {
+      iter->s32Depth = -1;
+      if ( (self != 0) && (self->data.root != 0) )
+      {
+         iter->s32Depth = 0;
+         iter->nodes[0] = self->data.root;
+         iter->u32Pos[0] = 0u;
+      }
+   }
+}
+
+/**
+ * Returns the next value and sets *ppKey to its key, or NULL after the last entry.
+ * Entries are visited in trie order, which depends on the key hashes and not on insertion order.
+ */
+dtl_dv_t *dtl_phv_iter_next_cstr(dtl_phv_iter_t *iter, const char **ppKey)
+{
+   if (iter == 0)
+   {
+      return (dtl_dv_t*) 0;
+   }
+   while (iter->s32Depth >= 0)
+   {
+      const dtl_phv_node_t *node = iter->nodes[iter->s32Depth];
+      uint32_t u32NumEntries = dtl_phv_num_entries(node);
+      uint32_t u32Pos = iter->u32Pos[iter->s32Depth]++;
+      if (u32Pos < u32NumEntries)
+      {
+         const dtl_phv_entry_t *entry = &NODE_ENTRIES(node)[u32Pos];
+         if (ppKey != 0)
+         {
+            *ppKey = dtl_atom_cstr(entry->key);
+         }
+         return entry->dv;
+      }
+      else if (u32Pos < (u32NumEntries + dtl_phv_popcount(node->u32NodeMap)))
+      {
+         assert(iter->s32Depth + 1 < DTL_PHV_MAX_DEPTH);
+         iter->s32Depth++;
+         iter->nodes[iter->s32Depth] = dtl_phv_children(node)[u32Pos - u32NumEntries];
+         iter->u32Pos[iter->s32Depth] = 0u;
+      }
+      else
+      {
+         iter->s32Depth--;
+      }
+   }
+   return (dtl_dv_t*) 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+/**
+ * A version made from an atomic version is atomic too, so that it can be shared the same way.
+ */
+static void dtl_phv_create(dtl_phv_t *self, dtl_phv_node_t *root, uint32_t u32Length, uint32_t u32Flags)
+{
+   self->pAny = &self->data;
+   self->data.root = root;
+   self->data.u32Length = u32Length;
+   self->u32Flags = ((uint32_t) DTL_DV_PHASH) | (u32Flags & DTL_DV_FLAG_ATOMIC);
+   dtl_refcnt_init((dtl_dv_t*) self);
+}
+
+static void dtl_phv_make_key(dtl_phv_key_t *key, const char *pKey)
+{
+   key->pKey = pKey;
+   key->u32Len = (uint32_t) strlen(pKey);
+   key->u32Hash = dtl_atom_hash_bstr((const uint8_t*) pKey, (const uint8_t*) pKey + key->u32Len);
+}
+
+static bool dtl_phv_key_equals(const dtl_phv_entry_t *entry, const dtl_phv_key_t *key)
+{
+   return (entry->u32Hash == key->u32Hash) && (dtl_atom_length(entry->key) == key->u32Len) &&
+      (memcmp(dtl_atom_cstr(entry->key), key->pKey, key->u32Len) == 0);
+}
+
+static const dtl_phv_entry_t *dtl_phv_find(const dtl_phv_node_t *node, const dtl_phv_key_t *key)
+{
+   uint32_t u32Shift = 0u;
+   for (;;)
+   {
+      uint32_t u32Bit;
+      if (node->u32NumCollisions != 0u)
+      {
+         uint32_t i;
+         for (i = 0u; i < node->u32NumCollisions; i++)
+         {
+            if (dtl_phv_key_equals(&NODE_ENTRIES(node)[i], key))
+            {
+               return &NODE_ENTRIES(node)[i];
+            }
+         }
+         return (const dtl_phv_entry_t*) 0;
+      }
+      u32Bit = dtl_phv_bit(key->u32Hash, u32Shift);
+      if ( (node->u32DataMap & u32Bit) != 0u)
+      {
+         const dtl_phv_entry_t *entry = &NODE_ENTRIES(node)[dtl_phv_index(node->u32DataMap, u32Bit)];
+         return dtl_phv_key_equals(entry, key)? entry : (const dtl_phv_entry_t*) 0;
+      }
+      if ( (node->u32NodeMap & u32Bit) == 0u)
+      {
+         return (const dtl_phv_entry_t*) 0;
+      }
+      node = dtl_phv_children(node)[dtl_phv_index(node->u32NodeMap, u32Bit)];
+      u32Shift += BITS_PER_LEVEL;
+   }
+}
+
+/**
+ * Returns a copy of node (owned by the caller) where key maps to dv, or NULL when out of memory.
+ * Only the nodes on the path to the key are copied, the copies share all other nodes with the original.
+ */
+static dtl_phv_node_t *dtl_phv_insert(const dtl_phv_node_t *node, const dtl_phv_key_t *key, uint32_t u32Shift, dtl_dv_t *dv, bool *pAdded)
+{
+   dtl_phv_entry_t entry;
+   dtl_phv_node_t *result;
+   uint32_t u32Bit;
+   entry.dv = dv;
+   entry.u32Hash = key->u32Hash;
+   if (node->u32NumCollisions != 0u)
+   {
+      uint32_t i;
+      for (i = 0u; i < node->u32NumCollisions; i++)
+      {
+         if (dtl_phv_key_equals(&NODE_ENTRIES(node)[i], key))
+         {
+            entry.key = NODE_ENTRIES(node)[i].key;
+            return dtl_phv_copy_set_entry(node, i, &entry);
+         }
+      }
+      entry.key = dtl_atom_intern_bstr((const uint8_t*) key->pKey, (const uint8_t*) key->pKey + key->u32Len);
+      result = (entry.key != 0)? dtl_phv_copy_insert_entry(node, node->u32NumCollisions, &entry, 0u, node->u32NumCollisions + 1u) : 0;
+      dtl_atom_release(entry.key);
+      *pAdded = true;
+      return result;
+   }
+   u32Bit = dtl_phv_bit(key->u32Hash, u32Shift);
+   if ( (node->u32DataMap & u32Bit) != 0u)
+   {
+      uint32_t u32Index = dtl_phv_index(node->u32DataMap, u32Bit);
+      const dtl_phv_entry_t *current = &NODE_ENTRIES(node)[u32Index];
+      if (dtl_phv_key_equals(current, key))
+      {
+         entry.key = current->key;
+         return dtl_phv_copy_set_entry(node, u32Index, &entry);
+      }
+      *pAdded = true;
+      entry.key = dtl_atom_intern_bstr((const uint8_t*) key->pKey, (const uint8_t*) key->pKey + key->u32Len);
+      if (entry.key == 0)
+      {
+         return (dtl_phv_node_t*) 0;
+      }
+      result = dtl_phv_merge(current, &entry, u32Shift + BITS_PER_LEVEL);
+      dtl_atom_release(entry.key);
+      return (result != 0)? dtl_phv_copy_entry_to_child(node, u32Bit, result) : 0;
+   }
+   if ( (node->u32NodeMap & u32Bit) != 0u)
+   {
+      uint32_t u32Index = dtl_phv_index(node->u32NodeMap, u32Bit);
+      result = dtl_phv_insert(dtl_phv_children(node)[u32Index], key, u32Shift + BITS_PER_LEVEL, dv, pAdded);
+      return (result != 0)? dtl_phv_copy_set_child(node, u32Index, result) : 0;
+   }
+   *pAdded = true;
+   entry.key = dtl_atom_intern_bstr((const uint8_t*) key->pKey, (const uint8_t*) key->pKey + key->u32Len);
+   result = (entry.key != 0)? dtl_phv_copy_insert_entry(node, dtl_phv_index(node->u32DataMap, u32Bit), &entry, node->u32DataMap | u32Bit, 0u) : 0;
+   dtl_atom_release(entry.key);
+   return result;
+}
+
+/**
+ * Returns a copy of node without key. NULL is returned when the key was the last entry in node or when
+ * *pRemoved is false (key not found) or *pFailed is true (out of memory).
+ * A child node left with a single entry is replaced by that entry, which keeps the trie as shallow as possible.
+ */
+static dtl_phv_node_t *dtl_phv_erase(const dtl_phv_node_t *node, const dtl_phv_key_t *key, uint32_t u32Shift, bool *pRemoved, bool *pFailed)
+{
+   dtl_phv_node_t *result;
+   uint32_t u32Bit;
+   if (node->u32NumCollisions != 0u)
+   {
+      uint32_t i;
+      for (i = 0u; i < node->u32NumCollisions; i++)
+      {
+         if (dtl_phv_key_equals(&NODE_ENTRIES(node)[i], key))
+         {
+            *pRemoved = true;
+            result = dtl_phv_copy_remove_entry(node, i, 0u, node->u32NumCollisions - 1u);
+            *pFailed = (result == 0);
+            return result;
+         }
+      }
+      return (dtl_phv_node_t*) 0;
+   }
+   u32Bit = dtl_phv_bit(key->u32Hash, u32Shift);
+   if ( (node->u32DataMap & u32Bit) != 0u)
+   {
+      uint32_t u32Index = dtl_phv_index(node->u32DataMap, u32Bit);
+      if (!dtl_phv_key_equals(&NODE_ENTRIES(node)[u32Index], key))
+      {
+         return (dtl_phv_node_t*) 0;
+      }
+      *pRemoved = true;
+      if ( (node->u32DataMap == u32Bit) && (node->u32NodeMap == 0u) )
+      {
+         return (dtl_phv_node_t*) 0;
+      }
+      result = dtl_phv_copy_remove_entry(node, u32Index, node->u32DataMap & ~u32Bit, 0u);
+      *pFailed = (result == 0);
+      return result;
+   }
+   if ( (node->u32NodeMap & u32Bit) != 0u)
+   {
+      uint32_t u32Index = dtl_phv_index(node->u32NodeMap, u32Bit);
+      dtl_phv_node_t *child = dtl_phv_erase(dtl_phv_children(node)[u32Index], key, u32Shift + BITS_PER_LEVEL, pRemoved, pFailed);
+      if ( (!*pRemoved) || *pFailed)
+      {
+         return (dtl_phv_node_t*) 0;
+      }
+      assert(child != 0); //child nodes always hold at least two entries
+      if ( (dtl_phv_num_entries(child) == 1u) && (child->u32NodeMap == 0u) )
+      {
+         result = dtl_phv_copy_child_to_entry(node, u32Bit, &NODE_ENTRIES(child)[0]);
+         dtl_phv_node_release(child);
+      }
+      else
+      {
+         result = dtl_phv_copy_set_child(node, u32Index, child);
+      }
+      *pFailed = (result == 0);
+      return result;
+   }
+   return (dtl_phv_node_t*) 0;
+}
+
+/**
+ * Returns a new node holding two entries with different keys, pushed down the trie until their hashes differ.
+ */
+static dtl_phv_node_t *dtl_phv_merge(const dtl_phv_entry_t *first, const dtl_phv_entry_t *second, uint32_t u32Shift)
+{
+   dtl_phv_node_t *node;
+   if (u32Shift > MAX_SHIFT)
+   {
+      node = dtl_phv_node_new(0u, 0u, 2u);
+      if (node != 0)
+      {
+         dtl_phv_copy_entries(&NODE_ENTRIES(node)[0], first, 1u);
+         dtl_phv_copy_entries(&NODE_ENTRIES(node)[1], second, 1u);
+      }
+   }
+   else
+   {
+      uint32_t u32FirstBit = dtl_phv_bit(first->u32Hash, u32Shift);
+      uint32_t u32SecondBit = dtl_phv_bit(second->u32Hash, u32Shift);
+      if (u32FirstBit != u32SecondBit)
+      {
+         node = dtl_phv_node_new(u32FirstBit | u32SecondBit, 0u, 0u);
+         if (node != 0)
+         {
+            bool isFirstLow = (u32FirstBit < u32SecondBit);
+            dtl_phv_copy_entries(&NODE_ENTRIES(node)[0], isFirstLow? first : second, 1u);
+            dtl_phv_copy_entries(&NODE_ENTRIES(node)[1], isFirstLow? second : first, 1u);
+         }
+      }
+      else
+      {
+         dtl_phv_node_t *child = dtl_phv_merge(first, second, u32Shift + BITS_PER_LEVEL);
+         if (child == 0)
+         {
+            return (dtl_phv_node_t*) 0;
+         }
+         node = dtl_phv_node_new(0u, u32FirstBit, 0u);
+         if (node == 0)
+         {
+            dtl_phv_node_release(child);
+            return (dtl_phv_node_t*) 0;
+         }
+         dtl_phv_children(node)[0] = child;
+      }
+   }
+   return node;
+}
+
+static dtl_phv_node_t *dtl_phv_node_new(uint32_t u32DataMap, uint32_t u32NodeMap, uint32_t u32NumCollisions)
+{
+   uint32_t u32NumEntries = (u32NumCollisions != 0u)? u32NumCollisions : dtl_phv_popcount(u32DataMap);
+   dtl_phv_node_t *node = (dtl_phv_node_t*) malloc(sizeof(dtl_phv_node_t) + (u32NumEntries * sizeof(dtl_phv_entry_t)) +
+      (dtl_phv_popcount(u32NodeMap) * sizeof(dtl_phv_node_t*)));
+   if (node != 0)
+   {
+      node->u32RefCnt = 1u;
+      node->u32DataMap = u32DataMap;
+      node->u32NodeMap = u32NodeMap;
+      node->u32NumCollisions = u32NumCollisions;
+   }
+   return node;
+}
+
+static void dtl_phv_node_release(dtl_phv_node_t *node)
+{
+   if ( (node != 0) && (dtl_atomic_dec_u32(&node->u32RefCnt) == 0u) )
+   {
+      uint32_t u32NumEntries = dtl_phv_num_entries(node);
+      uint32_t u32NumNodes = dtl_phv_popcount(node->u32NodeMap);
+      dtl_phv_node_t **children = dtl_phv_children(node);
+      uint32_t i;
+      for (i = 0u; i < u32NumEntries; i++)
+      {
+         dtl_atom_release(NODE_ENTRIES(node)[i].key);
+         dtl_dv_dec_ref(NODE_ENTRIES(node)[i].dv);
+      }
+      for (i = 0u; i < u32NumNodes; i++)
+      {
+         dtl_phv_node_release(children[i]);
+      }
+      free(node);
+   }
+}
+
+/*
+ * The copy functions below return a new node with one change applied, or NULL when out of memory.
+ * Entries and nodes taken over from the original node are retained, entry arguments are copied (retained)
+ * and child arguments are consumed (the node is released if the copy cannot be made).
+ * node may be NULL in dtl_phv_copy_insert_entry, the result then holds only the new entry.
+ */
+static dtl_phv_node_t *dtl_phv_copy_set_entry(const dtl_phv_node_t *node, uint32_t u32Index, const dtl_phv_entry_t *entry)
+{
+   uint32_t u32NumEntries = dtl_phv_num_entries(node);
+   dtl_phv_node_t *copy = dtl_phv_node_new(node->u32DataMap, node->u32NodeMap, node->u32NumCollisions);
+   if (copy != 0)
+   {
+      dtl_phv_copy_entries(NODE_ENTRIES(copy), NODE_ENTRIES(node), u32Index);
+      dtl_phv_copy_entries(&NODE_ENTRIES(copy)[u32Index], entry, 1u);
+      dtl_phv_copy_entries(&NODE_ENTRIES(copy)[u32Index + 1u], &NODE_ENTRIES(node)[u32Index + 1u], u32NumEntries - u32Index - 1u);
+      dtl_phv_copy_children(dtl_phv_children(copy), dtl_phv_children(node), dtl_phv_popcount(node->u32NodeMap));
+   }
+   return copy;
+}
+
+static dtl_phv_node_t *dtl_phv_copy_insert_entry(const dtl_phv_node_t *node, uint32_t u32Index, const dtl_phv_entry_t *entry, uint32_t u32DataMap, uint32_t u32NumCollisions)
+{
+   uint32_t u32NodeMap = (node != 0)? node->u32NodeMap : 0u;
+   uint32_t u32NumEntries = (node != 0)? dtl_phv_num_entries(node) : 0u;
+   dtl_phv_node_t *copy = dtl_phv_node_new(u32DataMap, u32NodeMap, u32NumCollisions);
+   if (copy != 0)
+   {
+      if (node != 0)
+      {
+         dtl_phv_copy_entries(NODE_ENTRIES(copy), NODE_ENTRIES(node), u32Index);
+         dtl_phv_copy_entries(&NODE_ENTRIES(copy)[u32Index + 1u], &NODE_ENTRIES(node)[u32Index], u32NumEntries - u32Index);
+         dtl_phv_copy_children(dtl_phv_children(copy), dtl_phv_children(node), dtl_phv_popcount(u32NodeMap));
+      }
+      dtl_phv_copy_entries(&NODE_ENTRIES(copy)[u32Index], entry, 1u);
+   }
+   return copy;
+}
+
+static dtl_phv_node_t *dtl_phv_copy_remove_entry(const dtl_phv_node_t *node, uint32_t u32Index, uint32_t u32DataMap, uint32_t u32NumCollisions)
+{
+   uint32_t u32NumEntries = dtl_phv_num_entries(node);
+   dtl_phv_node_t *copy;
+   if ( (node->u32NumCollisions != 0u) && (u32NumCollisions == 1u) )
+   {
+      //a single remaining colliding key becomes a regular entry, the parent takes it over
+      u32DataMap = 1u;
+      u32NumCollisions = 0u;
+   }
+   copy = dtl_phv_node_new(u32DataMap, node->u32NodeMap, u32NumCollisions);
+   if (copy != 0)
+   {
+      dtl_phv_copy_entries(NODE_ENTRIES(copy), NODE_ENTRIES(node), u32Index);
+      dtl_phv_copy_entries(&NODE_ENTRIES(copy)[u32Index], &NODE_ENTRIES(node)[u32Index + 1u], u32NumEntries - u32Index - 1u);
+      dtl_phv_copy_children(dtl_phv_children(copy), dtl_phv_children(node), dtl_phv_popcount(node->u32NodeMap));
+   }
+   return copy;
+}
+
+static dtl_phv_node_t *dtl_phv_copy_set_child(const dtl_phv_node_t *node, uint32_t u32Index, dtl_phv_node_t *child)
+{
+   uint32_t u32NumNodes = dtl_phv_popcount(node->u32NodeMap);
+   dtl_phv_node_t *copy = dtl_phv_node_new(node->u32DataMap, node->u32NodeMap, 0u);
+   if (copy == 0)
+   {
+      dtl_phv_node_release(child);
+      return (dtl_phv_node_t*) 0;
+   }
+   dtl_phv_copy_entries(NODE_ENTRIES(copy), NODE_ENTRIES(node), dtl_phv_num_entries(node));
+   dtl_phv_copy_children(dtl_phv_children(copy), dtl_phv_children(node), u32Index);
+   dtl_phv_children(copy)[u32Index] = child;
+   dtl_phv_copy_children(&dtl_phv_children(copy)[u32Index + 1u], &dtl_phv_children(node)[u32Index + 1u], u32NumNodes - u32Index - 1u);
+   return copy;
+}
+
+static dtl_phv_node_t *dtl_phv_copy_entry_to_child(const dtl_phv_node_t *node, uint32_t u32Bit, dtl_phv_node_t *child)
+{
+   uint32_t u32DataMap = node->u32DataMap & ~u32Bit;
+   uint32_t u32NodeMap = node->u32NodeMap | u32Bit;
+   uint32_t u32EntryIndex = dtl_phv_index(node->u32DataMap, u32Bit);
+   uint32_t u32NodeIndex = dtl_phv_index(u32NodeMap, u32Bit);
+   uint32_t u32NumEntries = dtl_phv_popcount(node->u32DataMap);
+   uint32_t u32NumNodes = dtl_phv_popcount(node->u32NodeMap);
+   dtl_phv_node_t *copy = dtl_phv_node_new(u32DataMap, u32NodeMap, 0u);
+   if (copy == 0)
+   {
+      dtl_phv_node_release(child);
+      return (dtl_phv_node_t*) 0;
+   }
+   dtl_phv_copy_entries(NODE_ENTRIES(copy), NODE_ENTRIES(node), u32EntryIndex);
+   dtl_phv_copy_entries(&NODE_ENTRIES(copy)[u32EntryIndex], &NODE_ENTRIES(node)[u32EntryIndex + 1u], u32NumEntries - u32EntryIndex - 1u);
+   dtl_phv_copy_children(dtl_phv_children(copy), dtl_phv_children(node), u32NodeIndex);
+   dtl_phv_children(copy)[u32NodeIndex] = child;
+   dtl_phv_copy_children(&dtl_phv_children(copy)[u32NodeIndex + 1u], &dtl_phv_children(node)[u32NodeIndex], u32NumNodes - u32NodeIndex);
+   return copy;
+}
+
+static dtl_phv_node_t *dtl_phv_copy_child_to_entry(const dtl_phv_node_t *node, uint32_t u32Bit, const dtl_phv_entry_t *entry)
+{
+   uint32_t u32DataMap = node->u32DataMap | u32Bit;
+   uint32_t u32NodeMap = node->u32NodeMap & ~u32Bit;
+   uint32_t u32EntryIndex = dtl_phv_index(u32DataMap, u32Bit);
+   uint32_t u32NodeIndex = dtl_phv_index(node->u32NodeMap, u32Bit);
+   uint32_t u32NumEntries = dtl_phv_popcount(node->u32DataMap);
+   uint32_t u32NumNodes = dtl_phv_popcount(node->u32NodeMap);
+   dtl_phv_node_t *copy = dtl_phv_node_new(u32DataMap, u32NodeMap, 0u);
+   if (copy != 0)
+   {
+      dtl_phv_copy_entries(NODE_ENTRIES(copy), NODE_ENTRIES(node), u32EntryIndex);
+      dtl_phv_copy_entries(&NODE_ENTRIES(copy)[u32EntryIndex], entry, 1u);
+      dtl_phv_copy_entries(&NODE_ENTRIES(copy)[u32EntryIndex + 1u], &NODE_ENTRIES(node)[u32EntryIndex], u32NumEntries - u32EntryIndex);
+      dtl_phv_copy_children(dtl_phv_children(copy), dtl_phv_children(node), u32NodeIndex);
+      dtl_phv_copy_children(&dtl_phv_children(copy)[u32NodeIndex], &dtl_phv_children(node)[u32NodeIndex + 1u], u32NumNodes - u32NodeIndex - 1u);
+   }
+   return copy;
+}
+
+static void dtl_phv_copy_entries(dtl_phv_entry_t *dest, const dtl_phv_entry_t *src, uint32_t u32Count)
+{
+   uint32_t i;
+   for (i = 0u; i < u32Count; i++)
+   {
+      dest[i] = src[i];
+      dtl_atom_retain(src[i].key);
+      dtl_dv_inc_ref(src[i].dv);
+   }
+}
+
+static void dtl_phv_copy_children(dtl_phv_node_t **dest, dtl_phv_node_t * const *src, uint32_t u32Count)
+{
+   uint32_t i;
+   for (i = 0u; i < u32Count; i++)
+   {
+      dest[i] = src[i];
+      dtl_atomic_inc_u32(&src[i]->u32RefCnt);
+   }
+}
@@ -0,0 +1,402 @@
+/*****************************************************************************
+* \file      dtl_pool.c
+* \author    Conny Gustafsson
+* \date      2026-10-17
+* \brief     Fixed-size block pools for DTL values
+*
+* Copyright (c) 2026 Conny Gustafsson
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <malloc.h>
+#include <assert.h>
+#include <string.h>
+#include "dtl_pool.h"
+#include "dtl_dv.h"
+#include "dtl_sv.h"
+#include "dtl_av.h"
+#include "dtl_hv.h"
+#include "dtl_phv.h"
+#include "dtl_pav.h"
+#include "dtl_tav.h"
+#include "dtl_thread.h"
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+//Leak check builds must see every allocation, the pool is therefore bypassed in such builds.
+#if defined(DTL_POOL_ALLOC) && !defined(MEM_LEAK_CHECK)
+#define DTL_POOL_ENABLED
+#endif
+
+#define BLOCK_ALIGN        16u
+#define ROUND_UP(x, a)     ( ((x) + ((a) - 1u)) & ~((a) - 1u) )
+#define BLOCK_SIZE(type)   ROUND_UP((uint32_t) sizeof(type), BLOCK_ALIGN)
+
+#ifdef DTL_POOL_ENABLED
+#define SLAB_SIZE          65536u   //must be a power of two, slabs are aligned to their size
+#define CACHE_MAX          256u     //blocks a thread may hold before it returns some to the pool
+#define CACHE_BATCH        64u      //blocks moved between thread cache and pool at a time
+
+typedef struct dtl_pool_block_tag{
+   struct dtl_pool_block_tag *next;
+} dtl_pool_block_t;
+
+typedef struct dtl_pool_slab_tag{
+   struct dtl_pool_slab_tag *prev;  //links in list of slabs that still have free blocks
+   struct dtl_pool_slab_tag *next;
+   dtl_pool_block_t *freeList;      //returned blocks
+   uint8_t *pBump;                  //first never used block
+   uint8_t *pEnd;
+   uint32_t u32NumUsed;             //blocks currently handed out from this slab
+   bool isLinked;
+} dtl_pool_slab_t;
+
+typedef struct dtl_pool_tag{
+   dtl_mutex_t lock;
+   uint32_t u32BlockSize;
+   dtl_pool_slab_t *available;
+   uint32_t u32NumSlabs;
+   uint32_t u32NumOutstanding;
+} dtl_pool_t;
+
+typedef struct dtl_pool_cache_tag{
+   dtl_pool_block_t *head;
+   uint32_t u32Count;
+} dtl_pool_cache_t;
+
+#define SLAB_HEADER_SIZE ROUND_UP((uint32_t) sizeof(dtl_pool_slab_t), BLOCK_ALIGN)
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+#ifdef DTL_POOL_ENABLED
+static void dtl_pool_refill(dtl_pool_t *pool, dtl_pool_cache_t *cache);
+static void dtl_pool_flush(dtl_pool_t *pool, dtl_pool_cache_t *cache, uint32_t u32Count);
+static dtl_pool_slab_t *dtl_pool_new_slab(dtl_pool_t *pool);
+static void dtl_pool_link_slab(dtl_pool_t *pool, dtl_pool_slab_t *slab);
+static void dtl_pool_unlink_slab(dtl_pool_t *pool, dtl_pool_slab_t *slab);
+static void dtl_pool_register_thread(void);
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+static const uint32_t m_blockSize[DTL_POOL_NUM_POOLS] = {
+   (uint32_t) sizeof(dtl_dv_t),
+   (uint32_t) sizeof(dtl_sv_t),
+   (uint32_t) sizeof(dtl_av_t),
+   (uint32_t) sizeof(dtl_hv_t),
+   (uint32_t) sizeof(dtl_phv_t),
+   (uint32_t) sizeof(dtl_pav_t),
+   (uint32_t) sizeof(dtl_tav_t)
+};
+
+#ifdef DTL_POOL_ENABLED
+static dtl_pool_t m_pools[DTL_POOL_NUM_POOLS] = {
+   {DTL_MUTEX_INITIALIZER, BLOCK_SIZE(dtl_dv_t), NULL, 0u, 0u},
+   {DTL_MUTEX_INITIALIZER, BLOCK_SIZE(dtl_sv_t), NULL, 0u, 0u},
+   {DTL_MUTEX_INITIALIZER, BLOCK_SIZE(dtl_av_t), NULL, 0u, 0u},
+   {DTL_MUTEX_INITIALIZER, BLOCK_SIZE(dtl_hv_t), NULL, 0u, 0u},
+   {DTL_MUTEX_INITIALIZER, BLOCK_SIZE(dtl_phv_t), NULL, 0u, 0u},
+   {DTL_MUTEX_INITIALIZER, BLOCK_SIZE(dtl_pav_t), NULL, 0u, 0u},
+   {DTL_MUTEX_INITIALIZER, BLOCK_SIZE(dtl_tav_t), NULL, 0u, 0u}
+};
+static DTL_THREAD_LOCAL dtl_pool_cache_t m_cache[DTL_POOL_NUM_POOLS];
+static DTL_THREAD_LOCAL bool m_threadRegistered = false;
+#ifndef _WIN32
+static pthread_once_t m_keyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t m_threadKey;
+#endif
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+void *dtl_pool_alloc(dtl_pool_id_t id)
+{
+   assert(id < DTL_POOL_NUM_POOLS);
+#ifdef DTL_POOL_ENABLED
+   {
+      dtl_pool_cache_t *cache = &m_cache[id];
+      dtl_pool_block_t *block;
+      if (cache->head == NULL)
+      {
+         dtl_pool_refill(&m_pools[id], cache);
+         if (cache->head == NULL)
+         {
+            return NULL;
+         }
+      }
+      block = cache->head;
+      cache->head = block->next;
+      cache->u32Count--;
+      return (void*) block;
+   }
+#else
+   return malloc(m_blockSize[id]);
+#endif
+}
+
+void dtl_pool_free(dtl_pool_id_t id, void *ptr)
+{
+   assert(id < DTL_POOL_NUM_POOLS);
+#ifdef DTL_POOL_ENABLED
+   if (ptr != NULL)
+   {
+      dtl_pool_cache_t *cache = &m_cache[id];
+      dtl_pool_block_t *block = (dtl_pool_block_t*) ptr;
+      if (!m_threadRegistered)
+      {
+         //a thread may free values that were allocated elsewhere, its cache must still be returned when it exits
+         dtl_pool_register_thread();
+      }
+      block->next = cache->head;
+      cache->head = block;
+      if (++cache->u32Count > CACHE_MAX)
+      {
+         dtl_pool_flush(&m_pools[id], cache, CACHE_BATCH);
+      }
+   }
+#else
+   free(ptr);
+#endif
+}
+
+/**
+ * Returns all blocks cached by the calling thread to their pools and releases slabs that no longer
+ * contain any blocks in use. Blocks cached by other threads are returned when those threads call this
+ * function or exit.
+ */
+void dtl_pool_trim(void)
+{
+#ifdef DTL_POOL_ENABLED
+   int32_t i;
+   for (i = 0; i < (int32_t) DTL_POOL_NUM_POOLS; i++)
+   {
+      dtl_pool_t *pool = &m_pools[i];
+      dtl_pool_slab_t *slab;
+      if (m_cache[i].u32Count > 0u)
+      {
+         dtl_pool_flush(pool, &m_cache[i], m_cache[i].u32Count);
+      }
+      dtl_mutex_lock(&pool->lock);
+      slab = pool->available;
+      while (slab != NULL)
+      {
+         dtl_pool_slab_t *next = slab->next;
+         if (slab->u32NumUsed == 0u)
+         {
+            dtl_pool_unlink_slab(pool, slab);
+            dtl_aligned_free(slab);
+            pool->u32NumSlabs--;
+         }
+         slab = next;
+      }
+      dtl_mutex_unlock(&pool->lock);
+   }
+#endif
+}
+
+bool dtl_pool_stats(dtl_pool_id_t id, dtl_pool_stats_t *stats)
+{
+   if ( (id < DTL_POOL_NUM_POOLS) && (stats != NULL) )
+   {
+      memset(stats, 0, sizeof(dtl_pool_stats_t));
+      stats->u32BlockSize = m_blockSize[id];
+#ifdef DTL_POOL_ENABLED
+      {
+         dtl_pool_t *pool = &m_pools[id];
+         stats->u32BlockSize = pool->u32BlockSize;
+         stats->u32BlocksPerSlab = (SLAB_SIZE - SLAB_HEADER_SIZE) / pool->u32BlockSize;
+         dtl_mutex_lock(&pool->lock);
+         stats->u32NumSlabs = pool->u32NumSlabs;
+         stats->u32NumOutstanding = pool->u32NumOutstanding;
+         dtl_mutex_unlock(&pool->lock);
+         stats->u32NumCached = m_cache[id].u32Count;
+      }
+#endif
+      return true;
+   }
+   return false;
+}
+
+bool dtl_pool_enabled(void)
+{
+#ifdef DTL_POOL_ENABLED
+   return true;
+#else
+   return false;
+#endif
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+#ifdef DTL_POOL_ENABLED
+static void dtl_pool_refill(dtl_pool_t *pool, dtl_pool_cache_t *cache)
+{
+   uint32_t i;
+   if (!m_threadRegistered)
+   {
+      dtl_pool_register_thread();
+   }
+   dtl_mutex_lock(&pool->lock);
+   for (i = 0u; i < CACHE_BATCH; i++)
+   {
+      dtl_pool_block_t *block;
+      dtl_pool_slab_t *slab = pool->available;
+      if (slab == NULL)
+      {
+         slab = dtl_pool_new_slab(pool);
+         if (slab == NULL)
+         {
+            break;
+         }
+      }
+      if (slab->freeList != NULL)
+      {
+         block = slab->freeList;
+         slab->freeList = block->next;
+      }
+      else
+      {
+         assert(slab->pBump + pool->u32BlockSize <= slab->pEnd);
+         block = (dtl_pool_block_t*) slab->pBump;
+         slab->pBump += pool->u32BlockSize;
+      }
+      slab->u32NumUsed++;
+      pool->u32NumOutstanding++;
+      if ( (slab->freeList == NULL) && (slab->pBump + pool->u32BlockSize > slab->pEnd) )
+      {
+         dtl_pool_unlink_slab(pool, slab);
+      }
+      block->next = cache->head;
+      cache->head = block;
+      cache->u32Count++;
+   }
+   dtl_mutex_unlock(&pool->lock);
+}
+
+static void dtl_pool_flush(dtl_pool_t *pool, dtl_pool_cache_t *cache, uint32_t u32Count)
+{
+   dtl_mutex_lock(&pool->lock);
+   while ( (u32Count > 0u) && (cache->head != NULL) )
+   {
+      dtl_pool_block_t *block = cache->head;
+      dtl_pool_slab_t *slab = (dtl_pool_slab_t*) ( ((uintptr_t) block) & ~((uintptr_t) SLAB_SIZE - 1u) );
+      cache->head = block->next;
+      cache->u32Count--;
+      block->next = slab->freeList;
+      slab->freeList = block;
+      assert(slab->u32NumUsed > 0u);
+      slab->u32NumUsed--;
+      pool->u32NumOutstanding--;
+      if (!slab->isLinked)
+      {
+         dtl_pool_link_slab(pool, slab);
+      }
+      u32Count--;
+   }
+   dtl_mutex_unlock(&pool->lock);
+}
+
+static dtl_pool_slab_t *dtl_pool_new_slab(dtl_pool_t *pool)
+{
+   dtl_pool_slab_t *slab = (dtl_pool_slab_t*) dtl_aligned_alloc(SLAB_SIZE, SLAB_SIZE);
+   if (slab != NULL)
+   {
+      uint32_t u32NumBlocks = (SLAB_SIZE - SLAB_HEADER_SIZE) / pool->u32BlockSize;
+      slab->prev = NULL;
+      slab->next = NULL;
+      slab->freeList = NULL;
+      slab->pBump = ((uint8_t*) slab) + SLAB_HEADER_SIZE;
+      slab->pEnd = slab->pBump + (u32NumBlocks * pool->u32BlockSize);
+      slab->u32NumUsed = 0u;
+      slab->isLinked = false;
+      dtl_pool_link_slab(pool, slab);
+      pool->u32NumSlabs++;
+   }
+   return slab;
+}
+
+static void dtl_pool_link_slab(dtl_pool_t *pool, dtl_pool_slab_t *slab)
+{
+   slab->prev = NULL;
+   slab->next = pool->available;
+   if (pool->available != NULL)
+   {
+      pool->available->prev = slab;
+   }
+   pool->available = slab;
+   slab->isLinked = true;
+}
+
+static void dtl_pool_unlink_slab(dtl_pool_t *pool, dtl_pool_slab_t *slab)
+{
+   if (slab->prev != NULL)
+   {
+      slab->prev->next = slab->next;
+   }
+   else
+   {
+      pool->available = slab->next;
+   }
+   if (slab->next != NULL)
+   {
+      slab->next->prev = slab->prev;
+   }
+   slab->prev = NULL;
+   slab->next = NULL;
+   slab->isLinked = false;
+}
+
+#ifndef _WIN32
+static void dtl_pool_thread_exit(void *arg)
+{
+   (void) arg;
+   m_threadRegistered = false; //values freed by later exit handlers register the thread again
+   dtl_pool_trim();
+}
+
+static void dtl_pool_create_key(void)
+{
+   (void) pthread_key_create(&m_threadKey, dtl_pool_thread_exit);
+}
+#endif
+
+/**
+ * Makes sure the blocks cached by a thread are given back when the thread exits.
+ * On Windows there is no portable hook for this, threads should call dtl_pool_trim before they exit.
+ */
+static void dtl_pool_register_thread(void)
+{
+   m_threadRegistered = true;
+#ifndef _WIN32
+   (void) pthread_once(&m_keyOnce, dtl_pool_create_key);
+   (void) pthread_setspecific(m_threadKey, (void*) &m_threadRegistered);
+#endif
+}
+#endif
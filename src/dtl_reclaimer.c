@@ -0,0 +1,247 @@
+/*****************************************************************************
+* \file      dtl_reclaimer.c
+* \author    Conny Gustafsson
+* \date      2026-10-17
+* \brief     Background thread that frees value trees released by other threads
+*
+* Copyright (c) 2026 Conny Gustafsson
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdlib.h>
+#include <string.h>
+#include "dtl_reclaimer.h"
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+#ifndef DTL_BIASED_REFCNT
+static dtl_thread_ret_t DTL_THREAD_CALL dtl_reclaimer_main(void *arg);
+#endif
+static void dtl_reclaimer_process(dtl_dv_t *batch);
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+volatile uint32_t g_dtl_reclaimer_isRunning = 0u;
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+//multi-producer single-consumer queue: producers push onto a lock-free stack (linked through pAny), the reclaimer takes it all at once
+static void * volatile m_head = NULL;
+static volatile uint32_t m_queueDepth = 0u;
+static volatile uint32_t m_maxQueueDepth = 0u;
+static dtl_mutex_t m_lock = DTL_MUTEX_INITIALIZER;
+static dtl_cond_t m_wake = DTL_COND_INITIALIZER;  //signaled when the queue becomes non-empty or the thread must stop
+static dtl_cond_t m_idle = DTL_COND_INITIALIZER;  //broadcast each time a batch has been freed
+static dtl_thread_t m_thread;
+static bool m_isStarted = false;
+static bool m_isStopping = false;
+static dtl_reclaimer_stats_t m_stats;
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Starts the reclaimer thread. From then on, when the last reference to an array or hash is released
+ * outside deferred mode, the releasing thread queues the container and the reclaimer frees it with everything it holds.
+ * Children of a queued tree are released by the reclaimer thread, so they must not be shared with values other
+ * threads still use unless their reference counts are atomic (dtl_dv_set_atomic or DTL_ATOMIC_REFCNT).
+ * Returns false if the thread could not be created. Biased reference counting (DTL_BIASED_REFCNT) is not supported,
+ * the children would only be queued back to the threads that own them.
+ */
+bool dtl_reclaimer_start(void)
+{
+#ifdef DTL_BIASED_REFCNT
+   return false;
+#else
+   bool isStarted;
+   dtl_mutex_lock(&m_lock);
+   if (!m_isStarted)
+   {
+      m_isStopping = false;
+      memset(&m_stats, 0, sizeof(m_stats));
+      dtl_atomic_store_u32(&m_maxQueueDepth, 0u);
+      if (dtl_thread_create(&m_thread, dtl_reclaimer_main, NULL) == 0)
+      {
+         m_isStarted = true;
+         dtl_atomic_store_u32(&g_dtl_reclaimer_isRunning, 1u);
+      }
+   }
+   isStarted = m_isStarted;
+   dtl_mutex_unlock(&m_lock);
+   return isStarted;
+#endif
+}
+
+/**
+ * Frees everything still queued and stops the reclaimer thread. Must not be called while other threads
+ * are releasing values, a tree queued after the thread has exited would never be freed.
+ */
+void dtl_reclaimer_stop(void)
+{
+   dtl_dv_t *batch;
+   dtl_mutex_lock(&m_lock);
+   if (!m_isStarted)
+   {
+      dtl_mutex_unlock(&m_lock);
+      return;
+   }
+   dtl_atomic_store_u32(&g_dtl_reclaimer_isRunning, 0u);
+   m_isStopping = true;
+   dtl_cond_signal(&m_wake);
+   dtl_mutex_unlock(&m_lock);
+   dtl_thread_join(m_thread);
+   //a releasing thread may have seen the reclaimer running just before it stopped
+   batch = (dtl_dv_t*) dtl_atomic_exchange_ptr(&m_head, NULL);
+   if (batch != NULL)
+   {
+      dtl_reclaimer_process(batch);
+   }
+   dtl_mutex_lock(&m_lock);
+   m_isStarted = false;
+   dtl_cond_broadcast(&m_idle);
+   dtl_mutex_unlock(&m_lock);
+}
+
+/**
+ * Waits until every tree queued so far has been freed.
+ */
+void dtl_reclaimer_flush(void)
+{
+   dtl_mutex_lock(&m_lock);
+   while (m_isStarted && (dtl_atomic_load_u32(&m_queueDepth) != 0u))
+   {
+      dtl_cond_wait(&m_idle, &m_lock);
+   }
+   dtl_mutex_unlock(&m_lock);
+}
+
+bool dtl_reclaimer_stats(dtl_reclaimer_stats_t *stats)
+{
+   if (stats != NULL)
+   {
+      dtl_mutex_lock(&m_lock);
+      *stats = m_stats;
+      dtl_mutex_unlock(&m_lock);
+      stats->u32QueueDepth = dtl_atomic_load_u32(&m_queueDepth);
+      stats->u32MaxQueueDepth = dtl_atomic_load_u32(&m_maxQueueDepth);
+      return true;
+   }
+   return false;
+}
+
+/**
+ * Pushes a dead value onto the queue and wakes the reclaimer thread if the queue was empty.
+ */
+bool dtl_reclaimer_enqueue(dtl_dv_t *dv)
+{
+   void *head;
+   uint32_t u32Depth = dtl_atomic_add_u32(&m_queueDepth, 1u);
+   uint32_t u32MaxDepth = dtl_atomic_load_u32(&m_maxQueueDepth);
+   while ( (u32Depth > u32MaxDepth) && (!dtl_atomic_cas_u32(&m_maxQueueDepth, u32MaxDepth, u32Depth)) )
+   {
+      u32MaxDepth = dtl_atomic_load_u32(&m_maxQueueDepth);
+   }
+   do
+   {
+      head = dtl_atomic_load_ptr(&m_head);
+      dv->pAny = head;
+   } while (!dtl_atomic_cas_ptr(&m_head, head, dv));
+   if (head == NULL)
+   {
+      dtl_mutex_lock(&m_lock);
+      dtl_cond_signal(&m_wake);
+      dtl_mutex_unlock(&m_lock);
+   }
+   return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+#ifndef DTL_BIASED_REFCNT
+static dtl_thread_ret_t DTL_THREAD_CALL dtl_reclaimer_main(void *arg)
+{
+   (void) arg;
+   for (;;)
+   {
+      dtl_dv_t *batch = (dtl_dv_t*) dtl_atomic_exchange_ptr(&m_head, NULL);
+      if (batch != NULL)
+      {
+         dtl_reclaimer_process(batch);
+      }
+      else
+      {
+         bool isDone;
+         dtl_mutex_lock(&m_lock);
+         while ( (dtl_atomic_load_ptr(&m_head) == NULL) && (!m_isStopping) )
+         {
+            dtl_cond_wait(&m_wake, &m_lock);
+         }
+         isDone = (dtl_atomic_load_ptr(&m_head) == NULL);
+         dtl_mutex_unlock(&m_lock);
+         if (isDone)
+         {
+            break;
+         }
+      }
+   }
+   return (dtl_thread_ret_t) 0;
+}
+#endif
+
+/**
+ * Frees a batch taken from the queue, oldest tree first, then wakes threads waiting in dtl_reclaimer_flush.
+ */
+static void dtl_reclaimer_process(dtl_dv_t *batch)
+{
+   dtl_dv_t *list = NULL;
+   uint32_t u32NumTrees = 0u;
+   uint64_t u64NumValues = 0u;
+   uint64_t u64NumBytes = 0u;
+   while (batch != NULL)
+   {
+      dtl_dv_t *next = (dtl_dv_t*) batch->pAny;
+      batch->pAny = list;
+      list = batch;
+      batch = next;
+   }
+   while (list != NULL)
+   {
+      dtl_dv_t *next = (dtl_dv_t*) list->pAny;
+      u64NumValues += dtl_dv_free_tree(list, &u64NumBytes);
+      u32NumTrees++;
+      list = next;
+   }
+   dtl_mutex_lock(&m_lock);
+   m_stats.u64NumTrees += u32NumTrees;
+   m_stats.u64NumValues += u64NumValues;
+   m_stats.u64NumBytes += u64NumBytes;
+   (void) dtl_atomic_add_u32(&m_queueDepth, 0u - u32NumTrees);
+   dtl_cond_broadcast(&m_idle);
+   dtl_mutex_unlock(&m_lock);
+}
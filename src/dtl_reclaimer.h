@@ -0,0 +1,56 @@
+/*****************************************************************************
+* \file      dtl_reclaimer.h
+* \author    Conny Gustafsson
+* \date      2026-10-17
+* \brief     Private interface between dtl_dv and the background reclaimer thread
+*
+* Copyright (c) 2026 Conny Gustafsson
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+#ifndef DTL_RECLAIMER_H
+#define DTL_RECLAIMER_H
+
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stdbool.h>
+#include "dtl_dv.h"
+#include "dtl_thread.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+extern volatile uint32_t g_dtl_reclaimer_isRunning;
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+bool dtl_reclaimer_enqueue(dtl_dv_t *dv);
+uint32_t dtl_dv_free_tree(dtl_dv_t *dv, uint64_t *pu64NumBytes); //implemented in dtl_dv.c
+
+/*
+ * Returns true when the dead value dv was queued for the reclaimer thread, false when the caller must free it.
+ */
+static inline bool dtl_reclaimer_handoff(dtl_dv_t *dv)
+{
+   return (dtl_atomic_load_u32(&g_dtl_reclaimer_isRunning) != 0u) && dtl_reclaimer_enqueue(dv);
+}
+
+#endif //DTL_RECLAIMER_H
@@ -0,0 +1,278 @@
+/*****************************************************************************
+* \file      dtl_refcnt.c
+* \author    Conny Gustafsson
+* \date      2026-10-17
+* \brief     Private biased reference counting (owner threads, shared counts and merge queues)
+*
+* Copyright (c) 2026 Conny Gustafsson
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdlib.h>
+#include <assert.h>
+#include "dtl_refcnt.h"
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+#ifdef DTL_BIASED_REFCNT
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define OWNER_ID_LIMIT  ((DTL_DV_OWNER_MASK >> DTL_DV_OWNER_SHIFT) + 1u) //id 0 means "no owner"
+#define QUEUE_MIN_CAP   16u
+
+typedef struct dtl_refcnt_owner_tag{
+   volatile uint32_t u32NumQueued; //modified under m_lock, polled by the owner without it
+   bool isAlive;
+   uint32_t u32QueueCap;
+   dtl_dv_t **ppQueue;             //values whose shared count went negative
+} dtl_refcnt_owner_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static void dtl_refcnt_register_thread(void);
+static bool dtl_refcnt_enqueue(dtl_dv_t *self);
+static bool dtl_refcnt_process(dtl_dv_t *self);
+static void dtl_refcnt_drain(dtl_refcnt_owner_t *owner, bool isExiting);
+#ifndef _WIN32
+static void dtl_refcnt_thread_exit(void *arg);
+static void dtl_refcnt_create_key(void);
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+DTL_THREAD_LOCAL uint32_t g_dtl_refcnt_owner = 0u;
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+static dtl_mutex_t m_lock = DTL_MUTEX_INITIALIZER;
+static dtl_refcnt_owner_t m_owners[OWNER_ID_LIMIT];
+static uint32_t m_nextId = 1u; //ids are never reused, a value may outlive the thread that owns it
+static DTL_THREAD_LOCAL bool m_isRegistered = false;
+#ifndef _WIN32
+static pthread_once_t m_keyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t m_threadKey;
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Returns the u32Flags bits for a value created by the calling thread. A thread gets its owner id when it
+ * creates its first value. Once all ids are used up new threads create DTL_DV_FLAG_ATOMIC values instead.
+ * Creating a value is also when an owner merges values that other threads have queued for it.
+ */
+uint32_t dtl_refcnt_owner_flags(void)
+{
+   if (!m_isRegistered)
+   {
+      dtl_refcnt_register_thread();
+   }
+   if (g_dtl_refcnt_owner == 0u)
+   {
+      return DTL_DV_FLAG_ATOMIC;
+   }
+   if (dtl_atomic_load_u32(&m_owners[g_dtl_refcnt_owner >> DTL_DV_OWNER_SHIFT].u32NumQueued) != 0u)
+   {
+      dtl_refcnt_drain(&m_owners[g_dtl_refcnt_owner >> DTL_DV_OWNER_SHIFT], false);
+   }
+   return g_dtl_refcnt_owner;
+}
+
+void dtl_refcnt_shared_inc(dtl_dv_t *self)
+{
+   (void) dtl_atomic_add_u32(&self->u32SharedRefCnt, DTL_REFCNT_ONE);
+}
+
+/**
+ * Drops a reference held by a thread that is not the owner. Returns true when the value must be deleted.
+ * A negative shared count means the owner's local count holds the remaining references,
+ * the value is then queued so that the owner merges the two counts.
+ */
+bool dtl_refcnt_shared_dec(dtl_dv_t *self)
+{
+   uint32_t u32Shared = dtl_atomic_add_u32(&self->u32SharedRefCnt, 0u - DTL_REFCNT_ONE);
+   if (u32Shared == DTL_REFCNT_MERGED)
+   {
+      return true;
+   }
+   while ( ( (u32Shared & (DTL_REFCNT_MERGED | DTL_REFCNT_QUEUED)) == 0u) && ( (int32_t) u32Shared < 0) )
+   {
+      if (dtl_atomic_cas_u32(&self->u32SharedRefCnt, u32Shared, u32Shared | DTL_REFCNT_QUEUED))
+      {
+         return dtl_refcnt_enqueue(self);
+      }
+      u32Shared = dtl_atomic_load_u32(&self->u32SharedRefCnt);
+   }
+   return false;
+}
+
+/**
+ * Called by the owner when its local count has reached zero. Returns true when no other thread holds a reference.
+ */
+bool dtl_refcnt_merge(dtl_dv_t *self)
+{
+   assert(self->u32RefCnt == 0u);
+   return dtl_atomic_add_u32(&self->u32SharedRefCnt, DTL_REFCNT_MERGED) == DTL_REFCNT_MERGED;
+}
+
+/**
+ * Merges the values queued for the calling thread.
+ */
+void dtl_refcnt_merge_queued(void)
+{
+   if (g_dtl_refcnt_owner != 0u)
+   {
+      dtl_refcnt_drain(&m_owners[g_dtl_refcnt_owner >> DTL_DV_OWNER_SHIFT], false);
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+/**
+ * On Windows there is no portable thread exit hook, a thread that hands values to other threads
+ * should call dtl_dv_refcnt_merge before it exits. Values released after that are never freed.
+ */
+static void dtl_refcnt_register_thread(void)
+{
+   m_isRegistered = true;
+   dtl_mutex_lock(&m_lock);
+   if (m_nextId < OWNER_ID_LIMIT)
+   {
+      m_owners[m_nextId].isAlive = true;
+      g_dtl_refcnt_owner = m_nextId << DTL_DV_OWNER_SHIFT;
+      m_nextId++;
+   }
+   dtl_mutex_unlock(&m_lock);
+#ifndef _WIN32
+   if (g_dtl_refcnt_owner != 0u)
+   {
+      (void) pthread_once(&m_keyOnce, dtl_refcnt_create_key);
+      (void) pthread_setspecific(m_threadKey, (void*) &m_isRegistered);
+   }
+#endif
+}
+
+/**
+ * Returns true when the value had to be processed immediately and must be deleted.
+ * That happens when the owner has exited, its local count can no longer change and is merged by the caller.
+ */
+static bool dtl_refcnt_enqueue(dtl_dv_t *self)
+{
+   dtl_refcnt_owner_t *owner = &m_owners[(self->u32Flags & DTL_DV_OWNER_MASK) >> DTL_DV_OWNER_SHIFT];
+   bool isQueued = false;
+   dtl_mutex_lock(&m_lock);
+   if (owner->isAlive)
+   {
+      uint32_t u32NumQueued = owner->u32NumQueued;
+      isQueued = true;
+      if (u32NumQueued == owner->u32QueueCap)
+      {
+         uint32_t u32NewCap = (owner->u32QueueCap == 0u)? QUEUE_MIN_CAP : owner->u32QueueCap * 2u;
+         dtl_dv_t **ppQueue = (dtl_dv_t**) realloc(owner->ppQueue, sizeof(dtl_dv_t*) * u32NewCap);
+         if (ppQueue != NULL)
+         {
+            owner->ppQueue = ppQueue;
+            owner->u32QueueCap = u32NewCap;
+         }
+      }
+      //when out of memory the value is leaked rather than freed while the owner may still reference it
+      if (u32NumQueued < owner->u32QueueCap)
+      {
+         owner->ppQueue[u32NumQueued] = self;
+         dtl_atomic_store_u32(&owner->u32NumQueued, u32NumQueued + 1u);
+      }
+   }
+   dtl_mutex_unlock(&m_lock);
+   return isQueued? false : dtl_refcnt_process(self);
+}
+
+/**
+ * Moves the owner's local count into the shared count and clears the queued bit.
+ * Returns true when the combined count is zero.
+ */
+static bool dtl_refcnt_process(dtl_dv_t *self)
+{
+   uint32_t u32Shared;
+   if ( (dtl_atomic_load_u32(&self->u32SharedRefCnt) & DTL_REFCNT_MERGED) != 0u)
+   {
+      u32Shared = dtl_atomic_add_u32(&self->u32SharedRefCnt, 0u - DTL_REFCNT_QUEUED);
+   }
+   else
+   {
+      u32Shared = dtl_atomic_add_u32(&self->u32SharedRefCnt, (self->u32RefCnt * DTL_REFCNT_ONE) + DTL_REFCNT_MERGED - DTL_REFCNT_QUEUED);
+      self->u32RefCnt = 0u;
+   }
+   return u32Shared == DTL_REFCNT_MERGED;
+}
+
+static void dtl_refcnt_drain(dtl_refcnt_owner_t *owner, bool isExiting)
+{
+   dtl_dv_t **ppQueue;
+   uint32_t u32NumQueued;
+   uint32_t i;
+   dtl_mutex_lock(&m_lock);
+   ppQueue = owner->ppQueue;
+   u32NumQueued = owner->u32NumQueued;
+   owner->ppQueue = NULL;
+   owner->u32QueueCap = 0u;
+   dtl_atomic_store_u32(&owner->u32NumQueued, 0u);
+   if (isExiting)
+   {
+      owner->isAlive = false;
+   }
+   dtl_mutex_unlock(&m_lock);
+   for (i = 0u; i < u32NumQueued; i++)
+   {
+      if (dtl_refcnt_process(ppQueue[i]))
+      {
+         dtl_dv_delete(ppQueue[i]);
+      }
+   }
+   free(ppQueue);
+}
+
+#ifndef _WIN32
+/**
+ * After this the values owned by the thread only use their shared counts. Threads that later drop the last
+ * references merge the (now constant) local counts themselves.
+ */
+static void dtl_refcnt_thread_exit(void *arg)
+{
+   dtl_refcnt_owner_t *owner = &m_owners[g_dtl_refcnt_owner >> DTL_DV_OWNER_SHIFT];
+   (void) arg;
+   g_dtl_refcnt_owner = 0u;
+   dtl_refcnt_drain(owner, true);
+}
+
+static void dtl_refcnt_create_key(void)
+{
+   (void) pthread_key_create(&m_threadKey, dtl_refcnt_thread_exit);
+}
+#endif
+
+#endif //DTL_BIASED_REFCNT
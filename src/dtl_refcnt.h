@@ -0,0 +1,75 @@
+/*****************************************************************************
+* \file      dtl_refcnt.h
+* \author    Conny Gustafsson
+* \date      2026-10-17
+* \brief     Private biased reference counting (owner threads, shared counts and merge queues)
+*
+* Copyright (c) 2026 Conny Gustafsson
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+#ifndef DTL_REFCNT_H
+#define DTL_REFCNT_H
+
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stdbool.h>
+#include "dtl_dv.h"
+#include "dtl_thread.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#ifdef DTL_BIASED_REFCNT
+//u32SharedRefCnt holds a signed count in bits 2-31 and two state bits
+#define DTL_REFCNT_MERGED   0x1u //the owner has given up its local count, only the shared count is used
+#define DTL_REFCNT_QUEUED   0x2u //the shared count went negative, the value waits in its owner's merge queue
+#define DTL_REFCNT_ONE      0x4u
+
+//owner bits (DTL_DV_OWNER_MASK) of the calling thread, 0 until it has created its first value
+extern DTL_THREAD_LOCAL uint32_t g_dtl_refcnt_owner;
+
+#define DTL_REFCNT_IS_OWNER(dv) ( (((dv)->u32Flags & DTL_DV_OWNER_MASK) == g_dtl_refcnt_owner) && ((dv)->u32RefCnt != 0u) )
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+#ifdef DTL_BIASED_REFCNT
+uint32_t dtl_refcnt_owner_flags(void);
+void dtl_refcnt_shared_inc(dtl_dv_t *self);
+bool dtl_refcnt_shared_dec(dtl_dv_t *self);
+bool dtl_refcnt_merge(dtl_dv_t *self);
+void dtl_refcnt_merge_queued(void);
+#endif
+
+/*
+ * Sets the reference count of a new heap value to one. With DTL_BIASED_REFCNT the calling thread becomes its owner.
+ */
+static inline void dtl_refcnt_init(dtl_dv_t *self)
+{
+   self->u32RefCnt = 1u;
+#ifdef DTL_BIASED_REFCNT
+   self->u32SharedRefCnt = 0u;
+   self->u32Flags |= dtl_refcnt_owner_flags();
+#endif
+}
+
+#endif //DTL_REFCNT_H
@@ -0,0 +1,1127 @@
+/*****************************************************************************
+* \file      dtl_sort.c
+* \author    Conny Gustafsson
+* \date      2026-10-17
+* \brief     Private stable sort of DTL value arrays (used by dtl_av_sort)
+*
+* Copyright (c) 2026 Conny Gustafsson
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdlib.h>
+#include <string.h>
+#include "dtl_sort.h"
+#include "dtl_sv.h"
+#include "dtl_thread.h"
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define MIN_MERGE       64u //shorter arrays are sorted by binary insertion alone
+#define MAX_RUNS        64u //run lengths on the stack grow at least as fast as the Fibonacci numbers
+#define RADIX_MIN_LEN   256u //shorter arrays are sorted by comparison
+#define PRESORTED_RUN   64u  //average run length from which merging runs beats a radix sort
+#define PARALLEL_MIN_LEN     65536u //shorter arrays are sorted on the calling thread
+#define PARALLEL_MIN_CHUNK   16384u //smallest chunk or merge slice handed to a thread
+#define PARALLEL_MAX_THREADS 64u
+#define RADIX_STR_SMALL 32u  //string buckets up to this size are finished by binary insertion
+#define RADIX_STR_END   0u   //bucket of strings that end at the current depth, sorts before any byte
+
+/*
+ * Each element is decorated with its sort key before sorting. Keys of the common scalar types are copied into the
+ * item, so comparing two items reads neither the scalars nor their payloads.
+ */
+typedef struct dtl_sort_item_tag
+{
+   union
+   {
+      int64_t i64;          //I32, I64
+      uint64_t u64;         //U32, U64, BOOL
+      double dbl;           //FLT, DBL
+      struct
+      {
+         const char *pData;
+         uint32_t u32Len;
+      } str;                //STR
+      const dtl_sv_t *sv;   //mixed or other scalar types, compared with dtl_sv_cmp
+   } key;
+   dtl_dv_t *dv;
+} dtl_sort_item_t;
+
+//how the keys were decorated
+typedef enum dtl_sort_key_tag
+{
+   DTL_SORT_KEY_I64,
+   DTL_SORT_KEY_U64,
+   DTL_SORT_KEY_DBL,
+   DTL_SORT_KEY_STR,
+   DTL_SORT_KEY_SV
+} dtl_sort_key_t;
+
+//numeric key mapped to an unsigned integer with the same order, sorted by LSD radix sort
+typedef struct dtl_sort_radix_item_tag
+{
+   uint64_t u64Key;
+   dtl_dv_t *dv;
+} dtl_sort_radix_item_t;
+
+//range of string items that share their first u32Depth bytes, waiting to be distributed by the next byte
+typedef struct dtl_sort_str_task_tag
+{
+   uint32_t u32Begin;
+   uint32_t u32End;
+   uint32_t u32Depth;
+} dtl_sort_str_task_t;
+
+typedef struct dtl_sort_tag dtl_sort_t;
+typedef bool (dtl_sort_lt_t)(const dtl_sort_item_t *left, const dtl_sort_item_t *right, dtl_sort_t *sort);
+
+typedef struct dtl_sort_run_tag
+{
+   dtl_sort_item_t *pBase;
+   uint32_t u32Len;
+} dtl_sort_run_t;
+
+struct dtl_sort_tag
+{
+   dtl_sort_lt_t *lt;
+   dtl_sort_key_t keyType;
+   bool reverse;
+   dtl_error_t errorCode;   //first error reported by dtl_sv_cmp
+   dtl_sort_item_t *pTmp;   //room for half of the items, used by merges
+   dtl_sort_run_t runs[MAX_RUNS];
+   uint32_t u32NumRuns;
+};
+
+//part of a parallel sort: sorting one chunk, or writing one slice of the merge of two sorted chunks
+typedef struct dtl_sort_task_tag
+{
+   dtl_sort_item_t *pLeft;
+   dtl_sort_item_t *pRight;
+   dtl_sort_item_t *pDest;  //merge output, or room for the merge sort temporaries of a chunk
+   uint32_t u32LeftLen;     //length of the chunk to sort
+   uint32_t u32RightLen;    //0 when sorting a chunk
+   uint32_t u32Begin;       //slice of the merged output written by this task
+   uint32_t u32End;
+   dtl_error_t errorCode;
+} dtl_sort_task_t;
+
+//tasks of one phase, taken in order by the worker threads
+typedef struct dtl_sort_pool_tag
+{
+   const dtl_sort_t *sort;
+   dtl_sort_task_t *pTasks;
+   uint32_t u32NumTasks;
+   volatile uint32_t u32NextTask;
+   bool isMerge;
+} dtl_sort_pool_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static dtl_error_t dtl_sort_decorate(dtl_sort_t *sort, dtl_dv_t **ppValues, uint32_t u32Len, dtl_key_func_t *key, dtl_sort_item_t *pItems);
+static void dtl_sort_range(dtl_sort_t *sort, dtl_sort_item_t *pItems, uint32_t u32Len);
+static void dtl_sort_pool_run(dtl_sort_pool_t *pool, uint32_t u32NumThreads);
+static dtl_thread_ret_t DTL_THREAD_CALL dtl_sort_worker(void *arg);
+static void dtl_sort_merge_slice(dtl_sort_t *sort, dtl_sort_task_t *task);
+static uint32_t dtl_sort_co_rank(dtl_sort_t *sort, const dtl_sort_task_t *task, uint32_t u32Pos);
+static bool dtl_sort_is_presorted(dtl_sort_t *sort, dtl_sort_item_t *pItems, uint32_t u32Len);
+static bool dtl_sort_radix_numeric(const dtl_sort_t *sort, dtl_sort_item_t *pItems, uint32_t u32Len);
+static bool dtl_sort_radix_str(dtl_sort_t *sort, dtl_sort_item_t *pItems, uint32_t u32Len);
+static uint32_t dtl_sort_str_byte(const dtl_sort_item_t *pItem, uint32_t u32Depth);
+static void dtl_sort_items(dtl_sort_t *sort, dtl_sort_item_t *pItems, uint32_t u32Len);
+static uint32_t dtl_sort_min_run(uint32_t u32Len);
+static uint32_t dtl_sort_count_run(dtl_sort_t *sort, dtl_sort_item_t *pItems, uint32_t u32Len);
+static void dtl_sort_binary_insertion(dtl_sort_t *sort, dtl_sort_item_t *pItems, uint32_t u32Len, uint32_t u32Start);
+static void dtl_sort_merge_collapse(dtl_sort_t *sort);
+static void dtl_sort_merge_force_collapse(dtl_sort_t *sort);
+static void dtl_sort_merge_at(dtl_sort_t *sort, uint32_t i);
+static void dtl_sort_merge_lo(dtl_sort_t *sort, dtl_sort_item_t *pLeft, uint32_t u32LeftLen, dtl_sort_item_t *pRight, uint32_t u32RightLen);
+static void dtl_sort_merge_hi(dtl_sort_t *sort, dtl_sort_item_t *pLeft, uint32_t u32LeftLen, dtl_sort_item_t *pRight, uint32_t u32RightLen);
+static uint32_t dtl_sort_upper_bound(dtl_sort_t *sort, const dtl_sort_item_t *pKey, const dtl_sort_item_t *pItems, uint32_t u32Len);
+static uint32_t dtl_sort_lower_bound(dtl_sort_t *sort, const dtl_sort_item_t *pKey, const dtl_sort_item_t *pItems, uint32_t u32Len);
+static bool dtl_sort_lt_i64(const dtl_sort_item_t *left, const dtl_sort_item_t *right, dtl_sort_t *sort);
+static bool dtl_sort_lt_u64(const dtl_sort_item_t *left, const dtl_sort_item_t *right, dtl_sort_t *sort);
+static bool dtl_sort_lt_dbl(const dtl_sort_item_t *left, const dtl_sort_item_t *right, dtl_sort_t *sort);
+static bool dtl_sort_lt_str(const dtl_sort_item_t *left, const dtl_sort_item_t *right, dtl_sort_t *sort);
+static bool dtl_sort_lt_sv(const dtl_sort_item_t *left, const dtl_sort_item_t *right, dtl_sort_t *sort);
+
+//a descending sort compares with the operands swapped, equal items then still keep their order
+static inline bool dtl_sort_lt(dtl_sort_t *sort, const dtl_sort_item_t *left, const dtl_sort_item_t *right)
+{
+   return sort->reverse? sort->lt(right, left, sort) : sort->lt(left, right, sort);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Stable sort of u32Len values in ascending (or with reverse, descending) order, equal values keep their order.
+ * Without a key function the values themselves must be scalars, otherwise key is called once per value and must
+ * return a scalar that stays valid during the sort (no reference is transferred).
+ * Scalars are ordered as by dtl_sv_cmp: numbers of different types by their exact value, NaN after all other numbers.
+ * The values are left in their original order when an error is returned.
+ */
+dtl_error_t dtl_sort_values(dtl_dv_t **ppValues, uint32_t u32Len, dtl_key_func_t *key, bool reverse)
+{
+   dtl_sort_t sort;
+   dtl_sort_item_t *pItems;
+   dtl_error_t errorCode;
+   uint32_t i;
+   if ( (ppValues == 0) && (u32Len > 0u) )
+   {
+      return DTL_INVALID_ARGUMENT_ERROR;
+   }
+   if (u32Len < 2u)
+   {
+      return DTL_NO_ERROR;
+   }
+   pItems = (dtl_sort_item_t*) malloc(((size_t) u32Len + (u32Len / 2u) + 1u) * sizeof(dtl_sort_item_t));
+   if (pItems == 0)
+   {
+      return DTL_MEM_ERROR;
+   }
+   sort.reverse = reverse;
+   sort.errorCode = DTL_NO_ERROR;
+   sort.pTmp = &pItems[u32Len];
+   sort.u32NumRuns = 0u;
+   errorCode = dtl_sort_decorate(&sort, ppValues, u32Len, key, pItems);
+   if (errorCode == DTL_NO_ERROR)
+   {
+      dtl_sort_range(&sort, pItems, u32Len);
+      errorCode = sort.errorCode;
+   }
+   if (errorCode == DTL_NO_ERROR)
+   {
+      for (i = 0u; i < u32Len; i++)
+      {
+         ppValues[i] = pItems[i].dv;
+      }
+   }
+   free(pItems);
+   return errorCode;
+}
+
+/**
+ * Same result as dtl_sort_values, with the work spread over up to u32NumThreads threads (the calling thread included).
+ * The items are split into one chunk per thread, the chunks are sorted in parallel and then merged pairwise, each
+ * merge cut into slices that are written in parallel. Merges take the left item on ties, so the result is the stable
+ * order whatever the number of threads. Key functions are only called from the calling thread, before any thread
+ * starts. Arrays shorter than PARALLEL_MIN_LEN, or u32NumThreads below 2, are sorted on the calling thread.
+ */
+dtl_error_t dtl_sort_values_parallel(dtl_dv_t **ppValues, uint32_t u32Len, dtl_key_func_t *key, bool reverse, uint32_t u32NumThreads)
+{
+   dtl_sort_t sort;
+   dtl_sort_pool_t pool;
+   dtl_sort_item_t *pItems;
+   dtl_sort_item_t *pSrc;
+   dtl_sort_item_t *pDst;
+   dtl_sort_task_t *pTasks;
+   dtl_error_t errorCode;
+   uint32_t u32NumChunks;
+   uint32_t u32ChunkLen;
+   uint32_t i;
+   if ( (ppValues == 0) && (u32Len > 0u) )
+   {
+      return DTL_INVALID_ARGUMENT_ERROR;
+   }
+   if (u32NumThreads > PARALLEL_MAX_THREADS)
+   {
+      u32NumThreads = PARALLEL_MAX_THREADS;
+   }
+   u32NumChunks = (u32Len / PARALLEL_MIN_CHUNK < u32NumThreads)? u32Len / PARALLEL_MIN_CHUNK : u32NumThreads;
+   if ( (u32Len < PARALLEL_MIN_LEN) || (u32NumChunks < 2u) )
+   {
+      return dtl_sort_values(ppValues, u32Len, key, reverse);
+   }
+   pItems = (dtl_sort_item_t*) malloc((size_t) u32Len * 2u * sizeof(dtl_sort_item_t));
+   //the merges of a round follow the chunks, at most one per chunk pair plus one per thread
+   pTasks = (dtl_sort_task_t*) malloc((2u * u32NumChunks + u32NumThreads) * sizeof(dtl_sort_task_t));
+   if ( (pItems == 0) || (pTasks == 0) )
+   {
+      free(pItems);
+      free(pTasks);
+      return DTL_MEM_ERROR;
+   }
+   sort.reverse = reverse;
+   sort.errorCode = DTL_NO_ERROR;
+   sort.pTmp = 0;
+   sort.u32NumRuns = 0u;
+   errorCode = dtl_sort_decorate(&sort, ppValues, u32Len, key, pItems);
+   pSrc = pItems;
+   pDst = &pItems[u32Len];
+   pool.sort = &sort;
+   pool.pTasks = pTasks;
+   //sort the chunks, each one uses the same part of the other half as room for its merges
+   u32ChunkLen = u32Len / u32NumChunks;
+   for (i = 0u; i < u32NumChunks; i++)
+   {
+      uint32_t u32Begin = i * u32ChunkLen;
+      pTasks[i].pLeft = &pSrc[u32Begin];
+      pTasks[i].pDest = &pDst[u32Begin];
+      pTasks[i].u32LeftLen = (i + 1u < u32NumChunks)? u32ChunkLen : (u32Len - u32Begin);
+      pTasks[i].u32RightLen = 0u;
+   }
+   if (errorCode == DTL_NO_ERROR)
+   {
+      pool.u32NumTasks = u32NumChunks;
+      pool.isMerge = false;
+      dtl_sort_pool_run(&pool, u32NumThreads);
+   }
+   //merge neighbouring chunks until one is left, tasks [0, u32NumChunks) keep describing the sorted chunks in pSrc
+   while ( (errorCode == DTL_NO_ERROR) && (u32NumChunks > 1u) )
+   {
+      dtl_sort_task_t *pMerges = &pTasks[u32NumChunks];
+      uint32_t u32NumMerges = 0u;
+      for (i = 0u; i < u32NumChunks; i++)
+      {
+         errorCode = (errorCode != DTL_NO_ERROR)? errorCode : pTasks[i].errorCode;
+      }
+      if (errorCode != DTL_NO_ERROR)
+      {
+         break;
+      }
+      for (i = 0u; i < u32NumChunks; i += 2u)
+      {
+         dtl_sort_task_t merge;
+         uint32_t u32MergedLen;
+         uint32_t u32NumSlices;
+         uint32_t u32Slice;
+         merge.pLeft = pTasks[i].pLeft;
+         merge.u32LeftLen = pTasks[i].u32LeftLen;
+         merge.pRight = (i + 1u < u32NumChunks)? pTasks[i + 1u].pLeft : &merge.pLeft[merge.u32LeftLen]; //odd chunk out is copied
+         merge.u32RightLen = (i + 1u < u32NumChunks)? pTasks[i + 1u].u32LeftLen : 0u;
+         merge.pDest = &pDst[merge.pLeft - pSrc];
+         u32MergedLen = merge.u32LeftLen + merge.u32RightLen;
+         u32NumSlices = (uint32_t) (((uint64_t) u32MergedLen * u32NumThreads + u32Len - 1u) / u32Len);
+         if (u32NumSlices > u32MergedLen / PARALLEL_MIN_CHUNK)
+         {
+            u32NumSlices = (u32MergedLen / PARALLEL_MIN_CHUNK > 0u)? u32MergedLen / PARALLEL_MIN_CHUNK : 1u;
+         }
+         for (u32Slice = 0u; u32Slice < u32NumSlices; u32Slice++)
+         {
+            merge.u32Begin = (uint32_t) (((uint64_t) u32MergedLen * u32Slice) / u32NumSlices);
+            merge.u32End = (uint32_t) (((uint64_t) u32MergedLen * (u32Slice + 1u)) / u32NumSlices);
+            pMerges[u32NumMerges++] = merge;
+         }
+      }
+      pool.pTasks = pMerges;
+      pool.u32NumTasks = u32NumMerges;
+      pool.isMerge = true;
+      dtl_sort_pool_run(&pool, u32NumThreads);
+      //the merged chunks become the chunks of the next round
+      u32NumChunks = 0u;
+      for (i = 0u; i < u32NumMerges; i++)
+      {
+         errorCode = (errorCode != DTL_NO_ERROR)? errorCode : pMerges[i].errorCode;
+         if (pMerges[i].u32Begin == 0u)
+         {
+            pTasks[u32NumChunks].pLeft = pMerges[i].pDest;
+            pTasks[u32NumChunks].u32LeftLen = pMerges[i].u32LeftLen + pMerges[i].u32RightLen;
+            pTasks[u32NumChunks].errorCode = DTL_NO_ERROR;
+            u32NumChunks++;
+         }
+      }
+      pool.pTasks = pTasks;
+      pDst = pSrc;
+      pSrc = pTasks[0].pLeft;
+   }
+   if ( (errorCode == DTL_NO_ERROR) && (u32NumChunks == 1u) )
+   {
+      errorCode = pTasks[0].errorCode;
+   }
+   if (errorCode == DTL_NO_ERROR)
+   {
+      for (i = 0u; i < u32Len; i++)
+      {
+         ppValues[i] = pSrc[i].dv;
+      }
+   }
+   free(pItems);
+   free(pTasks);
+   return errorCode;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Fills in the items and picks the comparison. When all keys have the same scalar type the key is copied into the
+ * item and compared directly, other arrays fall back to dtl_sv_cmp.
+ */
+static dtl_error_t dtl_sort_decorate(dtl_sort_t *sort, dtl_dv_t **ppValues, uint32_t u32Len, dtl_key_func_t *key, dtl_sort_item_t *pItems)
+{
+   uint32_t i;
+   dtl_sv_type_id svType = DTL_SV_NONE;
+   bool isHomogeneous = true;
+   for (i = 0u; i < u32Len; i++)
+   {
+      const dtl_dv_t *dv = (key != 0)? key(ppValues[i]) : ppValues[i];
+      if ( (dv == 0) || (dtl_dv_type(dv) != DTL_DV_SCALAR) )
+      {
+         return DTL_TYPE_ERROR;
+      }
+      pItems[i].key.sv = (const dtl_sv_t*) dv;
+      pItems[i].dv = ppValues[i];
+      if (i == 0u)
+      {
+         svType = dtl_sv_type(pItems[i].key.sv);
+      }
+      else if (dtl_sv_type(pItems[i].key.sv) != svType)
+      {
+         isHomogeneous = false;
+      }
+   }
+   sort->lt = dtl_sort_lt_sv;
+   sort->keyType = DTL_SORT_KEY_SV;
+   if (!isHomogeneous)
+   {
+      return DTL_NO_ERROR;
+   }
+   switch (svType)
+   {
+   case DTL_SV_I32:
+      for (i = 0u; i < u32Len; i++)
+      {
+         pItems[i].key.i64 = pItems[i].key.sv->svx.val.i32;
+      }
+      sort->lt = dtl_sort_lt_i64;
+      sort->keyType = DTL_SORT_KEY_I64;
+      break;
+   case DTL_SV_I64:
+      for (i = 0u; i < u32Len; i++)
+      {
+         pItems[i].key.i64 = pItems[i].key.sv->svx.val.i64;
+      }
+      sort->lt = dtl_sort_lt_i64;
+      sort->keyType = DTL_SORT_KEY_I64;
+      break;
+   case DTL_SV_U32:
+      for (i = 0u; i < u32Len; i++)
+      {
+         pItems[i].key.u64 = pItems[i].key.sv->svx.val.u32;
+      }
+      sort->lt = dtl_sort_lt_u64;
+      sort->keyType = DTL_SORT_KEY_U64;
+      break;
+   case DTL_SV_U64:
+      for (i = 0u; i < u32Len; i++)
+      {
+         pItems[i].key.u64 = pItems[i].key.sv->svx.val.u64;
+      }
+      sort->lt = dtl_sort_lt_u64;
+      sort->keyType = DTL_SORT_KEY_U64;
+      break;
+   case DTL_SV_BOOL:
+      for (i = 0u; i < u32Len; i++)
+      {
+         pItems[i].key.u64 = pItems[i].key.sv->svx.val.bl? 1u : 0u;
+      }
+      sort->lt = dtl_sort_lt_u64;
+      sort->keyType = DTL_SORT_KEY_U64;
+      break;
+   case DTL_SV_FLT:
+      for (i = 0u; i < u32Len; i++)
+      {
+         pItems[i].key.dbl = (double) pItems[i].key.sv->svx.val.flt;
+      }
+      sort->lt = dtl_sort_lt_dbl;
+      sort->keyType = DTL_SORT_KEY_DBL;
+      break;
+   case DTL_SV_DBL:
+      for (i = 0u; i < u32Len; i++)
+      {
+         pItems[i].key.dbl = pItems[i].key.sv->svx.val.dbl;
+      }
+      sort->lt = dtl_sort_lt_dbl;
+      sort->keyType = DTL_SORT_KEY_DBL;
+      break;
+   case DTL_SV_STR:
+      for (i = 0u; i < u32Len; i++)
+      {
+         uint32_t u32StrLen = 0u;
+         const char *pData = dtl_sv_get_str_data(pItems[i].key.sv, &u32StrLen);
+         pItems[i].key.str.pData = pData;
+         pItems[i].key.str.u32Len = u32StrLen;
+      }
+      sort->lt = dtl_sort_lt_str;
+      sort->keyType = DTL_SORT_KEY_STR;
+      break;
+   default:
+      //types dtl_sv_cmp cannot order report their error on the first comparison
+      break;
+   }
+   return DTL_NO_ERROR;
+}
+
+/**
+ * Timsort: ascending runs (strictly descending runs are reversed) are extended to a minimum length by binary
+ * insertion and merged so that pre-sorted and reversed input takes linear time. Merges first skip the items that
+ * are already in place, they do not switch to galloping mode.
+ */
+static void dtl_sort_items(dtl_sort_t *sort, dtl_sort_item_t *pItems, uint32_t u32Len)
+{
+   uint32_t u32MinRun = dtl_sort_min_run(u32Len);
+   uint32_t u32Pos = 0u;
+   while (u32Pos < u32Len)
+   {
+      uint32_t u32Remaining = u32Len - u32Pos;
+      uint32_t u32RunLen = dtl_sort_count_run(sort, &pItems[u32Pos], u32Remaining);
+      if (u32RunLen < u32MinRun)
+      {
+         uint32_t u32Forced = (u32Remaining < u32MinRun)? u32Remaining : u32MinRun;
+         dtl_sort_binary_insertion(sort, &pItems[u32Pos], u32Forced, u32RunLen);
+         u32RunLen = u32Forced;
+      }
+      sort->runs[sort->u32NumRuns].pBase = &pItems[u32Pos];
+      sort->runs[sort->u32NumRuns].u32Len = u32RunLen;
+      sort->u32NumRuns++;
+      dtl_sort_merge_collapse(sort);
+      u32Pos += u32RunLen;
+   }
+   dtl_sort_merge_force_collapse(sort);
+}
+
+/**
+ * Sorts decorated items by radix when the keys allow it, by merging runs otherwise. Errors end up in sort->errorCode.
+ */
+static void dtl_sort_range(dtl_sort_t *sort, dtl_sort_item_t *pItems, uint32_t u32Len)
+{
+   //the radix sorts give the same order as the comparison sort and report false when they cannot be used
+   bool isSorted = false;
+   if ( (u32Len >= RADIX_MIN_LEN) && (sort->keyType != DTL_SORT_KEY_SV) && !dtl_sort_is_presorted(sort, pItems, u32Len) )
+   {
+      isSorted = (sort->keyType == DTL_SORT_KEY_STR)? dtl_sort_radix_str(sort, pItems, u32Len) :
+                                                       dtl_sort_radix_numeric(sort, pItems, u32Len);
+   }
+   if (!isSorted)
+   {
+      dtl_sort_items(sort, pItems, u32Len);
+   }
+}
+
+/**
+ * Runs the tasks of the pool on up to u32NumThreads threads and returns when all are done. The calling thread takes
+ * part, so the tasks still complete (more slowly) when threads cannot be created.
+ */
+static void dtl_sort_pool_run(dtl_sort_pool_t *pool, uint32_t u32NumThreads)
+{
+   dtl_thread_t threads[PARALLEL_MAX_THREADS];
+   uint32_t u32NumStarted = 0u;
+   uint32_t i;
+   pool->u32NextTask = 0u;
+   for (i = 1u; (i < u32NumThreads) && (i < pool->u32NumTasks); i++)
+   {
+      if (dtl_thread_create(&threads[u32NumStarted], dtl_sort_worker, pool) != 0)
+      {
+         break;
+      }
+      u32NumStarted++;
+   }
+   (void) dtl_sort_worker(pool);
+   for (i = 0u; i < u32NumStarted; i++)
+   {
+      dtl_thread_join(threads[i]);
+   }
+}
+
+static dtl_thread_ret_t DTL_THREAD_CALL dtl_sort_worker(void *arg)
+{
+   dtl_sort_pool_t *pool = (dtl_sort_pool_t*) arg;
+   for (;;)
+   {
+      uint32_t u32Task = dtl_atomic_add_u32(&pool->u32NextTask, 1u) - 1u;
+      dtl_sort_task_t *task;
+      dtl_sort_t sort;
+      if (u32Task >= pool->u32NumTasks)
+      {
+         break;
+      }
+      task = &pool->pTasks[u32Task];
+      //each task has its own run stack and error, the comparison is shared
+      sort.lt = pool->sort->lt;
+      sort.keyType = pool->sort->keyType;
+      sort.reverse = pool->sort->reverse;
+      sort.errorCode = DTL_NO_ERROR;
+      sort.pTmp = task->pDest;
+      sort.u32NumRuns = 0u;
+      if (pool->isMerge)
+      {
+         dtl_sort_merge_slice(&sort, task);
+      }
+      else
+      {
+         dtl_sort_range(&sort, task->pLeft, task->u32LeftLen);
+      }
+      task->errorCode = sort.errorCode;
+   }
+   return 0;
+}
+
+/**
+ * Writes positions [u32Begin, u32End) of the merge of the left and right items. Right items go first only when they
+ * are less, so equal items keep their order.
+ */
+static void dtl_sort_merge_slice(dtl_sort_t *sort, dtl_sort_task_t *task)
+{
+   uint32_t u32Left = dtl_sort_co_rank(sort, task, task->u32Begin);
+   uint32_t u32LeftEnd = dtl_sort_co_rank(sort, task, task->u32End);
+   uint32_t u32Right = task->u32Begin - u32Left;
+   uint32_t u32RightEnd = task->u32End - u32LeftEnd;
+   dtl_sort_item_t *pDest = &task->pDest[task->u32Begin];
+   while ( (u32Left < u32LeftEnd) && (u32Right < u32RightEnd) )
+   {
+      if (dtl_sort_lt(sort, &task->pRight[u32Right], &task->pLeft[u32Left]))
+      {
+         *pDest++ = task->pRight[u32Right++];
+      }
+      else
+      {
+         *pDest++ = task->pLeft[u32Left++];
+      }
+   }
+   memcpy(pDest, &task->pLeft[u32Left], (u32LeftEnd - u32Left) * sizeof(dtl_sort_item_t));
+   pDest += u32LeftEnd - u32Left;
+   memcpy(pDest, &task->pRight[u32Right], (u32RightEnd - u32Right) * sizeof(dtl_sort_item_t));
+}
+
+/**
+ * Number of left items among the first u32Pos items of the merged output: the smallest count whose next left item is
+ * greater than the last right item taken.
+ */
+static uint32_t dtl_sort_co_rank(dtl_sort_t *sort, const dtl_sort_task_t *task, uint32_t u32Pos)
+{
+   uint32_t u32Low = (u32Pos > task->u32RightLen)? u32Pos - task->u32RightLen : 0u;
+   uint32_t u32High = (u32Pos < task->u32LeftLen)? u32Pos : task->u32LeftLen;
+   while (u32Low < u32High)
+   {
+      uint32_t u32Mid = u32Low + (u32High - u32Low) / 2u;
+      if (dtl_sort_lt(sort, &task->pRight[u32Pos - u32Mid - 1u], &task->pLeft[u32Mid]))
+      {
+         u32High = u32Mid;
+      }
+      else
+      {
+         u32Low = u32Mid + 1u;
+      }
+   }
+   return u32Low;
+}
+
+/**
+ * True when the items consist of long ascending or strictly descending runs, which the merge sort handles in close to
+ * linear time. The scan stops as soon as the runs get short, so random input costs only a few comparisons.
+ * Descending runs are reversed in place, as the merge sort would do.
+ */
+static bool dtl_sort_is_presorted(dtl_sort_t *sort, dtl_sort_item_t *pItems, uint32_t u32Len)
+{
+   uint32_t u32Pos = 0u;
+   uint32_t u32NumRuns = 0u;
+   while (u32Pos < u32Len)
+   {
+      u32Pos += dtl_sort_count_run(sort, &pItems[u32Pos], u32Len - u32Pos);
+      u32NumRuns++;
+      if ( (u32NumRuns * PRESORTED_RUN) > (u32Pos + PRESORTED_RUN) )
+      {
+         return false;
+      }
+   }
+   return true;
+}
+
+/**
+ * LSD radix sort on numeric keys, one byte per pass. The keys are mapped to unsigned integers with the same order
+ * (flipped for a descending sort) and all byte histograms are counted in one pass. Passes where every key has the
+ * same byte are skipped, so i32 values only need four. Each pass is stable, so equal keys keep their order.
+ * Returns false with the items untouched when out of memory.
+ */
+static bool dtl_sort_radix_numeric(const dtl_sort_t *sort, dtl_sort_item_t *pItems, uint32_t u32Len)
+{
+   uint32_t (*pCounts)[256];
+   dtl_sort_radix_item_t *pSrc;
+   dtl_sort_radix_item_t *pDst;
+   uint32_t u32Shift;
+   uint32_t i;
+   pSrc = (dtl_sort_radix_item_t*) malloc((size_t) u32Len * 2u * sizeof(dtl_sort_radix_item_t) + 8u * sizeof(*pCounts));
+   if (pSrc == 0)
+   {
+      return false;
+   }
+   pDst = &pSrc[u32Len];
+   pCounts = (uint32_t (*)[256]) (void*) &pDst[u32Len];
+   memset(pCounts, 0, 8u * sizeof(*pCounts));
+   for (i = 0u; i < u32Len; i++)
+   {
+      uint64_t u64Key;
+      uint32_t u32Byte;
+      if (sort->keyType == DTL_SORT_KEY_DBL)
+      {
+         double dbl = pItems[i].key.dbl;
+         if (dbl == 0.0)
+         {
+            dbl = 0.0; //-0.0 and 0.0 are equal
+         }
+         memcpy(&u64Key, &dbl, sizeof(u64Key));
+         if (dbl != dbl)
+         {
+            u64Key = UINT64_C(0x7FF8000000000000); //all NaNs are equal and above infinity
+         }
+         u64Key = ((u64Key >> 63) != 0u)? ~u64Key : (u64Key | (UINT64_C(1) << 63));
+      }
+      else if (sort->keyType == DTL_SORT_KEY_I64)
+      {
+         u64Key = (uint64_t) pItems[i].key.i64 ^ (UINT64_C(1) << 63);
+      }
+      else
+      {
+         u64Key = pItems[i].key.u64;
+      }
+      if (sort->reverse)
+      {
+         u64Key = ~u64Key;
+      }
+      pSrc[i].u64Key = u64Key;
+      pSrc[i].dv = pItems[i].dv;
+      for (u32Byte = 0u; u32Byte < 8u; u32Byte++)
+      {
+         pCounts[u32Byte][(u64Key >> (u32Byte * 8u)) & 0xFFu]++;
+      }
+   }
+   for (u32Shift = 0u; u32Shift < 64u; u32Shift += 8u)
+   {
+      uint32_t *pCount = pCounts[u32Shift / 8u];
+      uint32_t u32Sum = 0u;
+      dtl_sort_radix_item_t *pSwap;
+      if (pCount[(pSrc[0].u64Key >> u32Shift) & 0xFFu] == u32Len)
+      {
+         continue;
+      }
+      for (i = 0u; i < 256u; i++)
+      {
+         uint32_t u32Count = pCount[i];
+         pCount[i] = u32Sum;
+         u32Sum += u32Count;
+      }
+      for (i = 0u; i < u32Len; i++)
+      {
+         pDst[pCount[(pSrc[i].u64Key >> u32Shift) & 0xFFu]++] = pSrc[i];
+      }
+      pSwap = pSrc;
+      pSrc = pDst;
+      pDst = pSwap;
+   }
+   //the mapping is undone so that the items can still be compared (-0.0 comes back as 0.0, NaN as the quiet NaN)
+   for (i = 0u; i < u32Len; i++)
+   {
+      uint64_t u64Key = sort->reverse? ~pSrc[i].u64Key : pSrc[i].u64Key;
+      if (sort->keyType == DTL_SORT_KEY_DBL)
+      {
+         u64Key = ((u64Key >> 63) != 0u)? (u64Key & ~(UINT64_C(1) << 63)) : ~u64Key;
+         memcpy(&pItems[i].key.dbl, &u64Key, sizeof(u64Key));
+      }
+      else if (sort->keyType == DTL_SORT_KEY_I64)
+      {
+         pItems[i].key.i64 = (int64_t) (u64Key ^ (UINT64_C(1) << 63));
+      }
+      else
+      {
+         pItems[i].key.u64 = u64Key;
+      }
+      pItems[i].dv = pSrc[i].dv;
+   }
+   free((pSrc < pDst)? pSrc : pDst);
+   return true;
+}
+
+/**
+ * MSD radix sort on string keys. Ranges are distributed by their byte at the current depth into 257 buckets,
+ * strings that end there first, and each bucket is sorted stably. Buckets of at most RADIX_STR_SMALL items are
+ * finished by binary insertion. Pending ranges are kept on a heap stack instead of recursing, so long shared prefixes
+ * cannot exhaust the call stack. Returns false when out of memory.
+ */
+static bool dtl_sort_radix_str(dtl_sort_t *sort, dtl_sort_item_t *pItems, uint32_t u32Len)
+{
+   uint32_t au32Counts[257];
+   uint32_t au32Starts[257];
+   dtl_sort_str_task_t *pTasks;
+   dtl_sort_item_t *pAux;
+   uint32_t u32NumTasks = 0u;
+   uint32_t u32MaxTasks = 64u;
+   pAux = (dtl_sort_item_t*) malloc((size_t) u32Len * sizeof(dtl_sort_item_t));
+   pTasks = (dtl_sort_str_task_t*) malloc(u32MaxTasks * sizeof(dtl_sort_str_task_t));
+   if ( (pAux == 0) || (pTasks == 0) )
+   {
+      free(pAux);
+      free(pTasks);
+      return false;
+   }
+   pTasks[u32NumTasks].u32Begin = 0u;
+   pTasks[u32NumTasks].u32End = u32Len;
+   pTasks[u32NumTasks].u32Depth = 0u;
+   u32NumTasks++;
+   while (u32NumTasks > 0u)
+   {
+      dtl_sort_str_task_t task = pTasks[--u32NumTasks];
+      uint32_t u32Count = task.u32End - task.u32Begin;
+      uint32_t u32Sum = task.u32Begin;
+      uint32_t i;
+      if (u32Count <= RADIX_STR_SMALL)
+      {
+         dtl_sort_binary_insertion(sort, &pItems[task.u32Begin], u32Count, 1u);
+         continue;
+      }
+      memset(au32Counts, 0, sizeof(au32Counts));
+      for (i = task.u32Begin; i < task.u32End; i++)
+      {
+         au32Counts[dtl_sort_str_byte(&pItems[i], task.u32Depth)]++;
+      }
+      if (au32Counts[RADIX_STR_END] == u32Count)
+      {
+         continue; //all strings are equal
+      }
+      if (au32Counts[dtl_sort_str_byte(&pItems[task.u32Begin], task.u32Depth)] == u32Count)
+      {
+         //shared prefix, nothing moves at this depth
+         task.u32Depth++;
+         pTasks[u32NumTasks++] = task;
+         continue;
+      }
+      //bucket start positions, in reverse bucket order for a descending sort
+      for (i = 0u; i < 257u; i++)
+      {
+         uint32_t u32Bucket = sort->reverse? 256u - i : i;
+         uint32_t u32BucketCount = au32Counts[u32Bucket];
+         au32Starts[u32Bucket] = u32Sum;
+         au32Counts[u32Bucket] = u32Sum;
+         u32Sum += u32BucketCount;
+      }
+      for (i = task.u32Begin; i < task.u32End; i++)
+      {
+         pAux[au32Counts[dtl_sort_str_byte(&pItems[i], task.u32Depth)]++] = pItems[i];
+      }
+      memcpy(&pItems[task.u32Begin], &pAux[task.u32Begin], u32Count * sizeof(dtl_sort_item_t));
+      //au32Counts now holds the end of each bucket, strings that ended at this depth are already in order
+      for (i = 1u; i < 257u; i++)
+      {
+         uint32_t u32End = au32Counts[i];
+         uint32_t u32Begin = au32Starts[i];
+         if ( (u32End - u32Begin) > 1u )
+         {
+            if (u32NumTasks == u32MaxTasks)
+            {
+               dtl_sort_str_task_t *pGrown = (dtl_sort_str_task_t*) realloc(pTasks, 2u * u32MaxTasks * sizeof(dtl_sort_str_task_t));
+               if (pGrown == 0)
+               {
+                  //the ranges sorted so far stay valid, the comparison sort finishes the job
+                  free(pAux);
+                  free(pTasks);
+                  return false;
+               }
+               pTasks = pGrown;
+               u32MaxTasks *= 2u;
+            }
+            pTasks[u32NumTasks].u32Begin = u32Begin;
+            pTasks[u32NumTasks].u32End = u32End;
+            pTasks[u32NumTasks].u32Depth = task.u32Depth + 1u;
+            u32NumTasks++;
+         }
+      }
+   }
+   free(pAux);
+   free(pTasks);
+   return true;
+}
+
+//byte at u32Depth plus one, or RADIX_STR_END past the end of the string
+static uint32_t dtl_sort_str_byte(const dtl_sort_item_t *pItem, uint32_t u32Depth)
+{
+   return (u32Depth < pItem->key.str.u32Len)? ((uint32_t) (uint8_t) pItem->key.str.pData[u32Depth] + 1u) : RADIX_STR_END;
+}
+
+static uint32_t dtl_sort_min_run(uint32_t u32Len)
+{
+   uint32_t u32Rest = 0u;
+   while (u32Len >= MIN_MERGE)
+   {
+      u32Rest |= u32Len & 1u;
+      u32Len >>= 1u;
+   }
+   return u32Len + u32Rest;
+}
+
+static uint32_t dtl_sort_count_run(dtl_sort_t *sort, dtl_sort_item_t *pItems, uint32_t u32Len)
+{
+   uint32_t u32RunLen = 1u;
+   if (u32Len < 2u)
+   {
+      return u32Len;
+   }
+   if (dtl_sort_lt(sort, &pItems[1], &pItems[0]))
+   {
+      uint32_t i, j;
+      while ( (u32RunLen < u32Len) && dtl_sort_lt(sort, &pItems[u32RunLen], &pItems[u32RunLen - 1u]) )
+      {
+         u32RunLen++;
+      }
+      //only strictly descending runs are reversed, equal items never swap places
+      for (i = 0u, j = u32RunLen - 1u; i < j; i++, j--)
+      {
+         dtl_sort_item_t tmp = pItems[i];
+         pItems[i] = pItems[j];
+         pItems[j] = tmp;
+      }
+   }
+   else
+   {
+      while ( (u32RunLen < u32Len) && !dtl_sort_lt(sort, &pItems[u32RunLen], &pItems[u32RunLen - 1u]) )
+      {
+         u32RunLen++;
+      }
+   }
+   return u32RunLen;
+}
+
+/**
+ * Sorts pItems[0..u32Len) where the first u32Start items are already sorted.
+ */
+static void dtl_sort_binary_insertion(dtl_sort_t *sort, dtl_sort_item_t *pItems, uint32_t u32Len, uint32_t u32Start)
+{
+   uint32_t i;
+   for (i = (u32Start > 0u)? u32Start : 1u; i < u32Len; i++)
+   {
+      dtl_sort_item_t pivot = pItems[i];
+      uint32_t u32Pos = dtl_sort_upper_bound(sort, &pivot, pItems, i);
+      memmove(&pItems[u32Pos + 1u], &pItems[u32Pos], (i - u32Pos) * sizeof(dtl_sort_item_t));
+      pItems[u32Pos] = pivot;
+   }
+}
+
+/**
+ * Keeps the run lengths on the stack decreasing faster than the Fibonacci numbers, which bounds the stack depth
+ * and keeps merges balanced. The invariant is checked on the top four runs.
+ */
+static void dtl_sort_merge_collapse(dtl_sort_t *sort)
+{
+   while (sort->u32NumRuns > 1u)
+   {
+      uint32_t n = sort->u32NumRuns - 2u;
+      dtl_sort_run_t *runs = sort->runs;
+      if ( ((n > 0u) && (runs[n - 1u].u32Len <= (runs[n].u32Len + runs[n + 1u].u32Len))) ||
+           ((n > 1u) && (runs[n - 2u].u32Len <= (runs[n - 1u].u32Len + runs[n].u32Len))) )
+      {
+         if (runs[n - 1u].u32Len < runs[n + 1u].u32Len)
+         {
+            n--;
+         }
+      }
+      else if (runs[n].u32Len > runs[n + 1u].u32Len)
+      {
+         break;
+      }
+      dtl_sort_merge_at(sort, n);
+   }
+}
+
+static void dtl_sort_merge_force_collapse(dtl_sort_t *sort)
+{
+   while (sort->u32NumRuns > 1u)
+   {
+      uint32_t n = sort->u32NumRuns - 2u;
+      if ( (n > 0u) && (sort->runs[n - 1u].u32Len < sort->runs[n + 1u].u32Len) )
+      {
+         n--;
+      }
+      dtl_sort_merge_at(sort, n);
+   }
+}
+
+/**
+ * Merges runs i and i+1 on the stack.
+ */
+static void dtl_sort_merge_at(dtl_sort_t *sort, uint32_t i)
+{
+   dtl_sort_item_t *pLeft = sort->runs[i].pBase;
+   uint32_t u32LeftLen = sort->runs[i].u32Len;
+   dtl_sort_item_t *pRight = sort->runs[i + 1u].pBase;
+   uint32_t u32RightLen = sort->runs[i + 1u].u32Len;
+   uint32_t u32Skip;
+   sort->runs[i].u32Len = u32LeftLen + u32RightLen;
+   if (i == (sort->u32NumRuns - 3u))
+   {
+      sort->runs[i + 1u] = sort->runs[i + 2u];
+   }
+   sort->u32NumRuns--;
+   //left items not greater than the first right item are already in place
+   u32Skip = dtl_sort_upper_bound(sort, &pRight[0], pLeft, u32LeftLen);
+   pLeft += u32Skip;
+   u32LeftLen -= u32Skip;
+   if (u32LeftLen == 0u)
+   {
+      return;
+   }
+   //and so are the right items not less than the last left item
+   u32RightLen = dtl_sort_lower_bound(sort, &pLeft[u32LeftLen - 1u], pRight, u32RightLen);
+   if (u32RightLen == 0u)
+   {
+      return;
+   }
+   if (u32LeftLen <= u32RightLen)
+   {
+      dtl_sort_merge_lo(sort, pLeft, u32LeftLen, pRight, u32RightLen);
+   }
+   else
+   {
+      dtl_sort_merge_hi(sort, pLeft, u32LeftLen, pRight, u32RightLen);
+   }
+}
+
+/**
+ * Merges from the front with the (shorter) left run moved to the temporary buffer.
+ */
+static void dtl_sort_merge_lo(dtl_sort_t *sort, dtl_sort_item_t *pLeft, uint32_t u32LeftLen, dtl_sort_item_t *pRight, uint32_t u32RightLen)
+{
+   dtl_sort_item_t *pTmp = sort->pTmp;
+   dtl_sort_item_t *pDest = pLeft;
+   uint32_t i = 0u;
+   uint32_t j = 0u;
+   memcpy(pTmp, pLeft, u32LeftLen * sizeof(dtl_sort_item_t));
+   while ( (i < u32LeftLen) && (j < u32RightLen) )
+   {
+      if (dtl_sort_lt(sort, &pRight[j], &pTmp[i]))
+      {
+         *pDest++ = pRight[j++];
+      }
+      else
+      {
+         *pDest++ = pTmp[i++];
+      }
+   }
+   memcpy(pDest, &pTmp[i], (u32LeftLen - i) * sizeof(dtl_sort_item_t));
+}
+
+/**
+ * Merges from the back with the (shorter) right run moved to the temporary buffer.
+ */
+static void dtl_sort_merge_hi(dtl_sort_t *sort, dtl_sort_item_t *pLeft, uint32_t u32LeftLen, dtl_sort_item_t *pRight, uint32_t u32RightLen)
+{
+   dtl_sort_item_t *pTmp = sort->pTmp;
+   dtl_sort_item_t *pDest = &pRight[u32RightLen];
+   uint32_t i = u32LeftLen;
+   uint32_t j = u32RightLen;
+   memcpy(pTmp, pRight, u32RightLen * sizeof(dtl_sort_item_t));
+   while ( (i > 0u) && (j > 0u) )
+   {
+      if (dtl_sort_lt(sort, &pTmp[j - 1u], &pLeft[i - 1u]))
+      {
+         *--pDest = pLeft[--i];
+      }
+      else
+      {
+         *--pDest = pTmp[--j];
+      }
+   }
+   memcpy(pLeft, pTmp, j * sizeof(dtl_sort_item_t));
+}
+
+/**
+ * Number of leading items that are not greater than pKey (position after the last equal item).
+ */
+static uint32_t dtl_sort_upper_bound(dtl_sort_t *sort, const dtl_sort_item_t *pKey, const dtl_sort_item_t *pItems, uint32_t u32Len)
+{
+   uint32_t u32Low = 0u;
+   while (u32Low < u32Len)
+   {
+      uint32_t u32Mid = u32Low + ((u32Len - u32Low) / 2u);
+      if (dtl_sort_lt(sort, pKey, &pItems[u32Mid]))
+      {
+         u32Len = u32Mid;
+      }
+      else
+      {
+         u32Low = u32Mid + 1u;
+      }
+   }
+   return u32Low;
+}
+
+/**
+ * Number of leading items that are less than pKey (position of the first equal item).
+ */
+static uint32_t dtl_sort_lower_bound(dtl_sort_t *sort, const dtl_sort_item_t *pKey, const dtl_sort_item_t *pItems, uint32_t u32Len)
+{
+   uint32_t u32Low = 0u;
+   while (u32Low < u32Len)
+   {
+      uint32_t u32Mid = u32Low + ((u32Len - u32Low) / 2u);
+      if (dtl_sort_lt(sort, &pItems[u32Mid], pKey))
+      {
+         u32Low = u32Mid + 1u;
+      }
+      else
+      {
+         u32Len = u32Mid;
+      }
+   }
+   return u32Low;
+}
+
+static bool dtl_sort_lt_i64(const dtl_sort_item_t *left, const dtl_sort_item_t *right, dtl_sort_t *sort)
+{
+   (void) sort;
+   return left->key.i64 < right->key.i64;
+}
+
+static bool dtl_sort_lt_u64(const dtl_sort_item_t *left, const dtl_sort_item_t *right, dtl_sort_t *sort)
+{
+   (void) sort;
+   return left->key.u64 < right->key.u64;
+}
+
+static bool dtl_sort_lt_dbl(const dtl_sort_item_t *left, const dtl_sort_item_t *right, dtl_sort_t *sort)
+{
+   (void) sort;
+   //NaN sorts after all other numbers, as with dtl_sv_cmp
+   return (left->key.dbl < right->key.dbl) || ( (right->key.dbl != right->key.dbl) && (left->key.dbl == left->key.dbl) );
+}
+
+static bool dtl_sort_lt_str(const dtl_sort_item_t *left, const dtl_sort_item_t *right, dtl_sort_t *sort)
+{
+   uint32_t u32MinLen = (left->key.str.u32Len < right->key.str.u32Len)? left->key.str.u32Len : right->key.str.u32Len;
+   int result = (u32MinLen > 0u)? memcmp(left->key.str.pData, right->key.str.pData, u32MinLen) : 0;
+   (void) sort;
+   return (result < 0) || ( (result == 0) && (left->key.str.u32Len < right->key.str.u32Len) );
+}
+
+static bool dtl_sort_lt_sv(const dtl_sort_item_t *left, const dtl_sort_item_t *right, dtl_sort_t *sort)
+{
+   int32_t result = 0;
+   dtl_error_t errorCode = dtl_sv_cmp(left->key.sv, right->key.sv, &result);
+   if ( (errorCode != DTL_NO_ERROR) && (sort->errorCode == DTL_NO_ERROR) )
+   {
+      sort->errorCode = errorCode;
+   }
+   return result < 0;
+}
@@ -37,6 +37,10 @@
 #include "dtl_sv.h"
 #include "dtl_av.h"
 #include "dtl_hv.h"
+#include "dtl_pool.h"
+#include "dtl_thread.h"
+#include "dtl_refcnt.h"
+#include "dtl_numfmt.h"
 #ifdef MEM_LEAK_CHECK
 #include "CMemLeak.h"
 #endif
@@ -48,27 +52,104 @@
 //////////////////////////////////////////////////////////////////////////////
 // PRIVATE CONSTANTS AND DATA TYPES
 //////////////////////////////////////////////////////////////////////////////
-#define MAX_NUM_BUF 128
+#define DTL_SV_CSTR_RING_SIZE 8 //number of thread-local buffers used by dtl_sv_to_cstr for long numeric text
+
+//content of the dual-value cache, stored in the DTL_DV_CACHE_MASK bits of u32Flags
+#define DTL_SV_CACHE_NONE     0u
+#define DTL_SV_CACHE_NAN      1u //string is not a number
+#define DTL_SV_CACHE_I64      2u
+#define DTL_SV_CACHE_U64      3u
+#define DTL_SV_CACHE_DBL      4u
+#define DTL_SV_CACHE_TEXT     5u //text of a numeric scalar
+
+//the cache is only written when no other thread can be reading the scalar at the same time
+#ifdef DTL_BIASED_REFCNT
+#define DTL_SV_CAN_CACHE(sv)  false
+#else
+#define DTL_SV_CAN_CACHE(sv)  ( ( ((sv)->u32Flags & (DTL_DV_FLAG_IMMORTAL | DTL_DV_FLAG_FROZEN)) == 0u) && !DTL_DV_IS_ATOMIC(sv) )
+#endif
 #define BYTEARRAY_DEFAULT_GROWSIZE 256
 #define DTL_CHAR_MIN -128
 #define DTL_CHAR_MAX 127
+#define DTL_SV_NUM_SMALL_INT 256
+
+//The immortal tables are built at compile time so that no initialization (and no locking) is needed at runtime
+#define DTL_SV_IMMORTAL_FLAGS(svType) ( ((uint32_t)DTL_DV_SCALAR) | (((uint32_t)(svType)) << DTL_SV_TYPE_SHIFT) | DTL_DV_FLAG_IMMORTAL | DTL_DV_FLAG_FROZEN )
+#define DTL_SV_IMMORTAL_I32(n) {DTL_DV_HEAD_INIT(&m_dtl_sv_i32[n].svx, DTL_SV_IMMORTAL_FLAGS(DTL_SV_I32)), {{.i32 = (n)}, {0}}}
+#define DTL_SV_IMMORTAL_U32(n) {DTL_DV_HEAD_INIT(&m_dtl_sv_u32[n].svx, DTL_SV_IMMORTAL_FLAGS(DTL_SV_U32)), {{.u32 = (n)}, {0}}}
+#define DTL_SV_SMALL_INT_TEXT(n) {\
+   (char) ( ((n) >= 100)? ('0' + (n) / 100) : ((n) >= 10)? ('0' + (n) / 10) : ('0' + (n)) ),\
+   (char) ( ((n) >= 100)? ('0' + ((n) / 10) % 10) : ((n) >= 10)? ('0' + (n) % 10) : 0 ),\
+   (char) ( ((n) >= 100)? ('0' + (n) % 10) : 0 ),\
+   0 }
+#define DTL_SV_REPEAT4(X, n) X(n), X((n)+1), X((n)+2), X((n)+3)
+#define DTL_SV_REPEAT16(X, n) DTL_SV_REPEAT4(X, n), DTL_SV_REPEAT4(X, (n)+4), DTL_SV_REPEAT4(X, (n)+8), DTL_SV_REPEAT4(X, (n)+12)
+#define DTL_SV_REPEAT64(X, n) DTL_SV_REPEAT16(X, n), DTL_SV_REPEAT16(X, (n)+16), DTL_SV_REPEAT16(X, (n)+32), DTL_SV_REPEAT16(X, (n)+48)
+#define DTL_SV_REPEAT256(X) DTL_SV_REPEAT64(X, 0), DTL_SV_REPEAT64(X, 64), DTL_SV_REPEAT64(X, 128), DTL_SV_REPEAT64(X, 192)
+
+//groups of scalar types ordered by dtl_sv_cmp, values from different groups cannot be compared
+typedef enum dtl_sv_cmp_class_tag
+{
+   DTL_SV_CLASS_NONE,
+   DTL_SV_CLASS_BOOL,
+   DTL_SV_CLASS_NUM,
+   DTL_SV_CLASS_CHAR,
+   DTL_SV_CLASS_STR,
+   DTL_SV_CLASS_OTHER //pointers, values and bytes are only equal to themselves
+} dtl_sv_cmp_class_t;
+
+//numeric value widened without loss: integers that fit are always INT, so UINT is only used above INT64_MAX
+typedef struct dtl_sv_num_tag
+{
+   enum {DTL_SV_NUM_INT, DTL_SV_NUM_UINT, DTL_SV_NUM_DBL} kind;
+   union
+   {
+      int64_t i64;
+      uint64_t u64;
+      double dbl;
+   } val;
+} dtl_sv_num_t;
+
+#define DTL_SV_TWO_POW_63 9223372036854775808.0
+#define DTL_SV_TWO_POW_64 18446744073709551616.0
 
 //////////////////////////////////////////////////////////////////////////////
 // PRIVATE FUNCTION PROTOTYPES
 //////////////////////////////////////////////////////////////////////////////
 static void dtl_sv_set_type(dtl_sv_t *self,dtl_sv_type_id type);
-static void dtl_sv_ztrim(char *str);
 static void dtl_sv_to_string_internal(const dtl_sv_t *self, adt_str_t* str, bool* ok);
+static int32_t dtl_sv_format_text(const char *text, size_t len, char *buf, size_t cap);
+static void dtl_sv_arena_track(dtl_sv_t *self);
+static void dtl_sv_set_str_internal(dtl_sv_t *self, const uint8_t *pData, uint32_t u32Len);
+static const char *dtl_sv_str_data(const dtl_sv_t *self, uint32_t *pLen);
+static bool dtl_sv_str_equal_cstr(const dtl_sv_t *self, const char *cstr);
+static bool dtl_sv_str_to_num(const dtl_sv_t *self, dtl_sv_t *num);
+static uint32_t dtl_sv_cache_kind(const dtl_sv_t *self);
+static void dtl_sv_set_cache_kind(dtl_sv_t *self, uint32_t kind);
+static dtl_sv_cmp_class_t dtl_sv_cmp_class(dtl_sv_type_id type);
+static void dtl_sv_get_num(const dtl_sv_t *self, dtl_sv_num_t *num);
+static int32_t dtl_sv_cmp_num(const dtl_sv_num_t *left, const dtl_sv_num_t *right);
+static int32_t dtl_sv_cmp_i64_dbl(int64_t i64, double dbl);
+static int32_t dtl_sv_cmp_u64_dbl(uint64_t u64, double dbl);
+static uint32_t dtl_sv_hash_u64(uint64_t u64);
 
 //////////////////////////////////////////////////////////////////////////////
 // PUBLIC VARIABLES
 //////////////////////////////////////////////////////////////////////////////
-static dtl_svx_t g_dtl_svx_none = {0};
-dtl_sv_t g_dtl_sv_none = {&g_dtl_svx_none, 1, ((uint32_t)DTL_DV_SCALAR)};
+dtl_sv_t g_dtl_sv_none = {DTL_DV_HEAD_INIT(&g_dtl_sv_none.svx, ((uint32_t)DTL_DV_SCALAR) | DTL_DV_FLAG_IMMORTAL | DTL_DV_FLAG_FROZEN), {{0}, {0}}};
 
 //////////////////////////////////////////////////////////////////////////////
 // PRIVATE VARIABLES
 //////////////////////////////////////////////////////////////////////////////
+static dtl_sv_t m_dtl_sv_false = {DTL_DV_HEAD_INIT(&m_dtl_sv_false.svx, DTL_SV_IMMORTAL_FLAGS(DTL_SV_BOOL)), {{.bl = false}, {0}}};
+static dtl_sv_t m_dtl_sv_true = {DTL_DV_HEAD_INIT(&m_dtl_sv_true.svx, DTL_SV_IMMORTAL_FLAGS(DTL_SV_BOOL)), {{.bl = true}, {0}}};
+static dtl_sv_t m_dtl_sv_empty_str = {DTL_DV_HEAD_INIT(&m_dtl_sv_empty_str.svx, DTL_SV_IMMORTAL_FLAGS(DTL_SV_STR) | DTL_DV_FLAG_SSO),
+                                      {{.sso = {[DTL_SV_SSO_CAPACITY] = DTL_SV_SSO_CAPACITY}}, {0}}};
+static dtl_sv_t m_dtl_sv_i32[DTL_SV_NUM_SMALL_INT] = {DTL_SV_REPEAT256(DTL_SV_IMMORTAL_I32)};
+static dtl_sv_t m_dtl_sv_u32[DTL_SV_NUM_SMALL_INT] = {DTL_SV_REPEAT256(DTL_SV_IMMORTAL_U32)};
+static const char m_dtl_sv_small_int_text[DTL_SV_NUM_SMALL_INT][4] = {DTL_SV_REPEAT256(DTL_SV_SMALL_INT_TEXT)};
+static DTL_THREAD_LOCAL char m_dtl_sv_cstr_ring[DTL_SV_CSTR_RING_SIZE][DTL_SV_NUM_BUF_SIZE];
+static DTL_THREAD_LOCAL uint32_t m_dtl_sv_cstr_next = 0u;
 
 //////////////////////////////////////////////////////////////////////////////
 // PUBLIC FUNCTIONS
@@ -76,7 +157,7 @@ dtl_sv_t g_dtl_sv_none = {&g_dtl_svx_none, 1, ((uint32_t)DTL_DV_SCALAR)};
 //Constructor/Destructor
 dtl_sv_t* dtl_sv_new(void)
 {
-   dtl_sv_t *self = (dtl_sv_t*) malloc(sizeof(dtl_sv_t));
+   dtl_sv_t *self = (dtl_sv_t*) dtl_pool_alloc(DTL_POOL_SV);
    if(self !=(dtl_sv_t*)0)
    {
       dtl_sv_create(self);
@@ -86,9 +167,9 @@ dtl_sv_t* dtl_sv_new(void)
 
 void dtl_sv_delete(dtl_sv_t* self)
 {
-   if(self){
+   if( (self != 0) && ((self->u32Flags & (DTL_DV_FLAG_ARENA | DTL_DV_FLAG_IMMORTAL)) == 0u) ){
       dtl_sv_destroy(self);
-      free(self);
+      dtl_pool_free(DTL_POOL_SV, self);
    }
 }
 
@@ -96,18 +177,10 @@ void dtl_sv_create(dtl_sv_t* self)
 {
    if(self)
    {
-      self->pAny = (dtl_svx_t*) malloc(sizeof(dtl_svx_t));
-      if (self->pAny != 0)
-      {
-         memset(self->pAny, 0, sizeof(dtl_svx_t));
-         self->u32Flags = ((uint32_t)DTL_DV_SCALAR);
-         self->u32RefCnt = 1;
-         self->pAny->tmpStr = (adt_str_t*) 0;
-      }
-      else
-      {
-         assert(0);
-      }
+      memset(&self->svx, 0, sizeof(dtl_svx_t));
+      self->pAny = &self->svx;
+      self->u32Flags = ((uint32_t)DTL_DV_SCALAR);
+      dtl_refcnt_init((dtl_dv_t*) self);
    }
 }
 
@@ -118,35 +191,36 @@ void dtl_sv_destroy(dtl_sv_t* self)
       switch(dtl_sv_type(self))
       {
       case DTL_SV_STR:
-         adt_str_delete(self->pAny->val.str);
+         if ( (self->u32Flags & DTL_DV_FLAG_ATOM) != 0u)
+         {
+            dtl_atom_release(self->svx.val.atom);
+         }
+         else if ( (self->u32Flags & DTL_DV_FLAG_SSO) == 0u)
+         {
+            adt_str_delete(self->svx.val.str);
+         }
          break;
       case DTL_SV_PTR:
-         if(self->pAny->val.ptr.pDestructor != 0)
+         if(self->svx.val.ptr.pDestructor != 0)
          {
-            self->pAny->val.ptr.pDestructor(self->pAny->val.ptr.p);
+            self->svx.val.ptr.pDestructor(self->svx.val.ptr.p);
          }
          break;
       case DTL_SV_DV:
-         if(self->pAny->val.dv != 0)
+         if(self->svx.val.dv != 0)
          {
-            dtl_dv_dec_ref(self->pAny->val.dv);
+            dtl_dv_dec_ref(self->svx.val.dv);
          }
          break;
       case DTL_SV_BYTES:
-         adt_bytes_delete(self->pAny->val.bytes);
+         adt_bytes_delete(self->svx.val.bytes);
          break;
       case DTL_SV_BYTEARRAY:
-         adt_bytearray_delete(self->pAny->val.bytearray);
+         adt_bytearray_delete(self->svx.val.bytearray);
          break;
       default:
          break;
       }
-      if (self->pAny->tmpStr != 0)
-      {
-         adt_str_delete(self->pAny->tmpStr);
-         self->pAny->tmpStr = (adt_str_t*) 0;
-      }
-      free(self->pAny);
       self->pAny = 0;
    }
 }
@@ -291,6 +365,240 @@ dtl_sv_t *dtl_sv_make_bytearray_raw(const uint8_t *dataBuf, uint32_t dataLen)
    return self;
 }
 
+dtl_sv_t *dtl_sv_make_atom(dtl_atom_t *atom)
+{
+   dtl_sv_t *self = dtl_sv_new();
+   if(self)
+   {
+      dtl_sv_set_atom(self, atom);
+   }
+   return self;
+}
+
+//Immortal constructors
+/**
+ * The values returned by the dtl_sv_const functions are shared by all callers and must be treated as read-only.
+ * Reference counting is a no-op on them, passing them to dtl_dec_ref (or storing them in a container with
+ * autoIncRef=false) is always safe.
+ */
+dtl_sv_t *dtl_sv_const_bool(bool bl)
+{
+   return bl? &m_dtl_sv_true : &m_dtl_sv_false;
+}
+
+/**
+ * Returns the shared value for 0..255, any other value is returned as a new heap allocated scalar.
+ */
+dtl_sv_t *dtl_sv_const_i32(int32_t i32)
+{
+   if ( (i32 >= 0) && (i32 < DTL_SV_NUM_SMALL_INT) )
+   {
+      return &m_dtl_sv_i32[i32];
+   }
+   return dtl_sv_make_i32(i32);
+}
+
+/**
+ * Returns the shared value for 0..255, any other value is returned as a new heap allocated scalar.
+ */
+dtl_sv_t *dtl_sv_const_u32(uint32_t u32)
+{
+   if (u32 < DTL_SV_NUM_SMALL_INT)
+   {
+      return &m_dtl_sv_u32[u32];
+   }
+   return dtl_sv_make_u32(u32);
+}
+
+dtl_sv_t *dtl_sv_const_empty_str(void)
+{
+   return &m_dtl_sv_empty_str;
+}
+
+/**
+ * Creates a scalar in arena memory. The scalar is released by dtl_arena_reset, reference counting is disabled.
+ */
+dtl_sv_t* dtl_sv_arena_new(dtl_arena_t *arena)
+{
+   dtl_sv_t *self = (dtl_sv_t*) dtl_arena_alloc(arena, (uint32_t) sizeof(dtl_sv_t));
+   if(self != (dtl_sv_t*)0)
+   {
+      dtl_sv_create(self);
+      self->u32Flags |= DTL_DV_FLAG_ARENA;
+   }
+   return self;
+}
+
+dtl_sv_t *dtl_sv_arena_make_i32(dtl_arena_t *arena, int32_t i32)
+{
+   dtl_sv_t *self = dtl_sv_arena_new(arena);
+   if(self)
+   {
+      dtl_sv_set_i32(self, i32);
+   }
+   return self;
+}
+
+dtl_sv_t *dtl_sv_arena_make_u32(dtl_arena_t *arena, uint32_t u32)
+{
+   dtl_sv_t *self = dtl_sv_arena_new(arena);
+   if(self)
+   {
+      dtl_sv_set_u32(self, u32);
+   }
+   return self;
+}
+
+dtl_sv_t *dtl_sv_arena_make_i64(dtl_arena_t *arena, int64_t i64)
+{
+   dtl_sv_t *self = dtl_sv_arena_new(arena);
+   if(self)
+   {
+      dtl_sv_set_i64(self, i64);
+   }
+   return self;
+}
+
+dtl_sv_t *dtl_sv_arena_make_u64(dtl_arena_t *arena, uint64_t u64)
+{
+   dtl_sv_t *self = dtl_sv_arena_new(arena);
+   if(self)
+   {
+      dtl_sv_set_u64(self, u64);
+   }
+   return self;
+}
+
+dtl_sv_t *dtl_sv_arena_make_flt(dtl_arena_t *arena, float flt)
+{
+   dtl_sv_t *self = dtl_sv_arena_new(arena);
+   if(self)
+   {
+      dtl_sv_set_flt(self, flt);
+   }
+   return self;
+}
+
+dtl_sv_t *dtl_sv_arena_make_dbl(dtl_arena_t *arena, double dbl)
+{
+   dtl_sv_t *self = dtl_sv_arena_new(arena);
+   if(self)
+   {
+      dtl_sv_set_dbl(self, dbl);
+   }
+   return self;
+}
+
+dtl_sv_t *dtl_sv_arena_make_bool(dtl_arena_t *arena, bool bl)
+{
+   dtl_sv_t *self = dtl_sv_arena_new(arena);
+   if(self)
+   {
+      dtl_sv_set_bool(self, bl);
+   }
+   return self;
+}
+
+dtl_sv_t *dtl_sv_arena_make_char(dtl_arena_t *arena, char cr)
+{
+   dtl_sv_t *self = dtl_sv_arena_new(arena);
+   if(self)
+   {
+      dtl_sv_set_char(self, cr);
+   }
+   return self;
+}
+
+dtl_sv_t *dtl_sv_arena_make_ptr(dtl_arena_t *arena, void *ptr, void (*pDestructor)(void*))
+{
+   dtl_sv_t *self = dtl_sv_arena_new(arena);
+   if(self)
+   {
+      dtl_sv_set_ptr(self, ptr, pDestructor);
+   }
+   return self;
+}
+
+dtl_sv_t *dtl_sv_arena_make_str(dtl_arena_t *arena, const adt_str_t *str)
+{
+   dtl_sv_t *self = dtl_sv_arena_new(arena);
+   if(self)
+   {
+      dtl_sv_set_str(self, str);
+   }
+   return self;
+}
+
+dtl_sv_t *dtl_sv_arena_make_cstr(dtl_arena_t *arena, const char *cstr)
+{
+   dtl_sv_t *self = dtl_sv_arena_new(arena);
+   if(self)
+   {
+      dtl_sv_set_cstr(self, cstr);
+   }
+   return self;
+}
+
+dtl_sv_t *dtl_sv_arena_make_dv(dtl_arena_t *arena, dtl_dv_t *dv, bool autoIncRef)
+{
+   dtl_sv_t *self = dtl_sv_arena_new(arena);
+   if(self)
+   {
+      dtl_sv_set_dv(self, dv, autoIncRef);
+   }
+   return self;
+}
+
+dtl_sv_t *dtl_sv_arena_make_bytes(dtl_arena_t *arena, adt_bytes_t *bytes)
+{
+   dtl_sv_t *self = dtl_sv_arena_new(arena);
+   if(self)
+   {
+      dtl_sv_set_bytes(self, bytes);
+   }
+   return self;
+}
+
+dtl_sv_t *dtl_sv_arena_make_bytes_raw(dtl_arena_t *arena, const uint8_t *dataBuf, uint32_t dataLen)
+{
+   dtl_sv_t *self = dtl_sv_arena_new(arena);
+   if(self)
+   {
+      dtl_sv_set_bytes_raw(self, dataBuf, dataLen);
+   }
+   return self;
+}
+
+dtl_sv_t *dtl_sv_arena_make_bytearray(dtl_arena_t *arena, adt_bytearray_t *array)
+{
+   dtl_sv_t *self = dtl_sv_arena_new(arena);
+   if(self)
+   {
+      dtl_sv_set_bytearray(self, array);
+   }
+   return self;
+}
+
+dtl_sv_t *dtl_sv_arena_make_bytearray_raw(dtl_arena_t *arena, const uint8_t *dataBuf, uint32_t dataLen)
+{
+   dtl_sv_t *self = dtl_sv_arena_new(arena);
+   if(self)
+   {
+      dtl_sv_set_bytearray_raw(self, dataBuf, dataLen);
+   }
+   return self;
+}
+
+dtl_sv_t *dtl_sv_arena_make_atom(dtl_arena_t *arena, dtl_atom_t *atom)
+{
+   dtl_sv_t *self = dtl_sv_arena_new(arena);
+   if(self)
+   {
+      dtl_sv_set_atom(self, atom);
+   }
+   return self;
+}
+
 dtl_sv_type_id dtl_sv_type(const dtl_sv_t* self){
    if(self){
       uint8_t u8Type = (uint8_t) ((self->u32Flags & DTL_SV_TYPE_MASK)>>DTL_SV_TYPE_SHIFT);
@@ -301,7 +609,7 @@ dtl_sv_type_id dtl_sv_type(const dtl_sv_t* self){
 
 dtl_dv_type_id dtl_sv_dv_type(const dtl_sv_t* self){
    if( (self != 0) && ( (dtl_sv_type(self) == DTL_SV_DV)) ){
-      return dtl_dv_type(self->pAny->val.dv);
+      return dtl_dv_type(self->svx.val.dv);
    }
    return DTL_DV_INVALID;
 }
@@ -309,167 +617,183 @@ dtl_dv_type_id dtl_sv_dv_type(const dtl_sv_t* self){
 
 //Setters
 void dtl_sv_set_i32(dtl_sv_t *self, int32_t i32){
-   if(self){
-      if(dtl_sv_type(self)==DTL_SV_DV){
-         dtl_dv_dec_ref(self->pAny->val.dv);
-      }
+   if(DTL_DV_IS_WRITABLE(self)){
       dtl_sv_set_type(self,DTL_SV_I32);
-      self->pAny->val.i32 = i32;
+      self->svx.val.i32 = i32;
    }
 }
 
 void dtl_sv_set_u32(dtl_sv_t *self, uint32_t u32){
-   if(self){
-      if(dtl_sv_type(self)==DTL_SV_DV){
-         dtl_dv_dec_ref(self->pAny->val.dv);
-      }
+   if(DTL_DV_IS_WRITABLE(self)){
       dtl_sv_set_type(self,DTL_SV_U32);
-      self->pAny->val.u32 = u32;
+      self->svx.val.u32 = u32;
    }
 }
 
 void dtl_sv_set_i64(dtl_sv_t *self, int64_t i64){
-   if(self){
-      if(dtl_sv_type(self)==DTL_SV_DV){
-         dtl_dv_dec_ref(self->pAny->val.dv);
-      }
+   if(DTL_DV_IS_WRITABLE(self)){
       dtl_sv_set_type(self,DTL_SV_I64);
-      self->pAny->val.i64 = i64;
+      self->svx.val.i64 = i64;
    }
 }
 
 void dtl_sv_set_u64(dtl_sv_t *self, uint64_t u64){
-   if(self){
-      if(dtl_sv_type(self)==DTL_SV_DV){
-         dtl_dv_dec_ref(self->pAny->val.dv);
-      }
+   if(DTL_DV_IS_WRITABLE(self)){
       dtl_sv_set_type(self,DTL_SV_U64);
-      self->pAny->val.u64 = u64;
+      self->svx.val.u64 = u64;
    }
 }
 
 
 void dtl_sv_set_flt(dtl_sv_t *self, float flt){
-   if(self){
-      if(dtl_sv_type(self)==DTL_SV_DV){
-         dtl_dv_dec_ref(self->pAny->val.dv);
-      }
+   if(DTL_DV_IS_WRITABLE(self)){
       dtl_sv_set_type(self,DTL_SV_FLT);
-      self->pAny->val.flt = flt;
+      self->svx.val.flt = flt;
    }
 }
 void dtl_sv_set_dbl(dtl_sv_t *self, double dbl){
-   if(self){
+   if(DTL_DV_IS_WRITABLE(self)){
       dtl_sv_set_type(self,DTL_SV_DBL);
-      self->pAny->val.dbl = dbl;
+      self->svx.val.dbl = dbl;
    }
 }
 
 void dtl_sv_set_bool(dtl_sv_t *self, bool bl){
-   if(self){
+   if(DTL_DV_IS_WRITABLE(self)){
       dtl_sv_set_type(self,DTL_SV_BOOL);
-      self->pAny->val.bl = bl;
+      self->svx.val.bl = bl;
    }
 }
 
 void dtl_sv_set_char(dtl_sv_t* self, char cr)
 {
-   if (self)
+   if (DTL_DV_IS_WRITABLE(self))
    {
       dtl_sv_set_type(self, DTL_SV_CHAR);
-      self->pAny->val.cr = cr;
+      self->svx.val.cr = cr;
    }
 }
 
 void dtl_sv_set_ptr(dtl_sv_t *self, void *p, void (*pDestructor)(void*)){
-   if(self){
-      if(dtl_sv_type(self)==DTL_SV_DV){
-         dtl_dv_dec_ref(self->pAny->val.dv);
-      }
+   if(DTL_DV_IS_WRITABLE(self)){
       dtl_sv_set_type(self,DTL_SV_PTR);
-      self->pAny->val.ptr.p = p;
-      self->pAny->val.ptr.pDestructor = pDestructor;
+      self->svx.val.ptr.p = p;
+      self->svx.val.ptr.pDestructor = pDestructor;
    }
 }
 
 void dtl_sv_set_str(dtl_sv_t *self, const adt_str_t *str)
 {
-   if (self != 0)
+   if (DTL_DV_IS_WRITABLE(self))
    {
-      dtl_sv_set_type(self, DTL_SV_STR);
-      adt_str_set(self->pAny->val.str, str);
+      if (str != 0)
+      {
+         dtl_sv_set_str_internal(self, str->pStr, (uint32_t) adt_str_length(str));
+      }
+      else
+      {
+         dtl_sv_set_str_internal(self, (const uint8_t*) 0, 0u);
+      }
    }
 }
 
 void dtl_sv_set_cstr(dtl_sv_t *self, const char* cstr){
-   if(self != 0)
+   if(DTL_DV_IS_WRITABLE(self))
    {
-      dtl_sv_set_type(self, DTL_SV_STR);
-      adt_str_set_cstr(self->pAny->val.str, cstr);
+      if (cstr != 0)
+      {
+         dtl_sv_set_str_internal(self, (const uint8_t*) cstr, (uint32_t) strlen(cstr));
+      }
+      else
+      {
+         dtl_sv_set_str_internal(self, (const uint8_t*) 0, 0u);
+      }
    }
 }
 
 void dtl_sv_set_bstr(dtl_sv_t *self, const uint8_t *pBegin, const uint8_t *pEnd)
 {
-   if ( (self != 0) && (pBegin != 0) && (pEnd != 0) && (pBegin<=pEnd) )
+   if ( DTL_DV_IS_WRITABLE(self) && (pBegin != 0) && (pEnd != 0) && (pBegin<=pEnd) )
    {
-      dtl_sv_set_type(self, DTL_SV_STR);
-      adt_str_set_bstr(self->pAny->val.str, pBegin, pEnd);
+      dtl_sv_set_str_internal(self, pBegin, (uint32_t) (pEnd - pBegin));
    }
 }
 
 void dtl_sv_set_dv(dtl_sv_t *self, dtl_dv_t *dv, bool autoIncRef)
 {
-   if(self != 0)
+   if(DTL_DV_IS_WRITABLE(self))
    {
       dtl_sv_set_type(self,DTL_SV_DV);
-      self->pAny->val.dv = dv;
+      self->svx.val.dv = dv;
       if (autoIncRef)
       {
          dtl_dv_inc_ref(dv);
       }
    }
+   else if ( (self != 0) && (!autoIncRef) )
+   {
+      dtl_dv_dec_ref(dv); //frozen, the reference handed over by the caller is released
+   }
 }
 
 void dtl_sv_set_bytes(dtl_sv_t *self, adt_bytes_t *bytes)
 {
-   if (self != 0)
+   if (DTL_DV_IS_WRITABLE(self))
    {
       dtl_sv_set_type(self, DTL_SV_BYTES);
-      self->pAny->val.bytes = adt_bytes_clone(bytes);
+      self->svx.val.bytes = adt_bytes_clone(bytes);
    }
 }
 
 void dtl_sv_set_bytes_raw(dtl_sv_t *self, const uint8_t *dataBuf, uint32_t dataLen)
 {
-   if (self != 0)
+   if (DTL_DV_IS_WRITABLE(self))
    {
       dtl_sv_set_type(self, DTL_SV_BYTES);
-      self->pAny->val.bytes = adt_bytes_new(dataBuf, dataLen);
+      self->svx.val.bytes = adt_bytes_new(dataBuf, dataLen);
    }
 }
 
 void dtl_sv_set_bytearray(dtl_sv_t *self, adt_bytearray_t *array)
 {
-   dtl_sv_set_type(self, DTL_SV_BYTEARRAY);
-   adt_bytearray_append(self->pAny->val.bytearray, array->pData, array->u32CurLen);
+   if (DTL_DV_IS_WRITABLE(self))
+   {
+      dtl_sv_set_type(self, DTL_SV_BYTEARRAY);
+      adt_bytearray_append(self->svx.val.bytearray, array->pData, array->u32CurLen);
+   }
 }
 
 void dtl_sv_set_bytearray_raw(dtl_sv_t *self, const uint8_t *dataBuf, uint32_t dataLen)
 {
-   if (self != 0)
+   if (DTL_DV_IS_WRITABLE(self))
    {
       dtl_sv_set_type(self, DTL_SV_BYTEARRAY);
-      adt_bytearray_append(self->pAny->val.bytearray, dataBuf, dataLen);
+      adt_bytearray_append(self->svx.val.bytearray, dataBuf, dataLen);
    }
 }
 
 void dtl_sv_take_bytes(dtl_sv_t *self, adt_bytes_t *bytes)
 {
-   if (self != 0)
+   if (DTL_DV_IS_WRITABLE(self))
    {
       dtl_sv_set_type(self, DTL_SV_BYTES);
-      self->pAny->val.bytes = bytes;
+      self->svx.val.bytes = bytes;
+   }
+}
+
+/**
+ * Makes self a string scalar that shares the interned string. The scalar holds its own reference to the atom.
+ */
+void dtl_sv_set_atom(dtl_sv_t *self, dtl_atom_t *atom)
+{
+   if ( DTL_DV_IS_WRITABLE(self) && (atom != 0) )
+   {
+      dtl_atom_retain(atom);
+      dtl_sv_set_type(self, DTL_SV_NONE);
+      dtl_sv_set_type(self, DTL_SV_STR);
+      self->svx.val.atom = atom;
+      self->u32Flags |= DTL_DV_FLAG_ATOM;
+      dtl_sv_arena_track(self);
    }
 }
 
@@ -485,53 +809,61 @@ int32_t dtl_sv_to_i32(const dtl_sv_t *self, bool *ok)
       case DTL_SV_NONE:
          break;
       case DTL_SV_I32:
-         retval = self->pAny->val.i32;
+         retval = self->svx.val.i32;
          success = true;
          break;
       case DTL_SV_U32:
-         if (self->pAny->val.u32 <= INT32_MAX)
+         if (self->svx.val.u32 <= INT32_MAX)
          {
-            retval = (int32_t)self->pAny->val.u32;
+            retval = (int32_t)self->svx.val.u32;
             success = true;
          }
          break;
       case DTL_SV_I64:
-         if ( (self->pAny->val.i64 >= INT32_MIN) && (self->pAny->val.i64 <= INT32_MAX))
+         if ( (self->svx.val.i64 >= INT32_MIN) && (self->svx.val.i64 <= INT32_MAX))
          {
-            retval = (int32_t)self->pAny->val.i64;
+            retval = (int32_t)self->svx.val.i64;
             success = true;
          }
          break;
       case DTL_SV_U64:
-         if (self->pAny->val.i64 <= INT32_MAX)
+         if (self->svx.val.u64 <= (uint64_t)INT32_MAX)
          {
-            retval = (int32_t)self->pAny->val.i64;
+            retval = (int32_t)self->svx.val.u64;
             success = true;
          }
          break;
       case DTL_SV_FLT:
-         if ((self->pAny->val.flt >= (float)INT32_MIN) && (self->pAny->val.flt <= (float)INT32_MAX))
+         //(float)INT32_MAX rounds up to 2^31, compare as double so that 2^31 itself is rejected
+         if (((double)self->svx.val.flt >= (double)INT32_MIN) && ((double)self->svx.val.flt <= (double)INT32_MAX))
          {
-            retval = (int32_t)self->pAny->val.flt;
+            retval = (int32_t)self->svx.val.flt;
             success = true;
          }
          break;
       case DTL_SV_DBL:
-         if ((self->pAny->val.dbl >= (double)INT32_MIN) && (self->pAny->val.dbl <= (double)INT32_MAX))
+         if ((self->svx.val.dbl >= (double)INT32_MIN) && (self->svx.val.dbl <= (double)INT32_MAX))
          {
-            retval = (int32_t)self->pAny->val.dbl;
+            retval = (int32_t)self->svx.val.dbl;
             success = true;
          }
          break;
       case DTL_SV_BOOL:
-         retval = (int32_t) self->pAny->val.bl;
+         retval = (int32_t) self->svx.val.bl;
          success = true;
          break;
       case DTL_SV_CHAR:
-         retval = (int32_t)self->pAny->val.cr;
+         retval = (int32_t)self->svx.val.cr;
          success = true;
          break;
       case DTL_SV_STR:
+         {
+            dtl_sv_t num;
+            if (dtl_sv_str_to_num(self, &num))
+            {
+               return dtl_sv_to_i32(&num, ok);
+            }
+         }
          break;
       case DTL_SV_PTR:
          break;
@@ -559,54 +891,60 @@ uint32_t dtl_sv_to_u32(const dtl_sv_t *self, bool *ok)
       case DTL_SV_NONE:
          break;
       case DTL_SV_I32:
-         if (self->pAny->val.i32 >= 0)
+         if (self->svx.val.i32 >= 0)
          {
-            retval = (uint32_t)self->pAny->val.i32;
+            retval = (uint32_t)self->svx.val.i32;
             success = true;
          }
          break;
       case DTL_SV_U32:
-         retval =  self->pAny->val.u32;
+         retval =  self->svx.val.u32;
          success = true;
          break;
       case DTL_SV_I64:
-         if ( (self->pAny->val.i64 >= 0) && (self->pAny->val.i64 <= (int64_t)UINT32_MAX))
+         if ( (self->svx.val.i64 >= 0) && (self->svx.val.i64 <= (int64_t)UINT32_MAX))
          {
-            retval = (uint32_t)self->pAny->val.i64;
+            retval = (uint32_t)self->svx.val.i64;
             success = true;
          }
          break;
       case DTL_SV_U64:
-         if (self->pAny->val.u64 <= (uint64_t)UINT32_MAX)
+         if (self->svx.val.u64 <= (uint64_t)UINT32_MAX)
          {
-            retval = (uint32_t)self->pAny->val.u64;
+            retval = (uint32_t)self->svx.val.u64;
             success = true;
          }
-         success = true;
          break;
       case DTL_SV_FLT:
-         if (self->pAny->val.flt >= 0.0)
+         if ((self->svx.val.flt >= 0.0f) && ((double)self->svx.val.flt < 4294967296.0))
          {
-            retval = (uint32_t)self->pAny->val.flt;
+            retval = (uint32_t)self->svx.val.flt;
             success = true;
          }
          break;
       case DTL_SV_DBL:
-         if (self->pAny->val.dbl >= 0.0)
+         if ((self->svx.val.dbl >= 0.0) && (self->svx.val.dbl < 4294967296.0))
          {
-            retval = (uint32_t)self->pAny->val.dbl;
+            retval = (uint32_t)self->svx.val.dbl;
             success = true;
          }
          break;
       case DTL_SV_BOOL:
-         retval = (uint32_t) self->pAny->val.bl;
+         retval = (uint32_t) self->svx.val.bl;
          success = true;
          break;
       case DTL_SV_CHAR:
-         retval = (uint32_t)self->pAny->val.cr;
+         retval = (uint32_t)self->svx.val.cr;
          success = true;
          break;
       case DTL_SV_STR:
+         {
+            dtl_sv_t num;
+            if (dtl_sv_str_to_num(self, &num))
+            {
+               return dtl_sv_to_u32(&num, ok);
+            }
+         }
          break;
       case DTL_SV_PTR:
          break;
@@ -636,41 +974,54 @@ int64_t dtl_sv_to_i64(const dtl_sv_t *self, bool *ok)
       case DTL_SV_NONE:
          break;
       case DTL_SV_I32:
-         retval = (int32_t)self->pAny->val.i32;
+         retval = (int32_t)self->svx.val.i32;
          success = true;
          break;
       case DTL_SV_U32:
-         retval = (int64_t) self->pAny->val.u32;
+         retval = (int64_t) self->svx.val.u32;
          success = true;
          break;
       case DTL_SV_I64:
-         retval = (int64_t)self->pAny->val.i64;
+         retval = (int64_t)self->svx.val.i64;
          success = true;
          break;
       case DTL_SV_U64:
-         if (self->pAny->val.u64 <= INT64_MAX)
+         if (self->svx.val.u64 <= INT64_MAX)
          {
-            retval = (int64_t)self->pAny->val.i64;
+            retval = (int64_t)self->svx.val.i64;
             success = true;
          }
          break;
      case DTL_SV_FLT:
-         retval = (int64_t) self->pAny->val.flt;
-         success = true;
+         if (((double)self->svx.val.flt >= -DTL_SV_TWO_POW_63) && ((double)self->svx.val.flt < DTL_SV_TWO_POW_63))
+         {
+            retval = (int64_t) self->svx.val.flt;
+            success = true;
+         }
          break;
       case DTL_SV_DBL:
-         retval = (int64_t) self->pAny->val.dbl;
-         success = true;
+         if ((self->svx.val.dbl >= -DTL_SV_TWO_POW_63) && (self->svx.val.dbl < DTL_SV_TWO_POW_63))
+         {
+            retval = (int64_t) self->svx.val.dbl;
+            success = true;
+         }
          break;
      case DTL_SV_BOOL:
-         retval = (int64_t) self->pAny->val.bl;
+         retval = (int64_t) self->svx.val.bl;
          success = true;
          break;
      case DTL_SV_CHAR:
-        retval = (int64_t)self->pAny->val.cr;
+        retval = (int64_t)self->svx.val.cr;
         success = true;
         break;
       case DTL_SV_STR:
+         {
+            dtl_sv_t num;
+            if (dtl_sv_str_to_num(self, &num))
+            {
+               return dtl_sv_to_i64(&num, ok);
+            }
+         }
          break;
       case DTL_SV_PTR:
          break;
@@ -700,50 +1051,57 @@ uint64_t dtl_sv_to_u64(const dtl_sv_t *self, bool *ok)
       case DTL_SV_NONE:
          break;
       case DTL_SV_I32:
-         if (self->pAny->val.i32 >= 0)
+         if (self->svx.val.i32 >= 0)
          {
-            retval = (uint64_t)self->pAny->val.i32;
+            retval = (uint64_t)self->svx.val.i32;
             success = true;
          }
-         break;         break;
+         break;
       case DTL_SV_U32:
-         retval = (uint64_t) self->pAny->val.u32;
+         retval = (uint64_t) self->svx.val.u32;
          success = true;
          break;
       case DTL_SV_I64:
-         if (self->pAny->val.i32 >= 0)
+         if (self->svx.val.i64 >= 0)
          {
-            retval = (uint64_t)self->pAny->val.i64;
+            retval = (uint64_t)self->svx.val.i64;
             success = true;
          }
-         break;         break;
+         break;
       case DTL_SV_U64:
-         retval = self->pAny->val.u64;
+         retval = self->svx.val.u64;
          success = true;
          break;
       case DTL_SV_FLT:
-         if (self->pAny->val.flt >= 0.0)
+         if ((self->svx.val.flt >= 0.0f) && ((double)self->svx.val.flt < DTL_SV_TWO_POW_64))
          {
-            retval = (uint64_t)self->pAny->val.flt;
+            retval = (uint64_t)self->svx.val.flt;
             success = true;
          }
          break;
       case DTL_SV_DBL:
-         if (self->pAny->val.dbl >= 0.0)
+         if ((self->svx.val.dbl >= 0.0) && (self->svx.val.dbl < DTL_SV_TWO_POW_64))
          {
-            retval = (uint64_t)self->pAny->val.dbl;
+            retval = (uint64_t)self->svx.val.dbl;
             success = true;
          }
          break;
       case DTL_SV_BOOL:
-         retval = (uint64_t) self->pAny->val.bl;
+         retval = (uint64_t) self->svx.val.bl;
          success = true;
          break;
       case DTL_SV_CHAR:
-         retval = (uint64_t)self->pAny->val.cr;
+         retval = (uint64_t)self->svx.val.cr;
          success = true;
          break;
       case DTL_SV_STR:
+         {
+            dtl_sv_t num;
+            if (dtl_sv_str_to_num(self, &num))
+            {
+               return dtl_sv_to_u64(&num, ok);
+            }
+         }
          break;
       case DTL_SV_PTR:
          break;
@@ -775,40 +1133,47 @@ float dtl_sv_to_flt(const dtl_sv_t *self, bool *ok)
       case DTL_SV_NONE:
          break;
       case DTL_SV_I32:
-         retval = (float) self->pAny->val.i32;
+         retval = (float) self->svx.val.i32;
          success = true;
          break;
       case DTL_SV_U32:
-         retval = (float) self->pAny->val.u32;
+         retval = (float) self->svx.val.u32;
          success = true;
          break;
       case DTL_SV_I64:
-         retval = (float) self->pAny->val.i64;
+         retval = (float) self->svx.val.i64;
          success = true;
          break;
       case DTL_SV_U64:
-         retval = (float) self->pAny->val.u64;
+         retval = (float) self->svx.val.u64;
          success = true;
          break;
       case DTL_SV_FLT:
-         retval = self->pAny->val.flt;
+         retval = self->svx.val.flt;
          success = true;
          break;
       case DTL_SV_DBL:
-         retval = (float) self->pAny->val.dbl;
+         retval = (float) self->svx.val.dbl;
          success = true;
          break;
       case DTL_SV_BOOL:
-         retval = (float) self->pAny->val.bl;
+         retval = (float) self->svx.val.bl;
          success = true;
          break;
       case DTL_SV_CHAR:
-         retval = (float)self->pAny->val.cr;
+         retval = (float)self->svx.val.cr;
          success = true;
          break;
       case DTL_SV_STR:
-         break;
-      case DTL_SV_PTR:
+         {
+            dtl_sv_t num;
+            if (dtl_sv_str_to_num(self, &num))
+            {
+               return dtl_sv_to_flt(&num, ok);
+            }
+         }
+         break;
+      case DTL_SV_PTR:
          break;
       case DTL_SV_DV:
          break;
@@ -837,38 +1202,45 @@ double dtl_sv_to_dbl(const dtl_sv_t *self, bool *ok)
       case DTL_SV_NONE:
          break;
       case DTL_SV_I32:
-         retval = (double) self->pAny->val.i32;
+         retval = (double) self->svx.val.i32;
          success = true;
          break;
       case DTL_SV_U32:
-         retval = (double) self->pAny->val.u32;
+         retval = (double) self->svx.val.u32;
          success = true;
          break;
       case DTL_SV_FLT:
-         retval = (double) self->pAny->val.flt;
+         retval = (double) self->svx.val.flt;
          success = true;
          break;
       case DTL_SV_I64:
-         retval = (double) self->pAny->val.i64;
+         retval = (double) self->svx.val.i64;
          success = true;
          break;
       case DTL_SV_U64:
-         retval = (double) self->pAny->val.u64;
+         retval = (double) self->svx.val.u64;
          success = true;
          break;
       case DTL_SV_DBL:
-         retval = self->pAny->val.dbl;
+         retval = self->svx.val.dbl;
          success = true;
          break;
       case DTL_SV_BOOL:
-         retval = (double) self->pAny->val.bl;
+         retval = (double) self->svx.val.bl;
          success = true;
          break;
       case DTL_SV_CHAR:
-         retval = (double)self->pAny->val.cr;
+         retval = (double)self->svx.val.cr;
          success = true;
          break;
       case DTL_SV_STR:
+         {
+            dtl_sv_t num;
+            if (dtl_sv_str_to_num(self, &num))
+            {
+               return dtl_sv_to_dbl(&num, ok);
+            }
+         }
          break;
       case DTL_SV_PTR:
          break;
@@ -897,53 +1269,53 @@ char dtl_sv_to_char(const dtl_sv_t *self, bool *ok){
          if (ok != NULL) *ok = false;
          break;
       case DTL_SV_I32:
-         if ((self->pAny->val.i32 >= DTL_CHAR_MIN) && (self->pAny->val.i32 <= DTL_CHAR_MAX))
+         if ((self->svx.val.i32 >= DTL_CHAR_MIN) && (self->svx.val.i32 <= DTL_CHAR_MAX))
          {
-            retval = (char)self->pAny->val.i32;
+            retval = (char)self->svx.val.i32;
             success = true;
          }
          break;
       case DTL_SV_U32:
-         if (self->pAny->val.u32 <= DTL_CHAR_MAX)
+         if (self->svx.val.u32 <= DTL_CHAR_MAX)
          {
-            retval = (char)self->pAny->val.u32;
+            retval = (char)self->svx.val.u32;
             success = true;
          }
          break;
       case DTL_SV_I64:
-         if ((self->pAny->val.i64 >= DTL_CHAR_MIN) && (self->pAny->val.i64 <= DTL_CHAR_MAX))
+         if ((self->svx.val.i64 >= DTL_CHAR_MIN) && (self->svx.val.i64 <= DTL_CHAR_MAX))
          {
-            retval = (char)self->pAny->val.i64;
+            retval = (char)self->svx.val.i64;
             success = true;
          }
          break;
       case DTL_SV_U64:
-         if (self->pAny->val.u64 <= DTL_CHAR_MAX)
+         if (self->svx.val.u64 <= DTL_CHAR_MAX)
          {
-            retval = (char)self->pAny->val.u64;
+            retval = (char)self->svx.val.u64;
             success = true;
          }
          break;
       case DTL_SV_CHAR:
-         retval = self->pAny->val.cr;
+         retval = self->svx.val.cr;
          success = true;
          break;
       case DTL_SV_FLT:
-         if ((self->pAny->val.flt >= -128.0) && (self->pAny->val.i64 <= 127.0))
+         if ((self->svx.val.flt >= -128.0) && (self->svx.val.flt <= 127.0))
          {
-            retval = (char)self->pAny->val.flt;
+            retval = (char)self->svx.val.flt;
             success = true;
          }
          break;
       case DTL_SV_DBL:
-         if ((self->pAny->val.dbl >= -128.0) && (self->pAny->val.dbl <= 127.0))
+         if ((self->svx.val.dbl >= -128.0) && (self->svx.val.dbl <= 127.0))
          {
-            retval = (char)self->pAny->val.dbl;
+            retval = (char)self->svx.val.dbl;
             success = true;
          }
          break;
       case DTL_SV_BOOL:
-         retval = self->pAny->val.bl? 1 : 0;
+         retval = self->svx.val.bl? 1 : 0;
          break;
 
       case DTL_SV_STR:
@@ -979,34 +1351,34 @@ bool dtl_sv_to_bool(const dtl_sv_t* self, bool* ok) {
          if (ok != NULL) *ok = false;
          break;
       case DTL_SV_I32:
-         retval = (bool)self->pAny->val.i32;
+         retval = (bool)self->svx.val.i32;
          break;
       case DTL_SV_U32:
-         retval = (bool)self->pAny->val.u32;
+         retval = (bool)self->svx.val.u32;
          break;
       case DTL_SV_I64:
-         retval = (bool)self->pAny->val.i64;
+         retval = (bool)self->svx.val.i64;
          break;
       case DTL_SV_U64:
-         retval = (bool)self->pAny->val.u64;
+         retval = (bool)self->svx.val.u64;
          break;
       case DTL_SV_FLT:
-         retval = (bool)self->pAny->val.flt;
+         retval = (bool)self->svx.val.flt;
          break;
       case DTL_SV_DBL:
-         retval = (bool)self->pAny->val.dbl;
+         retval = (bool)self->svx.val.dbl;
          break;
       case DTL_SV_CHAR:
-         retval = self->pAny->val.cr == 0? false : true;
+         retval = self->svx.val.cr == 0? false : true;
          break;
       case DTL_SV_BOOL:
-         retval = self->pAny->val.bl;
+         retval = self->svx.val.bl;
          break;
       case DTL_SV_STR:
-         if (adt_str_equal_cstr(self->pAny->val.str, "true") || adt_str_equal_cstr(self->pAny->val.str, "TRUE")) {
+         if (dtl_sv_str_equal_cstr(self, "true") || dtl_sv_str_equal_cstr(self, "TRUE")) {
             retval = true;
          }
-         else if (!adt_str_equal_cstr(self->pAny->val.str, "false") && !adt_str_equal_cstr(self->pAny->val.str, "FALSE")) {
+         else if (!dtl_sv_str_equal_cstr(self, "false") && !dtl_sv_str_equal_cstr(self, "FALSE")) {
             if (ok != NULL) *ok = false;
          }
          break;
@@ -1035,15 +1407,15 @@ void* dtl_sv_to_ptr(const dtl_sv_t *self){
          break;
       case DTL_SV_I32:
 #ifdef _WIN64
-         return IntToPtr(self->pAny->val.i32);
+         return IntToPtr(self->svx.val.i32);
 #else
-         return (void*) ((long) self->pAny->val.i32);
+         return (void*) ((long) self->svx.val.i32);
 #endif
       case DTL_SV_U32:
 #ifdef _WIN64
-         return UIntToPtr(self->pAny->val.u32);
+         return UIntToPtr(self->svx.val.u32);
 #else
-         return (void*) ((unsigned long) self->pAny->val.u32);
+         return (void*) ((unsigned long) self->svx.val.u32);
 #endif
       case DTL_SV_I64:
          break;
@@ -1058,13 +1430,17 @@ void* dtl_sv_to_ptr(const dtl_sv_t *self){
       case DTL_SV_BOOL:
          break;
       case DTL_SV_STR:
-         return (void*) &self->pAny->val.str;
+         if ( (self->u32Flags & (DTL_DV_FLAG_SSO | DTL_DV_FLAG_ATOM)) != 0u)
+         {
+            break; //inline and interned strings have no adt_str_t
+         }
+         return (void*) &self->svx.val.str;
          break;
       case DTL_SV_PTR:
-         return self->pAny->val.ptr.p;
+         return self->svx.val.ptr.p;
          break;
       case DTL_SV_DV:
-         return (void*) self->pAny->val.dv;
+         return (void*) self->svx.val.dv;
          break;
       case DTL_SV_BYTES:
          break;
@@ -1075,6 +1451,13 @@ void* dtl_sv_to_ptr(const dtl_sv_t *self){
    return (void*)0;
 }
 
+/**
+ * The returned string stays valid until the scalar is modified or deleted.
+ * The exception is numbers whose text needs DTL_SV_CACHE_TEXT_SIZE characters or more (long doubles) and numbers
+ * with atomic or biased reference counting. Those are formatted into a thread-local buffer that is reused after
+ * DTL_SV_CSTR_RING_SIZE further calls in the same thread.
+ * Use dtl_sv_format when the text must be kept.
+ */
 const char* dtl_sv_to_cstr(dtl_sv_t *self, bool* ok){
    if(self != NULL)
    {
@@ -1089,26 +1472,40 @@ const char* dtl_sv_to_cstr(dtl_sv_t *self, bool* ok){
       case DTL_SV_FLT:
       case DTL_SV_DBL:
       case DTL_SV_CHAR:
-         if (self->pAny->tmpStr == NULL)
-         {
-            self->pAny->tmpStr = adt_str_new();
-         }
-         else
+         if (ok != NULL) *ok = true;
+         if ( (self->u32Flags & DTL_DV_FLAG_IMMORTAL) != 0u)
          {
-            adt_str_clear(self->pAny->tmpStr);
+            return m_dtl_sv_small_int_text[self->svx.val.u32];
          }
-         if (self->pAny->tmpStr != 0)
+         if (dtl_sv_cache_kind(self) != DTL_SV_CACHE_TEXT)
          {
-            dtl_sv_to_string_internal(self, self->pAny->tmpStr, ok);
-            return adt_str_cstr(self->pAny->tmpStr);
+            char numBuf[DTL_SV_NUM_BUF_SIZE];
+            int32_t len = dtl_sv_format(self, numBuf, sizeof(numBuf));
+            if ( (len >= DTL_SV_CACHE_TEXT_SIZE) || !DTL_SV_CAN_CACHE(self) )
+            {
+               char *buf = m_dtl_sv_cstr_ring[m_dtl_sv_cstr_next];
+               m_dtl_sv_cstr_next = (m_dtl_sv_cstr_next + 1u) % DTL_SV_CSTR_RING_SIZE;
+               memcpy(buf, numBuf, (size_t) len + 1u);
+               return buf;
+            }
+            memcpy(self->svx.cache.text, numBuf, (size_t) len + 1u);
+            dtl_sv_set_cache_kind(self, DTL_SV_CACHE_TEXT);
          }
-         break;
+         return self->svx.cache.text;
       case DTL_SV_BOOL:
          if (ok != NULL) *ok = true;
-         return self->pAny->val.bl? "true" : "false";
+         return self->svx.val.bl? "true" : "false";
       case DTL_SV_STR:
          if (ok != NULL) *ok = true;
-         return adt_str_cstr(self->pAny->val.str);
+         if ( (self->u32Flags & DTL_DV_FLAG_SSO) != 0u)
+         {
+            return self->svx.val.sso;
+         }
+         if ( (self->u32Flags & DTL_DV_FLAG_ATOM) != 0u)
+         {
+            return dtl_atom_cstr(self->svx.val.atom);
+         }
+         return adt_str_cstr(self->svx.val.str);
       case DTL_SV_PTR:
          break;
       case DTL_SV_DV:
@@ -1142,7 +1539,7 @@ dtl_dv_t *dtl_sv_to_dv(const dtl_sv_t *self)
    {
       if(dtl_sv_type(self) == DTL_SV_DV)
       {
-         return self->pAny->val.dv;
+         return self->svx.val.dv;
       }
    }
    return (dtl_dv_t*) 0;
@@ -1154,7 +1551,7 @@ dtl_sv_t *dtl_sv_to_sv(const dtl_sv_t *self)
    {
       if(dtl_sv_type(self) == DTL_SV_DV)
       {
-         dtl_dv_t *dv = self->pAny->val.dv;
+         dtl_dv_t *dv = self->svx.val.dv;
          if (dtl_dv_type(dv) == DTL_DV_SCALAR )
          {
             return (dtl_sv_t*) dv;
@@ -1171,7 +1568,7 @@ struct dtl_av_tag *dtl_sv_to_av(const dtl_sv_t *self)
    {
       if(dtl_sv_type(self) == DTL_SV_DV)
       {
-         dtl_dv_t *dv = self->pAny->val.dv;
+         dtl_dv_t *dv = self->svx.val.dv;
          if (dtl_dv_type(dv) == DTL_DV_ARRAY )
          {
             return (dtl_av_t*) dv;
@@ -1187,7 +1584,7 @@ struct dtl_hv_tag *dtl_sv_to_hv(const dtl_sv_t *self)
    {
       if(dtl_sv_type(self) == DTL_SV_DV)
       {
-         dtl_dv_t *dv = self->pAny->val.dv;
+         dtl_dv_t *dv = self->svx.val.dv;
          if (dtl_dv_type(dv) == DTL_DV_HASH )
          {
             return (dtl_hv_t*) dv;
@@ -1197,6 +1594,94 @@ struct dtl_hv_tag *dtl_sv_to_hv(const dtl_sv_t *self)
    return (dtl_hv_t*) 0;
 }
 
+//Formatting functions
+
+/**
+ * Writes the text representation of the scalar (the same text as dtl_sv_to_str) to buf.
+ * Works like snprintf: the output is truncated to cap-1 bytes and always null-terminated when cap > 0.
+ * Returns the length of the full text (excluding the null-terminator) or -1 if the scalar type has no text representation.
+ * Numbers always fit in a buffer of DTL_SV_NUM_BUF_SIZE bytes.
+ */
+int32_t dtl_sv_format(const dtl_sv_t *self, char *buf, size_t cap)
+{
+   if (self == 0)
+   {
+      return -1;
+   }
+   switch(dtl_sv_type(self))
+   {
+   case DTL_SV_NONE:
+      return dtl_sv_format_text("(undefined)", 11u, buf, cap);
+   case DTL_SV_I32:
+      return dtl_sv_format_i64((int64_t) self->svx.val.i32, buf, cap);
+   case DTL_SV_CHAR:
+      return dtl_sv_format_i64((int64_t) self->svx.val.cr, buf, cap);
+   case DTL_SV_U32:
+      return dtl_sv_format_u64((uint64_t) self->svx.val.u32, buf, cap);
+   case DTL_SV_I64:
+      return dtl_sv_format_i64(self->svx.val.i64, buf, cap);
+   case DTL_SV_U64:
+      return dtl_sv_format_u64(self->svx.val.u64, buf, cap);
+   case DTL_SV_FLT:
+      return dtl_sv_format_flt(self->svx.val.flt, buf, cap);
+   case DTL_SV_DBL:
+      return dtl_sv_format_dbl(self->svx.val.dbl, buf, cap);
+   case DTL_SV_BOOL:
+      return self->svx.val.bl? dtl_sv_format_text("true", 4u, buf, cap) : dtl_sv_format_text("false", 5u, buf, cap);
+   case DTL_SV_STR:
+      {
+         uint32_t u32Len;
+         const char *pData = dtl_sv_str_data(self, &u32Len);
+         return dtl_sv_format_text(pData, (size_t) u32Len, buf, cap);
+      }
+   case DTL_SV_PTR:
+      {
+         char numBuf[DTL_SV_NUM_BUF_SIZE];
+         int len = snprintf(numBuf, sizeof(numBuf), "%p", self->svx.val.ptr.p);
+         return dtl_sv_format_text(numBuf, (size_t) len, buf, cap);
+      }
+   default:
+      break;
+   }
+   return -1;
+}
+
+int32_t dtl_sv_format_i64(int64_t value, char *buf, size_t cap)
+{
+   char numBuf[DTL_NUMFMT_BUF_SIZE];
+   int32_t len = dtl_numfmt_i64(value, numBuf);
+   return dtl_sv_format_text(numBuf, (size_t) len, buf, cap);
+}
+
+int32_t dtl_sv_format_u64(uint64_t value, char *buf, size_t cap)
+{
+   char numBuf[DTL_NUMFMT_BUF_SIZE];
+   int32_t len = dtl_numfmt_u64(value, numBuf);
+   return dtl_sv_format_text(numBuf, (size_t) len, buf, cap);
+}
+
+/**
+ * Writes the shortest text that parses back (strtod) to exactly the same double.
+ * Numbers from 1e-6 up to 1e21 use fixed notation ("0.1", "1.5", "100"), others use an exponent ("1e+21", "2.5e-7").
+ * Infinity and NaN are written as "inf", "-inf" and "nan".
+ */
+int32_t dtl_sv_format_dbl(double value, char *buf, size_t cap)
+{
+   char numBuf[DTL_NUMFMT_BUF_SIZE];
+   int32_t len = dtl_numfmt_dbl(value, numBuf);
+   return dtl_sv_format_text(numBuf, (size_t) len, buf, cap);
+}
+
+/**
+ * Same as dtl_sv_format_dbl but with the precision of a float (0.1f is written as "0.1").
+ */
+int32_t dtl_sv_format_flt(float value, char *buf, size_t cap)
+{
+   char numBuf[DTL_NUMFMT_BUF_SIZE];
+   int32_t len = dtl_numfmt_flt(value, numBuf);
+   return dtl_sv_format_text(numBuf, (size_t) len, buf, cap);
+}
+
 //Comparison functions
 
 /*
@@ -1220,61 +1705,62 @@ dtl_error_t dtl_sv_lt(const dtl_sv_t *self, const dtl_sv_t *other, bool *result)
       case DTL_SV_I32:
          if (rightType == DTL_SV_I32)
          {
-            *result = self->pAny->val.i32 < other->pAny->val.i32;
+            *result = self->svx.val.i32 < other->svx.val.i32;
             retval = DTL_NO_ERROR;
          }
          break;
       case DTL_SV_U32:
          if (rightType == DTL_SV_U32)
          {
-            *result = self->pAny->val.u32 < other->pAny->val.u32;
+            *result = self->svx.val.u32 < other->svx.val.u32;
             retval = DTL_NO_ERROR;
          }
          break;
       case DTL_SV_I64:
          if (rightType == DTL_SV_I64)
          {
-            *result = self->pAny->val.i64 < other->pAny->val.i64;
+            *result = self->svx.val.i64 < other->svx.val.i64;
             retval = DTL_NO_ERROR;
          }
          break;
       case DTL_SV_U64:
          if (rightType == DTL_SV_U64)
          {
-            *result = self->pAny->val.u64 < other->pAny->val.u64;
+            *result = self->svx.val.u64 < other->svx.val.u64;
             retval = DTL_NO_ERROR;
          }
          break;
       case DTL_SV_FLT:
          if (rightType == DTL_SV_FLT)
          {
-            *result = self->pAny->val.flt < other->pAny->val.flt;
+            *result = self->svx.val.flt < other->svx.val.flt;
             retval = DTL_NO_ERROR;
          }
          break;
       case DTL_SV_DBL:
          if (rightType == DTL_SV_DBL)
          {
-            *result = self->pAny->val.dbl < other->pAny->val.dbl;
+            *result = self->svx.val.dbl < other->svx.val.dbl;
             retval = DTL_NO_ERROR;
          }
          break;
       case DTL_SV_BOOL:
          if (rightType == DTL_SV_BOOL)
          {
-            *result = self->pAny->val.bl < other->pAny->val.bl;
+            *result = self->svx.val.bl < other->svx.val.bl;
             retval = DTL_NO_ERROR;
          }
          break;
       case DTL_SV_STR:
          if (rightType == DTL_SV_STR)
          {
-            int tmp = adt_str_lt(self->pAny->val.str, other->pAny->val.str);
-            if (tmp >= 0)
-            {
-               *result = (bool) tmp;
-               retval = DTL_NO_ERROR;
-            }
+            uint32_t leftLen, rightLen;
+            const char *left = dtl_sv_str_data(self, &leftLen);
+            const char *right = dtl_sv_str_data(other, &rightLen);
+            uint32_t minLen = (leftLen < rightLen)? leftLen : rightLen;
+            int tmp = (minLen > 0u)? memcmp(left, right, minLen) : 0;
+            *result = (tmp < 0) || ( (tmp == 0) && (leftLen < rightLen) );
+            retval = DTL_NO_ERROR;
          }
          break;
       case DTL_SV_PTR:
@@ -1289,6 +1775,122 @@ dtl_error_t dtl_sv_lt(const dtl_sv_t *self, const dtl_sv_t *other, bool *result)
    return DTL_INVALID_ARGUMENT_ERROR;
 }
 
+/**
+ * Three-way compare: *result is negative, zero or positive when self is less than, equal to or greater than other.
+ * Unlike dtl_sv_lt, numbers of any type compare with each other by their exact value, without rounding through
+ * double, so (i64) 2^53+1 is greater than (dbl) 2^53. -0.0 equals 0.0 and NaN equals NaN and is greater than all other
+ * numbers, so this is a total order. None, bool, char and string scalars compare within their own type (strings by
+ * bytes, a prefix first). Other combinations, such as a number and a string, give DTL_TYPE_ERROR.
+ */
+dtl_error_t dtl_sv_cmp(const dtl_sv_t *self, const dtl_sv_t *other, int32_t *result)
+{
+   dtl_sv_cmp_class_t leftClass;
+   if ( (self == 0) || (other == 0) || (result == 0) )
+   {
+      return DTL_INVALID_ARGUMENT_ERROR;
+   }
+   *result = 0;
+   leftClass = dtl_sv_cmp_class(dtl_sv_type(self));
+   if ( (leftClass != dtl_sv_cmp_class(dtl_sv_type(other))) || (leftClass == DTL_SV_CLASS_OTHER) )
+   {
+      return DTL_TYPE_ERROR;
+   }
+   switch (leftClass)
+   {
+   case DTL_SV_CLASS_BOOL:
+      *result = (int32_t) self->svx.val.bl - (int32_t) other->svx.val.bl;
+      break;
+   case DTL_SV_CLASS_NUM:
+   {
+      dtl_sv_num_t left, right;
+      dtl_sv_get_num(self, &left);
+      dtl_sv_get_num(other, &right);
+      *result = dtl_sv_cmp_num(&left, &right);
+      break;
+   }
+   case DTL_SV_CLASS_CHAR:
+      *result = (int32_t) (uint8_t) self->svx.val.cr - (int32_t) (uint8_t) other->svx.val.cr;
+      break;
+   case DTL_SV_CLASS_STR:
+   {
+      uint32_t leftLen, rightLen;
+      const char *left = dtl_sv_str_data(self, &leftLen);
+      const char *right = dtl_sv_str_data(other, &rightLen);
+      uint32_t minLen = (leftLen < rightLen)? leftLen : rightLen;
+      int tmp = (minLen > 0u)? memcmp(left, right, minLen) : 0;
+      *result = (tmp != 0)? ((tmp < 0)? -1 : 1) : (leftLen < rightLen)? -1 : (leftLen > rightLen)? 1 : 0;
+      break;
+   }
+   default:
+      break; //None equals None
+   }
+   return DTL_NO_ERROR;
+}
+
+/**
+ * Hash that agrees with dtl_sv_cmp: scalars that compare equal hash equal, so 1, 1u, 1.0f and (u64) 1 give the same
+ * value. Strings hash to dtl_key_hash of their bytes, the hash dtl_hv uses for its keys. Pointer, value and bytes
+ * scalars, which dtl_sv_cmp does not order, hash by identity.
+ */
+uint32_t dtl_sv_hash(const dtl_sv_t *self)
+{
+   uint32_t u32Len;
+   const uint8_t *pData;
+   dtl_sv_num_t num;
+   if (self == 0)
+   {
+      return 0u;
+   }
+   switch (dtl_sv_cmp_class(dtl_sv_type(self)))
+   {
+   case DTL_SV_CLASS_NONE:
+      return dtl_sv_hash_u64(UINT64_C(0x4E4F4E45)); //"NONE"
+   case DTL_SV_CLASS_BOOL:
+      return dtl_sv_hash_u64(UINT64_C(0x424F4F4C00) + (self->svx.val.bl? 1u : 0u)); //"BOOL"
+   case DTL_SV_CLASS_CHAR:
+      return dtl_sv_hash_u64(UINT64_C(0x4348415200) + (uint8_t) self->svx.val.cr); //"CHAR"
+   case DTL_SV_CLASS_STR:
+      pData = (const uint8_t*) dtl_sv_str_data(self, &u32Len);
+      return dtl_key_hash(pData, pData + u32Len);
+   case DTL_SV_CLASS_NUM:
+      dtl_sv_get_num(self, &num);
+      if (num.kind == DTL_SV_NUM_DBL)
+      {
+         double dbl = num.val.dbl;
+         if (dbl != dbl)
+         {
+            return dtl_sv_hash_u64(UINT64_C(0x7FF8000000000000));
+         }
+         //doubles holding an integer hash as that integer
+         if ( (dbl >= -DTL_SV_TWO_POW_63) && (dbl < DTL_SV_TWO_POW_63) && ((double) (int64_t) dbl == dbl) )
+         {
+            return dtl_sv_hash_u64((uint64_t) (int64_t) dbl);
+         }
+         if ( (dbl >= DTL_SV_TWO_POW_63) && (dbl < DTL_SV_TWO_POW_64) )
+         {
+            return dtl_sv_hash_u64((uint64_t) dbl); //always an integer this large
+         }
+         memcpy(&num.val.u64, &dbl, sizeof(dbl));
+      }
+      return dtl_sv_hash_u64(num.val.u64); //same bits for INT and UINT
+   default:
+      return dtl_sv_hash_u64((uint64_t) (uintptr_t) self);
+   }
+}
+
+/**
+ * Gives direct access to the bytes of a string scalar without converting or copying them. The bytes are valid until
+ * the scalar is changed or released.
+ */
+const char* dtl_sv_get_str_data(const dtl_sv_t* self, uint32_t *pu32Len)
+{
+   if ( (self != 0) && (pu32Len != 0) && (dtl_sv_type(self) == DTL_SV_STR) )
+   {
+      return dtl_sv_str_data(self, pu32Len);
+   }
+   return (const char*) 0;
+}
+
 const adt_bytes_t* dtl_sv_get_bytes(const dtl_sv_t* self)
 {
    const adt_bytes_t *retval = (const adt_bytes_t*) 0;
@@ -1297,12 +1899,21 @@ const adt_bytes_t* dtl_sv_get_bytes(const dtl_sv_t* self)
       dtl_sv_type_id currentType = dtl_sv_type(self);
       if (currentType == DTL_SV_BYTES)
       {
-         retval = self->pAny->val.bytes;
+         retval = self->svx.val.bytes;
       }
    }
    return retval;
 }
 
+dtl_atom_t* dtl_sv_get_atom(const dtl_sv_t* self)
+{
+   if ( (self != 0) && (dtl_sv_type(self) == DTL_SV_STR) && ((self->u32Flags & DTL_DV_FLAG_ATOM) != 0u) )
+   {
+      return self->svx.val.atom;
+   }
+   return (dtl_atom_t*) 0;
+}
+
 const adt_bytearray_t* dtl_sv_get_bytearray(const dtl_sv_t* self)
 {
    const adt_bytearray_t *retval = (const adt_bytearray_t*) 0;
@@ -1311,7 +1922,7 @@ const adt_bytearray_t* dtl_sv_get_bytearray(const dtl_sv_t* self)
       dtl_sv_type_id currentType = dtl_sv_type(self);
       if (currentType == DTL_SV_BYTEARRAY)
       {
-         retval = self->pAny->val.bytearray;
+         retval = self->svx.val.bytearray;
       }
    }
    return retval;
@@ -1325,28 +1936,33 @@ const adt_bytearray_t* dtl_sv_get_bytearray(const dtl_sv_t* self)
 static void dtl_sv_set_type(dtl_sv_t *self, dtl_sv_type_id newType)
 {
    dtl_sv_type_id currentType = dtl_sv_type(self);
+   dtl_sv_set_cache_kind(self, DTL_SV_CACHE_NONE);
    if(currentType == DTL_SV_DV)
    {
-      dtl_dv_dec_ref(self->pAny->val.dv);
+      dtl_dv_dec_ref(self->svx.val.dv);
    }
-   else if (currentType == DTL_SV_STR)
+   else if ( (currentType == DTL_SV_STR) && (newType != DTL_SV_STR) )
    {
-      if (newType != DTL_SV_STR)
+      if ( (self->u32Flags & DTL_DV_FLAG_ATOM) != 0u)
       {
-         adt_str_delete(self->pAny->val.str);
+         dtl_atom_release(self->svx.val.atom);
+      }
+      else if ( (self->u32Flags & DTL_DV_FLAG_SSO) == 0u)
+      {
+         adt_str_delete(self->svx.val.str);
       }
    }
    else if (currentType == DTL_SV_BYTES)
    {
-      adt_bytes_delete(self->pAny->val.bytes);
-      self->pAny->val.bytes = (adt_bytes_t*) 0;
+      adt_bytes_delete(self->svx.val.bytes);
+      self->svx.val.bytes = (adt_bytes_t*) 0;
    }
    else if (currentType == DTL_SV_BYTEARRAY)
    {
       if (newType != DTL_SV_BYTEARRAY)
       {
-         adt_bytearray_delete(self->pAny->val.bytearray);
-         self->pAny->val.bytearray = (adt_bytearray_t*) 0;
+         adt_bytearray_delete(self->svx.val.bytearray);
+         self->svx.val.bytearray = (adt_bytearray_t*) 0;
       }
    }
    else
@@ -1354,149 +1970,397 @@ static void dtl_sv_set_type(dtl_sv_t *self, dtl_sv_type_id newType)
 
    }
 
-   if (newType == DTL_SV_STR)
+   if(newType == DTL_SV_BYTEARRAY)
    {
-      if (currentType != DTL_SV_STR)
+      if (currentType != DTL_SV_BYTEARRAY)
       {
-         self->pAny->val.str = adt_str_new();
+         self->svx.val.bytearray = adt_bytearray_new(BYTEARRAY_DEFAULT_GROWSIZE);
       }
       else
       {
-         adt_str_clear(self->pAny->val.str);
+         adt_bytearray_clear(self->svx.val.bytearray);
       }
    }
-   else if(newType == DTL_SV_BYTEARRAY)
+
+   switch(newType)
    {
-      if (currentType != DTL_SV_BYTEARRAY)
-      {
-         self->pAny->val.bytearray = adt_bytearray_new(BYTEARRAY_DEFAULT_GROWSIZE);
-      }
-      else
-      {
-         adt_bytearray_clear(self->pAny->val.bytearray);
-      }
+   case DTL_SV_PTR:
+   case DTL_SV_DV:
+   case DTL_SV_BYTES:
+   case DTL_SV_BYTEARRAY:
+      dtl_sv_arena_track(self);
+      break;
+   default:
+      break;
    }
 
+   if (newType != DTL_SV_STR)
+   {
+      self->u32Flags &= ~((uint32_t)(DTL_DV_FLAG_SSO | DTL_DV_FLAG_ATOM));
+   }
    self->u32Flags &= ~((uint32_t)DTL_SV_TYPE_MASK);
    self->u32Flags |= (((uint32_t)newType)<<DTL_SV_TYPE_SHIFT) & DTL_SV_TYPE_MASK;
 }
 
-static void dtl_sv_ztrim(char *str)
+/**
+ * Strings of at most DTL_SV_SSO_CAPACITY bytes are stored inline, longer strings are stored in an adt_str_t.
+ * An existing adt_str_t is reused when the new string is also long.
+ */
+static void dtl_sv_set_str_internal(dtl_sv_t *self, const uint8_t *pData, uint32_t u32Len)
 {
-   char *begin = str;
-   char *end = begin+strlen(str);
-   char *p = begin;
-   char *a=0,*b=0;
-   while( p<end){
-      if(!isdigit(*p)){
-         if(*p == '.'){
-            a = p;
-            break;
-         }
-         else{
-            return; //not a number
-         }
+   adt_str_t *str = (adt_str_t*) 0;
+   dtl_atom_t *atom = (dtl_atom_t*) 0;
+   if (dtl_sv_type(self) == DTL_SV_STR)
+   {
+      if ( (self->u32Flags & DTL_DV_FLAG_ATOM) != 0u)
+      {
+         atom = self->svx.val.atom; //released after the copy since pData may point into the atom
+         self->u32Flags &= ~((uint32_t)DTL_DV_FLAG_ATOM);
+      }
+      else if ( (self->u32Flags & DTL_DV_FLAG_SSO) == 0u)
+      {
+         str = self->svx.val.str;
       }
-      ++p;
    }
-   p=end-1;
-   while(p>a){
-      if(*p == '0'){
-         b=p;
+   dtl_sv_set_type(self, DTL_SV_STR);
+   if (u32Len <= DTL_SV_SSO_CAPACITY)
+   {
+      char *sso = self->svx.val.sso;
+      if (u32Len > 0u)
+      {
+         memmove(sso, pData, u32Len);
       }
-      else{
-         break;
+      sso[u32Len] = '\0';
+      sso[DTL_SV_SSO_CAPACITY] = (char) (DTL_SV_SSO_CAPACITY - u32Len); //doubles as null terminator when the buffer is full
+      self->u32Flags |= DTL_DV_FLAG_SSO;
+      if (str != 0)
+      {
+         adt_str_delete(str);
       }
-      --p;
    }
-   if(a && b){
-      assert(b>a);
-      if(b-1==a){
-         --b; //nothing on the right side of the '.'
+   else
+   {
+      if (str == 0)
+      {
+         str = adt_str_new();
+         self->svx.val.str = str;
+         self->u32Flags &= ~((uint32_t)DTL_DV_FLAG_SSO);
+         dtl_sv_arena_track(self);
+      }
+      if (str != 0)
+      {
+         adt_str_set_bstr(str, pData, pData + u32Len);
       }
-      *b=0;
    }
-   if(strlen(str)==0){
-      //empty string, replace with 0
-      strcpy(str,"0");
+   if (atom != 0)
+   {
+      dtl_atom_release(atom);
+   }
+}
+
+/**
+ * Returns the bytes of a DTL_SV_STR scalar. The data is only guaranteed to be null terminated for inline and interned strings.
+ */
+static const char *dtl_sv_str_data(const dtl_sv_t *self, uint32_t *pLen)
+{
+   if ( (self->u32Flags & DTL_DV_FLAG_SSO) != 0u)
+   {
+      *pLen = DTL_SV_SSO_CAPACITY - (uint32_t) (uint8_t) self->svx.val.sso[DTL_SV_SSO_CAPACITY];
+      return self->svx.val.sso;
+   }
+   if ( (self->u32Flags & DTL_DV_FLAG_ATOM) != 0u)
+   {
+      *pLen = dtl_atom_length(self->svx.val.atom);
+      return dtl_atom_cstr(self->svx.val.atom);
+   }
+   *pLen = (uint32_t) adt_str_length(self->svx.val.str);
+   return (const char*) self->svx.val.str->pStr;
+}
+
+static bool dtl_sv_str_equal_cstr(const dtl_sv_t *self, const char *cstr)
+{
+   uint32_t u32Len;
+   const char *pData = dtl_sv_str_data(self, &u32Len);
+   return (u32Len == (uint32_t) strlen(cstr)) && ( (u32Len == 0u) || (memcmp(pData, cstr, u32Len) == 0) );
+}
+
+/**
+ * Arena scalars that start owning heap data must be destroyed when their arena is reset.
+ */
+static void dtl_sv_arena_track(dtl_sv_t *self)
+{
+   if ( (self->u32Flags & (DTL_DV_FLAG_ARENA | DTL_DV_FLAG_FINALIZE)) == DTL_DV_FLAG_ARENA )
+   {
+      dtl_arena_add_finalizer(dtl_dv_arena((dtl_dv_t*) self), (dtl_dv_t*) self);
    }
 }
 
 static void dtl_sv_to_string_internal(const dtl_sv_t* self, adt_str_t* str, bool* ok)
 {
-   char numBuf[MAX_NUM_BUF];
-   bool isNum = false;
-   switch(dtl_sv_type(self))
+   if (dtl_sv_type(self) == DTL_SV_STR)
    {
-   case DTL_SV_NONE:
+      uint32_t u32Len;
+      const uint8_t *pData = (const uint8_t*) dtl_sv_str_data(self, &u32Len);
       if (ok != NULL) *ok = true;
-      adt_str_append_cstr(str,"(undefined)");
+      adt_str_set_bstr(str, pData, pData + u32Len);
+   }
+   else
+   {
+      char numBuf[DTL_SV_NUM_BUF_SIZE];
+      if (dtl_sv_format(self, numBuf, sizeof(numBuf)) >= 0)
+      {
+         if (ok != NULL) *ok = true;
+         adt_str_set_cstr(str, numBuf);
+      }
+   }
+}
+
+/**
+ * Copies len bytes of text into buf with snprintf semantics.
+ */
+static int32_t dtl_sv_format_text(const char *text, size_t len, char *buf, size_t cap)
+{
+   if ( (buf != 0) && (cap > 0u) )
+   {
+      size_t copyLen = (len < cap)? len : cap - 1u;
+      if (copyLen > 0u)
+      {
+         memcpy(buf, text, copyLen);
+      }
+      buf[copyLen] = '\0';
+   }
+   return (int32_t) len;
+}
+
+/**
+ * Converts a string scalar to a temporary numeric scalar (num). The parse result, including failure,
+ * is cached in self so that later numeric reads skip the parser. Values that may be shared between threads
+ * (immortal and atomic values) are never written to.
+ */
+static bool dtl_sv_str_to_num(const dtl_sv_t *self, dtl_sv_t *num)
+{
+   uint32_t kind = dtl_sv_cache_kind(self);
+   dtl_sv_cache_t cache;
+   if (kind == DTL_SV_CACHE_NONE)
+   {
+      uint32_t u32Len;
+      const char *pData = dtl_sv_str_data(self, &u32Len);
+      dtl_numfmt_value_t value;
+      switch (dtl_numfmt_parse(pData, u32Len, &value))
+      {
+      case DTL_NUMFMT_I64:
+         kind = DTL_SV_CACHE_I64;
+         cache.i64 = value.i64;
+         break;
+      case DTL_NUMFMT_U64:
+         kind = DTL_SV_CACHE_U64;
+         cache.u64 = value.u64;
+         break;
+      case DTL_NUMFMT_DBL:
+         kind = DTL_SV_CACHE_DBL;
+         cache.dbl = value.dbl;
+         break;
+      default:
+         kind = DTL_SV_CACHE_NAN;
+         cache.u64 = 0u;
+         break;
+      }
+      if (DTL_SV_CAN_CACHE(self))
+      {
+         dtl_sv_t *mutableSelf = (dtl_sv_t*) self; //the cache is not part of the observable value
+         mutableSelf->svx.cache = cache;
+         dtl_sv_set_cache_kind(mutableSelf, kind);
+      }
+   }
+   else
+   {
+      cache = self->svx.cache;
+   }
+   dtl_sv_create(num);
+   switch (kind)
+   {
+   case DTL_SV_CACHE_I64:
+      dtl_sv_set_i64(num, cache.i64);
+      return true;
+   case DTL_SV_CACHE_U64:
+      dtl_sv_set_u64(num, cache.u64);
+      return true;
+   case DTL_SV_CACHE_DBL:
+      dtl_sv_set_dbl(num, cache.dbl);
+      return true;
+   default:
       break;
+   }
+   return false;
+}
+
+static dtl_sv_cmp_class_t dtl_sv_cmp_class(dtl_sv_type_id type)
+{
+   switch (type)
+   {
+   case DTL_SV_NONE:
+      return DTL_SV_CLASS_NONE;
+   case DTL_SV_BOOL:
+      return DTL_SV_CLASS_BOOL;
    case DTL_SV_I32:
+   case DTL_SV_U32:
+   case DTL_SV_I64:
+   case DTL_SV_U64:
+   case DTL_SV_FLT:
+   case DTL_SV_DBL:
+      return DTL_SV_CLASS_NUM;
    case DTL_SV_CHAR:
-      if (ok != NULL) *ok = true;
-      sprintf(numBuf,"%d", (int) dtl_sv_to_i32(self, NULL));
-      isNum = true;
+      return DTL_SV_CLASS_CHAR;
+   case DTL_SV_STR:
+      return DTL_SV_CLASS_STR;
+   default:
+      return DTL_SV_CLASS_OTHER;
+   }
+}
+
+//self must be in DTL_SV_CLASS_NUM
+static void dtl_sv_get_num(const dtl_sv_t *self, dtl_sv_num_t *num)
+{
+   num->kind = DTL_SV_NUM_INT;
+   switch (dtl_sv_type(self))
+   {
+   case DTL_SV_I32:
+      num->val.i64 = self->svx.val.i32;
       break;
    case DTL_SV_U32:
-      if (ok != NULL) *ok = true;
-      sprintf(numBuf,"%u", (unsigned int) dtl_sv_to_u32(self, NULL));
-      isNum = true;
+      num->val.i64 = self->svx.val.u32;
       break;
    case DTL_SV_I64:
-      if (ok != NULL) *ok = true;
-      sprintf(numBuf,"%lld", (long long int) dtl_sv_to_i64(self, NULL));
-      isNum = true;
+      num->val.i64 = self->svx.val.i64;
       break;
    case DTL_SV_U64:
-      if (ok != NULL) *ok = true;
-      sprintf(numBuf,"%llu", (long long unsigned int) dtl_sv_to_u64(self, NULL));
-      isNum = true;
-      break;
-   case DTL_SV_FLT:
-      if (ok != NULL) *ok = true;
-      sprintf(numBuf,"%f", (double) dtl_sv_to_flt(self, NULL));
-      isNum = true;
-      dtl_sv_ztrim(numBuf);
-      break;
-   case DTL_SV_DBL:
-      if (ok != NULL) *ok = true;
-      sprintf(numBuf,"%f", dtl_sv_to_dbl(self, NULL));
-      isNum = true;
-      dtl_sv_ztrim(numBuf);
-      break;
-   case DTL_SV_BOOL:
-      if (ok != NULL) *ok = true;
-      if(dtl_sv_to_bool(self, NULL))
+      if (self->svx.val.u64 > (uint64_t) INT64_MAX)
       {
-         adt_str_set_cstr(str, "true");
+         num->kind = DTL_SV_NUM_UINT;
+         num->val.u64 = self->svx.val.u64;
       }
       else
       {
-         adt_str_set_cstr(str, "false");
+         num->val.i64 = (int64_t) self->svx.val.u64;
       }
       break;
-   case DTL_SV_STR:
-      if (ok != NULL) *ok = true;
-      adt_str_set(str, self->pAny->val.str);
-      break;
-   case DTL_SV_PTR:
-      if (ok != NULL) *ok = true;
-      sprintf(numBuf,"%p", dtl_sv_to_ptr(self));
-      isNum = true;
-      break;
-   case DTL_SV_DV:
-      //No conversion available
-      break;
-   case DTL_SV_BYTES:
-      //No conversion available
+   case DTL_SV_FLT:
+      num->kind = DTL_SV_NUM_DBL;
+      num->val.dbl = self->svx.val.flt; //exact
       break;
-   case DTL_SV_BYTEARRAY:
-      //No conversion available
+   default:
+      num->kind = DTL_SV_NUM_DBL;
+      num->val.dbl = self->svx.val.dbl;
       break;
    }
-   if(isNum)
+}
+
+static int32_t dtl_sv_cmp_num(const dtl_sv_num_t *left, const dtl_sv_num_t *right)
+{
+   if ( (left->kind == DTL_SV_NUM_DBL) && (left->val.dbl != left->val.dbl) )
+   {
+      return ( (right->kind == DTL_SV_NUM_DBL) && (right->val.dbl != right->val.dbl) )? 0 : 1;
+   }
+   if ( (right->kind == DTL_SV_NUM_DBL) && (right->val.dbl != right->val.dbl) )
+   {
+      return -1;
+   }
+   switch (left->kind)
+   {
+   case DTL_SV_NUM_INT:
+      switch (right->kind)
+      {
+      case DTL_SV_NUM_INT:
+         return (left->val.i64 > right->val.i64) - (left->val.i64 < right->val.i64);
+      case DTL_SV_NUM_UINT:
+         return -1;
+      default:
+         return dtl_sv_cmp_i64_dbl(left->val.i64, right->val.dbl);
+      }
+   case DTL_SV_NUM_UINT:
+      switch (right->kind)
+      {
+      case DTL_SV_NUM_INT:
+         return 1;
+      case DTL_SV_NUM_UINT:
+         return (left->val.u64 > right->val.u64) - (left->val.u64 < right->val.u64);
+      default:
+         return dtl_sv_cmp_u64_dbl(left->val.u64, right->val.dbl);
+      }
+   default:
+      switch (right->kind)
+      {
+      case DTL_SV_NUM_INT:
+         return -dtl_sv_cmp_i64_dbl(right->val.i64, left->val.dbl);
+      case DTL_SV_NUM_UINT:
+         return -dtl_sv_cmp_u64_dbl(right->val.u64, left->val.dbl);
+      default:
+         return (left->val.dbl > right->val.dbl) - (left->val.dbl < right->val.dbl);
+      }
+   }
+}
+
+/**
+ * Exact comparison of an integer with a double that is not NaN. The whole part of the double is compared as an
+ * integer, then the fraction (computed exactly) breaks the tie.
+ */
+static int32_t dtl_sv_cmp_i64_dbl(int64_t i64, double dbl)
+{
+   int64_t whole;
+   double fraction;
+   if (dbl < -DTL_SV_TWO_POW_63)
+   {
+      return 1;
+   }
+   if (dbl >= DTL_SV_TWO_POW_63)
+   {
+      return -1;
+   }
+   whole = (int64_t) dbl;
+   if (i64 != whole)
    {
-      adt_str_set_cstr(str, numBuf);
+      return (i64 < whole)? -1 : 1;
    }
+   fraction = dbl - (double) whole;
+   return (fraction > 0.0)? -1 : (fraction < 0.0)? 1 : 0;
+}
+
+static int32_t dtl_sv_cmp_u64_dbl(uint64_t u64, double dbl)
+{
+   uint64_t whole;
+   if (dbl < 0.0)
+   {
+      return 1;
+   }
+   if (dbl >= DTL_SV_TWO_POW_64)
+   {
+      return -1;
+   }
+   whole = (uint64_t) dbl;
+   if (u64 != whole)
+   {
+      return (u64 < whole)? -1 : 1;
+   }
+   return (dbl > (double) whole)? -1 : 0;
+}
+
+//64-bit finalizer of splitmix64, folded to 32 bits
+static uint32_t dtl_sv_hash_u64(uint64_t u64)
+{
+   u64 ^= u64 >> 30;
+   u64 *= UINT64_C(0xBF58476D1CE4E5B9);
+   u64 ^= u64 >> 27;
+   u64 *= UINT64_C(0x94D049BB133111EB);
+   u64 ^= u64 >> 31;
+   return (uint32_t) (u64 ^ (u64 >> 32));
+}
+
+static uint32_t dtl_sv_cache_kind(const dtl_sv_t *self)
+{
+   return (self->u32Flags & DTL_DV_CACHE_MASK) >> DTL_DV_CACHE_SHIFT;
+}
+
+static void dtl_sv_set_cache_kind(dtl_sv_t *self, uint32_t kind)
+{
+   self->u32Flags = (self->u32Flags & ~((uint32_t)DTL_DV_CACHE_MASK)) | ((kind << DTL_DV_CACHE_SHIFT) & DTL_DV_CACHE_MASK);
 }
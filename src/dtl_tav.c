@@ -0,0 +1,643 @@
+/*****************************************************************************
+* \file      dtl_tav.c
+* \author    Conny Gustafsson
+* \date      2026-10-17
+* \brief     Typed array value (packed vector of numbers of one element type)
+*
+* Copyright (c) 2026 Conny Gustafsson
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+#include "dtl_tav.h"
+#include "dtl_sv.h"
+#include "dtl_pool.h"
+#include "dtl_refcnt.h"
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define MIN_CAPACITY 8u
+#define MAX_LENGTH   ((uint32_t) INT32_MAX) //indices are int32_t
+#define TWO_POW_63   9223372036854775808.0
+#define TWO_POW_64   18446744073709551616.0
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static bool dtl_tav_index(const dtl_tav_t *self, int32_t s32Index, uint32_t *pu32Index);
+static dtl_error_t dtl_tav_grow(dtl_tav_t *self, uint32_t u32MinCapacity);
+static bool dtl_tav_store_i64(dtl_tav_data_t *data, uint32_t u32Index, int64_t value);
+static bool dtl_tav_store_u64(dtl_tav_data_t *data, uint32_t u32Index, uint64_t value);
+static bool dtl_tav_store_dbl(dtl_tav_data_t *data, uint32_t u32Index, double value);
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+static const uint8_t m_elemSize[DTL_TAV_NUM_ELEM_TYPES] = {1u, 2u, 4u, 8u, 1u, 2u, 4u, 8u, 4u, 8u};
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+dtl_tav_t *dtl_tav_new(dtl_tav_elem_t elemType)
+{
+   dtl_tav_t *self;
+   if ( (uint32_t) elemType >= (uint32_t) DTL_TAV_NUM_ELEM_TYPES )
+   {
+      return (dtl_tav_t*) 0;
+   }
+   self = (dtl_tav_t*) dtl_pool_alloc(DTL_POOL_TAV);
+   if (self != 0)
+   {
+      self->pAny = &self->data;
+      self->data.pElems = (void*) 0;
+      self->data.u32Length = 0u;
+      self->data.u32Capacity = 0u;
+      self->data.u8ElemType = (uint8_t) elemType;
+      self->data.u8ElemSize = m_elemSize[elemType];
+      self->u32Flags = (uint32_t) DTL_DV_TYPED_ARRAY;
+      dtl_refcnt_init((dtl_dv_t*) self);
+   }
+   return self;
+}
+
+void dtl_tav_delete(dtl_tav_t *self)
+{
+   if (self != 0)
+   {
+      free(self->data.pElems);
+      dtl_pool_free(DTL_POOL_TAV, self);
+   }
+}
+
+/**
+ * New typed array holding a copy of u32Count elements of elemType, given in native byte order.
+ */
+dtl_tav_t *dtl_tav_make(dtl_tav_elem_t elemType, const void *pElems, uint32_t u32Count)
+{
+   dtl_tav_t *self = dtl_tav_new(elemType);
+   if ( (self != 0) && (dtl_tav_append(self, pElems, u32Count) != DTL_NO_ERROR) )
+   {
+      dtl_tav_delete(self);
+      self = (dtl_tav_t*) 0;
+   }
+   return self;
+}
+
+/**
+ * Packs the numeric scalars of av into a new typed array. Integer scalars must fit elemType exactly, as with the
+ * dtl_tav_push functions. Returns NULL when av holds anything else (including strings that hold numbers).
+ */
+dtl_tav_t *dtl_tav_make_from_av(const dtl_av_t *av, dtl_tav_elem_t elemType)
+{
+   dtl_tav_t *self;
+   int32_t s32Len;
+   int32_t s32i;
+   if (av == 0)
+   {
+      return (dtl_tav_t*) 0;
+   }
+   s32Len = dtl_av_length(av);
+   self = dtl_tav_new(elemType);
+   if ( (self == 0) || (dtl_tav_reserve(self, s32Len) != DTL_NO_ERROR) )
+   {
+      dtl_tav_delete(self);
+      return (dtl_tav_t*) 0;
+   }
+   for (s32i = 0; s32i < s32Len; s32i++)
+   {
+      const dtl_sv_t *sv = (const dtl_sv_t*) dtl_av_value(av, s32i);
+      dtl_error_t errorCode = DTL_TYPE_ERROR;
+      if (dtl_dv_type((const dtl_dv_t*) sv) == DTL_DV_SCALAR)
+      {
+         switch (dtl_sv_type(sv))
+         {
+         case DTL_SV_I32:
+         case DTL_SV_I64:
+            errorCode = dtl_tav_push_i64(self, dtl_sv_to_i64(sv, NULL));
+            break;
+         case DTL_SV_U32:
+         case DTL_SV_U64:
+            errorCode = dtl_tav_push_u64(self, dtl_sv_to_u64(sv, NULL));
+            break;
+         case DTL_SV_FLT:
+         case DTL_SV_DBL:
+            errorCode = dtl_tav_push_dbl(self, dtl_sv_to_dbl(sv, NULL));
+            break;
+         default:
+            break;
+         }
+      }
+      if (errorCode != DTL_NO_ERROR)
+      {
+         dtl_tav_delete(self);
+         return (dtl_tav_t*) 0;
+      }
+   }
+   return self;
+}
+
+/**
+ * Boxes every element into a scalar of the matching type (I32 for I8 to I32, U32 for U8 to U32, FLT for F32 and so on).
+ * The caller owns the returned array. Returns NULL when out of memory.
+ */
+dtl_av_t *dtl_tav_to_av(const dtl_tav_t *self)
+{
+   dtl_av_t *av;
+   uint32_t i;
+   if (self == 0)
+   {
+      return (dtl_av_t*) 0;
+   }
+   av = dtl_av_new();
+   if ( (av == 0) || (dtl_av_reserve(av, (int32_t) self->data.u32Length) != DTL_NO_ERROR) )
+   {
+      if (av != 0)
+      {
+         dtl_av_delete(av);
+      }
+      return (dtl_av_t*) 0;
+   }
+   for (i = 0u; i < self->data.u32Length; i++)
+   {
+      const void *pElem = ((const uint8_t*) self->data.pElems) + ((size_t) i * self->data.u8ElemSize);
+      dtl_sv_t *sv;
+      switch ((dtl_tav_elem_t) self->data.u8ElemType)
+      {
+      case DTL_TAV_I8:  sv = dtl_sv_make_i32(*(const int8_t*) pElem); break;
+      case DTL_TAV_I16: sv = dtl_sv_make_i32(*(const int16_t*) pElem); break;
+      case DTL_TAV_I32: sv = dtl_sv_make_i32(*(const int32_t*) pElem); break;
+      case DTL_TAV_I64: sv = dtl_sv_make_i64(*(const int64_t*) pElem); break;
+      case DTL_TAV_U8:  sv = dtl_sv_make_u32(*(const uint8_t*) pElem); break;
+      case DTL_TAV_U16: sv = dtl_sv_make_u32(*(const uint16_t*) pElem); break;
+      case DTL_TAV_U32: sv = dtl_sv_make_u32(*(const uint32_t*) pElem); break;
+      case DTL_TAV_U64: sv = dtl_sv_make_u64(*(const uint64_t*) pElem); break;
+      case DTL_TAV_F32: sv = dtl_sv_make_flt(*(const float*) pElem); break;
+      default:          sv = dtl_sv_make_dbl(*(const double*) pElem); break;
+      }
+      if (sv == 0)
+      {
+         dtl_dec_ref(av);
+         return (dtl_av_t*) 0;
+      }
+      dtl_av_push(av, (dtl_dv_t*) sv, false);
+   }
+   return av;
+}
+
+dtl_error_t dtl_tav_push_i64(dtl_tav_t *self, int64_t value)
+{
+   dtl_error_t errorCode = dtl_tav_grow(self, (self != 0)? self->data.u32Length + 1u : 0u);
+   if (errorCode == DTL_NO_ERROR)
+   {
+      if (!dtl_tav_store_i64(&self->data, self->data.u32Length, value))
+      {
+         return DTL_CONVERSION_ERROR;
+      }
+      self->data.u32Length++;
+   }
+   return errorCode;
+}
+
+dtl_error_t dtl_tav_push_u64(dtl_tav_t *self, uint64_t value)
+{
+   dtl_error_t errorCode = dtl_tav_grow(self, (self != 0)? self->data.u32Length + 1u : 0u);
+   if (errorCode == DTL_NO_ERROR)
+   {
+      if (!dtl_tav_store_u64(&self->data, self->data.u32Length, value))
+      {
+         return DTL_CONVERSION_ERROR;
+      }
+      self->data.u32Length++;
+   }
+   return errorCode;
+}
+
+dtl_error_t dtl_tav_push_dbl(dtl_tav_t *self, double value)
+{
+   dtl_error_t errorCode = dtl_tav_grow(self, (self != 0)? self->data.u32Length + 1u : 0u);
+   if (errorCode == DTL_NO_ERROR)
+   {
+      if (!dtl_tav_store_dbl(&self->data, self->data.u32Length, value))
+      {
+         return DTL_CONVERSION_ERROR;
+      }
+      self->data.u32Length++;
+   }
+   return errorCode;
+}
+
+/**
+ * Appends u32Count elements that already have the element type of the array, in native byte order (one memcpy).
+ */
+dtl_error_t dtl_tav_append(dtl_tav_t *self, const void *pElems, uint32_t u32Count)
+{
+   dtl_error_t errorCode;
+   if ( (self == 0) || ( (pElems == 0) && (u32Count > 0u) ) || (u32Count > MAX_LENGTH - self->data.u32Length) )
+   {
+      return DTL_INVALID_ARGUMENT_ERROR;
+   }
+   errorCode = dtl_tav_grow(self, self->data.u32Length + u32Count);
+   if ( (errorCode == DTL_NO_ERROR) && (u32Count > 0u) )
+   {
+      memcpy(((uint8_t*) self->data.pElems) + ((size_t) self->data.u32Length * self->data.u8ElemSize), pElems,
+             (size_t) u32Count * self->data.u8ElemSize);
+      self->data.u32Length += u32Count;
+   }
+   return errorCode;
+}
+
+dtl_error_t dtl_tav_set_i64(dtl_tav_t *self, int32_t s32Index, int64_t value)
+{
+   uint32_t u32Index;
+   if (!dtl_tav_index(self, s32Index, &u32Index))
+   {
+      return DTL_INVALID_ARGUMENT_ERROR;
+   }
+   if (DTL_DV_IS_FROZEN(self))
+   {
+      return DTL_FROZEN_ERROR;
+   }
+   return dtl_tav_store_i64(&self->data, u32Index, value)? DTL_NO_ERROR : DTL_CONVERSION_ERROR;
+}
+
+dtl_error_t dtl_tav_set_u64(dtl_tav_t *self, int32_t s32Index, uint64_t value)
+{
+   uint32_t u32Index;
+   if (!dtl_tav_index(self, s32Index, &u32Index))
+   {
+      return DTL_INVALID_ARGUMENT_ERROR;
+   }
+   if (DTL_DV_IS_FROZEN(self))
+   {
+      return DTL_FROZEN_ERROR;
+   }
+   return dtl_tav_store_u64(&self->data, u32Index, value)? DTL_NO_ERROR : DTL_CONVERSION_ERROR;
+}
+
+dtl_error_t dtl_tav_set_dbl(dtl_tav_t *self, int32_t s32Index, double value)
+{
+   uint32_t u32Index;
+   if (!dtl_tav_index(self, s32Index, &u32Index))
+   {
+      return DTL_INVALID_ARGUMENT_ERROR;
+   }
+   if (DTL_DV_IS_FROZEN(self))
+   {
+      return DTL_FROZEN_ERROR;
+   }
+   return dtl_tav_store_dbl(&self->data, u32Index, value)? DTL_NO_ERROR : DTL_CONVERSION_ERROR;
+}
+
+/**
+ * Makes room for s32Len elements in total, so that pushing up to that length does not reallocate.
+ */
+dtl_error_t dtl_tav_reserve(dtl_tav_t *self, int32_t s32Len)
+{
+   if ( (self == 0) || (s32Len < 0) )
+   {
+      return DTL_INVALID_ARGUMENT_ERROR;
+   }
+   return dtl_tav_grow(self, (uint32_t) s32Len);
+}
+
+/**
+ * Removes all elements and keeps the buffer for reuse.
+ */
+void dtl_tav_clear(dtl_tav_t *self)
+{
+   if (DTL_DV_IS_WRITABLE(self))
+   {
+      self->data.u32Length = 0u;
+   }
+}
+
+int64_t dtl_tav_get_i64(const dtl_tav_t *self, int32_t s32Index, bool *ok)
+{
+   uint32_t u32Index;
+   int64_t retval = 0;
+   bool success = false;
+   if (dtl_tav_index(self, s32Index, &u32Index))
+   {
+      const void *pElem = ((const uint8_t*) self->data.pElems) + ((size_t) u32Index * self->data.u8ElemSize);
+      double dbl;
+      success = true;
+      switch ((dtl_tav_elem_t) self->data.u8ElemType)
+      {
+      case DTL_TAV_I8:  retval = *(const int8_t*) pElem; break;
+      case DTL_TAV_I16: retval = *(const int16_t*) pElem; break;
+      case DTL_TAV_I32: retval = *(const int32_t*) pElem; break;
+      case DTL_TAV_I64: retval = *(const int64_t*) pElem; break;
+      case DTL_TAV_U8:  retval = *(const uint8_t*) pElem; break;
+      case DTL_TAV_U16: retval = *(const uint16_t*) pElem; break;
+      case DTL_TAV_U32: retval = *(const uint32_t*) pElem; break;
+      case DTL_TAV_U64:
+         success = (*(const uint64_t*) pElem <= (uint64_t) INT64_MAX);
+         retval = success? (int64_t) *(const uint64_t*) pElem : 0;
+         break;
+      default:
+         dbl = ((dtl_tav_elem_t) self->data.u8ElemType == DTL_TAV_F32)? (double) *(const float*) pElem : *(const double*) pElem;
+         success = (dbl >= -TWO_POW_63) && (dbl < TWO_POW_63);
+         retval = success? (int64_t) dbl : 0;
+         break;
+      }
+   }
+   if (ok != 0)
+   {
+      *ok = success;
+   }
+   return retval;
+}
+
+uint64_t dtl_tav_get_u64(const dtl_tav_t *self, int32_t s32Index, bool *ok)
+{
+   uint32_t u32Index;
+   uint64_t retval = 0u;
+   bool success = false;
+   if (dtl_tav_index(self, s32Index, &u32Index))
+   {
+      const void *pElem = ((const uint8_t*) self->data.pElems) + ((size_t) u32Index * self->data.u8ElemSize);
+      int64_t i64 = 0;
+      double dbl;
+      success = true;
+      switch ((dtl_tav_elem_t) self->data.u8ElemType)
+      {
+      case DTL_TAV_I8:  i64 = *(const int8_t*) pElem; break;
+      case DTL_TAV_I16: i64 = *(const int16_t*) pElem; break;
+      case DTL_TAV_I32: i64 = *(const int32_t*) pElem; break;
+      case DTL_TAV_I64: i64 = *(const int64_t*) pElem; break;
+      case DTL_TAV_U8:  retval = *(const uint8_t*) pElem; break;
+      case DTL_TAV_U16: retval = *(const uint16_t*) pElem; break;
+      case DTL_TAV_U32: retval = *(const uint32_t*) pElem; break;
+      case DTL_TAV_U64: retval = *(const uint64_t*) pElem; break;
+      default:
+         dbl = ((dtl_tav_elem_t) self->data.u8ElemType == DTL_TAV_F32)? (double) *(const float*) pElem : *(const double*) pElem;
+         success = (dbl > -1.0) && (dbl < TWO_POW_64);
+         retval = success? (uint64_t) dbl : 0u;
+         break;
+      }
+      if (i64 != 0)
+      {
+         success = (i64 > 0);
+         retval = success? (uint64_t) i64 : 0u;
+      }
+   }
+   if (ok != 0)
+   {
+      *ok = success;
+   }
+   return retval;
+}
+
+double dtl_tav_get_dbl(const dtl_tav_t *self, int32_t s32Index, bool *ok)
+{
+   uint32_t u32Index;
+   double retval = 0.0;
+   bool success = false;
+   if (dtl_tav_index(self, s32Index, &u32Index))
+   {
+      const void *pElem = ((const uint8_t*) self->data.pElems) + ((size_t) u32Index * self->data.u8ElemSize);
+      success = true;
+      switch ((dtl_tav_elem_t) self->data.u8ElemType)
+      {
+      case DTL_TAV_I8:  retval = *(const int8_t*) pElem; break;
+      case DTL_TAV_I16: retval = *(const int16_t*) pElem; break;
+      case DTL_TAV_I32: retval = *(const int32_t*) pElem; break;
+      case DTL_TAV_I64: retval = (double) *(const int64_t*) pElem; break;
+      case DTL_TAV_U8:  retval = *(const uint8_t*) pElem; break;
+      case DTL_TAV_U16: retval = *(const uint16_t*) pElem; break;
+      case DTL_TAV_U32: retval = *(const uint32_t*) pElem; break;
+      case DTL_TAV_U64: retval = (double) *(const uint64_t*) pElem; break;
+      case DTL_TAV_F32: retval = *(const float*) pElem; break;
+      default:          retval = *(const double*) pElem; break;
+      }
+   }
+   if (ok != 0)
+   {
+      *ok = success;
+   }
+   return retval;
+}
+
+int32_t dtl_tav_length(const dtl_tav_t *self)
+{
+   if (self != 0)
+   {
+      return (int32_t) self->data.u32Length;
+   }
+   return -1;
+}
+
+dtl_tav_elem_t dtl_tav_elem_type(const dtl_tav_t *self)
+{
+   if (self != 0)
+   {
+      return (dtl_tav_elem_t) self->data.u8ElemType;
+   }
+   return DTL_TAV_NUM_ELEM_TYPES;
+}
+
+/**
+ * Direct read access to the elements, for example to sum a series or to write it to a file in one call.
+ */
+const void *dtl_tav_data(const dtl_tav_t *self)
+{
+   if (self != 0)
+   {
+      return self->data.pElems;
+   }
+   return (const void*) 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+static bool dtl_tav_index(const dtl_tav_t *self, int32_t s32Index, uint32_t *pu32Index)
+{
+   if (self == 0)
+   {
+      return false;
+   }
+   if (s32Index < 0)
+   {
+      s32Index += (int32_t) self->data.u32Length;
+   }
+   if ( (s32Index < 0) || ((uint32_t) s32Index >= self->data.u32Length) )
+   {
+      return false;
+   }
+   *pu32Index = (uint32_t) s32Index;
+   return true;
+}
+
+/**
+ * Checks that self can be written and has room for u32MinCapacity elements, doubling the buffer when it grows.
+ */
+static dtl_error_t dtl_tav_grow(dtl_tav_t *self, uint32_t u32MinCapacity)
+{
+   void *pElems;
+   uint32_t u32Capacity;
+   if (self == 0)
+   {
+      return DTL_INVALID_ARGUMENT_ERROR;
+   }
+   if (DTL_DV_IS_FROZEN(self))
+   {
+      return DTL_FROZEN_ERROR;
+   }
+   if (u32MinCapacity <= self->data.u32Capacity)
+   {
+      return DTL_NO_ERROR;
+   }
+   if (u32MinCapacity > MAX_LENGTH)
+   {
+      return DTL_MEM_ERROR;
+   }
+   u32Capacity = (self->data.u32Capacity < MIN_CAPACITY)? MIN_CAPACITY : self->data.u32Capacity;
+   while (u32Capacity < u32MinCapacity)
+   {
+      u32Capacity = (u32Capacity > MAX_LENGTH / 2u)? MAX_LENGTH : u32Capacity * 2u;
+   }
+   if ((size_t) u32Capacity > SIZE_MAX / self->data.u8ElemSize)
+   {
+      return DTL_MEM_ERROR; //buffer size does not fit size_t (32-bit targets)
+   }
+   pElems = realloc(self->data.pElems, (size_t) u32Capacity * self->data.u8ElemSize);
+   if (pElems == 0)
+   {
+      return DTL_MEM_ERROR;
+   }
+   self->data.pElems = pElems;
+   self->data.u32Capacity = u32Capacity;
+   return DTL_NO_ERROR;
+}
+
+static bool dtl_tav_store_i64(dtl_tav_data_t *data, uint32_t u32Index, int64_t value)
+{
+   void *pElem = ((uint8_t*) data->pElems) + ((size_t) u32Index * data->u8ElemSize);
+   if (value < 0)
+   {
+      switch ((dtl_tav_elem_t) data->u8ElemType)
+      {
+      case DTL_TAV_I8:
+         if (value < INT8_MIN) return false;
+         *(int8_t*) pElem = (int8_t) value;
+         return true;
+      case DTL_TAV_I16:
+         if (value < INT16_MIN) return false;
+         *(int16_t*) pElem = (int16_t) value;
+         return true;
+      case DTL_TAV_I32:
+         if (value < INT32_MIN) return false;
+         *(int32_t*) pElem = (int32_t) value;
+         return true;
+      case DTL_TAV_I64:
+         *(int64_t*) pElem = value;
+         return true;
+      case DTL_TAV_F32:
+      case DTL_TAV_F64:
+         return dtl_tav_store_dbl(data, u32Index, (double) value);
+      default:
+         return false; //unsigned
+      }
+   }
+   return dtl_tav_store_u64(data, u32Index, (uint64_t) value);
+}
+
+static bool dtl_tav_store_u64(dtl_tav_data_t *data, uint32_t u32Index, uint64_t value)
+{
+   void *pElem = ((uint8_t*) data->pElems) + ((size_t) u32Index * data->u8ElemSize);
+   switch ((dtl_tav_elem_t) data->u8ElemType)
+   {
+   case DTL_TAV_I8:
+      if (value > (uint64_t) INT8_MAX) return false;
+      *(int8_t*) pElem = (int8_t) value;
+      return true;
+   case DTL_TAV_I16:
+      if (value > (uint64_t) INT16_MAX) return false;
+      *(int16_t*) pElem = (int16_t) value;
+      return true;
+   case DTL_TAV_I32:
+      if (value > (uint64_t) INT32_MAX) return false;
+      *(int32_t*) pElem = (int32_t) value;
+      return true;
+   case DTL_TAV_I64:
+      if (value > (uint64_t) INT64_MAX) return false;
+      *(int64_t*) pElem = (int64_t) value;
+      return true;
+   case DTL_TAV_U8:
+      if (value > UINT8_MAX) return false;
+      *(uint8_t*) pElem = (uint8_t) value;
+      return true;
+   case DTL_TAV_U16:
+      if (value > UINT16_MAX) return false;
+      *(uint16_t*) pElem = (uint16_t) value;
+      return true;
+   case DTL_TAV_U32:
+      if (value > UINT32_MAX) return false;
+      *(uint32_t*) pElem = (uint32_t) value;
+      return true;
+   case DTL_TAV_U64:
+      *(uint64_t*) pElem = value;
+      return true;
+   default:
+      return dtl_tav_store_dbl(data, u32Index, (double) value);
+   }
+}
+
+/**
+ * Float elements take any double (F32 rounds, finite values beyond the float range are refused). Integer elements
+ * only take whole numbers in their range, which are then stored exactly.
+ */
+static bool dtl_tav_store_dbl(dtl_tav_data_t *data, uint32_t u32Index, double value)
+{
+   void *pElem = ((uint8_t*) data->pElems) + ((size_t) u32Index * data->u8ElemSize);
+   switch ((dtl_tav_elem_t) data->u8ElemType)
+   {
+   case DTL_TAV_F64:
+      *(double*) pElem = value;
+      return true;
+   case DTL_TAV_F32:
+      if ( (value > (double) FLT_MAX && value < HUGE_VAL) || (value < -(double) FLT_MAX && value > -HUGE_VAL) )
+      {
+         return false;
+      }
+      *(float*) pElem = (float) value;
+      return true;
+   default:
+      if ( (value >= -TWO_POW_63) && (value < 0.0) && ((double) (int64_t) value == value) )
+      {
+         return dtl_tav_store_i64(data, u32Index, (int64_t) value);
+      }
+      if ( (value >= 0.0) && (value < TWO_POW_64) && ((double) (uint64_t) value == value) )
+      {
+         return dtl_tav_store_u64(data, u32Index, (uint64_t) value);
+      }
+      return false; //fraction, NaN or out of range
+   }
+}
@@ -0,0 +1,238 @@
+/*****************************************************************************
+* \file      dtl_thread.h
+* \author    Conny Gustafsson
+* \date      2026-10-17
+* \brief     Private platform abstraction (threads, thread-local storage, mutexes, atomics, aligned memory)
+*
+* Copyright (c) 2026 Conny Gustafsson
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+#ifndef DTL_THREAD_H
+#define DTL_THREAD_H
+
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#include <malloc.h>
+#else
+#include <pthread.h>
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#if defined(_MSC_VER)
+# define DTL_THREAD_LOCAL __declspec(thread)
+#elif defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201112L) && !defined(__STDC_NO_THREADS__)
+# define DTL_THREAD_LOCAL _Thread_local
+#else
+# define DTL_THREAD_LOCAL __thread
+#endif
+
+#ifdef _WIN32
+typedef HANDLE dtl_thread_t;
+typedef DWORD dtl_thread_ret_t;
+# define DTL_THREAD_CALL WINAPI
+#else
+typedef pthread_t dtl_thread_t;
+typedef void* dtl_thread_ret_t;
+# define DTL_THREAD_CALL
+#endif
+typedef dtl_thread_ret_t (DTL_THREAD_CALL dtl_thread_func_t)(void *arg);
+
+#ifdef _WIN32
+typedef SRWLOCK dtl_mutex_t;
+# define DTL_MUTEX_INITIALIZER SRWLOCK_INIT
+# define dtl_mutex_lock(m) AcquireSRWLockExclusive(m)
+# define dtl_mutex_unlock(m) ReleaseSRWLockExclusive(m)
+typedef CONDITION_VARIABLE dtl_cond_t;
+# define DTL_COND_INITIALIZER CONDITION_VARIABLE_INIT
+# define dtl_cond_wait(c, m) (void) SleepConditionVariableSRW(c, m, INFINITE, 0)
+# define dtl_cond_signal(c) WakeConditionVariable(c)
+# define dtl_cond_broadcast(c) WakeAllConditionVariable(c)
+#else
+typedef pthread_mutex_t dtl_mutex_t;
+# define DTL_MUTEX_INITIALIZER PTHREAD_MUTEX_INITIALIZER
+# define dtl_mutex_lock(m) pthread_mutex_lock(m)
+# define dtl_mutex_unlock(m) pthread_mutex_unlock(m)
+typedef pthread_cond_t dtl_cond_t;
+# define DTL_COND_INITIALIZER PTHREAD_COND_INITIALIZER
+# define dtl_cond_wait(c, m) (void) pthread_cond_wait(c, m)
+# define dtl_cond_signal(c) (void) pthread_cond_signal(c)
+# define dtl_cond_broadcast(c) (void) pthread_cond_broadcast(c)
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static inline int dtl_thread_create(dtl_thread_t *thread, dtl_thread_func_t *func, void *arg)
+{
+#ifdef _WIN32
+   *thread = CreateThread(NULL, 0, func, arg, 0, NULL);
+   return (*thread != NULL)? 0 : -1;
+#else
+   return pthread_create(thread, NULL, func, arg);
+#endif
+}
+
+static inline void dtl_thread_join(dtl_thread_t thread)
+{
+#ifdef _WIN32
+   WaitForSingleObject(thread, INFINITE);
+   CloseHandle(thread);
+#else
+   (void) pthread_join(thread, NULL);
+#endif
+}
+
+/*
+ * 32-bit atomic counter operations. Increment is relaxed, the decrement and compare-exchange have
+ * acquire/release semantics so that the thread which drops the last reference sees all prior writes.
+ */
+static inline uint32_t dtl_atomic_load_u32(const volatile uint32_t *ptr)
+{
+#ifdef _MSC_VER
+   return (uint32_t) InterlockedCompareExchange((volatile LONG*) ptr, 0, 0);
+#else
+   return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+#endif
+}
+
+static inline void dtl_atomic_inc_u32(volatile uint32_t *ptr)
+{
+#ifdef _MSC_VER
+   (void) InterlockedIncrement((volatile LONG*) ptr);
+#else
+   (void) __atomic_add_fetch(ptr, 1u, __ATOMIC_RELAXED);
+#endif
+}
+
+//returns the new value
+static inline uint32_t dtl_atomic_dec_u32(volatile uint32_t *ptr)
+{
+#ifdef _MSC_VER
+   return (uint32_t) InterlockedDecrement((volatile LONG*) ptr);
+#else
+   return __atomic_sub_fetch(ptr, 1u, __ATOMIC_ACQ_REL);
+#endif
+}
+
+//returns the new value
+static inline uint32_t dtl_atomic_add_u32(volatile uint32_t *ptr, uint32_t value)
+{
+#ifdef _MSC_VER
+   return (uint32_t) InterlockedExchangeAdd((volatile LONG*) ptr, (LONG) value) + value;
+#else
+   return __atomic_add_fetch(ptr, value, __ATOMIC_ACQ_REL);
+#endif
+}
+
+static inline void dtl_atomic_store_u32(volatile uint32_t *ptr, uint32_t value)
+{
+#ifdef _MSC_VER
+   (void) InterlockedExchange((volatile LONG*) ptr, (LONG) value);
+#else
+   __atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+#endif
+}
+
+static inline bool dtl_atomic_cas_u32(volatile uint32_t *ptr, uint32_t expected, uint32_t desired)
+{
+#ifdef _MSC_VER
+   return (uint32_t) InterlockedCompareExchange((volatile LONG*) ptr, (LONG) desired, (LONG) expected) == expected;
+#else
+   return __atomic_compare_exchange_n(ptr, &expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+#endif
+}
+
+/*
+ * Pointer operations for lock-free lists. The compare-exchange releases the writes made to the new list node,
+ * the exchange acquires them.
+ */
+static inline void *dtl_atomic_load_ptr(void * volatile *ptr)
+{
+#ifdef _MSC_VER
+   return InterlockedCompareExchangePointer(ptr, NULL, NULL);
+#else
+   return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+#endif
+}
+
+static inline bool dtl_atomic_cas_ptr(void * volatile *ptr, void *expected, void *desired)
+{
+#ifdef _MSC_VER
+   return InterlockedCompareExchangePointer(ptr, desired, expected) == expected;
+#else
+   return __atomic_compare_exchange_n(ptr, &expected, desired, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+#endif
+}
+
+//returns the previous value
+static inline void *dtl_atomic_exchange_ptr(void * volatile *ptr, void *value)
+{
+#ifdef _MSC_VER
+   return InterlockedExchangePointer(ptr, value);
+#else
+   return __atomic_exchange_n(ptr, value, __ATOMIC_ACQ_REL);
+#endif
+}
+
+/*
+ * True when the reference count of a dtl_dv_t must be updated with the atomic operations above.
+ * Building with DTL_ATOMIC_REFCNT makes every value atomic, otherwise it is opt-in per value (DTL_DV_FLAG_ATOMIC).
+ */
+#ifdef DTL_ATOMIC_REFCNT
+#define DTL_DV_IS_ATOMIC(dv) true
+#else
+#define DTL_DV_IS_ATOMIC(dv) ( ((dv)->u32Flags & DTL_DV_FLAG_ATOMIC) != 0u)
+#endif
+
+static inline void *dtl_aligned_alloc(size_t alignment, size_t size)
+{
+#ifdef _WIN32
+   return _aligned_malloc(size, alignment);
+#else
+   void *ptr = NULL;
+   if (posix_memalign(&ptr, alignment, size) != 0)
+   {
+      return NULL;
+   }
+   return ptr;
+#endif
+}
+
+static inline void dtl_aligned_free(void *ptr)
+{
+#ifdef _WIN32
+   _aligned_free(ptr);
+#else
+   free(ptr);
+#endif
+}
+
+#endif //DTL_THREAD_H
@@ -10,6 +10,14 @@ CuSuite* testsuite_dtl_dv(void);
 CuSuite* testsuite_dtl_sv(void);
 CuSuite* testsuite_dtl_av(void);
 CuSuite* testsuite_dtl_hv(void);
+CuSuite* testsuite_dtl_htab(void);
+CuSuite* testsuite_dtl_phv(void);
+CuSuite* testsuite_dtl_pav(void);
+CuSuite* testsuite_dtl_pool(void);
+CuSuite* testsuite_dtl_reclaimer(void);
+CuSuite* testsuite_dtl_arena(void);
+CuSuite* testsuite_dtl_atom(void);
+CuSuite* testsuite_dtl_tav(void);
 
 void vfree(void *arg)
 {
@@ -26,6 +34,14 @@ void RunAllTests(void)
 	CuSuiteAddSuite(suite, testsuite_dtl_sv());
 	CuSuiteAddSuite(suite, testsuite_dtl_av());
 	CuSuiteAddSuite(suite, testsuite_dtl_hv());
+	CuSuiteAddSuite(suite, testsuite_dtl_htab());
+	CuSuiteAddSuite(suite, testsuite_dtl_phv());
+	CuSuiteAddSuite(suite, testsuite_dtl_pav());
+	CuSuiteAddSuite(suite, testsuite_dtl_pool());
+	CuSuiteAddSuite(suite, testsuite_dtl_reclaimer());
+	CuSuiteAddSuite(suite, testsuite_dtl_arena());
+	CuSuiteAddSuite(suite, testsuite_dtl_atom());
+	CuSuiteAddSuite(suite, testsuite_dtl_tav());
 
 	CuSuiteRun(suite);
 	CuSuiteSummary(suite, output);
@@ -0,0 +1,282 @@
+/*****************************************************************************
+* \file      testsuite_dtl_arena.c
+* \author    Conny Gustafsson
+* \date      2026-10-17
+* \brief     Unit tests for dtl_arena
+*
+* Copyright (c) 2026 Conny Gustafsson
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "CuTest.h"
+#include "dtl_arena.h"
+#include "dtl_sv.h"
+#include "dtl_av.h"
+#include "dtl_hv.h"
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define NUM_VALUES 5000
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static void test_dtl_arena_alloc(CuTest* tc);
+static void test_dtl_arena_scalars(CuTest* tc);
+static void test_dtl_arena_tree(CuTest* tc);
+static void test_dtl_arena_heap_children(CuTest* tc);
+static void test_dtl_arena_reuse_chunks(CuTest* tc);
+static void test_dtl_arena_promote(CuTest* tc);
+static void test_dtl_arena_promote_binary_keys(CuTest* tc);
+static void count_destructor_calls(void *arg);
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+static int m_destructorCalls;
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+CuSuite* testsuite_dtl_arena(void)
+{
+   CuSuite* suite = CuSuiteNew();
+
+   SUITE_ADD_TEST(suite, test_dtl_arena_alloc);
+   SUITE_ADD_TEST(suite, test_dtl_arena_scalars);
+   SUITE_ADD_TEST(suite, test_dtl_arena_tree);
+   SUITE_ADD_TEST(suite, test_dtl_arena_heap_children);
+   SUITE_ADD_TEST(suite, test_dtl_arena_reuse_chunks);
+   SUITE_ADD_TEST(suite, test_dtl_arena_promote);
+   SUITE_ADD_TEST(suite, test_dtl_arena_promote_binary_keys);
+
+   return suite;
+}
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+static void test_dtl_arena_alloc(CuTest* tc)
+{
+   dtl_arena_stats_t stats;
+   dtl_arena_t *arena = dtl_arena_new();
+   void *a, *b;
+   CuAssertPtrNotNull(tc, arena);
+   a = dtl_arena_alloc(arena, 1u);
+   b = dtl_arena_alloc(arena, 24u);
+   CuAssertPtrNotNull(tc, a);
+   CuAssertPtrNotNull(tc, b);
+   CuAssertTrue(tc, (((uintptr_t) b) & 7u) == 0u);
+   CuAssertPtrEquals(tc, NULL, dtl_arena_alloc(arena, 0u));
+   CuAssertPtrEquals(tc, NULL, dtl_arena_alloc(arena, DTL_ARENA_MAX_ALLOC + 1u));
+   CuAssertTrue(tc, dtl_arena_stats(arena, &stats));
+   CuAssertUIntEquals(tc, 1u, stats.u32NumChunks);
+   CuAssertUIntEquals(tc, 32u, (uint32_t) stats.u64BytesUsed);
+   dtl_arena_delete(arena);
+}
+
+static void test_dtl_arena_scalars(CuTest* tc)
+{
+   dtl_arena_stats_t stats;
+   dtl_arena_t *arena = dtl_arena_new();
+   dtl_sv_t *sv1 = dtl_sv_arena_make_i32(arena, -12);
+   dtl_sv_t *sv2 = dtl_sv_arena_make_dbl(arena, 1.5);
+   dtl_sv_t *sv3 = dtl_sv_arena_make_cstr(arena, "hello");
+   dtl_sv_t *sv4 = dtl_sv_make_i32(1);
+   bool ok = false;
+
+   CuAssertPtrNotNull(tc, sv1);
+   CuAssertPtrNotNull(tc, sv2);
+   CuAssertPtrNotNull(tc, sv3);
+   CuAssertPtrEquals(tc, arena, dtl_dv_arena((dtl_dv_t*) sv1));
+   CuAssertPtrEquals(tc, NULL, dtl_dv_arena((dtl_dv_t*) sv4));
+   CuAssertIntEquals(tc, -12, dtl_sv_to_i32(sv1, &ok));
+   CuAssertTrue(tc, ok);
+   CuAssertDblEquals(tc, 1.5, dtl_sv_to_dbl(sv2, &ok), 0.0);
+   CuAssertStrEquals(tc, "hello", dtl_sv_to_cstr(sv3, &ok));
+
+   //reference counting is disabled for arena values
+   dtl_inc_ref(sv1);
+   CuAssertUIntEquals(tc, 1u, dtl_ref_cnt(sv1));
+   dtl_dec_ref(sv1);
+   dtl_dec_ref(sv1);
+   CuAssertIntEquals(tc, -12, dtl_sv_to_i32(sv1, &ok));
+
+   //none of the values owns heap data, short strings are stored inline
+   CuAssertTrue(tc, dtl_arena_stats(arena, &stats));
+   CuAssertUIntEquals(tc, 0u, stats.u32NumFinalizers);
+   dtl_sv_set_cstr(sv1, "a string too long for inline storage");
+   CuAssertTrue(tc, dtl_arena_stats(arena, &stats));
+   CuAssertUIntEquals(tc, 1u, stats.u32NumFinalizers);
+   CuAssertStrEquals(tc, "a string too long for inline storage", dtl_sv_to_cstr(sv1, &ok));
+   //numeric to_cstr does not allocate
+   CuAssertStrEquals(tc, "1.5", dtl_sv_to_cstr(sv2, &ok));
+   CuAssertTrue(tc, dtl_arena_stats(arena, &stats));
+   CuAssertUIntEquals(tc, 1u, stats.u32NumFinalizers);
+
+   dtl_arena_reset(arena);
+   CuAssertTrue(tc, dtl_arena_stats(arena, &stats));
+   CuAssertUIntEquals(tc, 0u, stats.u32NumFinalizers);
+   CuAssertUIntEquals(tc, 0u, (uint32_t) stats.u64BytesUsed);
+   dtl_arena_delete(arena);
+   dtl_dec_ref(sv4);
+}
+
+static void test_dtl_arena_tree(CuTest* tc)
+{
+   dtl_arena_t *arena = dtl_arena_new();
+   dtl_hv_t *root = dtl_hv_arena_new(arena);
+   dtl_av_t *list = dtl_av_arena_new(arena);
+   int32_t i;
+   CuAssertPtrNotNull(tc, root);
+   CuAssertPtrNotNull(tc, list);
+   for (i = 0; i < NUM_VALUES; i++)
+   {
+      dtl_hv_t *item = dtl_hv_arena_new(arena);
+      dtl_hv_set_cstr(item, "id", (dtl_dv_t*) dtl_sv_arena_make_i32(arena, i), false);
+      dtl_hv_set_cstr(item, "name", (dtl_dv_t*) dtl_sv_arena_make_cstr(arena, "item"), false);
+      dtl_av_push(list, (dtl_dv_t*) item, false);
+   }
+   dtl_hv_set_cstr(root, "items", (dtl_dv_t*) list, false);
+   CuAssertIntEquals(tc, NUM_VALUES, dtl_av_length(list));
+   for (i = 0; i < NUM_VALUES; i++)
+   {
+      dtl_hv_t *item = (dtl_hv_t*) dtl_av_value(list, i);
+      CuAssertIntEquals(tc, i, dtl_sv_to_i32((dtl_sv_t*) dtl_hv_get_cstr(item, "id"), NULL));
+   }
+   //dropping the root does nothing, the arena owns the tree
+   dtl_dec_ref(root);
+   CuAssertIntEquals(tc, NUM_VALUES, dtl_av_length((dtl_av_t*) dtl_hv_get_cstr(root, "items")));
+   dtl_arena_delete(arena);
+}
+
+static void test_dtl_arena_heap_children(CuTest* tc)
+{
+   dtl_arena_t *arena = dtl_arena_new();
+   dtl_av_t *av = dtl_av_arena_new(arena);
+   dtl_hv_t *hv = dtl_hv_arena_new(arena);
+   dtl_sv_t *heapValue = dtl_sv_make_cstr("heap");
+   dtl_av_push(av, (dtl_dv_t*) heapValue, true);
+   dtl_hv_set_cstr(hv, "value", (dtl_dv_t*) heapValue, true);
+   dtl_av_push(av, (dtl_dv_t*) dtl_sv_arena_make_dv(arena, (dtl_dv_t*) heapValue, true), false);
+   CuAssertUIntEquals(tc, 4u, dtl_ref_cnt(heapValue));
+   dtl_arena_reset(arena);
+   CuAssertUIntEquals(tc, 1u, dtl_ref_cnt(heapValue));
+   dtl_dec_ref(heapValue);
+   dtl_arena_delete(arena);
+}
+
+static void test_dtl_arena_reuse_chunks(CuTest* tc)
+{
+   dtl_arena_stats_t stats;
+   dtl_arena_t *arena = dtl_arena_new();
+   uint32_t u32NumChunks;
+   int32_t i;
+   for (i = 0; i < NUM_VALUES; i++)
+   {
+      dtl_sv_arena_make_i32(arena, i);
+   }
+   CuAssertTrue(tc, dtl_arena_stats(arena, &stats));
+   CuAssertTrue(tc, stats.u32NumChunks > 1u);
+   CuAssertUIntEquals(tc, 0u, stats.u32NumFinalizers);
+   u32NumChunks = stats.u32NumChunks;
+   dtl_arena_reset(arena);
+   for (i = 0; i < NUM_VALUES; i++)
+   {
+      dtl_sv_arena_make_i32(arena, i);
+   }
+   CuAssertTrue(tc, dtl_arena_stats(arena, &stats));
+   CuAssertUIntEquals(tc, u32NumChunks, stats.u32NumChunks);
+   dtl_arena_delete(arena);
+}
+
+static void test_dtl_arena_promote(CuTest* tc)
+{
+   dtl_arena_t *arena = dtl_arena_new();
+   dtl_hv_t *root = dtl_hv_arena_new(arena);
+   dtl_av_t *list = dtl_av_arena_new(arena);
+   dtl_sv_t *heapValue = dtl_sv_make_i32(7);
+   dtl_hv_t *copy;
+   dtl_av_t *copyList;
+   dtl_dv_t *dv;
+   bool ok = false;
+
+   m_destructorCalls = 0;
+   dtl_av_push(list, (dtl_dv_t*) dtl_sv_arena_make_u64(arena, 0xFFFFFFFFFFFFull), false);
+   dtl_av_push(list, (dtl_dv_t*) dtl_sv_arena_make_cstr(arena, "text"), false);
+   dtl_av_push(list, (dtl_dv_t*) dtl_sv_arena_make_ptr(arena, &m_destructorCalls, count_destructor_calls), false);
+   dtl_av_push(list, (dtl_dv_t*) heapValue, false);
+   dtl_hv_set_cstr(root, "list", (dtl_dv_t*) list, false);
+   dtl_hv_set_cstr(root, "ref", (dtl_dv_t*) dtl_sv_arena_make_dv(arena, (dtl_dv_t*) dtl_hv_arena_new(arena), false), false);
+
+   copy = (dtl_hv_t*) dtl_dv_promote((dtl_dv_t*) root);
+   CuAssertPtrNotNull(tc, copy);
+   CuAssertPtrEquals(tc, NULL, dtl_dv_arena((dtl_dv_t*) copy));
+   dtl_arena_delete(arena);
+   CuAssertIntEquals(tc, 0, m_destructorCalls);
+
+   CuAssertIntEquals(tc, DTL_DV_HASH, dtl_dv_type((dtl_dv_t*) copy));
+   copyList = (dtl_av_t*) dtl_hv_get_cstr(copy, "list");
+   CuAssertIntEquals(tc, DTL_DV_ARRAY, dtl_dv_type((dtl_dv_t*) copyList));
+   CuAssertIntEquals(tc, 4, dtl_av_length(copyList));
+   CuAssertTrue(tc, dtl_sv_to_u64((dtl_sv_t*) dtl_av_value(copyList, 0), &ok) == 0xFFFFFFFFFFFFull);
+   CuAssertStrEquals(tc, "text", dtl_sv_to_cstr((dtl_sv_t*) dtl_av_value(copyList, 1), &ok));
+   CuAssertPtrEquals(tc, &m_destructorCalls, dtl_sv_to_ptr((dtl_sv_t*) dtl_av_value(copyList, 2)));
+   //heap values are shared rather than copied
+   CuAssertPtrEquals(tc, heapValue, dtl_av_value(copyList, 3));
+   CuAssertUIntEquals(tc, 1u, dtl_ref_cnt(heapValue));
+   dv = dtl_hv_get_cstr(copy, "ref");
+   CuAssertIntEquals(tc, DTL_SV_DV, dtl_sv_type((dtl_sv_t*) dv));
+   CuAssertIntEquals(tc, DTL_DV_HASH, dtl_sv_dv_type((dtl_sv_t*) dv));
+
+   dtl_dec_ref(copy);
+   CuAssertIntEquals(tc, 1, m_destructorCalls);
+}
+
+static void test_dtl_arena_promote_binary_keys(CuTest* tc)
+{
+   const uint8_t key[3] = {'a', 0, 'b'};
+   dtl_arena_t *arena = dtl_arena_new();
+   dtl_hv_t *root = dtl_hv_arena_new(arena);
+   dtl_hv_t *copy;
+
+   dtl_hv_set_bstr(root, key, key + 3, (dtl_dv_t*) dtl_sv_arena_make_i32(arena, 1), false);
+   dtl_hv_set_cstr(root, "a", (dtl_dv_t*) dtl_sv_arena_make_i32(arena, 2), false);
+   copy = (dtl_hv_t*) dtl_dv_promote((dtl_dv_t*) root);
+   dtl_arena_delete(arena);
+   CuAssertPtrNotNull(tc, copy);
+   CuAssertUIntEquals(tc, 2u, dtl_hv_length(copy));
+   CuAssertIntEquals(tc, 1, dtl_sv_to_i32((dtl_sv_t*) dtl_hv_get_bstr(copy, key, key + 3), NULL));
+   CuAssertIntEquals(tc, 2, dtl_sv_to_i32((dtl_sv_t*) dtl_hv_get_cstr(copy, "a"), NULL));
+   dtl_dec_ref(copy);
+}
+
+static void count_destructor_calls(void *arg)
+{
+   (*(int*) arg)++;
+}
@@ -0,0 +1,240 @@
+/*****************************************************************************
+* \file      testsuite_dtl_atom.c
+* \author    Conny Gustafsson
+* \date      2026-10-17
+* \brief     Unit tests for dtl_atom
+*
+* Copyright (c) 2026 Conny Gustafsson
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "CuTest.h"
+#include "dtl_atom.h"
+#include "dtl_sv.h"
+#include "dtl_thread.h"
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define NUM_THREADS     4
+#define NUM_KEYS        200
+#define NUM_ITERATIONS  200
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static void test_dtl_atom_intern(CuTest* tc);
+static void test_dtl_atom_bstr(CuTest* tc);
+static void test_dtl_atom_find(CuTest* tc);
+static void test_dtl_atom_many(CuTest* tc);
+static void test_dtl_atom_threads(CuTest* tc);
+static void test_dtl_atom_sv(CuTest* tc);
+static dtl_thread_ret_t DTL_THREAD_CALL intern_worker(void *arg);
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+CuSuite* testsuite_dtl_atom(void)
+{
+   CuSuite* suite = CuSuiteNew();
+
+   SUITE_ADD_TEST(suite, test_dtl_atom_intern);
+   SUITE_ADD_TEST(suite, test_dtl_atom_bstr);
+   SUITE_ADD_TEST(suite, test_dtl_atom_find);
+   SUITE_ADD_TEST(suite, test_dtl_atom_many);
+   SUITE_ADD_TEST(suite, test_dtl_atom_threads);
+   SUITE_ADD_TEST(suite, test_dtl_atom_sv);
+
+   return suite;
+}
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+static void test_dtl_atom_intern(CuTest* tc)
+{
+   uint32_t u32Count = dtl_atom_count();
+   dtl_atom_t *a = dtl_atom_intern("name");
+   dtl_atom_t *b = dtl_atom_intern("name");
+   dtl_atom_t *c = dtl_atom_intern("value");
+   CuAssertPtrNotNull(tc, a);
+   CuAssertPtrNotNull(tc, c);
+   CuAssertPtrEquals(tc, a, b);
+   CuAssertTrue(tc, a != c);
+   CuAssertStrEquals(tc, "name", dtl_atom_cstr(a));
+   CuAssertUIntEquals(tc, 4u, dtl_atom_length(a));
+   CuAssertUIntEquals(tc, 2u, dtl_atom_ref_cnt(a));
+   CuAssertUIntEquals(tc, u32Count + 2u, dtl_atom_count());
+   CuAssertTrue(tc, dtl_atom_hash(a) != dtl_atom_hash(c));
+   dtl_atom_release(b);
+   CuAssertUIntEquals(tc, 1u, dtl_atom_ref_cnt(a));
+   dtl_atom_release(a);
+   dtl_atom_release(c);
+   CuAssertUIntEquals(tc, u32Count, dtl_atom_count());
+   CuAssertPtrEquals(tc, NULL, dtl_atom_intern(NULL));
+}
+
+static void test_dtl_atom_bstr(CuTest* tc)
+{
+   const uint8_t data[3] = {'a', 0, 'b'};
+   dtl_atom_t *a = dtl_atom_intern_bstr(&data[0], &data[0] + sizeof(data));
+   dtl_atom_t *b = dtl_atom_intern("a");
+   dtl_atom_t *empty = dtl_atom_intern("");
+   CuAssertPtrNotNull(tc, a);
+   CuAssertPtrNotNull(tc, empty);
+   CuAssertTrue(tc, a != b);
+   CuAssertUIntEquals(tc, 3u, dtl_atom_length(a));
+   CuAssertUIntEquals(tc, 0u, dtl_atom_length(empty));
+   CuAssertStrEquals(tc, "", dtl_atom_cstr(empty));
+   dtl_atom_release(a);
+   dtl_atom_release(b);
+   dtl_atom_release(empty);
+}
+
+static void test_dtl_atom_find(CuTest* tc)
+{
+   dtl_atom_t *a;
+   CuAssertPtrEquals(tc, NULL, dtl_atom_find("not interned"));
+   a = dtl_atom_intern("interned");
+   CuAssertPtrEquals(tc, a, dtl_atom_find("interned"));
+   CuAssertUIntEquals(tc, 2u, dtl_atom_ref_cnt(a));
+   dtl_atom_release(a);
+   dtl_atom_release(a);
+   CuAssertPtrEquals(tc, NULL, dtl_atom_find("interned"));
+}
+
+static void test_dtl_atom_many(CuTest* tc)
+{
+   dtl_atom_t *atoms[NUM_KEYS * 10];
+   uint32_t u32Count = dtl_atom_count();
+   char buf[32];
+   int i;
+   for (i = 0; i < NUM_KEYS * 10; i++)
+   {
+      sprintf(buf, "key_%d", i);
+      atoms[i] = dtl_atom_intern(buf);
+      CuAssertPtrNotNull(tc, atoms[i]);
+   }
+   CuAssertUIntEquals(tc, u32Count + NUM_KEYS * 10, dtl_atom_count());
+   for (i = 0; i < NUM_KEYS * 10; i++)
+   {
+      sprintf(buf, "key_%d", i);
+      CuAssertStrEquals(tc, buf, dtl_atom_cstr(atoms[i]));
+      dtl_atom_release(atoms[i]);
+   }
+   CuAssertUIntEquals(tc, u32Count, dtl_atom_count());
+}
+
+static void test_dtl_atom_threads(CuTest* tc)
+{
+   dtl_thread_t threads[NUM_THREADS];
+   int results[NUM_THREADS];
+   uint32_t u32Count = dtl_atom_count();
+   int i;
+   for (i = 0; i < NUM_THREADS; i++)
+   {
+      results[i] = 0;
+      CuAssertIntEquals(tc, 0, dtl_thread_create(&threads[i], intern_worker, &results[i]));
+   }
+   for (i = 0; i < NUM_THREADS; i++)
+   {
+      dtl_thread_join(threads[i]);
+      CuAssertIntEquals(tc, NUM_KEYS * NUM_ITERATIONS, results[i]);
+   }
+   CuAssertUIntEquals(tc, u32Count, dtl_atom_count());
+}
+
+static void test_dtl_atom_sv(CuTest* tc)
+{
+   dtl_atom_t *atom = dtl_atom_intern("a key that is longer than sixteen bytes");
+   dtl_sv_t *sv1 = dtl_sv_make_atom(atom);
+   dtl_sv_t *sv2 = dtl_sv_make_atom(atom);
+   dtl_sv_t *sv3 = dtl_sv_make_cstr("a key that is longer than sixteen bytes");
+   bool ok = false;
+   bool ltres = true;
+   adt_str_t *str;
+
+   CuAssertIntEquals(tc, DTL_SV_STR, dtl_sv_type(sv1));
+   CuAssertUIntEquals(tc, 3u, dtl_atom_ref_cnt(atom));
+   CuAssertPtrEquals(tc, atom, dtl_sv_get_atom(sv1));
+   CuAssertPtrEquals(tc, NULL, dtl_sv_get_atom(sv3));
+   //both scalars share the interned buffer
+   CuAssertPtrEquals(tc, (void*) dtl_sv_to_cstr(sv1, &ok), (void*) dtl_sv_to_cstr(sv2, &ok));
+   CuAssertTrue(tc, ok);
+   CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_sv_lt(sv1, sv3, &ltres));
+   CuAssertTrue(tc, !ltres);
+   str = dtl_sv_to_str(sv1, &ok);
+   CuAssertStrEquals(tc, "a key that is longer than sixteen bytes", adt_str_cstr(str));
+   adt_str_delete(str);
+
+   //setting another value releases the atom
+   dtl_sv_set_cstr(sv1, dtl_sv_to_cstr(sv2, &ok));
+   CuAssertPtrEquals(tc, NULL, dtl_sv_get_atom(sv1));
+   CuAssertStrEquals(tc, "a key that is longer than sixteen bytes", dtl_sv_to_cstr(sv1, &ok));
+   CuAssertUIntEquals(tc, 2u, dtl_atom_ref_cnt(atom));
+   dtl_sv_set_i32(sv2, 1);
+   CuAssertUIntEquals(tc, 1u, dtl_atom_ref_cnt(atom));
+   dtl_sv_set_atom(sv3, atom);
+   dtl_sv_set_atom(sv3, atom);
+   CuAssertUIntEquals(tc, 2u, dtl_atom_ref_cnt(atom));
+   dtl_dec_ref(sv3);
+   CuAssertUIntEquals(tc, 1u, dtl_atom_ref_cnt(atom));
+
+   dtl_dec_ref(sv1);
+   dtl_dec_ref(sv2);
+   dtl_atom_release(atom);
+}
+
+static dtl_thread_ret_t DTL_THREAD_CALL intern_worker(void *arg)
+{
+   int *result = (int*) arg;
+   dtl_atom_t *atoms[NUM_KEYS];
+   char buf[32];
+   int i, j;
+   for (j = 0; j < NUM_ITERATIONS; j++)
+   {
+      for (i = 0; i < NUM_KEYS; i++)
+      {
+         sprintf(buf, "shared_key_%d", i);
+         atoms[i] = dtl_atom_intern(buf);
+      }
+      for (i = 0; i < NUM_KEYS; i++)
+      {
+         sprintf(buf, "shared_key_%d", i);
+         if ( (atoms[i] != 0) && (strcmp(buf, dtl_atom_cstr(atoms[i])) == 0) )
+         {
+            (*result)++;
+         }
+         dtl_atom_release(atoms[i]);
+      }
+   }
+   return (dtl_thread_ret_t) 0;
+}
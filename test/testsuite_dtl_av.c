@@ -29,9 +29,11 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <math.h>
 #include "CuTest.h"
 #include "dtl_sv.h"
 #include "dtl_av.h"
+#include "dtl_hv.h"
 #ifdef MEM_LEAK_CHECK
 #include "CMemLeak.h"
 #endif
@@ -48,6 +50,20 @@ static void test_dtl_av_push_pop(CuTest* tc);
 static void test_dtl_av_get_set(CuTest* tc);
 static void test_dtl_av_sort_i32(CuTest* tc);
 static void test_dtl_av_sort_strings(CuTest* tc);
+static void test_dtl_av_embedded_container(CuTest* tc);
+static void test_dtl_av_make_reserve(CuTest* tc);
+static void test_dtl_av_sort_large(CuTest* tc);
+static void test_dtl_av_sort_stable_key(CuTest* tc);
+static void test_dtl_av_sort_types(CuTest* tc);
+static void test_dtl_av_sort_errors(CuTest* tc);
+static void test_dtl_av_sort_radix_numbers(CuTest* tc);
+static void test_dtl_av_sort_radix_strings(CuTest* tc);
+static void test_dtl_av_sort_parallel(CuTest* tc);
+static dtl_dv_t *record_key(const dtl_dv_t *dv);
+static dtl_dv_t *record_name_key(const dtl_dv_t *dv);
+static int compare_i32(const void *a, const void *b);
+static int compare_i64(const void *a, const void *b);
+static int compare_cstr(const void *a, const void *b);
 
 //////////////////////////////////////////////////////////////////////////////
 // PRIVATE VARIABLES
@@ -65,6 +81,15 @@ CuSuite* testsuite_dtl_av(void)
    SUITE_ADD_TEST(suite, test_dtl_av_get_set);
    SUITE_ADD_TEST(suite, test_dtl_av_sort_i32);
    SUITE_ADD_TEST(suite, test_dtl_av_sort_strings);
+   SUITE_ADD_TEST(suite, test_dtl_av_embedded_container);
+   SUITE_ADD_TEST(suite, test_dtl_av_make_reserve);
+   SUITE_ADD_TEST(suite, test_dtl_av_sort_large);
+   SUITE_ADD_TEST(suite, test_dtl_av_sort_stable_key);
+   SUITE_ADD_TEST(suite, test_dtl_av_sort_types);
+   SUITE_ADD_TEST(suite, test_dtl_av_sort_errors);
+   SUITE_ADD_TEST(suite, test_dtl_av_sort_radix_numbers);
+   SUITE_ADD_TEST(suite, test_dtl_av_sort_radix_strings);
+   SUITE_ADD_TEST(suite, test_dtl_av_sort_parallel);
 
    return suite;
 }
@@ -165,4 +190,489 @@ static void test_dtl_av_sort_strings(CuTest* tc)
    dtl_dec_ref(av);
 }
 
+static void test_dtl_av_embedded_container(CuTest* tc)
+{
+   dtl_av_t *av = dtl_av_new();
+   dtl_av_t local;
+   CuAssertPtrNotNull(tc, av);
+   CuAssertPtrEquals(tc, &av->ary, av->pAny);
+   dtl_av_push(av, (dtl_dv_t*) dtl_sv_make_i32(1), false);
+   CuAssertIntEquals(tc, 1, adt_ary_length(av->pAny));
+   dtl_dec_ref(av);
+
+   //dtl_av_create works on caller provided memory
+   dtl_av_create(&local);
+   CuAssertPtrEquals(tc, &local.ary, local.pAny);
+   dtl_av_push(&local, (dtl_dv_t*) dtl_sv_make_i32(2), false);
+   CuAssertIntEquals(tc, 2, dtl_sv_to_i32((dtl_sv_t*) dtl_av_value(&local, 0), NULL));
+   dtl_av_destroy(&local);
+}
+
+static void test_dtl_av_make_reserve(CuTest* tc)
+{
+   dtl_dv_t *values[100];
+   void **ppFirst;
+   dtl_av_t *av;
+   int32_t i;
+   for (i = 0; i < 100; i++)
+   {
+      values[i] = (dtl_dv_t*) dtl_sv_make_i32(i);
+   }
+   //the array takes over the references, releasing it releases the values
+   av = dtl_av_make(values, 100);
+   CuAssertPtrNotNull(tc, av);
+   CuAssertIntEquals(tc, 100, dtl_av_length(av));
+   CuAssertTrue(tc, av->ary.s32AllocLen >= 100);
+   for (i = 0; i < 100; i++)
+   {
+      CuAssertPtrEquals(tc, values[i], dtl_av_value(av, i));
+      CuAssertIntEquals(tc, 1, (int32_t) values[i]->u32RefCnt);
+   }
+   dtl_dec_ref(av);
+
+   av = dtl_av_make(NULL, 0);
+   CuAssertPtrNotNull(tc, av);
+   CuAssertIntEquals(tc, 0, dtl_av_length(av));
+   CuAssertPtrEquals(tc, NULL, dtl_av_make(NULL, 1));
+   CuAssertPtrEquals(tc, NULL, dtl_av_make(values, -1));
+
+   //reserving keeps the length and makes the pushes up to it reuse one buffer
+   CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_av_reserve(av, 1000));
+   CuAssertIntEquals(tc, 0, dtl_av_length(av));
+   CuAssertTrue(tc, dtl_av_is_empty(av));
+   ppFirst = av->ary.pFirst;
+   for (i = 0; i < 1000; i++)
+   {
+      dtl_av_push(av, (dtl_dv_t*) dtl_sv_make_i32(i), false);
+   }
+   CuAssertPtrEquals(tc, (void*) ppFirst, (void*) av->ary.pFirst);
+   CuAssertIntEquals(tc, 999, dtl_sv_to_i32((dtl_sv_t*) dtl_av_value(av, -1), NULL));
+   CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_av_reserve(av, 10)); //smaller than the length
+   CuAssertIntEquals(tc, 1000, dtl_av_length(av));
+   CuAssertIntEquals(tc, DTL_INVALID_ARGUMENT_ERROR, dtl_av_reserve(av, -1));
+   CuAssertIntEquals(tc, DTL_INVALID_ARGUMENT_ERROR, dtl_av_reserve(NULL, 10));
+   dtl_dv_freeze((dtl_dv_t*) av);
+   CuAssertIntEquals(tc, DTL_FROZEN_ERROR, dtl_av_reserve(av, 2000));
+   dtl_dec_ref(av);
+}
+
+/**
+ * Random, ascending, descending and partly sorted input, compared against qsort.
+ */
+static void test_dtl_av_sort_large(CuTest* tc)
+{
+   int32_t values[5000];
+   int32_t expected[5000];
+   int32_t pattern;
+   uint32_t seed = 12345u;
+   for (pattern = 0; pattern < 4; pattern++)
+   {
+      dtl_av_t *av = dtl_av_new();
+      int32_t i;
+      for (i = 0; i < 5000; i++)
+      {
+         seed = seed * 1103515245u + 12345u;
+         switch (pattern)
+         {
+         case 0: values[i] = (int32_t) ((seed >> 8) % 1000u) - 500; break; //many duplicates
+         case 1: values[i] = i; break;
+         case 2: values[i] = 5000 - i; break;
+         default: values[i] = ((i % 700) < 600)? i : (int32_t) ((seed >> 8) % 5000u); break; //sorted runs with noise
+         }
+         expected[i] = values[i];
+         dtl_av_push(av, (dtl_dv_t*) dtl_sv_make_i32(values[i]), false);
+      }
+      qsort(expected, 5000, sizeof(int32_t), compare_i32);
+      CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_av_sort(av, NULL, false));
+      for (i = 0; i < 5000; i++)
+      {
+         CuAssertIntEquals(tc, expected[i], dtl_sv_to_i32((dtl_sv_t*) dtl_av_value(av, i), NULL));
+      }
+      CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_av_sort(av, NULL, true));
+      for (i = 0; i < 5000; i++)
+      {
+         CuAssertIntEquals(tc, expected[4999 - i], dtl_sv_to_i32((dtl_sv_t*) dtl_av_value(av, i), NULL));
+      }
+      dtl_dec_ref(av);
+   }
+}
+
+/**
+ * Hashes sorted by a field: the key function is used and records with equal keys keep their order, also in reverse.
+ */
+static void test_dtl_av_sort_stable_key(CuTest* tc)
+{
+   dtl_av_t *av = dtl_av_new();
+   int32_t i;
+   for (i = 0; i < 300; i++)
+   {
+      dtl_hv_t *hv = dtl_hv_new();
+      dtl_hv_set_cstr(hv, "group", (dtl_dv_t*) dtl_sv_make_i32((i * 7) % 10), false);
+      dtl_hv_set_cstr(hv, "seq", (dtl_dv_t*) dtl_sv_make_i32(i), false);
+      dtl_av_push(av, (dtl_dv_t*) hv, false);
+   }
+   CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_av_sort(av, record_key, false));
+   for (i = 1; i < 300; i++)
+   {
+      dtl_hv_t *prev = (dtl_hv_t*) dtl_av_value(av, i - 1);
+      dtl_hv_t *cur = (dtl_hv_t*) dtl_av_value(av, i);
+      int32_t prevGroup = dtl_sv_to_i32((dtl_sv_t*) dtl_hv_get_cstr(prev, "group"), NULL);
+      int32_t curGroup = dtl_sv_to_i32((dtl_sv_t*) dtl_hv_get_cstr(cur, "group"), NULL);
+      CuAssertTrue(tc, prevGroup <= curGroup);
+      if (prevGroup == curGroup)
+      {
+         CuAssertTrue(tc, dtl_sv_to_i32((dtl_sv_t*) dtl_hv_get_cstr(prev, "seq"), NULL) <
+                          dtl_sv_to_i32((dtl_sv_t*) dtl_hv_get_cstr(cur, "seq"), NULL));
+      }
+   }
+   CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_av_sort(av, record_key, true));
+   for (i = 1; i < 300; i++)
+   {
+      dtl_hv_t *prev = (dtl_hv_t*) dtl_av_value(av, i - 1);
+      dtl_hv_t *cur = (dtl_hv_t*) dtl_av_value(av, i);
+      int32_t prevGroup = dtl_sv_to_i32((dtl_sv_t*) dtl_hv_get_cstr(prev, "group"), NULL);
+      int32_t curGroup = dtl_sv_to_i32((dtl_sv_t*) dtl_hv_get_cstr(cur, "group"), NULL);
+      CuAssertTrue(tc, prevGroup >= curGroup);
+      if (prevGroup == curGroup)
+      {
+         CuAssertTrue(tc, dtl_sv_to_i32((dtl_sv_t*) dtl_hv_get_cstr(prev, "seq"), NULL) <
+                          dtl_sv_to_i32((dtl_sv_t*) dtl_hv_get_cstr(cur, "seq"), NULL));
+      }
+   }
+   dtl_dec_ref(av);
+}
+
+static void test_dtl_av_sort_types(CuTest* tc)
+{
+   dtl_av_t *av = dtl_av_new();
+   bool ok = false;
+   dtl_av_push(av, (dtl_dv_t*) dtl_sv_make_dbl(2.5), false);
+   dtl_av_push(av, (dtl_dv_t*) dtl_sv_make_dbl(-1.0), false);
+   dtl_av_push(av, (dtl_dv_t*) dtl_sv_make_dbl(1e300), false);
+   CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_av_sort(av, NULL, false));
+   CuAssertDblEquals(tc, -1.0, dtl_sv_to_dbl((dtl_sv_t*) dtl_av_value(av, 0), NULL), 0.0);
+   CuAssertDblEquals(tc, 1e300, dtl_sv_to_dbl((dtl_sv_t*) dtl_av_value(av, 2), NULL), 0.0);
+   dtl_av_clear(av);
+
+   dtl_av_push(av, (dtl_dv_t*) dtl_sv_make_u64(UINT64_MAX), false);
+   dtl_av_push(av, (dtl_dv_t*) dtl_sv_make_u64(0u), false);
+   dtl_av_push(av, (dtl_dv_t*) dtl_sv_make_u64(((uint64_t) 1u) << 63), false);
+   CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_av_sort(av, NULL, false));
+   CuAssertTrue(tc, dtl_sv_to_u64((dtl_sv_t*) dtl_av_value(av, 0), NULL) == 0u);
+   CuAssertTrue(tc, dtl_sv_to_u64((dtl_sv_t*) dtl_av_value(av, 2), NULL) == UINT64_MAX);
+   dtl_av_clear(av);
+
+   //strings compare by bytes, a prefix sorts first, inline and heap strings mix
+   dtl_av_push(av, (dtl_dv_t*) dtl_sv_make_cstr("abc"), false);
+   dtl_av_push(av, (dtl_dv_t*) dtl_sv_make_cstr("ab"), false);
+   dtl_av_push(av, (dtl_dv_t*) dtl_sv_make_cstr("abc, but longer than an inline string"), false);
+   dtl_av_push(av, (dtl_dv_t*) dtl_sv_make_cstr(""), false);
+   CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_av_sort(av, NULL, false));
+   CuAssertStrEquals(tc, "", dtl_sv_to_cstr((dtl_sv_t*) dtl_av_value(av, 0), &ok));
+   CuAssertStrEquals(tc, "ab", dtl_sv_to_cstr((dtl_sv_t*) dtl_av_value(av, 1), &ok));
+   CuAssertStrEquals(tc, "abc", dtl_sv_to_cstr((dtl_sv_t*) dtl_av_value(av, 2), &ok));
+   CuAssertStrEquals(tc, "abc, but longer than an inline string", dtl_sv_to_cstr((dtl_sv_t*) dtl_av_value(av, 3), &ok));
+   dtl_av_clear(av);
+
+   dtl_av_push(av, (dtl_dv_t*) dtl_sv_make_bool(true), false);
+   dtl_av_push(av, (dtl_dv_t*) dtl_sv_make_bool(false), false);
+   CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_av_sort(av, NULL, false));
+   CuAssertTrue(tc, !dtl_sv_to_bool((dtl_sv_t*) dtl_av_value(av, 0), NULL));
+   dtl_av_clear(av);
+
+   //numbers of different types sort together by their exact value
+   dtl_av_push(av, (dtl_dv_t*) dtl_sv_make_u64(UINT64_MAX), false);
+   dtl_av_push(av, (dtl_dv_t*) dtl_sv_make_i32(3), false);
+   dtl_av_push(av, (dtl_dv_t*) dtl_sv_make_dbl(9007199254740992.0), false);
+   dtl_av_push(av, (dtl_dv_t*) dtl_sv_make_i64(9007199254740993), false);
+   dtl_av_push(av, (dtl_dv_t*) dtl_sv_make_flt(2.5f), false);
+   dtl_av_push(av, (dtl_dv_t*) dtl_sv_make_i64(-5), false);
+   dtl_av_push(av, (dtl_dv_t*) dtl_sv_make_u32(3u), false);
+   CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_av_sort(av, NULL, false));
+   CuAssertIntEquals(tc, -5, dtl_sv_to_i32((dtl_sv_t*) dtl_av_value(av, 0), NULL));
+   CuAssertIntEquals(tc, DTL_SV_FLT, dtl_sv_type((dtl_sv_t*) dtl_av_value(av, 1)));
+   CuAssertIntEquals(tc, DTL_SV_I32, dtl_sv_type((dtl_sv_t*) dtl_av_value(av, 2))); //equal to the u32, keeps its place
+   CuAssertIntEquals(tc, DTL_SV_U32, dtl_sv_type((dtl_sv_t*) dtl_av_value(av, 3)));
+   CuAssertIntEquals(tc, DTL_SV_DBL, dtl_sv_type((dtl_sv_t*) dtl_av_value(av, 4)));
+   CuAssertIntEquals(tc, DTL_SV_I64, dtl_sv_type((dtl_sv_t*) dtl_av_value(av, 5)));
+   CuAssertIntEquals(tc, DTL_SV_U64, dtl_sv_type((dtl_sv_t*) dtl_av_value(av, 6)));
+   dtl_dec_ref(av);
+}
+
+static void test_dtl_av_sort_errors(CuTest* tc)
+{
+   dtl_av_t *av = dtl_av_new();
+   dtl_dv_t *first = (dtl_dv_t*) dtl_sv_make_i32(3);
+   dtl_dv_t *second = (dtl_dv_t*) dtl_sv_make_i32(1);
+   dtl_dv_t *third = (dtl_dv_t*) dtl_sv_make_cstr("2");
+   CuAssertIntEquals(tc, DTL_INVALID_ARGUMENT_ERROR, dtl_av_sort(NULL, NULL, false));
+   CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_av_sort(av, NULL, false)); //empty
 
+   //numbers and strings cannot be ordered by dtl_sv_cmp, the array stays as it was
+   dtl_av_push(av, first, false);
+   dtl_av_push(av, second, false);
+   dtl_av_push(av, third, false);
+   CuAssertIntEquals(tc, DTL_TYPE_ERROR, dtl_av_sort(av, NULL, false));
+   CuAssertPtrEquals(tc, first, dtl_av_value(av, 0));
+   CuAssertPtrEquals(tc, second, dtl_av_value(av, 1));
+   CuAssertPtrEquals(tc, third, dtl_av_value(av, 2));
+   dtl_av_clear(av);
+
+   //arrays need a key function to be sorted by one of their fields
+   dtl_av_push(av, (dtl_dv_t*) dtl_av_new(), false);
+   dtl_av_push(av, (dtl_dv_t*) dtl_av_new(), false);
+   CuAssertIntEquals(tc, DTL_TYPE_ERROR, dtl_av_sort(av, NULL, false));
+   CuAssertIntEquals(tc, DTL_TYPE_ERROR, dtl_av_sort(av, record_key, false)); //no "group" field
+   dtl_dec_ref(av);
+}
+
+/**
+ * Arrays long enough for the radix sort: full range 64-bit integers and doubles with signed zeros, infinities and NaN.
+ */
+static void test_dtl_av_sort_radix_numbers(CuTest* tc)
+{
+   int64_t values[1000];
+   dtl_dv_t *zeros[4];
+   dtl_av_t *av = dtl_av_new();
+   uint64_t seed = 4711u;
+   int32_t numZeros = 0;
+   int32_t i;
+   for (i = 0; i < 1000; i++)
+   {
+      seed = seed * 6364136223846793005u + 1442695040888963407u;
+      switch (i % 4)
+      {
+      case 0: values[i] = (int64_t) seed; break;
+      case 1: values[i] = (int64_t) (seed >> 40) - 8000000; break;
+      case 2: values[i] = (i % 8 == 2)? INT64_MIN : INT64_MAX; break;
+      default: values[i] = (int64_t) (seed >> 60); break; //many duplicates
+      }
+      dtl_av_push(av, (dtl_dv_t*) dtl_sv_make_i64(values[i]), false);
+   }
+   qsort(values, 1000, sizeof(int64_t), compare_i64);
+   CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_av_sort(av, NULL, false));
+   for (i = 0; i < 1000; i++)
+   {
+      CuAssertTrue(tc, values[i] == dtl_sv_to_i64((dtl_sv_t*) dtl_av_value(av, i), NULL));
+   }
+   CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_av_sort(av, NULL, true));
+   for (i = 0; i < 1000; i++)
+   {
+      CuAssertTrue(tc, values[999 - i] == dtl_sv_to_i64((dtl_sv_t*) dtl_av_value(av, i), NULL));
+   }
+   dtl_av_clear(av);
+
+   //-0.0 and 0.0 are equal and keep their order
+   for (i = 0; i < 1000; i++)
+   {
+      dtl_dv_t *dv;
+      seed = seed * 6364136223846793005u + 1442695040888963407u;
+      switch (i % 250)
+      {
+      case 0: case 1: case 2: case 3:
+         dv = (dtl_dv_t*) dtl_sv_make_dbl(((i / 250) % 2 == 0)? -0.0 : 0.0);
+         if ((i % 250) == 0)
+         {
+            zeros[numZeros++] = dv;
+         }
+         break;
+      case 4: dv = (dtl_dv_t*) dtl_sv_make_dbl((i < 500)? HUGE_VAL : -HUGE_VAL); break;
+      case 5: dv = (dtl_dv_t*) dtl_sv_make_dbl(-4.9e-324); break;
+      default: dv = (dtl_dv_t*) dtl_sv_make_dbl(((double) (int64_t) seed) / 1e9); break;
+      }
+      dtl_av_push(av, dv, false);
+   }
+   CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_av_sort(av, NULL, false));
+   numZeros = 0;
+   for (i = 0; i < 1000; i++)
+   {
+      dtl_dv_t *dv = dtl_av_value(av, i);
+      if (i > 0)
+      {
+         CuAssertTrue(tc, dtl_sv_to_dbl((dtl_sv_t*) dtl_av_value(av, i - 1), NULL) <= dtl_sv_to_dbl((dtl_sv_t*) dv, NULL));
+      }
+      if ( (numZeros < 4) && (dv == zeros[numZeros]) )
+      {
+         numZeros++;
+      }
+   }
+   CuAssertIntEquals(tc, 4, numZeros);
+   CuAssertTrue(tc, dtl_sv_to_dbl((dtl_sv_t*) dtl_av_value(av, 0), NULL) == -HUGE_VAL);
+
+   //NaN goes after all other numbers, first in a descending sort
+   dtl_av_push(av, (dtl_dv_t*) dtl_sv_make_dbl(NAN), false);
+   dtl_av_push(av, (dtl_dv_t*) dtl_sv_make_dbl(HUGE_VAL), false);
+   CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_av_sort(av, NULL, false));
+   CuAssertTrue(tc, isnan(dtl_sv_to_dbl((dtl_sv_t*) dtl_av_value(av, 1001), NULL)));
+   CuAssertTrue(tc, dtl_sv_to_dbl((dtl_sv_t*) dtl_av_value(av, 1000), NULL) == HUGE_VAL);
+   CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_av_sort(av, NULL, true));
+   CuAssertTrue(tc, isnan(dtl_sv_to_dbl((dtl_sv_t*) dtl_av_value(av, 0), NULL)));
+   CuAssertTrue(tc, dtl_sv_to_dbl((dtl_sv_t*) dtl_av_value(av, 1001), NULL) == -HUGE_VAL);
+   dtl_av_clear(av);
+   dtl_av_push(av, (dtl_dv_t*) dtl_sv_make_dbl(2.0), false);
+   dtl_av_push(av, (dtl_dv_t*) dtl_sv_make_dbl(NAN), false);
+   dtl_av_push(av, (dtl_dv_t*) dtl_sv_make_dbl(1.0), false);
+   CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_av_sort(av, NULL, false));
+   CuAssertDblEquals(tc, 1.0, dtl_sv_to_dbl((dtl_sv_t*) dtl_av_value(av, 0), NULL), 0.0);
+   CuAssertTrue(tc, isnan(dtl_sv_to_dbl((dtl_sv_t*) dtl_av_value(av, 2), NULL)));
+   dtl_dec_ref(av);
+}
+
+/**
+ * Strings with shared prefixes, empty strings and bytes above 0x7F, sorted directly and by a key, compared with strcmp.
+ */
+static void test_dtl_av_sort_radix_strings(CuTest* tc)
+{
+   static const char *prefixes[5] = {"", "a", "\xC3\xA9t\xC3\xA9", "a/long/shared/prefix/that/is/not/inline/", "\x7F"};
+   char names[1500][64];
+   const char *expected[1500];
+   dtl_av_t *av = dtl_av_new();
+   dtl_av_t *records = dtl_av_new();
+   uint32_t seed = 99u;
+   bool ok = false;
+   int32_t i;
+   for (i = 0; i < 1500; i++)
+   {
+      dtl_hv_t *hv = dtl_hv_new();
+      seed = seed * 1103515245u + 12345u;
+      if ((seed >> 16) % 7u == 0u)
+      {
+         strcpy(names[i], prefixes[(seed >> 8) % 5u]);
+      }
+      else
+      {
+         sprintf(names[i], "%s%u", prefixes[(seed >> 8) % 5u], (seed >> 12) % 300u);
+      }
+      expected[i] = names[i];
+      dtl_av_push(av, (dtl_dv_t*) dtl_sv_make_cstr(names[i]), false);
+      dtl_hv_set_cstr(hv, "name", (dtl_dv_t*) dtl_sv_make_cstr(names[i]), false);
+      dtl_hv_set_cstr(hv, "seq", (dtl_dv_t*) dtl_sv_make_i32(i), false);
+      dtl_av_push(records, (dtl_dv_t*) hv, false);
+   }
+   qsort((void*) expected, 1500, sizeof(const char*), compare_cstr);
+   CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_av_sort(av, NULL, false));
+   for (i = 0; i < 1500; i++)
+   {
+      CuAssertStrEquals(tc, expected[i], dtl_sv_to_cstr((dtl_sv_t*) dtl_av_value(av, i), &ok));
+   }
+   CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_av_sort(av, NULL, true));
+   for (i = 0; i < 1500; i++)
+   {
+      CuAssertStrEquals(tc, expected[1499 - i], dtl_sv_to_cstr((dtl_sv_t*) dtl_av_value(av, i), &ok));
+   }
+
+   //equal names keep their order in both directions
+   CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_av_sort(records, record_name_key, true));
+   CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_av_sort(records, record_name_key, false));
+   for (i = 0; i < 1500; i++)
+   {
+      dtl_hv_t *cur = (dtl_hv_t*) dtl_av_value(records, i);
+      CuAssertStrEquals(tc, expected[i], dtl_sv_to_cstr((dtl_sv_t*) dtl_hv_get_cstr(cur, "name"), &ok));
+      if (i > 0)
+      {
+         dtl_hv_t *prev = (dtl_hv_t*) dtl_av_value(records, i - 1);
+         if (strcmp(expected[i - 1], expected[i]) == 0)
+         {
+            CuAssertTrue(tc, dtl_sv_to_i32((dtl_sv_t*) dtl_hv_get_cstr(prev, "seq"), NULL) <
+                             dtl_sv_to_i32((dtl_sv_t*) dtl_hv_get_cstr(cur, "seq"), NULL));
+         }
+      }
+   }
+   dtl_dec_ref(av);
+   dtl_dec_ref(records);
+}
+
+/**
+ * The parallel sort gives exactly the order of the serial one, equal values included, for any number of threads.
+ */
+static void test_dtl_av_sort_parallel(CuTest* tc)
+{
+   static const uint32_t threadCounts[4] = {1u, 2u, 3u, 8u};
+   const int32_t count = 100000;
+   dtl_dv_t **values = (dtl_dv_t**) malloc(count * sizeof(dtl_dv_t*));
+   dtl_av_t *expected = dtl_av_new();
+   uint32_t seed = 777u;
+   int32_t reverse;
+   int32_t i;
+   CuAssertPtrNotNull(tc, values);
+   for (i = 0; i < count; i++)
+   {
+      seed = seed * 1103515245u + 12345u;
+      //many duplicates, and a sorted stretch
+      values[i] = (dtl_dv_t*) dtl_sv_make_i32((i < 30000)? i / 4 : (int32_t) ((seed >> 8) % 5000u) - 2500);
+   }
+   for (reverse = 0; reverse < 2; reverse++)
+   {
+      uint32_t t;
+      for (i = 0; i < count; i++)
+      {
+         dtl_av_push(expected, values[i], true);
+      }
+      CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_av_sort(expected, NULL, reverse != 0));
+      for (t = 0u; t < 4u; t++)
+      {
+         dtl_av_t *av = dtl_av_new();
+         for (i = 0; i < count; i++)
+         {
+            dtl_av_push(av, values[i], true);
+         }
+         CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_av_sort_parallel(av, NULL, reverse != 0, threadCounts[t]));
+         for (i = 0; i < count; i++)
+         {
+            CuAssertPtrEquals(tc, dtl_av_value(expected, i), dtl_av_value(av, i));
+         }
+         dtl_dec_ref(av);
+      }
+      dtl_av_clear(expected);
+   }
+
+   //mixed types are reported and leave the array unchanged
+   for (i = 0; i < count; i++)
+   {
+      dtl_av_push(expected, values[i], true);
+   }
+   dtl_av_push(expected, (dtl_dv_t*) dtl_sv_make_cstr("not a number"), false);
+   CuAssertIntEquals(tc, DTL_TYPE_ERROR, dtl_av_sort_parallel(expected, NULL, false, 4u));
+   for (i = 0; i < count; i++)
+   {
+      CuAssertPtrEquals(tc, values[i], dtl_av_value(expected, i));
+   }
+   CuAssertIntEquals(tc, DTL_INVALID_ARGUMENT_ERROR, dtl_av_sort_parallel(NULL, NULL, false, 4u));
+   dtl_dv_freeze((dtl_dv_t*) expected);
+   CuAssertIntEquals(tc, DTL_FROZEN_ERROR, dtl_av_sort_parallel(expected, NULL, false, 4u));
+   dtl_dec_ref(expected);
+   for (i = 0; i < count; i++)
+   {
+      dtl_dec_ref(values[i]);
+   }
+   free(values);
+}
+
+static dtl_dv_t *record_key(const dtl_dv_t *dv)
+{
+   return (dtl_dv_type(dv) == DTL_DV_HASH)? dtl_hv_get_cstr((const dtl_hv_t*) dv, "group") : NULL;
+}
+
+static dtl_dv_t *record_name_key(const dtl_dv_t *dv)
+{
+   return (dtl_dv_type(dv) == DTL_DV_HASH)? dtl_hv_get_cstr((const dtl_hv_t*) dv, "name") : NULL;
+}
+
+static int compare_i32(const void *a, const void *b)
+{
+   int32_t left = *(const int32_t*) a;
+   int32_t right = *(const int32_t*) b;
+   return (left > right) - (left < right);
+}
+
+static int compare_i64(const void *a, const void *b)
+{
+   int64_t left = *(const int64_t*) a;
+   int64_t right = *(const int64_t*) b;
+   return (left > right) - (left < right);
+}
+
+static int compare_cstr(const void *a, const void *b)
+{
+   return strcmp(*(const char* const*) a, *(const char* const*) b);
+}
@@ -6,24 +6,403 @@
 #include <time.h>
 #include "CuTest.h"
 #include "dtl_sv.h"
+#include "dtl_av.h"
+#include "dtl_hv.h"
+#include "dtl_thread.h"
 #include "CMemLeak.h"
 
+#define SHARED_NUM_THREADS	4
+#define SHARED_NUM_KEYS		64
+#define SHARED_ROUNDS		300
+#define DEEP_NESTING		200000 //far more stack than available if values were freed recursively
+
+typedef struct shared_worker_tag{
+	dtl_hv_t *hv;
+	int32_t s32Sum;
+} shared_worker_t;
+
+typedef struct handoff_worker_tag{
+	dtl_dv_t *dv;     //reference handed to the worker, released there
+	dtl_dv_t *keep;   //the worker takes a reference and leaves it to the creator to release
+	dtl_dv_t *result; //value created by the worker, handed back
+	int *pCount;
+} handoff_worker_t;
+
+static void run_shared_workers(CuTest* tc, bool freeze);
+static dtl_thread_ret_t DTL_THREAD_CALL shared_worker(void *arg);
+static dtl_thread_ret_t DTL_THREAD_CALL handoff_worker(void *arg);
+static void count_destructor(void *arg);
+
 
 void test_dtl_dv_null(CuTest* tc){
 	dtl_dv_t *dv = dtl_dv_null();
 	CuAssertPtrNotNull(tc,dv);
-	CuAssertIntEquals(tc,DTL_DV_NULL,dv->u32Flags);
+	CuAssertIntEquals(tc,DTL_DV_NULL,dv->u32Flags & ~DTL_DV_OWNER_MASK);
 	CuAssertIntEquals(tc,1,dv->u32RefCnt);
 	dtl_dec_ref(dv);
 }
 
+void test_dtl_dv_set_atomic(CuTest* tc){
+	dtl_hv_t *hv = dtl_hv_new();
+	dtl_av_t *av = dtl_av_new();
+	dtl_sv_t *sv = dtl_sv_make_i32(1000);
+	dtl_sv_t *ref = dtl_sv_new();
+	dtl_av_push(av, (dtl_dv_t*) sv, false);
+	dtl_av_push(av, (dtl_dv_t*) dtl_sv_const_bool(true), false);
+	dtl_sv_set_dv(ref, (dtl_dv_t*) dtl_hv_new(), false);
+	dtl_hv_set_cstr(hv, "list", (dtl_dv_t*) av, false);
+	dtl_hv_set_cstr(hv, "ref", (dtl_dv_t*) ref, false);
+	dtl_hv_set_cstr(hv, "null", dtl_dv_const_null(), false);
+
+	dtl_dv_set_atomic((dtl_dv_t*) hv);
+#ifndef DTL_BIASED_REFCNT
+	CuAssertTrue(tc, (hv->u32Flags & DTL_DV_FLAG_ATOMIC) != 0u);
+	CuAssertTrue(tc, (av->u32Flags & DTL_DV_FLAG_ATOMIC) != 0u);
+	CuAssertTrue(tc, (sv->u32Flags & DTL_DV_FLAG_ATOMIC) != 0u);
+	CuAssertTrue(tc, (ref->u32Flags & DTL_DV_FLAG_ATOMIC) != 0u);
+	CuAssertTrue(tc, (ref->svx.val.dv->u32Flags & DTL_DV_FLAG_ATOMIC) != 0u);
+#endif
+	CuAssertTrue(tc, (dtl_sv_const_bool(true)->u32Flags & DTL_DV_FLAG_ATOMIC) == 0u);
+	CuAssertTrue(tc, (dtl_dv_const_null()->u32Flags & DTL_DV_FLAG_ATOMIC) == 0u);
+	CuAssertIntEquals(tc, DTL_DV_HASH, dtl_dv_type((dtl_dv_t*) hv));
+	CuAssertIntEquals(tc, DTL_SV_I32, dtl_sv_type(sv));
+
+	//reference counting works as before
+	dtl_inc_ref(sv);
+	CuAssertIntEquals(tc, 2, dtl_ref_cnt(sv));
+	dtl_dec_ref(sv);
+	CuAssertIntEquals(tc, 1, dtl_ref_cnt(sv));
+	//atomic scalars do not write to their dual-value cache
+	CuAssertStrEquals(tc, "1000", dtl_sv_to_cstr(sv, NULL));
+	CuAssertIntEquals(tc, 0, (int) (sv->u32Flags & DTL_DV_CACHE_MASK));
+	dtl_dec_ref(hv);
+}
+
+void test_dtl_dv_atomic_threads(CuTest* tc){
+	run_shared_workers(tc, false);
+}
+
+void test_dtl_dv_freeze(CuTest* tc){
+	dtl_hv_t *hv = dtl_hv_new();
+	dtl_av_t *av = dtl_av_new();
+	dtl_sv_t *num = dtl_sv_make_i32(1000);
+	dtl_sv_t *str = dtl_sv_make_cstr("123");
+	dtl_sv_t *ref = dtl_sv_new();
+	dtl_hv_t *inner = dtl_hv_new();
+	dtl_av_push(av, (dtl_dv_t*) num, false);
+	dtl_av_push(av, (dtl_dv_t*) str, false);
+	dtl_hv_set_cstr(inner, "x", (dtl_dv_t*) dtl_sv_make_dbl(0.5), false);
+	dtl_sv_set_dv(ref, (dtl_dv_t*) inner, false);
+	dtl_hv_set_cstr(hv, "list", (dtl_dv_t*) av, false);
+	dtl_hv_set_cstr(hv, "ref", (dtl_dv_t*) ref, false);
+	CuAssertTrue(tc, !dtl_dv_is_frozen((dtl_dv_t*) hv));
+
+	dtl_dv_freeze((dtl_dv_t*) hv);
+	CuAssertTrue(tc, dtl_dv_is_frozen((dtl_dv_t*) hv));
+	CuAssertTrue(tc, dtl_dv_is_frozen((dtl_dv_t*) av));
+	CuAssertTrue(tc, dtl_dv_is_frozen((dtl_dv_t*) str));
+	CuAssertTrue(tc, dtl_dv_is_frozen((dtl_dv_t*) ref));
+	CuAssertTrue(tc, dtl_dv_is_frozen(dtl_hv_get_cstr(inner, "x")));
+	CuAssertTrue(tc, !dtl_dv_is_frozen((dtl_dv_t*) 0));
+#ifndef DTL_BIASED_REFCNT
+	CuAssertTrue(tc, (num->u32Flags & DTL_DV_FLAG_ATOMIC) != 0u);
+	CuAssertTrue(tc, (inner->u32Flags & DTL_DV_FLAG_ATOMIC) != 0u);
+#endif
+
+	//setters leave frozen values unchanged
+	dtl_sv_set_i32(num, 7);
+	dtl_sv_set_cstr(str, "abc");
+	dtl_sv_set_dv(ref, (dtl_dv_t*) 0, false);
+	dtl_av_push(av, (dtl_dv_t*) dtl_sv_const_bool(true), false);
+	dtl_av_clear(av);
+	dtl_hv_set_cstr(hv, "list", (dtl_dv_t*) dtl_sv_const_bool(false), false);
+	CuAssertPtrEquals(tc, (void*) 0, dtl_av_pop(av));
+	dtl_inc_ref(num); //dtl_av_set takes over a reference, which is released again
+	CuAssertPtrEquals(tc, (void*) 0, dtl_av_set(av, 0, (dtl_dv_t*) num));
+	CuAssertPtrEquals(tc, (void*) 0, dtl_hv_remove_cstr(hv, "ref"));
+	CuAssertIntEquals(tc, DTL_FROZEN_ERROR, dtl_av_sort(av, (dtl_key_func_t*) 0, false));
+	CuAssertIntEquals(tc, 1000, dtl_sv_to_i32(num, NULL));
+	CuAssertPtrEquals(tc, inner, dtl_sv_to_hv(ref));
+	CuAssertIntEquals(tc, 2, dtl_av_length(av));
+	CuAssertPtrEquals(tc, av, dtl_hv_get_cstr(hv, "list"));
+	CuAssertIntEquals(tc, 2, (int) dtl_hv_length(hv));
+
+	//reads do not write to the dual-value cache
+	CuAssertStrEquals(tc, "1000", dtl_sv_to_cstr(num, NULL));
+	CuAssertIntEquals(tc, 123, dtl_sv_to_i32(str, NULL));
+	CuAssertIntEquals(tc, 0, (int) (num->u32Flags & DTL_DV_CACHE_MASK));
+	CuAssertIntEquals(tc, 0, (int) (str->u32Flags & DTL_DV_CACHE_MASK));
+
+	//shared constants are frozen too
+	CuAssertTrue(tc, dtl_dv_is_frozen((dtl_dv_t*) dtl_sv_const_i32(5)));
+	dtl_sv_set_i32(dtl_sv_const_i32(5), 6);
+	CuAssertIntEquals(tc, 5, dtl_sv_to_i32(dtl_sv_const_i32(5), NULL));
+
+	//a frozen value can be placed in a mutable container
+	inner = dtl_hv_new();
+	dtl_hv_set_cstr(inner, "frozen", (dtl_dv_t*) hv, false);
+	dtl_hv_set_cstr(inner, "other", (dtl_dv_t*) dtl_sv_make_i32(1), false);
+	CuAssertIntEquals(tc, 2, (int) dtl_hv_length(inner));
+	dtl_dec_ref(inner);
+}
+
+void test_dtl_dv_frozen_setters_release(CuTest* tc){
+	dtl_av_t *av = dtl_av_new();
+	dtl_hv_t *hv = dtl_hv_new();
+	dtl_sv_t *sv = dtl_sv_new();
+	dtl_sv_t *kept = dtl_sv_make_ptr((void*) 0, (void (*)(void*)) 0);
+	int count = 0;
+	dtl_av_push(av, (dtl_dv_t*) dtl_sv_make_i32(1), false);
+	dtl_dv_freeze((dtl_dv_t*) av);
+	dtl_dv_freeze((dtl_dv_t*) hv);
+	dtl_dv_freeze((dtl_dv_t*) sv);
+
+	//the reference handed over to a setter is released when the container is frozen
+	dtl_av_push(av, (dtl_dv_t*) dtl_sv_make_ptr(&count, count_destructor), false);
+	CuAssertIntEquals(tc, 1, count);
+	dtl_av_unshift(av, (dtl_dv_t*) dtl_sv_make_ptr(&count, count_destructor));
+	CuAssertIntEquals(tc, 2, count);
+	CuAssertPtrEquals(tc, (void*) 0, dtl_av_set(av, 0, (dtl_dv_t*) dtl_sv_make_ptr(&count, count_destructor)));
+	CuAssertIntEquals(tc, 3, count);
+	dtl_hv_set_cstr(hv, "a", (dtl_dv_t*) dtl_sv_make_ptr(&count, count_destructor), false);
+	CuAssertIntEquals(tc, 4, count);
+	dtl_hv_set_bstr(hv, (const uint8_t*) "b", (const uint8_t*) "b" + 1, (dtl_dv_t*) dtl_sv_make_ptr(&count, count_destructor), false);
+	CuAssertIntEquals(tc, 5, count);
+	dtl_sv_set_dv(sv, (dtl_dv_t*) dtl_sv_make_ptr(&count, count_destructor), false);
+	CuAssertIntEquals(tc, 6, count);
+
+	//with autoIncrementRef the caller keeps its reference
+	dtl_av_push(av, (dtl_dv_t*) kept, true);
+	dtl_hv_set_cstr(hv, "a", (dtl_dv_t*) kept, true);
+	CuAssertUIntEquals(tc, 1u, dtl_ref_cnt(kept));
+	CuAssertIntEquals(tc, 1, dtl_av_length(av));
+	CuAssertUIntEquals(tc, 0u, dtl_hv_length(hv));
+	dtl_dec_ref(kept);
+	dtl_dec_ref(av);
+	dtl_dec_ref(hv);
+	dtl_dec_ref(sv);
+}
+
+void test_dtl_dv_frozen_threads(CuTest* tc){
+	run_shared_workers(tc, true);
+}
+
+static void run_shared_workers(CuTest* tc, bool freeze){
+	dtl_thread_t threads[SHARED_NUM_THREADS];
+	shared_worker_t workers[SHARED_NUM_THREADS];
+	dtl_hv_t *hv = dtl_hv_new();
+	char key[16];
+	int32_t s32Expected = 0;
+	int32_t i;
+	for(i=0;i<SHARED_NUM_KEYS;i++){
+		char text[16];
+		sprintf(key, "key%d", (int) i);
+		sprintf(text, "%d", (int) i);
+		if( (i & 1) == 0 ){
+			dtl_hv_set_cstr(hv, key, (dtl_dv_t*) dtl_sv_make_cstr(text), false);
+		}
+		else{
+			dtl_av_t *av = dtl_av_new();
+			dtl_av_push(av, (dtl_dv_t*) dtl_sv_make_i32(i), false);
+			dtl_hv_set_cstr(hv, key, (dtl_dv_t*) av, false);
+		}
+		s32Expected += i;
+	}
+	if(freeze){
+		dtl_dv_freeze((dtl_dv_t*) hv);
+	}
+	else{
+		dtl_dv_set_atomic((dtl_dv_t*) hv);
+	}
+
+	//each worker owns one reference to the tree, the last one to finish frees it
+	for(i=0;i<SHARED_NUM_THREADS;i++){
+		workers[i].hv = hv;
+		workers[i].s32Sum = 0;
+		dtl_inc_ref(hv);
+		CuAssertIntEquals(tc, 0, dtl_thread_create(&threads[i], shared_worker, &workers[i]));
+	}
+	dtl_dec_ref(hv);
+	for(i=0;i<SHARED_NUM_THREADS;i++){
+		dtl_thread_join(threads[i]);
+		CuAssertIntEquals(tc, s32Expected * SHARED_ROUNDS, workers[i].s32Sum);
+	}
+}
+
+/*
+ * Values released in a thread other than the one that created them:
+ * reference moved to another thread, creator releasing first, and creator thread exiting first.
+ */
+void test_dtl_dv_handoff(CuTest* tc){
+	dtl_thread_t thread;
+	handoff_worker_t worker;
+	dtl_dv_t *dv;
+	int count = 0;
+
+	worker.pCount = &count;
+	worker.dv = (dtl_dv_t*) dtl_sv_make_ptr(&count, count_destructor);
+	worker.keep = (dtl_dv_t*) dtl_sv_make_ptr(&count, count_destructor);
+	worker.result = (dtl_dv_t*) 0;
+	dtl_dv_set_atomic(worker.dv);
+	dtl_dv_set_atomic(worker.keep);
+	CuAssertIntEquals(tc, 0, dtl_thread_create(&thread, handoff_worker, &worker));
+	dtl_thread_join(thread);
+	dtl_dv_refcnt_merge();
+	CuAssertIntEquals(tc, 1, count);
+
+	//the worker still holds a reference to keep
+	dtl_dec_ref(worker.keep);
+	CuAssertIntEquals(tc, 1, count);
+	dtl_dec_ref(worker.keep);
+	CuAssertIntEquals(tc, 2, count);
+
+	//the thread that created result has exited
+	dv = worker.result;
+	CuAssertPtrNotNull(tc, dv);
+	dtl_inc_ref(dv);
+	dtl_dec_ref(dv);
+	CuAssertIntEquals(tc, 2, count);
+	dtl_dec_ref(dv);
+	CuAssertIntEquals(tc, 3, count);
+}
+
+void test_dtl_dv_deep_nesting(CuTest* tc){
+	dtl_av_t *root = dtl_av_new();
+	dtl_av_t *av = root;
+	dtl_hv_t *hv;
+	int count = 0;
+	int32_t i;
+	for(i=0;i<DEEP_NESTING;i++){
+		dtl_av_t *child = dtl_av_new();
+		dtl_av_push(av, (dtl_dv_t*) child, false);
+		av = child;
+	}
+	dtl_av_push(av, (dtl_dv_t*) dtl_sv_make_ptr(&count, count_destructor), false);
+	hv = dtl_hv_new();
+	dtl_hv_set_cstr(hv, "deep", (dtl_dv_t*) root, false);
+	dtl_dec_ref(hv);
+	CuAssertIntEquals(tc, 1, count);
+	CuAssertUIntEquals(tc, 0u, dtl_reclaim_pending());
+}
+
+void test_dtl_dv_freeze_deep_nesting(CuTest* tc){
+	dtl_av_t *root = dtl_av_new();
+	dtl_av_t *av = root;
+	dtl_sv_t *leaf = dtl_sv_make_i32(1);
+	int32_t i;
+	for(i=0;i<DEEP_NESTING;i++){
+		dtl_av_t *child = dtl_av_new();
+		if( (i % 2) == 0 ){
+			dtl_av_push(av, (dtl_dv_t*) child, false);
+		}
+		else{
+			//every other level goes through a scalar reference
+			dtl_av_push(av, (dtl_dv_t*) dtl_sv_make_dv((dtl_dv_t*) child, false), false);
+		}
+		av = child;
+	}
+	dtl_av_push(av, (dtl_dv_t*) leaf, false);
+	dtl_dv_set_atomic((dtl_dv_t*) root);
+	dtl_dv_freeze((dtl_dv_t*) root);
+	CuAssertTrue(tc, dtl_dv_is_frozen((dtl_dv_t*) root));
+	CuAssertTrue(tc, dtl_dv_is_frozen((dtl_dv_t*) av));
+	CuAssertTrue(tc, dtl_dv_is_frozen((dtl_dv_t*) leaf));
+	dtl_dec_ref(root);
+	CuAssertUIntEquals(tc, 0u, dtl_reclaim_pending());
+}
+
+void test_dtl_dv_deferred_reclaim(CuTest* tc){
+	dtl_av_t *av = dtl_av_new();
+	int count = 0;
+	int32_t i;
+	for(i=0;i<10;i++){
+		dtl_av_push(av, (dtl_dv_t*) dtl_sv_make_ptr(&count, count_destructor), false);
+	}
+	dtl_reclaim_set_deferred(true);
+	dtl_dec_ref(av);
+	CuAssertIntEquals(tc, 0, count);
+	CuAssertUIntEquals(tc, 1u, dtl_reclaim_pending());
+	CuAssertUIntEquals(tc, 1u, dtl_reclaim(1u));
+	CuAssertIntEquals(tc, 0, count);
+	CuAssertUIntEquals(tc, 10u, dtl_reclaim_pending());
+	CuAssertUIntEquals(tc, 3u, dtl_reclaim(3u));
+	CuAssertIntEquals(tc, 3, count);
+	CuAssertUIntEquals(tc, 7u, dtl_reclaim(100u));
+	CuAssertIntEquals(tc, 10, count);
+	CuAssertUIntEquals(tc, 0u, dtl_reclaim_pending());
+	CuAssertUIntEquals(tc, 0u, dtl_reclaim(100u));
+
+	//pending values are freed by the next release once deferred mode is off
+	dtl_dec_ref(dtl_sv_make_ptr(&count, count_destructor));
+	CuAssertIntEquals(tc, 10, count);
+	dtl_reclaim_set_deferred(false);
+	dtl_dec_ref(dtl_sv_make_ptr(&count, count_destructor));
+	CuAssertIntEquals(tc, 12, count);
+	CuAssertUIntEquals(tc, 0u, dtl_reclaim_pending());
+}
 
+static dtl_thread_ret_t DTL_THREAD_CALL handoff_worker(void *arg){
+	handoff_worker_t *worker = (handoff_worker_t*) arg;
+	dtl_sv_t *sv = dtl_sv_make_ptr(worker->pCount, count_destructor);
+	dtl_av_t *av = dtl_av_new();
+	dtl_dv_inc_ref(worker->dv);
+	dtl_av_push(av, worker->dv, false);
+	dtl_dv_dec_ref(worker->dv);
+	dtl_dec_ref(av);
+	dtl_dv_inc_ref(worker->keep);
+	dtl_dv_set_atomic((dtl_dv_t*) sv);
+	worker->result = (dtl_dv_t*) sv;
+	return (dtl_thread_ret_t) 0;
+}
+
+static void count_destructor(void *arg){
+	(*(int*) arg)++;
+}
+
+static dtl_thread_ret_t DTL_THREAD_CALL shared_worker(void *arg){
+	shared_worker_t *worker = (shared_worker_t*) arg;
+	dtl_dv_t *held[SHARED_NUM_KEYS];
+	char key[16];
+	int32_t i;
+	for(i=0;i<SHARED_ROUNDS * SHARED_NUM_KEYS;i++){
+		int32_t s32Index = i % SHARED_NUM_KEYS;
+		dtl_dv_t *dv;
+		sprintf(key, "key%d", (int) s32Index);
+		dv = dtl_hv_get_cstr(worker->hv, key);
+		dtl_dv_inc_ref(dv);
+		held[s32Index] = dv;
+		if(dtl_dv_type(dv) == DTL_DV_SCALAR){
+			worker->s32Sum += dtl_sv_to_i32((dtl_sv_t*) dv, NULL);
+		}
+		else{
+			//numbers are read through their text, which must not be cached in a shared scalar
+			worker->s32Sum += atoi(dtl_sv_to_cstr((dtl_sv_t*) dtl_av_value((dtl_av_t*) dv, 0), NULL));
+		}
+		if(s32Index == SHARED_NUM_KEYS - 1){
+			int32_t j;
+			for(j=0;j<SHARED_NUM_KEYS;j++){
+				dtl_dv_dec_ref(held[j]);
+			}
+		}
+	}
+	dtl_dec_ref(worker->hv);
+	return (dtl_thread_ret_t) 0;
+}
 
 CuSuite* testsuite_dtl_dv(void)
 {
 	CuSuite* suite = CuSuiteNew();
 
 	SUITE_ADD_TEST(suite, test_dtl_dv_null);
+	SUITE_ADD_TEST(suite, test_dtl_dv_set_atomic);
+	SUITE_ADD_TEST(suite, test_dtl_dv_atomic_threads);
+	SUITE_ADD_TEST(suite, test_dtl_dv_freeze);
+	SUITE_ADD_TEST(suite, test_dtl_dv_frozen_setters_release);
+	SUITE_ADD_TEST(suite, test_dtl_dv_frozen_threads);
+	SUITE_ADD_TEST(suite, test_dtl_dv_handoff);
+	SUITE_ADD_TEST(suite, test_dtl_dv_deep_nesting);
+	SUITE_ADD_TEST(suite, test_dtl_dv_freeze_deep_nesting);
+	SUITE_ADD_TEST(suite, test_dtl_dv_deferred_reclaim);
 	return suite;
 }
 
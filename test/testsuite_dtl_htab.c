@@ -0,0 +1,313 @@
+/*****************************************************************************
+* \file      testsuite_dtl_htab.c
+* \author    Conny Gustafsson
+* \date      2026-10-17
+* \brief     Unit tests for dtl_htab_t
+*
+* Copyright (c) 2026 Conny Gustafsson
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include "CuTest.h"
+#include "dtl_htab.h"
+#include "dtl_atom.h"
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define NUM_KEYS 5000
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static void test_dtl_htab_insert_find(CuTest* tc);
+static void test_dtl_htab_remove(CuTest* tc);
+static void test_dtl_htab_churn(CuTest* tc);
+static void test_dtl_htab_same_hash(CuTest* tc);
+static void test_dtl_htab_destructor(CuTest* tc);
+static void **insert_cstr(dtl_htab_t *table, const char *pKey, bool *pIsNew);
+static void **find_cstr(const dtl_htab_t *table, const char *pKey);
+static bool remove_cstr(dtl_htab_t *table, const char *pKey);
+static void make_key(char *pBuf, int32_t i);
+static void count_destructor(void *arg);
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+static int32_t m_numDestroyed;
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+CuSuite* testsuite_dtl_htab(void)
+{
+   CuSuite* suite = CuSuiteNew();
+
+   SUITE_ADD_TEST(suite, test_dtl_htab_insert_find);
+   SUITE_ADD_TEST(suite, test_dtl_htab_remove);
+   SUITE_ADD_TEST(suite, test_dtl_htab_churn);
+   SUITE_ADD_TEST(suite, test_dtl_htab_same_hash);
+   SUITE_ADD_TEST(suite, test_dtl_htab_destructor);
+
+   return suite;
+}
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+static void test_dtl_htab_insert_find(CuTest* tc)
+{
+   dtl_htab_t table;
+   char key[64];
+   bool isNew = false;
+   int32_t i;
+   uint32_t u32Pos = 0u;
+   const dtl_htab_entry_t *entry;
+   dtl_htab_create(&table, NULL);
+   CuAssertPtrEquals(tc, NULL, find_cstr(&table, "k0"));
+   CuAssertUIntEquals(tc, 0u, dtl_htab_footprint(&table));
+   for (i = 0; i < NUM_KEYS; i++)
+   {
+      void **ppVal;
+      make_key(key, i);
+      ppVal = insert_cstr(&table, key, &isNew);
+      CuAssertPtrNotNull(tc, ppVal);
+      CuAssertTrue(tc, isNew);
+      *ppVal = (void*) (intptr_t) (i + 1);
+   }
+   CuAssertUIntEquals(tc, NUM_KEYS, dtl_htab_length(&table));
+   CuAssertTrue(tc, dtl_htab_footprint(&table) >= NUM_KEYS * sizeof(dtl_htab_entry_t));
+   for (i = 0; i < NUM_KEYS; i++)
+   {
+      void **ppVal;
+      make_key(key, i);
+      ppVal = find_cstr(&table, key);
+      CuAssertPtrNotNull(tc, ppVal);
+      CuAssertIntEquals(tc, i + 1, (int32_t) (intptr_t) *ppVal);
+      CuAssertPtrEquals(tc, ppVal, insert_cstr(&table, key, &isNew));
+      CuAssertTrue(tc, !isNew);
+   }
+   CuAssertPtrEquals(tc, NULL, find_cstr(&table, "missing"));
+   CuAssertPtrEquals(tc, NULL, find_cstr(&table, "k")); //prefix of stored keys
+
+   //entries come back in insertion order with their length and hash
+   for (i = 0; i < NUM_KEYS; i++)
+   {
+      entry = dtl_htab_next(&table, &u32Pos);
+      CuAssertPtrNotNull(tc, entry);
+      make_key(key, i);
+      CuAssertStrEquals(tc, key, dtl_htab_entry_key(entry));
+      CuAssertUIntEquals(tc, (uint32_t) strlen(key), entry->u32KeyLen);
+      CuAssertUIntEquals(tc, dtl_atom_hash_cstr(key, NULL), entry->u32Hash);
+   }
+   CuAssertPtrEquals(tc, NULL, (void*) dtl_htab_next(&table, &u32Pos));
+   dtl_htab_destroy(&table);
+   CuAssertUIntEquals(tc, 0u, dtl_htab_length(&table));
+}
+
+static void test_dtl_htab_remove(CuTest* tc)
+{
+   dtl_htab_t table;
+   char key[64];
+   void *pVal = NULL;
+   int32_t i;
+   uint32_t u32Pos = 0u;
+   const dtl_htab_entry_t *entry;
+   dtl_htab_create(&table, NULL);
+   CuAssertTrue(tc, !remove_cstr(&table, "k0"));
+   for (i = 0; i < NUM_KEYS; i++)
+   {
+      make_key(key, i);
+      *insert_cstr(&table, key, NULL) = (void*) (intptr_t) (i + 1);
+   }
+   for (i = 0; i < NUM_KEYS; i += 2)
+   {
+      make_key(key, i);
+      CuAssertTrue(tc, dtl_htab_remove(&table, key, (uint32_t) strlen(key), dtl_atom_hash_cstr(key, NULL), &pVal));
+      CuAssertIntEquals(tc, i + 1, (int32_t) (intptr_t) pVal);
+      CuAssertTrue(tc, !remove_cstr(&table, key));
+   }
+   CuAssertUIntEquals(tc, NUM_KEYS / 2, dtl_htab_length(&table));
+   for (i = 0; i < NUM_KEYS; i++)
+   {
+      make_key(key, i);
+      CuAssertTrue(tc, (find_cstr(&table, key) != NULL) == ((i % 2) != 0));
+   }
+   //removed entries are skipped, the rest keep their order also after the table is rebuilt
+   for (i = NUM_KEYS; i < 2 * NUM_KEYS; i++)
+   {
+      make_key(key, i);
+      *insert_cstr(&table, key, NULL) = (void*) (intptr_t) (i + 1);
+   }
+   for (i = 1; i < 2 * NUM_KEYS; i++)
+   {
+      if ( (i < NUM_KEYS) && ((i % 2) == 0) )
+      {
+         continue;
+      }
+      entry = dtl_htab_next(&table, &u32Pos);
+      CuAssertPtrNotNull(tc, entry);
+      CuAssertIntEquals(tc, i + 1, (int32_t) (intptr_t) entry->pVal);
+   }
+   CuAssertPtrEquals(tc, NULL, (void*) dtl_htab_next(&table, &u32Pos));
+
+   //removing every key leaves an empty table that can be filled again
+   u32Pos = 0u;
+   while ( (entry = dtl_htab_next(&table, &u32Pos)) != NULL )
+   {
+      strcpy(key, dtl_htab_entry_key(entry));
+      CuAssertTrue(tc, remove_cstr(&table, key));
+   }
+   CuAssertUIntEquals(tc, 0u, dtl_htab_length(&table));
+   *insert_cstr(&table, "again", NULL) = (void*) (intptr_t) 1;
+   CuAssertPtrNotNull(tc, find_cstr(&table, "again"));
+   dtl_htab_destroy(&table);
+}
+
+/**
+ * Inserting and removing keys at a steady size reuses the space of removed entries instead of growing.
+ */
+static void test_dtl_htab_churn(CuTest* tc)
+{
+   dtl_htab_t table;
+   char key[64];
+   int32_t i;
+   dtl_htab_create(&table, NULL);
+   for (i = 0; i < 100; i++)
+   {
+      make_key(key, i);
+      *insert_cstr(&table, key, NULL) = (void*) (intptr_t) (i + 1);
+   }
+   for (i = 100; i < 100000; i++)
+   {
+      make_key(key, i - 100);
+      CuAssertTrue(tc, remove_cstr(&table, key));
+      make_key(key, i);
+      *insert_cstr(&table, key, NULL) = (void*) (intptr_t) (i + 1);
+   }
+   CuAssertUIntEquals(tc, 100u, dtl_htab_length(&table));
+   CuAssertTrue(tc, table.u32Capacity <= 512u);
+   for (i = 100000 - 100; i < 100000; i++)
+   {
+      make_key(key, i);
+      CuAssertPtrNotNull(tc, find_cstr(&table, key));
+   }
+   dtl_htab_destroy(&table);
+}
+
+/**
+ * Keys with equal hashes all land in the same probe sequence and are told apart by length and bytes.
+ */
+static void test_dtl_htab_same_hash(CuTest* tc)
+{
+   dtl_htab_t table;
+   char key[64];
+   int32_t i;
+   dtl_htab_create(&table, NULL);
+   for (i = 0; i < 200; i++)
+   {
+      make_key(key, i);
+      *dtl_htab_insert(&table, key, (uint32_t) strlen(key), 0x12345u, NULL) = (void*) (intptr_t) (i + 1);
+   }
+   for (i = 0; i < 200; i += 3)
+   {
+      make_key(key, i);
+      CuAssertTrue(tc, dtl_htab_remove(&table, key, (uint32_t) strlen(key), 0x12345u, NULL));
+   }
+   for (i = 0; i < 200; i++)
+   {
+      void **ppVal;
+      make_key(key, i);
+      ppVal = dtl_htab_find(&table, key, (uint32_t) strlen(key), 0x12345u);
+      if ( (i % 3) == 0)
+      {
+         CuAssertPtrEquals(tc, NULL, ppVal);
+      }
+      else
+      {
+         CuAssertPtrNotNull(tc, ppVal);
+         CuAssertIntEquals(tc, i + 1, (int32_t) (intptr_t) *ppVal);
+      }
+   }
+   dtl_htab_destroy(&table);
+}
+
+static void test_dtl_htab_destructor(CuTest* tc)
+{
+   dtl_htab_t table;
+   void *pVal = NULL;
+   m_numDestroyed = 0;
+   dtl_htab_create(&table, count_destructor);
+   *insert_cstr(&table, "a", NULL) = &m_numDestroyed;
+   *insert_cstr(&table, "a key too long to be stored inline", NULL) = &m_numDestroyed;
+   *insert_cstr(&table, "c", NULL) = &m_numDestroyed;
+   CuAssertTrue(tc, dtl_htab_remove(&table, "c", 1u, dtl_atom_hash_cstr("c", NULL), &pVal));
+   CuAssertPtrEquals(tc, &m_numDestroyed, pVal);
+   CuAssertIntEquals(tc, 0, m_numDestroyed); //the caller owns removed values
+   dtl_htab_destroy(&table);
+   CuAssertIntEquals(tc, 2, m_numDestroyed);
+}
+
+static void **insert_cstr(dtl_htab_t *table, const char *pKey, bool *pIsNew)
+{
+   uint32_t u32KeyLen;
+   uint32_t u32Hash = dtl_atom_hash_cstr(pKey, &u32KeyLen);
+   return dtl_htab_insert(table, pKey, u32KeyLen, u32Hash, pIsNew);
+}
+
+static void **find_cstr(const dtl_htab_t *table, const char *pKey)
+{
+   uint32_t u32KeyLen;
+   uint32_t u32Hash = dtl_atom_hash_cstr(pKey, &u32KeyLen);
+   return dtl_htab_find(table, pKey, u32KeyLen, u32Hash);
+}
+
+static bool remove_cstr(dtl_htab_t *table, const char *pKey)
+{
+   uint32_t u32KeyLen;
+   uint32_t u32Hash = dtl_atom_hash_cstr(pKey, &u32KeyLen);
+   return dtl_htab_remove(table, pKey, u32KeyLen, u32Hash, NULL);
+}
+
+//every seventh key is too long to be stored inside its entry
+static void make_key(char *pBuf, int32_t i)
+{
+   if ( (i % 7) == 0)
+   {
+      sprintf(pBuf, "k%d/with/a/longer/path", i);
+   }
+   else
+   {
+      sprintf(pBuf, "k%d", i);
+   }
+}
+
+static void count_destructor(void *arg)
+{
+   (*(int32_t*) arg)++;
+}
@@ -33,12 +33,21 @@
 #include "dtl_sv.h"
 #include "dtl_av.h"
 #include "dtl_hv.h"
+#include "dtl_thread.h"
 #ifdef MEM_LEAK_CHECK
 #include "CMemLeak.h"
 #endif
 //////////////////////////////////////////////////////////////////////////////
 // PRIVATE CONSTANTS AND DATA TYPES
 //////////////////////////////////////////////////////////////////////////////
+#define ITER_NUM_KEYS     100
+#define ITER_NUM_THREADS  4
+#define ITER_NUM_WALKS    200
+
+typedef struct iter_worker_arg_tag{
+   const dtl_hv_t *hv;
+   int32_t s32Sum;
+} iter_worker_arg_t;
 
 //////////////////////////////////////////////////////////////////////////////
 // PRIVATE FUNCTION PROTOTYPES
@@ -47,6 +56,16 @@ static void test_dtl_hv_new_delete(CuTest* tc);
 static void test_dtl_hv_get_cstr_set(CuTest* tc);
 static void test_dtl_hv_keys_sorted(CuTest* tc);
 static void test_dtl_hv_iter(CuTest* tc);
+static void test_dtl_hv_iter_nested(CuTest* tc);
+static void test_dtl_hv_iter_threads(CuTest* tc);
+static void test_dtl_hv_atom_keys(CuTest* tc);
+static void test_dtl_hv_embedded_container(CuTest* tc);
+static void test_dtl_hv_bstr_keys(CuTest* tc);
+static void test_dtl_hv_hashed_keys(CuTest* tc);
+static void test_dtl_hv_keys_with_nul(CuTest* tc);
+static void test_dtl_hv_reserve(CuTest* tc);
+static void test_dtl_hv_make_from_pairs(CuTest* tc);
+static dtl_thread_ret_t DTL_THREAD_CALL iter_worker(void *arg);
 
 //////////////////////////////////////////////////////////////////////////////
 // PRIVATE VARIABLES
@@ -63,6 +82,15 @@ CuSuite* testsuite_dtl_hv(void)
    SUITE_ADD_TEST(suite, test_dtl_hv_get_cstr_set);
    SUITE_ADD_TEST(suite, test_dtl_hv_keys_sorted);
    SUITE_ADD_TEST(suite, test_dtl_hv_iter);
+   SUITE_ADD_TEST(suite, test_dtl_hv_iter_nested);
+   SUITE_ADD_TEST(suite, test_dtl_hv_iter_threads);
+   SUITE_ADD_TEST(suite, test_dtl_hv_atom_keys);
+   SUITE_ADD_TEST(suite, test_dtl_hv_embedded_container);
+   SUITE_ADD_TEST(suite, test_dtl_hv_bstr_keys);
+   SUITE_ADD_TEST(suite, test_dtl_hv_hashed_keys);
+   SUITE_ADD_TEST(suite, test_dtl_hv_keys_with_nul);
+   SUITE_ADD_TEST(suite, test_dtl_hv_reserve);
+   SUITE_ADD_TEST(suite, test_dtl_hv_make_from_pairs);
 
    return suite;
 }
@@ -169,3 +197,320 @@ static void test_dtl_hv_iter(CuTest* tc)
 
    dtl_dec_ref(hv);
 }
+
+static void test_dtl_hv_iter_nested(CuTest* tc)
+{
+   dtl_hv_t *hv = dtl_hv_new();
+   dtl_hv_t *other = dtl_hv_new();
+   dtl_hv_iter_t outer;
+   dtl_hv_iter_t inner;
+   int32_t s32NumPairs = 0;
+   dtl_hv_set_cstr(hv, "First", (dtl_dv_t*) dtl_sv_make_i32(1), false);
+   dtl_hv_set_cstr(hv, "Second", (dtl_dv_t*) 0, false);
+   dtl_hv_set_cstr(hv, "Third", (dtl_dv_t*) dtl_sv_make_i32(4), false);
+   dtl_hv_set_cstr(other, "Second", (dtl_dv_t*) dtl_sv_make_i32(2), false);
+
+   dtl_hv_iter_begin(hv, &outer);
+   CuAssertTrue(tc, dtl_hv_iter_next(&outer));
+   CuAssertStrEquals(tc, "First", outer.pKey);
+   CuAssertUIntEquals(tc, 5u, outer.u32KeyLen);
+   CuAssertPtrEquals(tc, dtl_hv_get_cstr(hv, "First"), outer.dv);
+   CuAssertTrue(tc, dtl_hv_iter_next(&outer));
+   CuAssertStrEquals(tc, "Second", outer.pKey);
+   CuAssertUIntEquals(tc, 6u, outer.u32KeyLen);
+   CuAssertPtrEquals(tc, NULL, outer.dv); //a NULL value does not end the iteration
+
+   //the stored hash only depends on the key
+   dtl_hv_iter_begin(other, &inner);
+   CuAssertTrue(tc, dtl_hv_iter_next(&inner));
+   CuAssertUIntEquals(tc, outer.u32KeyHash, inner.u32KeyHash);
+   CuAssertTrue(tc, !dtl_hv_iter_next(&inner));
+
+   CuAssertTrue(tc, dtl_hv_iter_next(&outer));
+   CuAssertStrEquals(tc, "Third", outer.pKey);
+   CuAssertTrue(tc, !dtl_hv_iter_next(&outer));
+   CuAssertTrue(tc, !dtl_hv_iter_next(&outer));
+
+   //nested walks of the same hash do not disturb each other
+   dtl_hv_iter_begin(hv, &outer);
+   while (dtl_hv_iter_next(&outer))
+   {
+      dtl_hv_iter_begin(hv, &inner);
+      while (dtl_hv_iter_next(&inner))
+      {
+         s32NumPairs++;
+      }
+   }
+   CuAssertIntEquals(tc, 9, s32NumPairs);
+
+   dtl_hv_iter_begin((dtl_hv_t*) 0, &outer);
+   CuAssertTrue(tc, !dtl_hv_iter_next(&outer));
+   CuAssertTrue(tc, !dtl_hv_iter_next((dtl_hv_iter_t*) 0));
+   dtl_dec_ref(other);
+   dtl_dec_ref(hv);
+}
+
+static void test_dtl_hv_iter_threads(CuTest* tc)
+{
+   dtl_thread_t threads[ITER_NUM_THREADS];
+   iter_worker_arg_t args[ITER_NUM_THREADS];
+   dtl_hv_t *hv = dtl_hv_new();
+   char key[16];
+   int32_t i;
+   for (i = 0; i < ITER_NUM_KEYS; i++)
+   {
+      sprintf(key, "k%d", i);
+      dtl_hv_set_cstr(hv, key, (dtl_dv_t*) dtl_sv_make_i32(i), false);
+   }
+   dtl_dv_freeze((dtl_dv_t*) hv);
+   for (i = 0; i < ITER_NUM_THREADS; i++)
+   {
+      args[i].hv = hv;
+      args[i].s32Sum = 0;
+      CuAssertIntEquals(tc, 0, dtl_thread_create(&threads[i], iter_worker, &args[i]));
+   }
+   for (i = 0; i < ITER_NUM_THREADS; i++)
+   {
+      dtl_thread_join(threads[i]);
+      CuAssertIntEquals(tc, ITER_NUM_WALKS * (ITER_NUM_KEYS * (ITER_NUM_KEYS - 1) / 2), args[i].s32Sum);
+   }
+   dtl_dec_ref(hv);
+}
+
+static void test_dtl_hv_atom_keys(CuTest* tc)
+{
+   dtl_hv_t *hv = dtl_hv_new();
+   dtl_atom_t *shortKey = dtl_atom_intern("id");
+   dtl_atom_t *longKey = dtl_atom_intern("a_rather_long_key_name");
+   dtl_av_t *keys;
+   dtl_sv_t *sv;
+
+   dtl_hv_set_atom(hv, shortKey, (dtl_dv_t*) dtl_sv_make_i32(1), false);
+   dtl_hv_set_atom(hv, longKey, (dtl_dv_t*) dtl_sv_make_i32(2), false);
+   CuAssertIntEquals(tc, 1, dtl_sv_to_i32((dtl_sv_t*) dtl_hv_get_atom(hv, shortKey), NULL));
+   CuAssertIntEquals(tc, 2, dtl_sv_to_i32((dtl_sv_t*) dtl_hv_get_cstr(hv, "a_rather_long_key_name"), NULL));
+
+   //long keys are returned as interned strings
+   keys = dtl_hv_keys(hv);
+   CuAssertIntEquals(tc, 2, dtl_av_length(keys));
+   CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_av_sort(keys, NULL, false));
+   sv = (dtl_sv_t*) dtl_av_value(keys, 0);
+   CuAssertPtrEquals(tc, longKey, dtl_sv_get_atom(sv));
+   sv = (dtl_sv_t*) dtl_av_value(keys, 1);
+   CuAssertStrEquals(tc, "id", dtl_sv_to_cstr(sv, NULL));
+   CuAssertPtrEquals(tc, NULL, dtl_sv_get_atom(sv));
+
+   dtl_dec_ref(keys);
+   dtl_dec_ref(hv);
+   dtl_atom_release(shortKey);
+   dtl_atom_release(longKey);
+}
+
+static void test_dtl_hv_embedded_container(CuTest* tc)
+{
+   dtl_hv_t *hv = dtl_hv_new();
+   dtl_hv_t local;
+   CuAssertPtrNotNull(tc, hv);
+   CuAssertPtrEquals(tc, &hv->hash, hv->pAny);
+   dtl_hv_set_cstr(hv, "a", (dtl_dv_t*) dtl_sv_make_i32(1), false);
+   CuAssertIntEquals(tc, 1, dtl_htab_length(hv->pAny));
+   dtl_dec_ref(hv);
+
+   //dtl_hv_create works on caller provided memory
+   dtl_hv_create(&local);
+   CuAssertPtrEquals(tc, &local.hash, local.pAny);
+   dtl_hv_set_cstr(&local, "b", (dtl_dv_t*) dtl_sv_make_i32(2), false);
+   CuAssertIntEquals(tc, 2, dtl_sv_to_i32((dtl_sv_t*) dtl_hv_get_cstr(&local, "b"), NULL));
+   dtl_hv_destroy(&local);
+}
+
+static void test_dtl_hv_bstr_keys(CuTest* tc)
+{
+   //keys sliced out of a buffer, none of them followed by a NUL
+   const uint8_t buf[] = "{\"name\":1,\"name_of_a_longer_field\":2}";
+   const uint8_t *name = &buf[2];
+   const uint8_t *longName = &buf[11];
+   dtl_hv_t *hv = dtl_hv_new();
+   dtl_hv_iter_t iter;
+
+   dtl_hv_set_bstr(hv, name, name + 4, (dtl_dv_t*) dtl_sv_make_i32(1), false);
+   dtl_hv_set_bstr(hv, longName, longName + 22, (dtl_dv_t*) dtl_sv_make_i32(2), false);
+   dtl_hv_set_bstr(hv, name, name, (dtl_dv_t*) dtl_sv_make_i32(3), false); //empty key
+   CuAssertUIntEquals(tc, 3u, dtl_hv_length(hv));
+   CuAssertIntEquals(tc, 1, dtl_sv_to_i32((dtl_sv_t*) dtl_hv_get_cstr(hv, "name"), NULL));
+   CuAssertIntEquals(tc, 2, dtl_sv_to_i32((dtl_sv_t*) dtl_hv_get_bstr(hv, longName, longName + 22), NULL));
+   CuAssertIntEquals(tc, 3, dtl_sv_to_i32((dtl_sv_t*) dtl_hv_get_cstr(hv, ""), NULL));
+   CuAssertPtrEquals(tc, NULL, dtl_hv_get_bstr(hv, name, name + 3));
+   CuAssertTrue(tc, dtl_hv_exists_bstr(hv, name, name + 4));
+   CuAssertTrue(tc, !dtl_hv_exists_bstr(hv, name, name + 5));
+   CuAssertPtrEquals(tc, NULL, dtl_hv_get_bstr(hv, name + 4, name)); //end before begin
+
+   //the hash keeps its own NUL-terminated copy of the key
+   dtl_hv_iter_begin(hv, &iter);
+   CuAssertTrue(tc, dtl_hv_iter_next(&iter));
+   CuAssertStrEquals(tc, "name", iter.pKey);
+   CuAssertTrue(tc, dtl_hv_iter_next(&iter));
+   CuAssertStrEquals(tc, "name_of_a_longer_field", iter.pKey);
+
+   dtl_dec_ref(dtl_hv_remove_bstr(hv, name, name + 4));
+   CuAssertTrue(tc, !dtl_hv_exists_cstr(hv, "name"));
+   CuAssertUIntEquals(tc, 2u, dtl_hv_length(hv));
+   dtl_dec_ref(hv);
+}
+
+static void test_dtl_hv_keys_with_nul(CuTest* tc)
+{
+   const uint8_t shortKey[3] = {'a', 0, 'b'};
+   const uint8_t longKey[20] = {'l', 'o', 'n', 'g', 0, 'k', 'e', 'y', '_', 'w', 'i', 't', 'h', '_', 'a', '_', 'n', 'u', 'l', '!'};
+   dtl_hv_t *hv = dtl_hv_new();
+   dtl_av_t *keys;
+   bool foundShort = false;
+   bool foundLong = false;
+   int32_t i;
+
+   dtl_hv_set_bstr(hv, shortKey, shortKey + 3, (dtl_dv_t*) dtl_sv_make_i32(1), false);
+   dtl_hv_set_bstr(hv, longKey, longKey + 20, (dtl_dv_t*) dtl_sv_make_i32(2), false);
+   dtl_hv_set_cstr(hv, "a", (dtl_dv_t*) dtl_sv_make_i32(3), false);
+   keys = dtl_hv_keys(hv);
+   CuAssertIntEquals(tc, 3, dtl_av_length(keys));
+   for (i = 0; i < 3; i++)
+   {
+      uint32_t u32Len = 0u;
+      const char *pData = dtl_sv_get_str_data((dtl_sv_t*) dtl_av_value(keys, i), &u32Len);
+      CuAssertPtrNotNull(tc, pData);
+      if ( (u32Len == 3u) && (memcmp(pData, shortKey, 3u) == 0) )
+      {
+         foundShort = true;
+      }
+      else if ( (u32Len == 20u) && (memcmp(pData, longKey, 20u) == 0) )
+      {
+         foundLong = true;
+      }
+      else
+      {
+         CuAssertUIntEquals(tc, 1u, u32Len);
+         CuAssertTrue(tc, pData[0] == 'a');
+      }
+   }
+   CuAssertTrue(tc, foundShort);
+   CuAssertTrue(tc, foundLong);
+   dtl_dec_ref(keys);
+   dtl_dec_ref(hv);
+}
+
+static void test_dtl_hv_hashed_keys(CuTest* tc)
+{
+   const uint8_t key[] = "temperature";
+   const uint8_t *end = key + 11;
+   uint32_t u32Hash = dtl_key_hash(key, end);
+   dtl_hv_t *hv = dtl_hv_new();
+   dtl_hv_t *other = dtl_hv_new();
+   dtl_atom_t *atom = dtl_atom_intern("temperature");
+   dtl_hv_iter_t iter;
+
+   CuAssertUIntEquals(tc, dtl_atom_hash(atom), u32Hash);
+   dtl_hv_set_hashed(hv, key, end, u32Hash, (dtl_dv_t*) dtl_sv_make_i32(20), false);
+   CuAssertIntEquals(tc, 20, dtl_sv_to_i32((dtl_sv_t*) dtl_hv_get_hashed(hv, key, end, u32Hash), NULL));
+   CuAssertIntEquals(tc, 20, dtl_sv_to_i32((dtl_sv_t*) dtl_hv_get_cstr(hv, "temperature"), NULL));
+   CuAssertIntEquals(tc, 20, dtl_sv_to_i32((dtl_sv_t*) dtl_hv_get_atom(hv, atom), NULL));
+   CuAssertTrue(tc, dtl_hv_exists_hashed(hv, key, end, u32Hash));
+   CuAssertTrue(tc, !dtl_hv_exists_hashed(hv, key, end - 1, dtl_key_hash(key, end - 1)));
+
+   //the hash an iterator reports can be used to copy entries without hashing the keys again
+   dtl_hv_iter_begin(hv, &iter);
+   while (dtl_hv_iter_next(&iter))
+   {
+      const uint8_t *pKey = (const uint8_t*) iter.pKey;
+      dtl_hv_set_hashed(other, pKey, pKey + iter.u32KeyLen, iter.u32KeyHash, iter.dv, true);
+   }
+   CuAssertPtrEquals(tc, dtl_hv_get_cstr(hv, "temperature"), dtl_hv_get_cstr(other, "temperature"));
+
+   dtl_dec_ref(dtl_hv_remove_hashed(hv, key, end, u32Hash));
+   CuAssertUIntEquals(tc, 0u, dtl_hv_length(hv));
+   CuAssertUIntEquals(tc, 1u, dtl_hv_length(other));
+   dtl_dec_ref(hv);
+   dtl_dec_ref(other);
+   dtl_atom_release(atom);
+}
+
+static void test_dtl_hv_reserve(CuTest* tc)
+{
+   dtl_hv_t *hv = dtl_hv_new();
+   const dtl_htab_entry_t *pEntries;
+   char key[32];
+   int32_t i;
+   CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_hv_reserve(hv, 1000u));
+   CuAssertUIntEquals(tc, 0u, dtl_hv_length(hv));
+   pEntries = hv->hash.pEntries;
+   CuAssertPtrNotNull(tc, pEntries);
+   for (i = 0; i < 1000; i++)
+   {
+      sprintf(key, "key%d", i);
+      dtl_hv_set_cstr(hv, key, (dtl_dv_t*) dtl_sv_make_i32(i), false);
+   }
+   //all keys went into the table allocated by dtl_hv_reserve
+   CuAssertPtrEquals(tc, (void*) pEntries, (void*) hv->hash.pEntries);
+   CuAssertUIntEquals(tc, 1000u, dtl_hv_length(hv));
+   CuAssertIntEquals(tc, 500, dtl_sv_to_i32((dtl_sv_t*) dtl_hv_get_cstr(hv, "key500"), NULL));
+
+   //reserving less than the current length leaves the table alone
+   CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_hv_reserve(hv, 10u));
+   CuAssertPtrEquals(tc, (void*) pEntries, (void*) hv->hash.pEntries);
+   //growing keeps the insertion order
+   CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_hv_reserve(hv, 5000u));
+   CuAssertUIntEquals(tc, 1000u, dtl_hv_length(hv));
+   CuAssertStrEquals(tc, "key0", dtl_htab_entry_key(&hv->hash.pEntries[0]));
+   CuAssertStrEquals(tc, "key999", dtl_htab_entry_key(&hv->hash.pEntries[999]));
+   CuAssertIntEquals(tc, DTL_INVALID_ARGUMENT_ERROR, dtl_hv_reserve(NULL, 10u));
+   dtl_dv_freeze((dtl_dv_t*) hv);
+   CuAssertIntEquals(tc, DTL_FROZEN_ERROR, dtl_hv_reserve(hv, 10000u));
+   dtl_dec_ref(hv);
+}
+
+static void test_dtl_hv_make_from_pairs(CuTest* tc)
+{
+   dtl_hv_pair_t pairs[4];
+   dtl_hv_t *hv;
+   dtl_hv_iter_t iter;
+   pairs[0].pKey = "x";
+   pairs[0].dv = (dtl_dv_t*) dtl_sv_make_i32(1);
+   pairs[1].pKey = "a key too long to be stored inline";
+   pairs[1].dv = (dtl_dv_t*) dtl_sv_make_i32(2);
+   pairs[2].pKey = "x"; //repeated key, the last value wins
+   pairs[2].dv = (dtl_dv_t*) dtl_sv_make_i32(3);
+   pairs[3].pKey = NULL; //skipped, its value is released
+   pairs[3].dv = (dtl_dv_t*) dtl_sv_make_i32(4);
+   hv = dtl_hv_make_from_pairs(pairs, 4u);
+   CuAssertPtrNotNull(tc, hv);
+   CuAssertUIntEquals(tc, 2u, dtl_hv_length(hv));
+   CuAssertPtrEquals(tc, pairs[2].dv, dtl_hv_get_cstr(hv, "x"));
+   CuAssertIntEquals(tc, 1, (int32_t) pairs[2].dv->u32RefCnt);
+   dtl_hv_iter_begin(hv, &iter);
+   CuAssertTrue(tc, dtl_hv_iter_next(&iter));
+   CuAssertStrEquals(tc, "x", iter.pKey);
+   CuAssertTrue(tc, dtl_hv_iter_next(&iter));
+   CuAssertIntEquals(tc, 2, dtl_sv_to_i32((dtl_sv_t*) iter.dv, NULL));
+   dtl_dec_ref(hv);
+
+   hv = dtl_hv_make_from_pairs(NULL, 0u);
+   CuAssertPtrNotNull(tc, hv);
+   CuAssertUIntEquals(tc, 0u, dtl_hv_length(hv));
+   dtl_dec_ref(hv);
+   CuAssertPtrEquals(tc, NULL, dtl_hv_make_from_pairs(NULL, 1u));
+}
+
+static dtl_thread_ret_t DTL_THREAD_CALL iter_worker(void *arg)
+{
+   iter_worker_arg_t *workerArg = (iter_worker_arg_t*) arg;
+   int32_t i;
+   for (i = 0; i < ITER_NUM_WALKS; i++)
+   {
+      dtl_hv_iter_t iter;
+      dtl_hv_iter_begin(workerArg->hv, &iter);
+      while (dtl_hv_iter_next(&iter))
+      {
+         workerArg->s32Sum += dtl_sv_to_i32((dtl_sv_t*) iter.dv, NULL);
+      }
+   }
+   return (dtl_thread_ret_t) 0;
+}
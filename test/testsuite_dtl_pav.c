@@ -0,0 +1,233 @@
+/*****************************************************************************
+* \file      testsuite_dtl_pav.c
+* \author    Conny Gustafsson
+* \date      2026-10-17
+* \brief     Unit tests for dtl_pav_t
+*
+* Copyright (c) 2026 Conny Gustafsson
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdlib.h>
+#include <stdio.h>
+#include "CuTest.h"
+#include "dtl_sv.h"
+#include "dtl_pav.h"
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define MANY_VALUES 40000 //three trie levels below the root plus the tail
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static void test_dtl_pav_push(CuTest* tc);
+static void test_dtl_pav_set(CuTest* tc);
+static void test_dtl_pav_pop(CuTest* tc);
+static void test_dtl_pav_index(CuTest* tc);
+static void test_dtl_pav_release(CuTest* tc);
+static dtl_pav_t *push_i32(dtl_pav_t *pav, int32_t i32Value);
+static dtl_pav_t *pop(dtl_pav_t *pav);
+static int32_t value_i32(const dtl_pav_t *pav, int32_t s32Index);
+static void count_free(void *arg);
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+CuSuite* testsuite_dtl_pav(void)
+{
+   CuSuite* suite = CuSuiteNew();
+
+   SUITE_ADD_TEST(suite, test_dtl_pav_push);
+   SUITE_ADD_TEST(suite, test_dtl_pav_set);
+   SUITE_ADD_TEST(suite, test_dtl_pav_pop);
+   SUITE_ADD_TEST(suite, test_dtl_pav_index);
+   SUITE_ADD_TEST(suite, test_dtl_pav_release);
+
+   return suite;
+}
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+static void test_dtl_pav_push(CuTest* tc)
+{
+   dtl_pav_t *pav = dtl_pav_new();
+   dtl_pav_t *small;
+   int32_t i;
+   CuAssertPtrNotNull(tc, pav);
+   CuAssertIntEquals(tc, DTL_DV_PARRAY, dtl_dv_type((dtl_dv_t*) pav));
+   CuAssertIntEquals(tc, 0, dtl_pav_length(pav));
+   for (i = 0; i < 100; i++)
+   {
+      pav = push_i32(pav, i);
+   }
+   small = pav;
+   dtl_inc_ref(small);
+   for (; i < MANY_VALUES; i++)
+   {
+      pav = push_i32(pav, i);
+   }
+   CuAssertIntEquals(tc, MANY_VALUES, dtl_pav_length(pav));
+   CuAssertIntEquals(tc, 100, dtl_pav_length(small));
+   for (i = 0; i < MANY_VALUES; i++)
+   {
+      CuAssertIntEquals(tc, i, value_i32(pav, i));
+   }
+   for (i = 0; i < 100; i++)
+   {
+      CuAssertIntEquals(tc, i, value_i32(small, i));
+   }
+   dtl_dec_ref(small);
+   dtl_dec_ref(pav);
+}
+
+static void test_dtl_pav_set(CuTest* tc)
+{
+   dtl_pav_t *pav = dtl_pav_new();
+   dtl_pav_t *changed;
+   int32_t i;
+   for (i = 0; i < 2000; i++)
+   {
+      pav = push_i32(pav, i);
+   }
+   dtl_inc_ref(pav);
+   changed = pav;
+   for (i = 0; i < 2000; i += 3)
+   {
+      dtl_pav_t *version = dtl_pav_set(changed, i, (dtl_dv_t*) dtl_sv_make_i32(-i), false);
+      dtl_dec_ref(changed);
+      changed = version;
+   }
+   for (i = 0; i < 2000; i++)
+   {
+      CuAssertIntEquals(tc, i, value_i32(pav, i));
+      CuAssertIntEquals(tc, ((i % 3) == 0)? -i : i, value_i32(changed, i));
+   }
+   CuAssertPtrEquals(tc, (void*) 0, dtl_pav_set(pav, 2000, (dtl_dv_t*) 0, true));
+   CuAssertPtrEquals(tc, (void*) 0, dtl_pav_set(pav, -2001, (dtl_dv_t*) 0, true));
+   dtl_dec_ref(changed);
+   dtl_dec_ref(pav);
+}
+
+static void test_dtl_pav_pop(CuTest* tc)
+{
+   dtl_pav_t *pav = dtl_pav_new();
+   dtl_pav_t *full;
+   int32_t i;
+   CuAssertPtrEquals(tc, (void*) 0, dtl_pav_pop(pav));
+   for (i = 0; i < MANY_VALUES; i++)
+   {
+      pav = push_i32(pav, i);
+   }
+   full = pav;
+   dtl_inc_ref(full);
+   for (i = MANY_VALUES; i > 0; i--)
+   {
+      CuAssertIntEquals(tc, i, dtl_pav_length(pav));
+      CuAssertIntEquals(tc, i - 1, value_i32(pav, -1));
+      CuAssertIntEquals(tc, 0, value_i32(pav, 0));
+      pav = pop(pav);
+   }
+   CuAssertIntEquals(tc, 0, dtl_pav_length(pav));
+   CuAssertIntEquals(tc, MANY_VALUES, dtl_pav_length(full));
+   CuAssertIntEquals(tc, MANY_VALUES - 1, value_i32(full, -1));
+
+   //a popped version can grow again
+   for (i = 0; i < 1100; i++)
+   {
+      pav = push_i32(pav, i);
+   }
+   for (i = 0; i < 1100; i++)
+   {
+      CuAssertIntEquals(tc, i, value_i32(pav, i));
+   }
+   dtl_dec_ref(full);
+   dtl_dec_ref(pav);
+}
+
+static void test_dtl_pav_index(CuTest* tc)
+{
+   dtl_pav_t *pav = dtl_pav_new();
+   pav = push_i32(pav, 1);
+   pav = push_i32(pav, 2);
+   CuAssertIntEquals(tc, 2, value_i32(pav, -1));
+   CuAssertIntEquals(tc, 1, value_i32(pav, -2));
+   CuAssertPtrEquals(tc, (void*) 0, dtl_pav_value(pav, -3));
+   CuAssertPtrEquals(tc, (void*) 0, dtl_pav_value(pav, 2));
+   CuAssertPtrEquals(tc, (void*) 0, dtl_pav_value((dtl_pav_t*) 0, 0));
+   CuAssertIntEquals(tc, 0, dtl_pav_length((dtl_pav_t*) 0));
+   CuAssertPtrEquals(tc, (void*) 0, dtl_pav_push((dtl_pav_t*) 0, (dtl_dv_t*) 0, true));
+   dtl_dec_ref(pav);
+}
+
+static void test_dtl_pav_release(CuTest* tc)
+{
+   int32_t s32NumFreed = 0;
+   dtl_pav_t *pav = dtl_pav_new();
+   dtl_pav_t *other;
+   int32_t i;
+   for (i = 0; i < 1000; i++)
+   {
+      dtl_pav_t *version = dtl_pav_push(pav, (dtl_dv_t*) dtl_sv_make_ptr(&s32NumFreed, count_free), false);
+      dtl_dec_ref(pav);
+      pav = version;
+   }
+   other = dtl_pav_set(pav, 10, (dtl_dv_t*) dtl_sv_make_ptr(&s32NumFreed, count_free), false);
+   dtl_dec_ref(pav);
+   CuAssertIntEquals(tc, 1, s32NumFreed); //the replaced element
+   pav = pop(other);
+   CuAssertIntEquals(tc, 2, s32NumFreed); //the popped element
+   dtl_dec_ref(pav);
+   CuAssertIntEquals(tc, 1001, s32NumFreed);
+}
+
+/**
+ * Returns a version of pav with i32Value appended, releasing pav.
+ */
+static dtl_pav_t *push_i32(dtl_pav_t *pav, int32_t i32Value)
+{
+   dtl_pav_t *version = dtl_pav_push(pav, (dtl_dv_t*) dtl_sv_make_i32(i32Value), false);
+   dtl_dec_ref(pav);
+   return version;
+}
+
+static dtl_pav_t *pop(dtl_pav_t *pav)
+{
+   dtl_pav_t *version = dtl_pav_pop(pav);
+   dtl_dec_ref(pav);
+   return version;
+}
+
+static int32_t value_i32(const dtl_pav_t *pav, int32_t s32Index)
+{
+   dtl_sv_t *sv = (dtl_sv_t*) dtl_pav_value(pav, s32Index);
+   return (sv != 0)? dtl_sv_to_i32(sv, (bool*) 0) : -1000;
+}
+
+static void count_free(void *arg)
+{
+   (*(int32_t*) arg)++;
+}
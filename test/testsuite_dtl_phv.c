@@ -0,0 +1,388 @@
+/*****************************************************************************
+* \file      testsuite_dtl_phv.c
+* \author    Conny Gustafsson
+* \date      2026-10-17
+* \brief     Unit tests for dtl_phv_t
+*
+* Copyright (c) 2026 Conny Gustafsson
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "CuTest.h"
+#include "dtl_sv.h"
+#include "dtl_phv.h"
+#include "dtl_atom.h"
+#include "dtl_thread.h"
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define MANY_KEYS          10000
+#define SHARED_NUM_KEYS    1000
+#define NUM_READERS        4
+#define READER_ITERATIONS  20
+
+typedef struct reader_arg_tag{
+   const dtl_phv_t *shared;
+   int32_t s32NumErrors;
+} reader_arg_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static void test_dtl_phv_versions(CuTest* tc);
+static void test_dtl_phv_many_keys(CuTest* tc);
+static void test_dtl_phv_collisions(CuTest* tc);
+static void test_dtl_phv_iter(CuTest* tc);
+static void test_dtl_phv_release(CuTest* tc);
+static void test_dtl_phv_threads(CuTest* tc);
+static dtl_phv_t *set_i32(dtl_phv_t *phv, const char *pKey, int32_t i32Value);
+static dtl_phv_t *remove_key(dtl_phv_t *phv, const char *pKey);
+static int32_t get_i32(const dtl_phv_t *phv, const char *pKey);
+static void count_free(void *arg);
+static dtl_thread_ret_t DTL_THREAD_CALL reader(void *arg);
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+CuSuite* testsuite_dtl_phv(void)
+{
+   CuSuite* suite = CuSuiteNew();
+
+   SUITE_ADD_TEST(suite, test_dtl_phv_versions);
+   SUITE_ADD_TEST(suite, test_dtl_phv_many_keys);
+   SUITE_ADD_TEST(suite, test_dtl_phv_collisions);
+   SUITE_ADD_TEST(suite, test_dtl_phv_iter);
+   SUITE_ADD_TEST(suite, test_dtl_phv_release);
+   SUITE_ADD_TEST(suite, test_dtl_phv_threads);
+
+   return suite;
+}
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+static void test_dtl_phv_versions(CuTest* tc)
+{
+   dtl_phv_t *v0 = dtl_phv_new();
+   dtl_phv_t *v1;
+   dtl_phv_t *v2;
+   dtl_phv_t *v3;
+   dtl_phv_t *v4;
+   dtl_phv_t *v5;
+   CuAssertPtrNotNull(tc, v0);
+   CuAssertIntEquals(tc, DTL_DV_PHASH, dtl_dv_type((dtl_dv_t*) v0));
+   CuAssertUIntEquals(tc, 0u, dtl_phv_length(v0));
+   CuAssertPtrEquals(tc, (void*) 0, dtl_phv_get_cstr(v0, "a"));
+
+   v1 = dtl_phv_set_cstr(v0, "a", (dtl_dv_t*) dtl_sv_make_i32(1), false);
+   v2 = dtl_phv_set_cstr(v1, "b", (dtl_dv_t*) dtl_sv_make_i32(2), false);
+   v3 = dtl_phv_set_cstr(v2, "a", (dtl_dv_t*) dtl_sv_make_i32(10), false);
+   v4 = dtl_phv_remove_cstr(v3, "b");
+   v5 = dtl_phv_remove_cstr(v4, "missing");
+   CuAssertPtrEquals(tc, v4, v5); //nothing to remove
+   dtl_dec_ref(v5);
+
+   //each version keeps the contents it was created with
+   CuAssertUIntEquals(tc, 0u, dtl_phv_length(v0));
+   CuAssertUIntEquals(tc, 1u, dtl_phv_length(v1));
+   CuAssertUIntEquals(tc, 2u, dtl_phv_length(v2));
+   CuAssertUIntEquals(tc, 2u, dtl_phv_length(v3));
+   CuAssertUIntEquals(tc, 1u, dtl_phv_length(v4));
+   CuAssertIntEquals(tc, 1, get_i32(v1, "a"));
+   CuAssertTrue(tc, !dtl_phv_exists_cstr(v1, "b"));
+   CuAssertIntEquals(tc, 1, get_i32(v2, "a"));
+   CuAssertIntEquals(tc, 2, get_i32(v2, "b"));
+   CuAssertIntEquals(tc, 10, get_i32(v3, "a"));
+   CuAssertIntEquals(tc, 2, get_i32(v3, "b"));
+   CuAssertIntEquals(tc, 10, get_i32(v4, "a"));
+   CuAssertTrue(tc, !dtl_phv_exists_cstr(v4, "b"));
+   CuAssertTrue(tc, dtl_phv_exists_cstr(v4, "a"));
+
+   //removing the last key gives an empty version
+   v5 = dtl_phv_remove_cstr(v4, "a");
+   CuAssertUIntEquals(tc, 0u, dtl_phv_length(v5));
+   CuAssertPtrEquals(tc, (void*) 0, dtl_phv_get_cstr(v5, "a"));
+
+   CuAssertPtrEquals(tc, (void*) 0, dtl_phv_set_cstr((dtl_phv_t*) 0, "a", (dtl_dv_t*) 0, true));
+   CuAssertPtrEquals(tc, (void*) 0, dtl_phv_set_cstr(v0, (const char*) 0, (dtl_dv_t*) 0, true));
+   CuAssertUIntEquals(tc, 0u, dtl_phv_length((dtl_phv_t*) 0));
+
+   dtl_dec_ref(v0);
+   dtl_dec_ref(v1);
+   dtl_dec_ref(v2);
+   dtl_dec_ref(v3);
+   dtl_dec_ref(v4);
+   dtl_dec_ref(v5);
+}
+
+static void test_dtl_phv_many_keys(CuTest* tc)
+{
+   dtl_phv_t *phv = dtl_phv_new();
+   dtl_phv_t *half;
+   char key[16];
+   int32_t i;
+   for (i = 0; i < MANY_KEYS; i++)
+   {
+      sprintf(key, "k%d", i);
+      phv = set_i32(phv, key, i);
+   }
+   CuAssertUIntEquals(tc, MANY_KEYS, dtl_phv_length(phv));
+   for (i = 0; i < MANY_KEYS; i++)
+   {
+      sprintf(key, "k%d", i);
+      CuAssertIntEquals(tc, i, get_i32(phv, key));
+   }
+   CuAssertTrue(tc, !dtl_phv_exists_cstr(phv, "k-1"));
+
+   //remove the even keys from a new version
+   dtl_inc_ref(phv);
+   half = phv;
+   for (i = 0; i < MANY_KEYS; i += 2)
+   {
+      sprintf(key, "k%d", i);
+      half = remove_key(half, key);
+   }
+   CuAssertUIntEquals(tc, MANY_KEYS / 2, dtl_phv_length(half));
+   CuAssertUIntEquals(tc, MANY_KEYS, dtl_phv_length(phv));
+   for (i = 0; i < MANY_KEYS; i++)
+   {
+      sprintf(key, "k%d", i);
+      CuAssertTrue(tc, dtl_phv_exists_cstr(half, key) == ((i % 2) != 0));
+      CuAssertIntEquals(tc, i, get_i32(phv, key));
+   }
+   for (i = 1; i < MANY_KEYS; i += 2)
+   {
+      sprintf(key, "k%d", i);
+      half = remove_key(half, key);
+   }
+   CuAssertUIntEquals(tc, 0u, dtl_phv_length(half));
+   dtl_dec_ref(half);
+   dtl_dec_ref(phv);
+}
+
+static void test_dtl_phv_collisions(CuTest* tc)
+{
+   //these keys have the same 32-bit hash
+   const char *keys[3] = {"key1779985", "key12621907", "key13337780"};
+   dtl_phv_t *phv = dtl_phv_new();
+   dtl_phv_t *removed;
+   int32_t i;
+   CuAssertUIntEquals(tc, dtl_atom_hash_bstr((const uint8_t*) keys[0], (const uint8_t*) keys[0] + strlen(keys[0])),
+      dtl_atom_hash_bstr((const uint8_t*) keys[1], (const uint8_t*) keys[1] + strlen(keys[1])));
+   CuAssertUIntEquals(tc, dtl_atom_hash_bstr((const uint8_t*) keys[0], (const uint8_t*) keys[0] + strlen(keys[0])),
+      dtl_atom_hash_bstr((const uint8_t*) keys[2], (const uint8_t*) keys[2] + strlen(keys[2])));
+   phv = set_i32(phv, "other", -1);
+   for (i = 0; i < 3; i++)
+   {
+      phv = set_i32(phv, keys[i], i);
+   }
+   phv = set_i32(phv, keys[1], 100); //replace inside the collision node
+   CuAssertUIntEquals(tc, 4u, dtl_phv_length(phv));
+   CuAssertIntEquals(tc, 0, get_i32(phv, keys[0]));
+   CuAssertIntEquals(tc, 100, get_i32(phv, keys[1]));
+   CuAssertIntEquals(tc, 2, get_i32(phv, keys[2]));
+   CuAssertIntEquals(tc, -1, get_i32(phv, "other"));
+
+   for (i = 0; i < 3; i++)
+   {
+      int32_t j;
+      dtl_inc_ref(phv);
+      removed = remove_key(phv, keys[i]);
+      CuAssertUIntEquals(tc, 3u, dtl_phv_length(removed));
+      CuAssertTrue(tc, !dtl_phv_exists_cstr(removed, keys[i]));
+      for (j = 0; j < 3; j++)
+      {
+         if (j != i)
+         {
+            CuAssertTrue(tc, dtl_phv_exists_cstr(removed, keys[j]));
+            //down to a single colliding key
+            removed = remove_key(removed, keys[j]);
+            break;
+         }
+      }
+      CuAssertUIntEquals(tc, 2u, dtl_phv_length(removed));
+      CuAssertTrue(tc, dtl_phv_exists_cstr(removed, "other"));
+      CuAssertTrue(tc, dtl_phv_exists_cstr(removed, keys[3 - i - j]));
+      dtl_dec_ref(removed);
+   }
+   dtl_dec_ref(phv);
+}
+
+static void test_dtl_phv_iter(CuTest* tc)
+{
+   dtl_phv_t *phv = dtl_phv_new();
+   dtl_phv_iter_t iter;
+   dtl_dv_t *dv;
+   const char *pKey = (const char*) 0;
+   char key[16];
+   int32_t i;
+   int32_t s32Count = 0;
+   int32_t s32Sum = 0;
+   dtl_phv_iter_init(phv, &iter);
+   CuAssertPtrEquals(tc, (void*) 0, dtl_phv_iter_next_cstr(&iter, &pKey));
+   for (i = 0; i < 1000; i++)
+   {
+      sprintf(key, "k%d", i);
+      phv = set_i32(phv, key, i);
+   }
+   dtl_phv_iter_init(phv, &iter);
+   while ( (dv = dtl_phv_iter_next_cstr(&iter, &pKey)) != 0)
+   {
+      int32_t s32Value = dtl_sv_to_i32((dtl_sv_t*) dv, (bool*) 0);
+      sprintf(key, "k%d", s32Value);
+      CuAssertStrEquals(tc, key, pKey);
+      s32Count++;
+      s32Sum += s32Value;
+   }
+   CuAssertIntEquals(tc, 1000, s32Count);
+   CuAssertIntEquals(tc, 999 * 1000 / 2, s32Sum);
+   CuAssertPtrEquals(tc, (void*) 0, dtl_phv_iter_next_cstr(&iter, &pKey));
+   dtl_dec_ref(phv);
+}
+
+static void test_dtl_phv_release(CuTest* tc)
+{
+   int32_t s32NumFreed = 0;
+   dtl_phv_t *versions[3];
+   dtl_sv_t *shared = dtl_sv_make_ptr(&s32NumFreed, count_free);
+   char key[16];
+   int32_t i;
+   versions[0] = dtl_phv_new();
+   for (i = 0; i < 100; i++)
+   {
+      sprintf(key, "k%d", i);
+      versions[0] = set_i32(versions[0], key, i);
+   }
+   versions[1] = dtl_phv_set_cstr(versions[0], "shared", (dtl_dv_t*) shared, true);
+   versions[2] = dtl_phv_set_cstr(versions[1], "k0", (dtl_dv_t*) shared, true);
+   CuAssertUIntEquals(tc, 3u, shared->u32RefCnt);
+   dtl_dec_ref(shared);
+   dtl_dec_ref(versions[1]);
+   CuAssertIntEquals(tc, 0, s32NumFreed);
+   CuAssertPtrEquals(tc, shared, dtl_phv_get_cstr(versions[2], "shared"));
+   CuAssertPtrEquals(tc, shared, dtl_phv_get_cstr(versions[2], "k0"));
+   dtl_dec_ref(versions[2]);
+   CuAssertIntEquals(tc, 1, s32NumFreed);
+   CuAssertIntEquals(tc, 0, get_i32(versions[0], "k0"));
+   dtl_dec_ref(versions[0]);
+}
+
+/**
+ * Readers derive their own versions from a frozen version while other readers look it up.
+ */
+static void test_dtl_phv_threads(CuTest* tc)
+{
+   dtl_thread_t threads[NUM_READERS];
+   reader_arg_t args[NUM_READERS];
+   dtl_phv_t *phv = dtl_phv_new();
+   char key[16];
+   int32_t i;
+   for (i = 0; i < SHARED_NUM_KEYS; i++)
+   {
+      sprintf(key, "k%d", i);
+      phv = set_i32(phv, key, i);
+   }
+   dtl_dv_freeze((dtl_dv_t*) phv);
+   for (i = 0; i < NUM_READERS; i++)
+   {
+      args[i].shared = phv;
+      args[i].s32NumErrors = 0;
+      CuAssertIntEquals(tc, 0, dtl_thread_create(&threads[i], reader, &args[i]));
+   }
+   for (i = 0; i < NUM_READERS; i++)
+   {
+      dtl_thread_join(threads[i]);
+      CuAssertIntEquals(tc, 0, args[i].s32NumErrors);
+   }
+   CuAssertUIntEquals(tc, 1u, phv->u32RefCnt);
+   for (i = 0; i < SHARED_NUM_KEYS; i++)
+   {
+      sprintf(key, "k%d", i);
+      CuAssertIntEquals(tc, i, get_i32(phv, key));
+   }
+   dtl_dec_ref(phv);
+}
+
+/**
+ * Returns a version of phv with pKey set, releasing phv.
+ */
+static dtl_phv_t *set_i32(dtl_phv_t *phv, const char *pKey, int32_t i32Value)
+{
+   dtl_phv_t *version = dtl_phv_set_cstr(phv, pKey, (dtl_dv_t*) dtl_sv_make_i32(i32Value), false);
+   dtl_dec_ref(phv);
+   return version;
+}
+
+static dtl_phv_t *remove_key(dtl_phv_t *phv, const char *pKey)
+{
+   dtl_phv_t *version = dtl_phv_remove_cstr(phv, pKey);
+   dtl_dec_ref(phv);
+   return version;
+}
+
+static int32_t get_i32(const dtl_phv_t *phv, const char *pKey)
+{
+   dtl_sv_t *sv = (dtl_sv_t*) dtl_phv_get_cstr(phv, pKey);
+   return (sv != 0)? dtl_sv_to_i32(sv, (bool*) 0) : -1000;
+}
+
+static void count_free(void *arg)
+{
+   (*(int32_t*) arg)++;
+}
+
+static dtl_thread_ret_t DTL_THREAD_CALL reader(void *arg)
+{
+   reader_arg_t *readerArg = (reader_arg_t*) arg;
+   char key[16];
+   int32_t i;
+   int32_t s32Iteration;
+   for (s32Iteration = 0; s32Iteration < READER_ITERATIONS; s32Iteration++)
+   {
+      dtl_phv_t *own;
+      dtl_inc_ref(readerArg->shared);
+      own = (dtl_phv_t*) readerArg->shared;
+      for (i = 0; i < SHARED_NUM_KEYS; i += 10)
+      {
+         sprintf(key, "k%d", i);
+         if (get_i32(readerArg->shared, key) != i)
+         {
+            readerArg->s32NumErrors++;
+         }
+         own = set_i32(own, key, -i);
+         sprintf(key, "k%d", i + 1);
+         own = remove_key(own, key);
+      }
+      if (dtl_phv_length(own) != (SHARED_NUM_KEYS - (SHARED_NUM_KEYS / 10)))
+      {
+         readerArg->s32NumErrors++;
+      }
+      dtl_dec_ref(own);
+   }
+   return (dtl_thread_ret_t) 0;
+}
@@ -0,0 +1,139 @@
+/*****************************************************************************
+* \file      testsuite_dtl_pool.c
+* \author    Conny Gustafsson
+* \date      2026-10-17
+* \brief     Unit tests for dtl_pool
+*
+* Copyright (c) 2026 Conny Gustafsson
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "CuTest.h"
+#include "dtl_pool.h"
+#include "dtl_sv.h"
+#include "dtl_av.h"
+#include "dtl_hv.h"
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define NUM_VALUES 5000
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static void test_dtl_pool_alloc_free(CuTest* tc);
+static void test_dtl_pool_values(CuTest* tc);
+static void test_dtl_pool_trim(CuTest* tc);
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+CuSuite* testsuite_dtl_pool(void)
+{
+   CuSuite* suite = CuSuiteNew();
+
+   SUITE_ADD_TEST(suite, test_dtl_pool_alloc_free);
+   SUITE_ADD_TEST(suite, test_dtl_pool_values);
+   SUITE_ADD_TEST(suite, test_dtl_pool_trim);
+
+   return suite;
+}
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+static void test_dtl_pool_alloc_free(CuTest* tc)
+{
+   dtl_pool_stats_t stats;
+   void *a = dtl_pool_alloc(DTL_POOL_SV);
+   void *b = dtl_pool_alloc(DTL_POOL_SV);
+   CuAssertPtrNotNull(tc, a);
+   CuAssertPtrNotNull(tc, b);
+   CuAssertTrue(tc, a != b);
+   CuAssertTrue(tc, dtl_pool_stats(DTL_POOL_SV, &stats));
+   CuAssertTrue(tc, stats.u32BlockSize >= sizeof(dtl_sv_t));
+   memset(a, 0xAA, sizeof(dtl_sv_t));
+   memset(b, 0x55, sizeof(dtl_sv_t));
+   dtl_pool_free(DTL_POOL_SV, a);
+   dtl_pool_free(DTL_POOL_SV, b);
+   CuAssertTrue(tc, !dtl_pool_stats(DTL_POOL_NUM_POOLS, &stats));
+}
+
+static void test_dtl_pool_values(CuTest* tc)
+{
+   int32_t i;
+   dtl_av_t *av = dtl_av_new();
+   dtl_hv_t *hv = dtl_hv_new();
+   CuAssertPtrNotNull(tc, av);
+   CuAssertPtrNotNull(tc, hv);
+   for (i = 0; i < NUM_VALUES; i++)
+   {
+      dtl_av_push(av, (dtl_dv_t*) dtl_sv_make_i32(i), false);
+   }
+   dtl_hv_set_cstr(hv, "values", (dtl_dv_t*) av, false);
+   dtl_hv_set_cstr(hv, "null", dtl_dv_null(), false);
+   CuAssertIntEquals(tc, NUM_VALUES, dtl_av_length(av));
+   for (i = 0; i < NUM_VALUES; i++)
+   {
+      CuAssertIntEquals(tc, i, dtl_sv_to_i32((dtl_sv_t*) dtl_av_value(av, i), NULL));
+   }
+   dtl_dec_ref(hv);
+}
+
+static void test_dtl_pool_trim(CuTest* tc)
+{
+   dtl_pool_stats_t stats;
+   int32_t i;
+   dtl_sv_t **values = (dtl_sv_t**) malloc(sizeof(dtl_sv_t*) * NUM_VALUES);
+   CuAssertPtrNotNull(tc, values);
+   dtl_pool_trim();
+   for (i = 0; i < NUM_VALUES; i++)
+   {
+      values[i] = dtl_sv_make_i32(i);
+   }
+   CuAssertTrue(tc, dtl_pool_stats(DTL_POOL_SV, &stats));
+   if (dtl_pool_enabled())
+   {
+      CuAssertTrue(tc, stats.u32NumSlabs > 0u);
+      CuAssertTrue(tc, stats.u32NumOutstanding >= NUM_VALUES);
+   }
+   for (i = 0; i < NUM_VALUES; i++)
+   {
+      dtl_dec_ref(values[i]);
+   }
+   dtl_pool_trim();
+   CuAssertTrue(tc, dtl_pool_stats(DTL_POOL_SV, &stats));
+   CuAssertUIntEquals(tc, 0u, stats.u32NumCached);
+   CuAssertUIntEquals(tc, 0u, stats.u32NumOutstanding);
+   CuAssertUIntEquals(tc, 0u, stats.u32NumSlabs);
+   free(values);
+}
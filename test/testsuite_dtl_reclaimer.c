@@ -0,0 +1,208 @@
+/*****************************************************************************
+* \file      testsuite_dtl_reclaimer.c
+* \author    Conny Gustafsson
+* \date      2026-10-17
+* \brief     Unit tests for the background reclaimer thread
+*
+* Copyright (c) 2026 Conny Gustafsson
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "CuTest.h"
+#include "dtl_sv.h"
+#include "dtl_av.h"
+#include "dtl_hv.h"
+#include "dtl_thread.h"
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define TREE_NUM_ITEMS     100
+#define NUM_PRODUCERS      4
+#define TREES_PER_PRODUCER 200
+
+typedef struct free_counter_tag{
+   int32_t s32NumFreed;
+   int32_t s32NumFreedByCaller; //freed on the thread that released the tree
+} free_counter_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static void test_dtl_reclaimer_handoff(CuTest* tc);
+static void test_dtl_reclaimer_producers(CuTest* tc);
+static void test_dtl_reclaimer_stop(CuTest* tc);
+static dtl_av_t *make_tree(free_counter_t *counter);
+static void count_free(void *arg);
+static dtl_thread_ret_t DTL_THREAD_CALL producer(void *arg);
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+static DTL_THREAD_LOCAL bool m_isReleasingThread = false;
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+CuSuite* testsuite_dtl_reclaimer(void)
+{
+   CuSuite* suite = CuSuiteNew();
+
+   SUITE_ADD_TEST(suite, test_dtl_reclaimer_handoff);
+   SUITE_ADD_TEST(suite, test_dtl_reclaimer_producers);
+   SUITE_ADD_TEST(suite, test_dtl_reclaimer_stop);
+
+   return suite;
+}
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+static void test_dtl_reclaimer_handoff(CuTest* tc)
+{
+   free_counter_t counter = {0, 0};
+   dtl_reclaimer_stats_t stats;
+   dtl_av_t *av;
+#ifdef DTL_BIASED_REFCNT
+   CuAssertTrue(tc, !dtl_reclaimer_start());
+   return;
+#endif
+   CuAssertTrue(tc, dtl_reclaimer_start());
+   CuAssertTrue(tc, dtl_reclaimer_start()); //already running
+   m_isReleasingThread = true;
+   av = make_tree(&counter);
+   dtl_dec_ref(av);
+   dtl_reclaimer_flush();
+   CuAssertIntEquals(tc, TREE_NUM_ITEMS, counter.s32NumFreed);
+   CuAssertIntEquals(tc, 0, counter.s32NumFreedByCaller);
+   CuAssertTrue(tc, dtl_reclaimer_stats(&stats));
+   CuAssertUIntEquals(tc, 0u, stats.u32QueueDepth);
+   CuAssertUIntEquals(tc, 1u, stats.u32MaxQueueDepth);
+   CuAssertTrue(tc, stats.u64NumTrees == 1u);
+   CuAssertTrue(tc, stats.u64NumValues == (1u + TREE_NUM_ITEMS * 2u)); //av, its hashes and their scalars
+   CuAssertTrue(tc, stats.u64NumBytes >= stats.u64NumValues * sizeof(dtl_sv_t));
+
+   //scalars are freed by the releasing thread
+   dtl_dec_ref(dtl_sv_make_ptr(&counter, count_free));
+   CuAssertIntEquals(tc, 1, counter.s32NumFreedByCaller);
+
+   //deferred mode keeps released values on the thread's own list
+   dtl_reclaim_set_deferred(true);
+   dtl_dec_ref(make_tree(&counter));
+   CuAssertUIntEquals(tc, 1u, dtl_reclaim_pending());
+   dtl_reclaim_set_deferred(false);
+   (void) dtl_reclaim(UINT32_MAX);
+   CuAssertIntEquals(tc, 1 + TREE_NUM_ITEMS, counter.s32NumFreedByCaller);
+
+   dtl_reclaimer_stop();
+   dtl_reclaimer_stop(); //not running
+   dtl_dec_ref(make_tree(&counter));
+   CuAssertIntEquals(tc, 1 + TREE_NUM_ITEMS * 2, counter.s32NumFreedByCaller);
+   CuAssertIntEquals(tc, 1 + TREE_NUM_ITEMS * 3, counter.s32NumFreed);
+   m_isReleasingThread = false;
+}
+
+static void test_dtl_reclaimer_producers(CuTest* tc)
+{
+   dtl_thread_t threads[NUM_PRODUCERS];
+   free_counter_t counter = {0, 0};
+   dtl_reclaimer_stats_t stats;
+   int32_t i;
+#ifdef DTL_BIASED_REFCNT
+   return;
+#endif
+   CuAssertTrue(tc, dtl_reclaimer_start());
+   for (i = 0; i < NUM_PRODUCERS; i++)
+   {
+      CuAssertIntEquals(tc, 0, dtl_thread_create(&threads[i], producer, &counter));
+   }
+   for (i = 0; i < NUM_PRODUCERS; i++)
+   {
+      dtl_thread_join(threads[i]);
+   }
+   dtl_reclaimer_flush();
+   CuAssertTrue(tc, dtl_reclaimer_stats(&stats));
+   CuAssertUIntEquals(tc, 0u, stats.u32QueueDepth);
+   CuAssertTrue(tc, stats.u64NumTrees == NUM_PRODUCERS * TREES_PER_PRODUCER);
+   CuAssertIntEquals(tc, NUM_PRODUCERS * TREES_PER_PRODUCER * TREE_NUM_ITEMS, counter.s32NumFreed);
+   CuAssertIntEquals(tc, 0, counter.s32NumFreedByCaller);
+   dtl_reclaimer_stop();
+}
+
+static void test_dtl_reclaimer_stop(CuTest* tc)
+{
+   free_counter_t counter = {0, 0};
+   int32_t i;
+#ifdef DTL_BIASED_REFCNT
+   return;
+#endif
+   CuAssertTrue(tc, dtl_reclaimer_start());
+   for (i = 0; i < 10; i++)
+   {
+      dtl_dec_ref(make_tree(&counter));
+   }
+   dtl_reclaimer_stop(); //frees what is still queued
+   CuAssertIntEquals(tc, 10 * TREE_NUM_ITEMS, counter.s32NumFreed);
+   dtl_reclaimer_flush(); //returns at once when not running
+}
+
+/**
+ * An array of TREE_NUM_ITEMS hashes, each holding a scalar that counts when it is freed.
+ */
+static dtl_av_t *make_tree(free_counter_t *counter)
+{
+   dtl_av_t *av = dtl_av_new();
+   int32_t i;
+   for (i = 0; i < TREE_NUM_ITEMS; i++)
+   {
+      dtl_hv_t *hv = dtl_hv_new();
+      dtl_hv_set_cstr(hv, "item", (dtl_dv_t*) dtl_sv_make_ptr(counter, count_free), false);
+      dtl_av_push(av, (dtl_dv_t*) hv, false);
+   }
+   return av;
+}
+
+static void count_free(void *arg)
+{
+   free_counter_t *counter = (free_counter_t*) arg;
+   counter->s32NumFreed++;
+   if (m_isReleasingThread)
+   {
+      counter->s32NumFreedByCaller++;
+   }
+}
+
+static dtl_thread_ret_t DTL_THREAD_CALL producer(void *arg)
+{
+   int32_t i;
+   m_isReleasingThread = true;
+   for (i = 0; i < TREES_PER_PRODUCER; i++)
+   {
+      dtl_dec_ref(make_tree((free_counter_t*) arg));
+   }
+   return (dtl_thread_ret_t) 0;
+}
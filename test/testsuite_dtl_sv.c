@@ -29,8 +29,12 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <math.h>
+#include <locale.h>
 #include "CuTest.h"
 #include "dtl_sv.h"
+#include "dtl_av.h"
+#include "dtl_hv.h"
 #ifdef MEM_LEAK_CHECK
 #include "CMemLeak.h"
 #endif
@@ -47,6 +51,17 @@ static void test_dtl_sv_make(CuTest* tc);
 static void test_dtl_sv_bool(CuTest* tc);
 static void test_dtl_sv_lt_i32(CuTest* tc);
 static void test_dtl_sv_lt_str(CuTest* tc);
+static void test_dtl_sv_cmp_numbers(CuTest* tc);
+static void test_dtl_sv_cmp_types(CuTest* tc);
+static void test_dtl_sv_hash(CuTest* tc);
+static void test_dtl_sv_embedded_payload(CuTest* tc);
+static void test_dtl_sv_short_str(CuTest* tc);
+static void test_dtl_sv_immortal(CuTest* tc);
+static void test_dtl_sv_format(CuTest* tc);
+static void test_dtl_sv_format_roundtrip(CuTest* tc);
+static void test_dtl_sv_dual_value(CuTest* tc);
+static void test_dtl_sv_parse_long_text(CuTest* tc);
+static void test_dtl_sv_str_to_int_range(CuTest* tc);
 
 //////////////////////////////////////////////////////////////////////////////
 // PRIVATE VARIABLES
@@ -64,6 +79,17 @@ CuSuite* testsuite_dtl_sv(void)
    SUITE_ADD_TEST(suite, test_dtl_sv_bool);
    SUITE_ADD_TEST(suite, test_dtl_sv_lt_i32);
    SUITE_ADD_TEST(suite, test_dtl_sv_lt_str);
+   SUITE_ADD_TEST(suite, test_dtl_sv_cmp_numbers);
+   SUITE_ADD_TEST(suite, test_dtl_sv_cmp_types);
+   SUITE_ADD_TEST(suite, test_dtl_sv_hash);
+   SUITE_ADD_TEST(suite, test_dtl_sv_embedded_payload);
+   SUITE_ADD_TEST(suite, test_dtl_sv_short_str);
+   SUITE_ADD_TEST(suite, test_dtl_sv_immortal);
+   SUITE_ADD_TEST(suite, test_dtl_sv_format);
+   SUITE_ADD_TEST(suite, test_dtl_sv_format_roundtrip);
+   SUITE_ADD_TEST(suite, test_dtl_sv_dual_value);
+   SUITE_ADD_TEST(suite, test_dtl_sv_parse_long_text);
+   SUITE_ADD_TEST(suite, test_dtl_sv_str_to_int_range);
    return suite;
 }
 //////////////////////////////////////////////////////////////////////////////
@@ -260,3 +286,591 @@ static void test_dtl_sv_lt_str(CuTest* tc)
    dtl_dec_ref(a);
    dtl_dec_ref(b);
 }
+
+/**
+ * Numbers of all types in ascending order, including pairs that are equal or differ by less than a double can show.
+ * Every pair must compare as their positions do.
+ */
+static void test_dtl_sv_cmp_numbers(CuTest* tc)
+{
+   dtl_sv_t *values[16];
+   int32_t ranks[16] = {0, 1, 2, 3, 3, 4, 4, 4, 5, 6, 7, 8, 9, 9, 10, 11};
+   int32_t i, j;
+   values[0] = dtl_sv_make_dbl(-HUGE_VAL);
+   values[1] = dtl_sv_make_i64(INT64_MIN);
+   values[2] = dtl_sv_make_dbl(-1.5);
+   values[3] = dtl_sv_make_i32(-1);
+   values[4] = dtl_sv_make_flt(-1.0f);
+   values[5] = dtl_sv_make_dbl(-0.0);
+   values[6] = dtl_sv_make_u32(0u);
+   values[7] = dtl_sv_make_dbl(0.0);
+   values[8] = dtl_sv_make_dbl(4.9e-324);
+   values[9] = dtl_sv_make_dbl(9007199254740992.0); //2^53
+   values[10] = dtl_sv_make_i64(9007199254740993); //2^53 + 1, rounds to 2^53 as a double
+   values[11] = dtl_sv_make_u64((uint64_t) INT64_MAX); //rounds to 2^63 as a double
+   values[12] = dtl_sv_make_dbl(9223372036854775808.0); //2^63
+   values[13] = dtl_sv_make_u64(UINT64_C(9223372036854775808));
+   values[14] = dtl_sv_make_u64(UINT64_MAX);
+   values[15] = dtl_sv_make_dbl(HUGE_VAL);
+   for (i = 0; i < 16; i++)
+   {
+      for (j = 0; j < 16; j++)
+      {
+         int32_t result = 99;
+         int32_t expected = (ranks[i] > ranks[j]) - (ranks[i] < ranks[j]);
+         CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_sv_cmp(values[i], values[j], &result));
+         CuAssertIntEquals(tc, expected, (result > 0) - (result < 0));
+      }
+   }
+   //NaN is equal to itself and greater than everything else
+   for (i = 0; i < 16; i++)
+   {
+      dtl_sv_t *nan = dtl_sv_make_dbl(NAN);
+      int32_t result = 0;
+      CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_sv_cmp(nan, values[i], &result));
+      CuAssertTrue(tc, result > 0);
+      CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_sv_cmp(values[i], nan, &result));
+      CuAssertTrue(tc, result < 0);
+      CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_sv_cmp(nan, nan, &result));
+      CuAssertIntEquals(tc, 0, result);
+      dtl_dec_ref(nan);
+      dtl_dec_ref(values[i]);
+   }
+}
+
+static void test_dtl_sv_cmp_types(CuTest* tc)
+{
+   dtl_sv_t *abc = dtl_sv_make_cstr("abc");
+   dtl_sv_t *ab = dtl_sv_make_cstr("ab");
+   dtl_sv_t *one = dtl_sv_make_i32(1);
+   dtl_sv_t *none = dtl_sv_new();
+   dtl_sv_t *yes = dtl_sv_make_bool(true);
+   dtl_sv_t *no = dtl_sv_make_bool(false);
+   int32_t result = 0;
+   CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_sv_cmp(ab, abc, &result));
+   CuAssertTrue(tc, result < 0);
+   CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_sv_cmp(abc, abc, &result));
+   CuAssertIntEquals(tc, 0, result);
+   CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_sv_cmp(yes, no, &result));
+   CuAssertTrue(tc, result > 0);
+   CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_sv_cmp(none, none, &result));
+   CuAssertIntEquals(tc, 0, result);
+   //different kinds of scalars have no order
+   CuAssertIntEquals(tc, DTL_TYPE_ERROR, dtl_sv_cmp(one, abc, &result));
+   CuAssertIntEquals(tc, DTL_TYPE_ERROR, dtl_sv_cmp(one, yes, &result));
+   CuAssertIntEquals(tc, DTL_TYPE_ERROR, dtl_sv_cmp(none, one, &result));
+   CuAssertIntEquals(tc, DTL_INVALID_ARGUMENT_ERROR, dtl_sv_cmp(one, NULL, &result));
+   CuAssertIntEquals(tc, DTL_INVALID_ARGUMENT_ERROR, dtl_sv_cmp(one, one, NULL));
+   dtl_dec_ref(abc);
+   dtl_dec_ref(ab);
+   dtl_dec_ref(one);
+   dtl_dec_ref(none);
+   dtl_dec_ref(yes);
+   dtl_dec_ref(no);
+}
+
+static void test_dtl_sv_hash(CuTest* tc)
+{
+   dtl_sv_t *values[6];
+   dtl_sv_t *text = dtl_sv_make_cstr("key");
+   dtl_sv_t *other = dtl_sv_make_dbl(0.5);
+   uint32_t hash;
+   int32_t i;
+   //the same number in every type hashes alike
+   values[0] = dtl_sv_make_i32(7);
+   values[1] = dtl_sv_make_u32(7u);
+   values[2] = dtl_sv_make_i64(7);
+   values[3] = dtl_sv_make_u64(7u);
+   values[4] = dtl_sv_make_flt(7.0f);
+   values[5] = dtl_sv_make_dbl(7.0);
+   hash = dtl_sv_hash(values[0]);
+   for (i = 0; i < 6; i++)
+   {
+      CuAssertTrue(tc, hash == dtl_sv_hash(values[i]));
+      dtl_dec_ref(values[i]);
+   }
+   values[0] = dtl_sv_make_dbl(-0.0);
+   values[1] = dtl_sv_make_i32(0);
+   values[2] = dtl_sv_make_u64(UINT64_MAX - 2047u);
+   values[3] = dtl_sv_make_dbl(18446744073709549568.0); //UINT64_MAX - 2047
+   values[4] = dtl_sv_make_dbl(NAN);
+   values[5] = dtl_sv_make_dbl(-NAN);
+   CuAssertTrue(tc, dtl_sv_hash(values[0]) == dtl_sv_hash(values[1]));
+   CuAssertTrue(tc, dtl_sv_hash(values[2]) == dtl_sv_hash(values[3]));
+   CuAssertTrue(tc, dtl_sv_hash(values[4]) == dtl_sv_hash(values[5]));
+   CuAssertTrue(tc, dtl_sv_hash(values[1]) != dtl_sv_hash(other));
+   for (i = 0; i < 6; i++)
+   {
+      dtl_dec_ref(values[i]);
+   }
+   //strings hash like dtl_hv keys
+   CuAssertTrue(tc, dtl_sv_hash(text) == dtl_key_hash((const uint8_t*) "key", (const uint8_t*) "key" + 3));
+   dtl_dec_ref(text);
+   dtl_dec_ref(other);
+}
+
+static void test_dtl_sv_embedded_payload(CuTest* tc)
+{
+   dtl_sv_t *sv = dtl_sv_make_i32(42);
+   CuAssertPtrNotNull(tc, sv);
+   CuAssertPtrEquals(tc, &sv->svx, sv->pAny);
+   CuAssertIntEquals(tc, 42, sv->pAny->val.i32);
+   dtl_sv_set_cstr(sv, "Hello");
+   CuAssertStrEquals(tc, "Hello", sv->pAny->val.sso);
+   dtl_sv_set_cstr(sv, "A string too long for inline storage");
+   CuAssertStrEquals(tc, "A string too long for inline storage", adt_str_cstr(sv->pAny->val.str));
+   dtl_dec_ref(sv);
+
+   CuAssertPtrEquals(tc, &g_dtl_sv_none.svx, g_dtl_sv_none.pAny);
+   CuAssertIntEquals(tc, DTL_SV_NONE, dtl_sv_type(dtl_sv_none()));
+}
+
+static void test_dtl_sv_short_str(CuTest* tc)
+{
+   const uint8_t bstr[5] = {'a', 0, 'b', 0, 'c'};
+   dtl_sv_t *sv = dtl_sv_make_cstr("");
+   dtl_sv_t *other;
+   adt_str_t *str;
+   bool ok = false;
+   bool ltres = false;
+
+   CuAssertIntEquals(tc, DTL_SV_STR, dtl_sv_type(sv));
+   CuAssertStrEquals(tc, "", dtl_sv_to_cstr(sv, &ok));
+   CuAssertTrue(tc, ok);
+
+   //15 bytes is the longest inline string
+   dtl_sv_set_cstr(sv, "123456789012345");
+   CuAssertTrue(tc, (sv->u32Flags & DTL_DV_FLAG_SSO) != 0u);
+   CuAssertStrEquals(tc, "123456789012345", dtl_sv_to_cstr(sv, &ok));
+   dtl_sv_set_cstr(sv, "1234567890123456");
+   CuAssertTrue(tc, (sv->u32Flags & DTL_DV_FLAG_SSO) == 0u);
+   CuAssertStrEquals(tc, "1234567890123456", dtl_sv_to_cstr(sv, &ok));
+   dtl_sv_set_cstr(sv, "short");
+   CuAssertTrue(tc, (sv->u32Flags & DTL_DV_FLAG_SSO) != 0u);
+   CuAssertStrEquals(tc, "short", dtl_sv_to_cstr(sv, &ok));
+   dtl_sv_set_i32(sv, 5);
+   CuAssertTrue(tc, (sv->u32Flags & DTL_DV_FLAG_SSO) == 0u);
+   CuAssertIntEquals(tc, 5, dtl_sv_to_i32(sv, &ok));
+
+   //embedded null bytes are kept
+   dtl_sv_set_bstr(sv, &bstr[0], &bstr[0] + sizeof(bstr));
+   str = dtl_sv_to_str(sv, &ok);
+   CuAssertPtrNotNull(tc, str);
+   CuAssertIntEquals(tc, 5, adt_str_length(str));
+   adt_str_delete(str);
+
+   dtl_sv_set_cstr(sv, "TRUE");
+   CuAssertTrue(tc, dtl_sv_to_bool(sv, &ok));
+   CuAssertTrue(tc, ok);
+
+   //comparison between inline and heap strings
+   other = dtl_sv_make_cstr("short string stored on the heap");
+   dtl_sv_set_cstr(sv, "short");
+   CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_sv_lt(sv, other, &ltres));
+   CuAssertTrue(tc, ltres);
+   CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_sv_lt(other, sv, &ltres));
+   CuAssertTrue(tc, !ltres);
+   dtl_sv_set_cstr(sv, "shorter");
+   CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_sv_lt(other, sv, &ltres));
+   CuAssertTrue(tc, ltres);
+   dtl_sv_set_str(sv, other->pAny->val.str);
+   CuAssertStrEquals(tc, "short string stored on the heap", dtl_sv_to_cstr(sv, &ok));
+
+   dtl_dec_ref(other);
+   dtl_dec_ref(sv);
+}
+
+static void test_dtl_sv_immortal(CuTest* tc)
+{
+   dtl_sv_t *sv;
+   dtl_sv_t *other;
+   dtl_av_t *av;
+   bool ok = false;
+   int32_t i;
+
+   //small integers are shared and reference counting does not touch them
+   sv = dtl_sv_const_i32(7);
+   CuAssertPtrEquals(tc, sv, dtl_sv_const_i32(7));
+   CuAssertIntEquals(tc, DTL_SV_I32, dtl_sv_type(sv));
+   CuAssertTrue(tc, (sv->u32Flags & DTL_DV_FLAG_IMMORTAL) != 0u);
+   dtl_inc_ref(sv);
+   CuAssertIntEquals(tc, 1, dtl_ref_cnt(sv));
+   dtl_dec_ref(sv);
+   dtl_dec_ref(sv);
+   CuAssertIntEquals(tc, 1, dtl_ref_cnt(sv));
+   CuAssertIntEquals(tc, 7, dtl_sv_to_i32(sv, &ok));
+   CuAssertTrue(tc, ok);
+   for (i = 0; i < 256; i++)
+   {
+      char buf[16];
+      sprintf(buf, "%d", (int) i);
+      CuAssertIntEquals(tc, i, dtl_sv_to_i32(dtl_sv_const_i32(i), NULL));
+      CuAssertIntEquals(tc, i, (int32_t) dtl_sv_to_u32(dtl_sv_const_u32((uint32_t) i), NULL));
+      CuAssertStrEquals(tc, buf, dtl_sv_to_cstr(dtl_sv_const_i32(i), &ok));
+      CuAssertStrEquals(tc, buf, dtl_sv_to_cstr(dtl_sv_const_u32((uint32_t) i), &ok));
+   }
+   CuAssertIntEquals(tc, DTL_SV_U32, dtl_sv_type(dtl_sv_const_u32(255u)));
+
+   //outside of the table a new value is returned
+   sv = dtl_sv_const_i32(256);
+   other = dtl_sv_const_i32(256);
+   CuAssertTrue(tc, sv != other);
+   CuAssertTrue(tc, (sv->u32Flags & DTL_DV_FLAG_IMMORTAL) == 0u);
+   CuAssertIntEquals(tc, 256, dtl_sv_to_i32(sv, NULL));
+   dtl_dec_ref(sv);
+   dtl_dec_ref(other);
+   sv = dtl_sv_const_i32(-1);
+   CuAssertIntEquals(tc, -1, dtl_sv_to_i32(sv, NULL));
+   dtl_dec_ref(sv);
+
+   //booleans and empty string
+   CuAssertPtrEquals(tc, dtl_sv_const_bool(true), dtl_sv_const_bool(true));
+   CuAssertTrue(tc, dtl_sv_to_bool(dtl_sv_const_bool(true), NULL));
+   CuAssertTrue(tc, !dtl_sv_to_bool(dtl_sv_const_bool(false), NULL));
+   CuAssertIntEquals(tc, DTL_SV_BOOL, dtl_sv_type(dtl_sv_const_bool(false)));
+   CuAssertIntEquals(tc, DTL_SV_STR, dtl_sv_type(dtl_sv_const_empty_str()));
+   CuAssertStrEquals(tc, "", dtl_sv_to_cstr(dtl_sv_const_empty_str(), &ok));
+   CuAssertTrue(tc, ok);
+
+   //containers release their elements without freeing the shared values
+   av = dtl_av_new();
+   for (i = 0; i < 10; i++)
+   {
+      dtl_av_push(av, (dtl_dv_t*) dtl_sv_const_i32(i), false);
+      dtl_av_push(av, (dtl_dv_t*) dtl_sv_const_bool((i & 1) != 0), true);
+      dtl_av_push(av, dtl_dv_const_null(), false);
+   }
+   CuAssertIntEquals(tc, 30, dtl_av_length(av));
+   dtl_dec_ref(av);
+   CuAssertIntEquals(tc, 9, dtl_sv_to_i32(dtl_sv_const_i32(9), NULL));
+   CuAssertIntEquals(tc, DTL_DV_NULL, dtl_dv_type(dtl_dv_const_null()));
+   CuAssertIntEquals(tc, 1, dtl_ref_cnt(dtl_dv_const_null()));
+}
+
+static void test_dtl_sv_format(CuTest* tc)
+{
+   char buf[64];
+   char small[4];
+   const char *text[3];
+   dtl_sv_t *sv = dtl_sv_make_i32(-1234);
+   dtl_sv_t *other = dtl_sv_make_dbl(2.5);
+   bool ok = false;
+
+   CuAssertIntEquals(tc, 5, dtl_sv_format(sv, buf, sizeof(buf)));
+   CuAssertStrEquals(tc, "-1234", buf);
+   //truncated output is still null-terminated and the full length is returned
+   CuAssertIntEquals(tc, 5, dtl_sv_format(sv, small, sizeof(small)));
+   CuAssertStrEquals(tc, "-12", small);
+   CuAssertIntEquals(tc, 5, dtl_sv_format(sv, NULL, 0u));
+
+   CuAssertIntEquals(tc, 3, dtl_sv_format(other, buf, sizeof(buf)));
+   CuAssertStrEquals(tc, "2.5", buf);
+   CuAssertTrue(tc, dtl_sv_format_dbl(1e300, buf, sizeof(buf)) < DTL_SV_NUM_BUF_SIZE);
+   CuAssertIntEquals(tc, 20, dtl_sv_format_u64(18446744073709551615ull, buf, sizeof(buf)));
+   CuAssertStrEquals(tc, "18446744073709551615", buf);
+   CuAssertIntEquals(tc, 20, dtl_sv_format_i64(-9223372036854775807ll - 1, buf, sizeof(buf)));
+   CuAssertStrEquals(tc, "-9223372036854775808", buf);
+
+   dtl_sv_set_bool(other, true);
+   CuAssertIntEquals(tc, 4, dtl_sv_format(other, buf, sizeof(buf)));
+   CuAssertStrEquals(tc, "true", buf);
+   dtl_sv_set_cstr(other, "a string too long for inline storage");
+   CuAssertIntEquals(tc, 36, dtl_sv_format(other, buf, sizeof(buf)));
+   CuAssertStrEquals(tc, "a string too long for inline storage", buf);
+   dtl_sv_set_dv(other, (dtl_dv_t*) dtl_sv_make_i32(1), false);
+   CuAssertIntEquals(tc, -1, dtl_sv_format(other, buf, sizeof(buf)));
+
+   //long numeric to_cstr results stay valid across a few calls in the same thread
+   dtl_sv_set_u64(other, 42u);
+   dtl_sv_set_i64(sv, -1234567890123456ll);
+   text[0] = dtl_sv_to_cstr(sv, &ok);
+   CuAssertTrue(tc, ok);
+   text[1] = dtl_sv_to_cstr(other, &ok);
+   dtl_sv_set_i32(sv, 7);
+   text[2] = dtl_sv_to_cstr(sv, &ok);
+   CuAssertStrEquals(tc, "-1234567890123456", text[0]);
+   CuAssertStrEquals(tc, "42", text[1]);
+   CuAssertStrEquals(tc, "7", text[2]);
+
+   dtl_dec_ref(sv);
+   dtl_dec_ref(other);
+}
+
+static void test_dtl_sv_format_roundtrip(CuTest* tc)
+{
+   char buf[DTL_SV_NUM_BUF_SIZE];
+   uint64_t state = 88172645463325252ull;
+   uint32_t i;
+   dtl_sv_t *sv = dtl_sv_make_flt(0.1f);
+
+   //shortest text, fixed notation between 1e-6 and 1e21
+   CuAssertStrEquals(tc, "0.1", dtl_sv_to_cstr(sv, NULL));
+   dtl_sv_set_dbl(sv, 0.1);
+   CuAssertStrEquals(tc, "0.1", dtl_sv_to_cstr(sv, NULL));
+   dtl_sv_set_dbl(sv, -1.5);
+   CuAssertStrEquals(tc, "-1.5", dtl_sv_to_cstr(sv, NULL));
+   dtl_sv_set_dbl(sv, 100.0);
+   CuAssertStrEquals(tc, "100", dtl_sv_to_cstr(sv, NULL));
+   dtl_sv_set_dbl(sv, 1e-7);
+   CuAssertStrEquals(tc, "1e-7", dtl_sv_to_cstr(sv, NULL));
+   dtl_sv_set_dbl(sv, 0.000001);
+   CuAssertStrEquals(tc, "0.000001", dtl_sv_to_cstr(sv, NULL));
+   dtl_sv_set_dbl(sv, 1e21);
+   CuAssertStrEquals(tc, "1e+21", dtl_sv_to_cstr(sv, NULL));
+   dtl_sv_set_dbl(sv, 5e-324);
+   CuAssertStrEquals(tc, "5e-324", dtl_sv_to_cstr(sv, NULL));
+   dtl_sv_set_dbl(sv, 1.7976931348623157e308);
+   CuAssertStrEquals(tc, "1.7976931348623157e+308", dtl_sv_to_cstr(sv, NULL));
+   dtl_sv_set_dbl(sv, -0.0);
+   CuAssertStrEquals(tc, "-0", dtl_sv_to_cstr(sv, NULL));
+   dtl_sv_set_dbl(sv, HUGE_VAL);
+   CuAssertStrEquals(tc, "inf", dtl_sv_to_cstr(sv, NULL));
+   dtl_sv_set_flt(sv, 3.4028235e38f);
+   CuAssertStrEquals(tc, "3.4028235e+38", dtl_sv_to_cstr(sv, NULL));
+   dtl_sv_set_i64(sv, -9223372036854775807ll - 1);
+   CuAssertStrEquals(tc, "-9223372036854775808", dtl_sv_to_cstr(sv, NULL));
+
+   //random bit patterns (including subnormals) must parse back to the same value
+   for (i = 0u; i < 100000u; i++)
+   {
+      uint64_t bits;
+      uint32_t fbits;
+      double value;
+      double parsed;
+      float fvalue;
+      float fparsed;
+      state ^= state << 13;
+      state ^= state >> 7;
+      state ^= state << 17;
+      bits = ( (i & 3u) == 1u)? (state & 0x000FFFFFFFFFFFFFull) : state;
+      memcpy(&value, &bits, sizeof(value));
+      if (!isnan(value) && !isinf(value))
+      {
+         dtl_sv_format_dbl(value, buf, sizeof(buf));
+         parsed = strtod(buf, NULL);
+         CuAssertTrue(tc, memcmp(&value, &parsed, sizeof(value)) == 0);
+      }
+      fbits = (uint32_t) (state >> 32);
+      memcpy(&fvalue, &fbits, sizeof(fvalue));
+      if (!isnan(fvalue) && !isinf(fvalue))
+      {
+         dtl_sv_format_flt(fvalue, buf, sizeof(buf));
+         fparsed = strtof(buf, NULL);
+         CuAssertTrue(tc, memcmp(&fvalue, &fparsed, sizeof(fvalue)) == 0);
+      }
+   }
+   dtl_dec_ref(sv);
+}
+
+static void test_dtl_sv_parse_long_text(CuTest* tc)
+{
+   static const char *commaLocales[] = {"de_DE.UTF-8", "de_DE.utf8", "fr_FR.UTF-8", "sv_SE.UTF-8", "German_Germany.1252"};
+   char text[512];
+   const char *oldLocale;
+   bool ok = false;
+   uint32_t i;
+   dtl_sv_t *sv = dtl_sv_new();
+
+   //300 digits, longer than the stack buffer of the strtod fallback
+   text[0] = '1';
+   memset(&text[1], '0', 299u);
+   text[300] = '\0';
+   dtl_sv_set_cstr(sv, text);
+   CuAssertTrue(tc, dtl_sv_to_dbl(sv, &ok) == 1e299);
+   CuAssertTrue(tc, ok);
+   memcpy(text, "0.", 2u);
+   memset(&text[2], '0', 200u);
+   memcpy(&text[202], "125e5", 6u);
+   dtl_sv_set_cstr(sv, text);
+   CuAssertTrue(tc, dtl_sv_to_dbl(sv, &ok) == 1.25e-196);
+   CuAssertTrue(tc, ok);
+   for (i = 0u; i < 200u; i++)
+   {
+      text[i] = (char) ('1' + (i % 9u));
+   }
+   memcpy(&text[200], ".5x", 4u);
+   dtl_sv_set_cstr(sv, text);
+   dtl_sv_to_dbl(sv, &ok);
+   CuAssertTrue(tc, !ok);
+
+   //the result does not depend on the decimal point of the current locale
+   oldLocale = setlocale(LC_NUMERIC, NULL);
+   CuAssertPtrNotNull(tc, oldLocale);
+   strcpy(text, oldLocale);
+   for (i = 0u; i < sizeof(commaLocales) / sizeof(commaLocales[0]); i++)
+   {
+      if (setlocale(LC_NUMERIC, commaLocales[i]) != NULL)
+      {
+         break;
+      }
+   }
+   dtl_sv_set_cstr(sv, "1.2345678901234567890123"); //too many digits for the fast path
+   CuAssertTrue(tc, dtl_sv_to_dbl(sv, &ok) == 1.2345678901234567890123);
+   CuAssertTrue(tc, ok);
+   setlocale(LC_NUMERIC, text);
+   dtl_dec_ref(sv);
+}
+
+static void test_dtl_sv_str_to_int_range(CuTest* tc)
+{
+   //strings whose number does not fit the requested integer type
+   static const char *tooLargeFor32[] = {"18446744073709551615", "9223372036854775808", "4294967296", "4294967296.5", "1e30", "nan"};
+   static const char *notUnsigned[] = {"-4294967295", "-1", "-9223372036854775808", "-1e30", "nan"};
+   dtl_sv_t *sv = dtl_sv_new();
+   bool ok;
+   uint32_t i;
+
+   for (i = 0u; i < sizeof(tooLargeFor32) / sizeof(tooLargeFor32[0]); i++)
+   {
+      dtl_sv_set_cstr(sv, tooLargeFor32[i]);
+      ok = true;
+      dtl_sv_to_i32(sv, &ok);
+      CuAssertTrue(tc, !ok);
+      ok = true;
+      dtl_sv_to_u32(sv, &ok);
+      CuAssertTrue(tc, !ok);
+   }
+   for (i = 0u; i < sizeof(notUnsigned) / sizeof(notUnsigned[0]); i++)
+   {
+      dtl_sv_set_cstr(sv, notUnsigned[i]);
+      ok = true;
+      dtl_sv_to_u32(sv, &ok);
+      CuAssertTrue(tc, !ok);
+      ok = true;
+      dtl_sv_to_u64(sv, &ok);
+      CuAssertTrue(tc, !ok);
+   }
+   dtl_sv_set_cstr(sv, "1e30");
+   ok = true;
+   dtl_sv_to_i64(sv, &ok);
+   CuAssertTrue(tc, !ok);
+   ok = true;
+   dtl_sv_to_u64(sv, &ok);
+   CuAssertTrue(tc, !ok);
+   dtl_sv_set_cstr(sv, "9223372036854775808.5");
+   ok = true;
+   dtl_sv_to_i64(sv, &ok);
+   CuAssertTrue(tc, !ok);
+   dtl_sv_set_cstr(sv, "18446744073709551616.5");
+   ok = true;
+   dtl_sv_to_u64(sv, &ok);
+   CuAssertTrue(tc, !ok);
+   dtl_sv_set_cstr(sv, "nan");
+   ok = true;
+   dtl_sv_to_i64(sv, &ok);
+   CuAssertTrue(tc, !ok);
+
+   //the edges of each range still convert
+   dtl_sv_set_cstr(sv, "-2147483648");
+   CuAssertTrue(tc, dtl_sv_to_i32(sv, &ok) == INT32_MIN && ok);
+   dtl_sv_set_cstr(sv, "4294967295.5");
+   CuAssertTrue(tc, dtl_sv_to_u32(sv, &ok) == UINT32_MAX && ok);
+   dtl_sv_set_cstr(sv, "-9.223372036854775808e18");
+   CuAssertTrue(tc, dtl_sv_to_i64(sv, &ok) == INT64_MIN && ok);
+   dtl_sv_set_cstr(sv, "1.8446744073709550e19");
+   CuAssertTrue(tc, dtl_sv_to_u64(sv, &ok) == UINT64_C(18446744073709549568) && ok);
+   dtl_sv_set_cstr(sv, "9223372036854775808");
+   CuAssertTrue(tc, dtl_sv_to_u64(sv, &ok) == UINT64_C(9223372036854775808) && ok);
+
+   //scalars of the numeric types themselves
+   dtl_sv_set_u64(sv, UINT64_MAX);
+   dtl_sv_to_i32(sv, &ok);
+   CuAssertTrue(tc, !ok);
+   dtl_sv_set_i64(sv, -4294967295LL);
+   dtl_sv_to_u64(sv, &ok);
+   CuAssertTrue(tc, !ok);
+   dtl_sv_set_flt(sv, 2147483648.0f);
+   dtl_sv_to_i32(sv, &ok);
+   CuAssertTrue(tc, !ok);
+   dtl_sv_set_flt(sv, 1e20f);
+   dtl_sv_to_i64(sv, &ok);
+   CuAssertTrue(tc, !ok);
+   dtl_sv_set_flt(sv, 300.0f);
+   dtl_sv_to_char(sv, &ok);
+   CuAssertTrue(tc, !ok);
+   dtl_dec_ref(sv);
+}
+
+static void test_dtl_sv_dual_value(CuTest* tc)
+{
+   char buf[DTL_SV_NUM_BUF_SIZE];
+   uint64_t state = 2463534242ull;
+   const char *text;
+   bool ok = false;
+   uint32_t i;
+   dtl_sv_t *sv = dtl_sv_make_cstr("123");
+
+   //string to number, parsed once and served from the cache afterwards
+   CuAssertIntEquals(tc, 123, dtl_sv_to_i32(sv, &ok));
+   CuAssertTrue(tc, ok);
+   CuAssertIntEquals(tc, 123, dtl_sv_to_i32(sv, &ok));
+   CuAssertDblEquals(tc, 123.0, dtl_sv_to_dbl(sv, &ok), 0.0);
+   CuAssertIntEquals(tc, DTL_SV_STR, dtl_sv_type(sv));
+   CuAssertStrEquals(tc, "123", dtl_sv_to_cstr(sv, NULL));
+   dtl_sv_set_cstr(sv, "-2.5e3");
+   CuAssertDblEquals(tc, -2500.0, dtl_sv_to_dbl(sv, &ok), 0.0);
+   CuAssertTrue(tc, ok);
+   CuAssertIntEquals(tc, -2500, dtl_sv_to_i32(sv, &ok));
+   CuAssertTrue(tc, ok);
+   dtl_sv_set_cstr(sv, "18446744073709551615");
+   CuAssertTrue(tc, dtl_sv_to_u64(sv, &ok) == UINT64_MAX);
+   CuAssertTrue(tc, ok);
+   dtl_sv_to_i64(sv, &ok);
+   CuAssertTrue(tc, !ok);
+   dtl_sv_set_cstr(sv, "0.1");
+   CuAssertTrue(tc, dtl_sv_to_dbl(sv, NULL) == 0.1);
+   dtl_sv_set_cstr(sv, "-inf");
+   CuAssertTrue(tc, isinf(dtl_sv_to_dbl(sv, &ok)) && ok);
+   dtl_sv_set_cstr(sv, "12abc");
+   dtl_sv_to_i32(sv, &ok);
+   CuAssertTrue(tc, !ok);
+   dtl_sv_to_dbl(sv, &ok);
+   CuAssertTrue(tc, !ok);
+   dtl_sv_set_cstr(sv, "");
+   dtl_sv_to_dbl(sv, &ok);
+   CuAssertTrue(tc, !ok);
+   dtl_sv_to_i32(dtl_sv_const_empty_str(), &ok);
+   CuAssertTrue(tc, !ok);
+
+   //number to string, the text stays put until the value changes (atomic and biased builds do not cache)
+   dtl_sv_set_i32(sv, -42);
+   text = dtl_sv_to_cstr(sv, NULL);
+   CuAssertStrEquals(tc, "-42", text);
+#if !defined(DTL_ATOMIC_REFCNT) && !defined(DTL_BIASED_REFCNT)
+   CuAssertPtrEquals(tc, (void*) text, (void*) dtl_sv_to_cstr(sv, NULL));
+   for (i = 0u; i < 20u; i++)
+   {
+      dtl_sv_t *other = dtl_sv_make_u32(i + 1000u);
+      dtl_sv_to_cstr(other, NULL);
+      dtl_dec_ref(other);
+   }
+   CuAssertStrEquals(tc, "-42", text);
+#endif
+   dtl_sv_set_dbl(sv, 0.25);
+   CuAssertStrEquals(tc, "0.25", dtl_sv_to_cstr(sv, NULL));
+   CuAssertDblEquals(tc, 0.25, dtl_sv_to_dbl(sv, NULL), 0.0);
+   dtl_sv_set_dbl(sv, 0.1234567890123);
+   CuAssertStrEquals(tc, "0.1234567890123", dtl_sv_to_cstr(sv, NULL));
+
+   //formatted text of random doubles must parse back to the same value
+   for (i = 0u; i < 20000u; i++)
+   {
+      uint64_t bits;
+      double value;
+      double parsed;
+      state ^= state << 13;
+      state ^= state >> 7;
+      state ^= state << 17;
+      bits = ( (i & 1u) == 1u)? ( (state >> 12) | 0x3FF0000000000000ull) : state;
+      memcpy(&value, &bits, sizeof(value));
+      if (!isnan(value))
+      {
+         dtl_sv_format_dbl(value, buf, sizeof(buf));
+         dtl_sv_set_cstr(sv, buf);
+         parsed = dtl_sv_to_dbl(sv, &ok);
+         CuAssertTrue(tc, ok);
+         CuAssertTrue(tc, memcmp(&value, &parsed, sizeof(value)) == 0);
+      }
+   }
+   dtl_dec_ref(sv);
+}
@@ -0,0 +1,302 @@
+/*****************************************************************************
+* \file      testsuite_dtl_tav.c
+* \author    Conny Gustafsson
+* \date      2026-10-17
+* \brief     Unit tests for dtl_tav
+*
+* Copyright (c) 2026 Conny Gustafsson
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include "CuTest.h"
+#include "dtl_sv.h"
+#include "dtl_tav.h"
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define MANY_VALUES 10000
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static void test_dtl_tav_push(CuTest* tc);
+static void test_dtl_tav_range(CuTest* tc);
+static void test_dtl_tav_get(CuTest* tc);
+static void test_dtl_tav_set(CuTest* tc);
+static void test_dtl_tav_append(CuTest* tc);
+static void test_dtl_tav_av(CuTest* tc);
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+CuSuite* testsuite_dtl_tav(void)
+{
+   CuSuite* suite = CuSuiteNew();
+
+   SUITE_ADD_TEST(suite, test_dtl_tav_push);
+   SUITE_ADD_TEST(suite, test_dtl_tav_range);
+   SUITE_ADD_TEST(suite, test_dtl_tav_get);
+   SUITE_ADD_TEST(suite, test_dtl_tav_set);
+   SUITE_ADD_TEST(suite, test_dtl_tav_append);
+   SUITE_ADD_TEST(suite, test_dtl_tav_av);
+
+   return suite;
+}
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+static void test_dtl_tav_push(CuTest* tc)
+{
+   dtl_tav_t *tav = dtl_tav_new(DTL_TAV_I32);
+   const int32_t *pElems;
+   int32_t i;
+   bool ok = false;
+   CuAssertPtrNotNull(tc, tav);
+   CuAssertIntEquals(tc, DTL_DV_TYPED_ARRAY, dtl_dv_type((dtl_dv_t*) tav));
+   CuAssertIntEquals(tc, DTL_TAV_I32, dtl_tav_elem_type(tav));
+   CuAssertIntEquals(tc, 0, dtl_tav_length(tav));
+   for (i = 0; i < MANY_VALUES; i++)
+   {
+      CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_tav_push_i64(tav, i - 5000));
+   }
+   CuAssertIntEquals(tc, MANY_VALUES, dtl_tav_length(tav));
+   pElems = (const int32_t*) dtl_tav_data(tav);
+   for (i = 0; i < MANY_VALUES; i++)
+   {
+      CuAssertIntEquals(tc, i - 5000, pElems[i]);
+   }
+   CuAssertTrue(tc, dtl_tav_get_i64(tav, -1, &ok) == 4999);
+   CuAssertTrue(tc, ok);
+   dtl_tav_clear(tav);
+   CuAssertIntEquals(tc, 0, dtl_tav_length(tav));
+   dtl_dec_ref(tav);
+   CuAssertPtrEquals(tc, NULL, dtl_tav_new(DTL_TAV_NUM_ELEM_TYPES));
+   CuAssertIntEquals(tc, -1, dtl_tav_length(NULL));
+   CuAssertIntEquals(tc, DTL_INVALID_ARGUMENT_ERROR, dtl_tav_push_i64(NULL, 0));
+}
+
+static void test_dtl_tav_range(CuTest* tc)
+{
+   dtl_tav_t *i8 = dtl_tav_new(DTL_TAV_I8);
+   dtl_tav_t *u16 = dtl_tav_new(DTL_TAV_U16);
+   dtl_tav_t *i64 = dtl_tav_new(DTL_TAV_I64);
+   dtl_tav_t *u64 = dtl_tav_new(DTL_TAV_U64);
+   dtl_tav_t *f32 = dtl_tav_new(DTL_TAV_F32);
+   CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_tav_push_i64(i8, -128));
+   CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_tav_push_u64(i8, 127u));
+   CuAssertIntEquals(tc, DTL_CONVERSION_ERROR, dtl_tav_push_i64(i8, -129));
+   CuAssertIntEquals(tc, DTL_CONVERSION_ERROR, dtl_tav_push_i64(i8, 128));
+   CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_tav_push_dbl(i8, -3.0));
+   CuAssertIntEquals(tc, DTL_CONVERSION_ERROR, dtl_tav_push_dbl(i8, 1.5));
+   CuAssertIntEquals(tc, DTL_CONVERSION_ERROR, dtl_tav_push_dbl(i8, NAN));
+   CuAssertIntEquals(tc, 3, dtl_tav_length(i8));
+
+   CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_tav_push_u64(u16, 65535u));
+   CuAssertIntEquals(tc, DTL_CONVERSION_ERROR, dtl_tav_push_u64(u16, 65536u));
+   CuAssertIntEquals(tc, DTL_CONVERSION_ERROR, dtl_tav_push_i64(u16, -1));
+   CuAssertIntEquals(tc, DTL_CONVERSION_ERROR, dtl_tav_push_dbl(u16, -0.5));
+   CuAssertIntEquals(tc, 1, dtl_tav_length(u16));
+
+   CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_tav_push_i64(i64, INT64_MIN));
+   CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_tav_push_dbl(i64, -9223372036854775808.0));
+   CuAssertIntEquals(tc, DTL_CONVERSION_ERROR, dtl_tav_push_dbl(i64, 9223372036854775808.0));
+   CuAssertIntEquals(tc, DTL_CONVERSION_ERROR, dtl_tav_push_u64(i64, (uint64_t) INT64_MAX + 1u));
+   CuAssertIntEquals(tc, 2, dtl_tav_length(i64));
+
+   CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_tav_push_u64(u64, UINT64_MAX));
+   CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_tav_push_dbl(u64, 9223372036854775808.0));
+   CuAssertIntEquals(tc, DTL_CONVERSION_ERROR, dtl_tav_push_dbl(u64, 18446744073709551616.0));
+   CuAssertIntEquals(tc, DTL_CONVERSION_ERROR, dtl_tav_push_dbl(u64, INFINITY));
+   CuAssertIntEquals(tc, 2, dtl_tav_length(u64));
+
+   CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_tav_push_dbl(f32, 0.1));
+   CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_tav_push_dbl(f32, -INFINITY));
+   CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_tav_push_dbl(f32, NAN));
+   CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_tav_push_i64(f32, -16777217));
+   CuAssertIntEquals(tc, DTL_CONVERSION_ERROR, dtl_tav_push_dbl(f32, 1e300));
+   CuAssertIntEquals(tc, 4, dtl_tav_length(f32));
+   CuAssertTrue(tc, dtl_tav_get_dbl(f32, 0, NULL) == (double) 0.1f);
+   CuAssertTrue(tc, isinf(dtl_tav_get_dbl(f32, 1, NULL)));
+   CuAssertTrue(tc, isnan(dtl_tav_get_dbl(f32, 2, NULL)));
+   CuAssertTrue(tc, dtl_tav_get_dbl(f32, 3, NULL) == -16777216.0);
+
+   dtl_dec_ref(i8);
+   dtl_dec_ref(u16);
+   dtl_dec_ref(i64);
+   dtl_dec_ref(u64);
+   dtl_dec_ref(f32);
+}
+
+static void test_dtl_tav_get(CuTest* tc)
+{
+   const int16_t i16Elems[3] = {-300, 0, 300};
+   const double dblElems[6] = {-2.75, 2.75, 1e20, NAN, -9223372036854775808.0, 9223372036854775808.0};
+   const uint64_t u64Elems[2] = {5u, UINT64_MAX};
+   dtl_tav_t *i16 = dtl_tav_make(DTL_TAV_I16, i16Elems, 3u);
+   dtl_tav_t *f64 = dtl_tav_make(DTL_TAV_F64, dblElems, 6u);
+   dtl_tav_t *u64 = dtl_tav_make(DTL_TAV_U64, u64Elems, 2u);
+   bool ok = false;
+   CuAssertTrue(tc, dtl_tav_get_i64(i16, 0, &ok) == -300);
+   CuAssertTrue(tc, ok);
+   CuAssertTrue(tc, dtl_tav_get_u64(i16, 0, &ok) == 0u);
+   CuAssertTrue(tc, !ok);
+   CuAssertTrue(tc, dtl_tav_get_u64(i16, 1, &ok) == 0u);
+   CuAssertTrue(tc, ok);
+   CuAssertTrue(tc, dtl_tav_get_u64(i16, 2, &ok) == 300u);
+   CuAssertTrue(tc, ok);
+   CuAssertTrue(tc, dtl_tav_get_dbl(i16, -3, &ok) == -300.0);
+   CuAssertTrue(tc, ok);
+   dtl_tav_get_i64(i16, 3, &ok);
+   CuAssertTrue(tc, !ok);
+   dtl_tav_get_dbl(i16, -4, &ok);
+   CuAssertTrue(tc, !ok);
+
+   CuAssertTrue(tc, dtl_tav_get_i64(f64, 0, &ok) == -2);
+   CuAssertTrue(tc, ok);
+   CuAssertTrue(tc, dtl_tav_get_u64(f64, 1, &ok) == 2u);
+   CuAssertTrue(tc, ok);
+   CuAssertTrue(tc, dtl_tav_get_u64(f64, 0, &ok) == 0u);
+   CuAssertTrue(tc, !ok);
+   CuAssertTrue(tc, dtl_tav_get_u64(f64, 2, &ok) == 0u); //1e20 is beyond UINT64_MAX
+   CuAssertTrue(tc, !ok);
+   dtl_tav_get_i64(f64, 3, &ok);
+   CuAssertTrue(tc, !ok);
+   CuAssertTrue(tc, dtl_tav_get_i64(f64, 4, &ok) == INT64_MIN); //-2^63 is the lowest int64_t
+   CuAssertTrue(tc, ok);
+   dtl_tav_get_i64(f64, 5, &ok);
+   CuAssertTrue(tc, !ok);
+
+   CuAssertTrue(tc, dtl_tav_get_u64(u64, 1, &ok) == UINT64_MAX);
+   CuAssertTrue(tc, ok);
+   dtl_tav_get_i64(u64, 1, &ok);
+   CuAssertTrue(tc, !ok);
+   CuAssertTrue(tc, dtl_tav_get_i64(u64, 0, &ok) == 5);
+   CuAssertTrue(tc, ok);
+
+   dtl_dec_ref(i16);
+   dtl_dec_ref(f64);
+   dtl_dec_ref(u64);
+}
+
+static void test_dtl_tav_set(CuTest* tc)
+{
+   dtl_tav_t *tav = dtl_tav_new(DTL_TAV_U8);
+   int32_t i;
+   for (i = 0; i < 10; i++)
+   {
+      CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_tav_push_u64(tav, (uint64_t) i));
+   }
+   CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_tav_set_i64(tav, 0, 255));
+   CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_tav_set_u64(tav, -1, 200u));
+   CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_tav_set_dbl(tav, 5, 42.0));
+   CuAssertIntEquals(tc, DTL_CONVERSION_ERROR, dtl_tav_set_i64(tav, 1, 256));
+   CuAssertIntEquals(tc, DTL_CONVERSION_ERROR, dtl_tav_set_dbl(tav, 1, 0.5));
+   CuAssertIntEquals(tc, DTL_INVALID_ARGUMENT_ERROR, dtl_tav_set_i64(tav, 10, 1));
+   CuAssertTrue(tc, dtl_tav_get_u64(tav, 0, NULL) == 255u);
+   CuAssertTrue(tc, dtl_tav_get_u64(tav, 1, NULL) == 1u);
+   CuAssertTrue(tc, dtl_tav_get_u64(tav, 5, NULL) == 42u);
+   CuAssertTrue(tc, dtl_tav_get_u64(tav, 9, NULL) == 200u);
+
+   dtl_dv_freeze((dtl_dv_t*) tav);
+   CuAssertIntEquals(tc, DTL_FROZEN_ERROR, dtl_tav_set_i64(tav, 1, 7));
+   CuAssertIntEquals(tc, DTL_FROZEN_ERROR, dtl_tav_push_i64(tav, 7));
+   CuAssertIntEquals(tc, DTL_FROZEN_ERROR, dtl_tav_reserve(tav, 100));
+   dtl_tav_clear(tav);
+   CuAssertIntEquals(tc, 10, dtl_tav_length(tav));
+   CuAssertTrue(tc, dtl_tav_get_u64(tav, 1, NULL) == 1u);
+   dtl_dec_ref(tav);
+}
+
+static void test_dtl_tav_append(CuTest* tc)
+{
+   const float fltElems[3] = {1.5f, -2.5f, 3.25f};
+   dtl_tav_t *tav = dtl_tav_new(DTL_TAV_F32);
+   int32_t i;
+   CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_tav_reserve(tav, 1000));
+   for (i = 0; i < 300; i++)
+   {
+      CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_tav_append(tav, fltElems, 3u));
+   }
+   CuAssertIntEquals(tc, DTL_NO_ERROR, dtl_tav_append(tav, NULL, 0u));
+   CuAssertIntEquals(tc, DTL_INVALID_ARGUMENT_ERROR, dtl_tav_append(tav, NULL, 1u));
+   CuAssertIntEquals(tc, DTL_INVALID_ARGUMENT_ERROR, dtl_tav_reserve(tav, -1));
+   CuAssertIntEquals(tc, 900, dtl_tav_length(tav));
+   for (i = 0; i < 900; i++)
+   {
+      CuAssertTrue(tc, dtl_tav_get_dbl(tav, i, NULL) == (double) fltElems[i % 3]);
+   }
+   dtl_dec_ref(tav);
+}
+
+static void test_dtl_tav_av(CuTest* tc)
+{
+   const int64_t i64Elems[4] = {-1, 0, 70000, INT64_MAX};
+   dtl_tav_t *tav = dtl_tav_make(DTL_TAV_I64, i64Elems, 4u);
+   dtl_tav_t *copy;
+   dtl_av_t *av = dtl_tav_to_av(tav);
+   dtl_sv_t *sv;
+   int32_t i;
+   bool ok = false;
+   CuAssertPtrNotNull(tc, av);
+   CuAssertIntEquals(tc, 4, dtl_av_length(av));
+   for (i = 0; i < 4; i++)
+   {
+      sv = (dtl_sv_t*) dtl_av_value(av, i);
+      CuAssertIntEquals(tc, DTL_SV_I64, dtl_sv_type(sv));
+      CuAssertTrue(tc, dtl_sv_to_i64(sv, &ok) == i64Elems[i]);
+   }
+   copy = dtl_tav_make_from_av(av, DTL_TAV_F64);
+   CuAssertPtrNotNull(tc, copy);
+   CuAssertTrue(tc, dtl_tav_get_dbl(copy, 2, NULL) == 70000.0);
+   CuAssertPtrEquals(tc, NULL, dtl_tav_make_from_av(av, DTL_TAV_I32)); //INT64_MAX does not fit
+   dtl_dec_ref(copy);
+   copy = dtl_tav_make_from_av(av, DTL_TAV_I64);
+   CuAssertTrue(tc, dtl_tav_get_i64(copy, 3, NULL) == INT64_MAX);
+   dtl_dec_ref(copy);
+
+   dtl_av_push(av, (dtl_dv_t*) dtl_sv_make_dbl(0.5), false);
+   dtl_av_push(av, (dtl_dv_t*) dtl_sv_make_flt(2.0f), false);
+   copy = dtl_tav_make_from_av(av, DTL_TAV_F32);
+   CuAssertPtrNotNull(tc, copy);
+   CuAssertTrue(tc, dtl_tav_get_dbl(copy, 4, NULL) == 0.5);
+   dtl_dec_ref(copy);
+   dtl_av_push(av, (dtl_dv_t*) dtl_sv_make_cstr("1"), false);
+   CuAssertPtrEquals(tc, NULL, dtl_tav_make_from_av(av, DTL_TAV_F64));
+   dtl_dec_ref(av);
+   dtl_dec_ref(tav);
+
+   tav = dtl_tav_new(DTL_TAV_U8);
+   dtl_tav_push_u64(tav, 200u);
+   av = dtl_tav_to_av(tav);
+   sv = (dtl_sv_t*) dtl_av_value(av, 0);
+   CuAssertIntEquals(tc, DTL_SV_U32, dtl_sv_type(sv));
+   CuAssertIntEquals(tc, 200, (int) dtl_sv_to_u32(sv, NULL));
+   dtl_dec_ref(av);
+   dtl_dec_ref(tav);
+}